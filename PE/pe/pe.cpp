@@ -1,4 +1,5 @@
 #include "pe.hpp"
+#include "../../src/checkpoint/Checkpoint.hpp"
 #include <thread>
 #include <chrono>
 #include <iostream>
@@ -22,18 +23,59 @@ void PE::set_segment(uint64_t baseA, uint64_t baseB, uint64_t partial_out, uint6
     R_[5] = partial_out;  // reuse para store final
 }
 
-void PE::run(uint64_t max_steps) {
+void PE::save(CheckpointWriter& w) const {
+    w.pod(int32_t(id_));
+    w.pod(uint64_t(prog_.size()));
+    for (const Instr& I : prog_) {
+        w.pod(I.op); w.pod(I.d); w.pod(I.a); w.pod(I.b); w.pod(I.imm);
+    }
+    w.pod(pc_);
+    w.put(R_.data(), sizeof(uint64_t) * R_.size());
+    w.pod(barrier_epoch_);
+}
+
+bool PE::load(CheckpointReader& r) {
+    int32_t id = -1;
+    uint64_t n = 0;
+    if (!r.pod(id) || !r.pod(n)) return false;
+    if (id != id_) return r.fail("id de PE distinto al del checkpoint");
+    // Cada instrucción ocupa 12 B en el archivo: n no puede pedir más de lo que queda
+    static constexpr size_t kInstrBytes = sizeof(Op) + 3 + sizeof(int64_t);
+    if (n > r.remaining() / kInstrBytes) return r.fail("programa más largo que el archivo");
+    Program p(n);
+    for (Instr& I : p) {
+        if (!r.pod(I.op) || !r.pod(I.d) || !r.pod(I.a) || !r.pod(I.b) || !r.pod(I.imm)) return false;
+        if (uint8_t(I.op) > uint8_t(Op::FENCE)) return r.fail("opcode de PE desconocido");
+        if (I.d >= R_.size() || I.a >= R_.size() || I.b >= R_.size())
+            return r.fail("registro de PE fuera de rango");
+    }
+    if (!r.pod(pc_) || !r.get(R_.data(), sizeof(uint64_t) * R_.size()) || !r.pod(barrier_epoch_))
+        return false;
+    prog_ = std::move(p);
+    return true;
+}
+
+void PE::copy_state_from(const PE& o) {
+    prog_ = o.prog_;
+    pc_ = o.pc_;
+    R_ = o.R_;
+    barrier_epoch_ = o.barrier_epoch_;
+}
+
+uint64_t PE::run(uint64_t max_steps) {
     uint64_t steps = 0;
     bool halted = false;
     while (!halted) {
         if (mem_) mem_->service(); 
         step(halted);
-        if (max_steps && ++steps >= max_steps) break;
+        if (!halted) ++steps;
+        if (max_steps && steps >= max_steps) break;
     }
+    return steps;
 }
 
 void PE::step(bool& halted) {
-    if (pc_ >= prog_.size()) { halted = true; return; }
+    if (pc_ >= prog_.size() || (mem_ && mem_->fault())) { halted = true; return; }
     const Instr& I = prog_[pc_];
 
     switch (I.op) {
@@ -52,6 +94,16 @@ void PE::step(bool& halted) {
             pc_++;
         } break;
 
+        case Op::STNT: {
+            mem_->store_nt64(R_[I.a], R_[I.d]);
+            pc_++;
+        } break;
+
+        case Op::FENCE: {
+            mem_->fence();
+            pc_++;
+        } break;
+
         case Op::FMUL: {
             double a = u64_as_double(R_[I.a]);
             double b = u64_as_double(R_[I.b]);
@@ -78,6 +130,55 @@ void PE::step(bool& halted) {
             R_[I.d] = R_[I.a] + (R_[I.b] << I.imm);
             pc_++;
         } break;
+
+        case Op::LI:  R_[I.d] = static_cast<uint64_t>(I.imm); pc_++; break;
+        case Op::SUB: R_[I.d] = R_[I.a] - R_[I.b]; pc_++; break;
+
+        case Op::CAS: {
+            R_[I.d] = mem_->cas64(R_[I.a], R_[I.d], R_[I.b]);
+            pc_++;
+        } break;
+
+        case Op::FETCH_ADD: {
+            R_[I.d] = mem_->fetch_add64(R_[I.a], R_[I.b]);
+            pc_++;
+        } break;
+
+        case Op::FETCH_FADD: {
+            R_[I.d] = mem_->fetch_fadd64(R_[I.a], u64_as_double(R_[I.b]));
+            pc_++;
+        } break;
+
+        case Op::LL: {
+            R_[I.d] = mem_->ll64(R_[I.a]);
+            pc_++;
+        } break;
+
+        case Op::SC: {
+            R_[I.d] = mem_->sc64(R_[I.a], R_[I.b]) ? 0 : 1;
+            pc_++;
+        } break;
+
+        case Op::WAIT: {
+            mem_->wait_eq64(R_[I.a], R_[I.d]);
+            pc_++;
+        } break;
+
+        case Op::BARRIER: {
+            // Sense-reversing centralizada: el último en llegar reinicia el contador
+            // y publica el nuevo episodio; los demás esperan coherentemente.
+            const uint64_t cnt = R_[I.a];
+            const uint64_t rel = cnt + kBarrierReleaseOffset;
+            const uint64_t n   = static_cast<uint64_t>(I.imm);
+            const uint64_t ep  = ++barrier_epoch_;
+            if (mem_->fetch_add64(cnt, 1) == n - 1) {
+                mem_->store64(cnt, 0);
+                mem_->store64(rel, ep);
+            } else {
+                mem_->wait_eq64(rel, ep);
+            }
+            pc_++;
+        } break;
     }
 }
 
@@ -3,6 +3,7 @@
 #include <vector>
 #include <array>
 #include <cstring>
+#include <thread>
 
 
 class IMemoryPort {
@@ -11,13 +12,72 @@ public:
     virtual uint64_t load64(uint64_t addr) = 0;
     virtual void     store64(uint64_t addr, uint64_t val) = 0;
     virtual void     service() = 0; 
+
+    // Atómicos read-modify-write (devuelven el valor previo en memoria).
+    // La implementación por defecto NO es atómica entre hilos: sirve para puertos
+    // de un solo PE (p.ej. memoria trivial de pruebas). MesiMemoryPort la
+    // sobreescribe obteniendo la línea en M y reteniéndola frente a snoops.
+    virtual uint64_t cas64(uint64_t addr, uint64_t expected, uint64_t desired) {
+        uint64_t old = load64(addr);
+        if (old == expected) store64(addr, desired);
+        return old;
+    }
+    virtual uint64_t fetch_add64(uint64_t addr, uint64_t delta) {
+        uint64_t old = load64(addr);
+        store64(addr, old + delta);
+        return old;
+    }
+    virtual uint64_t fetch_fadd64(uint64_t addr, double delta) {
+        uint64_t old = load64(addr);
+        double d; std::memcpy(&d, &old, 8); d += delta;
+        uint64_t u; std::memcpy(&u, &d, 8);
+        store64(addr, u);
+        return old;
+    }
+    // Load-linked / store-conditional (sc64 devuelve true si tuvo éxito).
+    virtual uint64_t ll64(uint64_t addr) { return load64(addr); }
+    virtual bool     sc64(uint64_t addr, uint64_t val) { store64(addr, val); return true; }
+
+    // Store no temporal (sin read-for-ownership) y la barrera que publica los
+    // pendientes. Por defecto: store común y nada que publicar.
+    virtual void store_nt64(uint64_t addr, uint64_t val) { store64(addr, val); }
+    virtual void fence() {}
+
+    // Espera hasta que [addr] == val. Por defecto: sondeo con yield.
+    // MesiMemoryPort duerme entre sondeos hasta que llegue una invalidación.
+    virtual void wait_eq64(uint64_t addr, uint64_t val) {
+        while (load64(addr) != val) std::this_thread::yield();
+    }
+
+    // Error del puerto (p.ej. un fallo de página sin memoria física): el acceso
+    // que falló no tiene efecto (un load lee 0) y el PE se detiene antes de la
+    // instrucción siguiente. nullptr = sin error.
+    virtual const char* fault() const { return nullptr; }
 };
 
 enum class Op : uint8_t {
     LOAD, STORE, FMUL, FADD, INC, DEC, JNZ, HALT,
     LEA,           // Rd = Ra + (Rb << imm)  ( dir. efectivas A[i],B[i])
+    LI,            // Rd = imm
+    SUB,           // Rd = Ra - Rb (entero)
+    // --- Atómicos (coherentes vía MESI) ---
+    CAS,           // Rd = old = [Ra]; si old == Rd(previo) => [Ra] = Rb
+    FETCH_ADD,     // Rd = old = [Ra]; [Ra] = old + Rb            (entero)
+    FETCH_FADD,    // Rd = old = [Ra]; [Ra] = old + Rb            (double)
+    LL,            // Rd = [Ra] y reserva la línea
+    SC,            // si la reserva sigue viva: [Ra] = Rb, Rd = 0; si no Rd = 1
+    // --- Sincronización ---
+    WAIT,          // bloquea hasta que [Ra] == Rd (espera coherente, sin quemar CPU del host)
+    BARRIER,       // barrera centralizada: contador en [Ra], liberación en [Ra+32], imm = participantes
+    // --- Escrituras en flujo ---
+    STNT,          // [Ra] = Rd no temporal: sin traer la línea (write-combining)
+    FENCE,         // publica los STNT pendientes del PE (último: PE::load valida op <= FENCE)
 };
 
+// Desplazamiento de la palabra de liberación de BARRIER respecto del contador
+// (una línea de 32 B aparte para no compartir línea con el contador).
+static constexpr uint64_t kBarrierReleaseOffset = 32;
+
 struct Instr {
     Op op;
     uint8_t d=0, a=0, b=0;
@@ -26,20 +86,43 @@ struct Instr {
 
 using Program = std::vector<Instr>;
 
+class CheckpointWriter;
+class CheckpointReader;
+
 
 class PE {
 public:
     explicit PE(int id, IMemoryPort* mem);
 
+    int id() const { return id_; }
+
     void load_program(const Program& p);
 
     void set_segment(uint64_t baseA, uint64_t baseB, uint64_t partial_out, uint64_t len_quarter);
 
-    void run(uint64_t max_steps = 0);
+    // Ejecuta hasta HALT o max_steps instrucciones (0 = sin límite); se puede
+    // reanudar. Devuelve las instrucciones ejecutadas (HALT no cuenta).
+    uint64_t run(uint64_t max_steps = 0);
+    // También detenido si el puerto de memoria reportó un error (IMemoryPort::fault)
+    bool halted() const {
+        return pc_ >= prog_.size() || prog_[pc_].op == Op::HALT || (mem_ && mem_->fault());
+    }
+
+    const Program& program() const { return prog_; }
+
+    // Cambia el puerto de memoria entre pasos (p.ej. modo funcional/detallado
+    // de la simulación muestreada); el PE debe estar detenido.
+    void set_memory_port(IMemoryPort* mem) { mem_ = mem; }
 
     const std::array<uint64_t,8>& regs() const { return R_; }
 
     void step(bool& halted);
+
+    // Checkpoint: programa, pc_, registros y episodio de BARRIER (no el puerto)
+    void save(CheckpointWriter& w) const;
+    bool load(CheckpointReader& r);
+    // Fork en memoria: mismo estado que save/load (el puerto de memoria no se toca)
+    void copy_state_from(const PE& o);
     static inline double u64_as_double(uint64_t u) {
         double d; std::memcpy(&d, &u, 8); return d;
     }
@@ -50,6 +133,7 @@ private:
     Program prog_;
     uint64_t pc_ = 0;
     std::array<uint64_t,8> R_{}; // 8 x 64-bit
+    uint64_t barrier_epoch_ = 0; // episodios de BARRIER completados (sentido = paridad)
 
     static inline uint64_t double_as_u64(double d) {
         uint64_t u; std::memcpy(&u, &d, 8); return u;
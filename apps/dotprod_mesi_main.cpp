@@ -10,7 +10,7 @@
  *  - Crea 4 cachés MESI (una por PE) y las conecta al interconect.
  *  - Construye el “programa” mini-ISA (LEA/LOAD/FMUL/FADD/INC/DEC/JNZ/STORE/HALT).
  *  - Parte N en 4 segmentos contiguos (N/4 por PE) y asigna el tramo a cada PE.
- *  - Ejecuta los 4 PEs (hilos) y, al final, lee los 4 parciales (vía caché) y valida.
+ *  - Ejecuta los 4 PEs (hilos) y, al final, lee los 4 parciales (DMA coherente) y valida.
  *
  * Detalles de coherencia:
  *  - Lecturas de A y B tienden a instalar líneas en S (BusRd).
@@ -39,48 +39,10 @@
 #include "../src/MesiInterconnect.hpp"
 #include "../src/memory/cache/mesi/MESICache.hpp"
 #include "../src/memory/SharedMemory.h"
+#include "../src/MesiMemoryPort.hpp"   // PortMetrics + MesiMemoryPort (IMemoryPort sobre la L1$)
+#include "../src/dma/DmaAgent.hpp"     // lectura coherente de resultados
 #include "../PE/pe/pe.hpp"
 
-// ---------------- Métricas simples por puerto ----------------
-// Solo para contar invocaciones desde el PE (no son las métricas internas de la L1$)
-struct PortMetrics { uint64_t loads=0, stores=0; };
-
-// ---------------- IMemoryPort respaldado por la caché MESI ----------------
-// Adapta la interfaz del PE (IMemoryPort) a la L1$ MESI.
-// En este modelo síncrono, si load()/store() devuelve false es porque se emitió
-// BusRd/BusRdX; el reintento ya es hit (tras onDataResponse del bus).
-class MesiMemoryPort : public IMemoryPort {
-public:
-  MesiMemoryPort(MESICache& cache, MesiInterconnect& ic, PortMetrics* pm=nullptr)
-  : cache_(cache), ic_(ic), pm_(pm) {}
-
-  // Lee 8B coherentemente (alineación implícita a offset dentro de la línea).
-  uint64_t load64(uint64_t addr) override {
-    if (pm_) pm_->loads++;
-    uint64_t u = 0;
-    while (!cache_.load(addr, &u)) {
-      // bus síncrono: el segundo intento ya es hit al llegar onDataResponse
-    }
-    return u;
-  }
-
-  // Escribe 8B coherentemente (write-allocate + write-back).
-  void store64(uint64_t addr, uint64_t val) override {
-    if (pm_) pm_->stores++;
-    while (!cache_.store(addr, &val)) {
-      // write-allocate: tras el Data/propiedad, el reintento completa
-    }
-  }
-
-  // En un bus asíncrono aquí se bombearía la cola del bus. En este demo no hace falta.
-  void service() override { /* vacío para bus síncrono */ }
-
-private:
-  MESICache&        cache_;
-  MesiInterconnect& ic_;
-  PortMetrics*      pm_;
-};
-
 // ---------------- Programa de dot product (mini-ISA) ----------------
 // R0=i, R1=baseA, R2=baseB, R3=acc, R5=partial_out, R7=limit; temporales R4,R6
 // Por iteración:
@@ -105,33 +67,6 @@ static Program make_dot_program() {
   return p;
 }
 
-// -------- Helpers: escribir/leer double en SharedMemory (8B) --------
-// Se usan solo para la inicialización/lectura de verificación a memoria compartida.
-// El cómputo en sí siempre accede a través de la caché (vía MesiMemoryPort).
-static inline void shm_write_double(SharedMemory& shm, uint64_t addr, double v) {
-  uint64_t u; std::memcpy(&u, &v, 8);
-  auto req = std::make_shared<Message>(MessageType::WRITE_MEM, -1, -1);
-  req->payload.write_mem.address = static_cast<uint32_t>(addr);
-  req->payload.write_mem.size    = 8;
-  req->data_write.resize(8);
-  for (int i=0;i<8;++i) req->data_write[i] = static_cast<uint8_t>((u >> (i*8)) & 0xFF);
-  shm.handle_message(req, [&](MessageP){});
-}
-
-static inline double shm_read_double(SharedMemory& shm, uint64_t addr) {
-  auto req = std::make_shared<Message>(MessageType::READ_MEM, -1, -1);
-  req->payload.read_mem.address = static_cast<uint32_t>(addr);
-  req->payload.read_mem.size    = 8;
-  double d = 0.0;
-  shm.handle_message(req, [&](MessageP resp){
-    if (resp && resp->type == MessageType::READ_RESP &&
-        resp->payload.read_resp.status && resp->read_resp_data.size() == 8) {
-      std::memcpy(&d, resp->read_resp_data.data(), 8);
-    }
-  });
-  return d;
-}
-
 int main() {
   // ====== Layout FIJO para SharedMemory (4096 B, línea = 32 B) ======
   // Memoria total pequeña para el demo de N=248:
@@ -162,16 +97,17 @@ int main() {
   MesiInterconnect bus(/*irrelevante*/0);
   bus.set_shared_memory(&shm); // El bus resolverá Data/Flush contra esta memoria
 
-  // --- Inicializa A, B, parciales en SharedMemory ---
+  // --- Inicializa A, B, parciales en SharedMemory (escrituras en bloque, sin caché) ---
+  std::vector<double> A(N), B(N);
   for (size_t i = 0; i < N; ++i) {
-    shm_write_double(shm, baseA + i * 8, double(i + 1));           // A[i] = 1..N
-    shm_write_double(shm, baseB + i * 8, 0.5 * double(i + 1));     // B[i] = 0.5,1.0,1.5,...
+    A[i] = double(i + 1);          // A[i] = 1..N
+    B[i] = 0.5 * double(i + 1);    // B[i] = 0.5,1.0,1.5,...
   }
+  shm.write_doubles(baseA, A.data(), N);
+  shm.write_doubles(baseB, B.data(), N);
   // Inicializa parciales a 0.0
-  shm_write_double(shm, o0, 0.0);
-  shm_write_double(shm, o1, 0.0);
-  shm_write_double(shm, o2, 0.0);
-  shm_write_double(shm, o3, 0.0);
+  const double zero = 0.0;
+  for (uint64_t o : {o0, o1, o2, o3}) shm.write_doubles(o, &zero, 1);
 
   // --- Caches MESI + conexión al bus ---
   MESICache c0(0, bus), c1(1, bus), c2(2, bus), c3(3, bus);
@@ -217,11 +153,13 @@ int main() {
   std::thread t3([&]{ pe3.run(0); });
   t0.join(); t1.join(); t2.join(); t3.join();
 
-  // --- Lectura COHERENTE de parciales (vía L1$/Bus) ---
-  // Leemos a través del puerto (y por ende de la caché) para respetar coherencia.
+  // --- Lectura COHERENTE de parciales (agente DMA sobre el bus) ---
+  // Las líneas de parciales siguen en M en cada L1$: el snoop del DMA las
+  // escribe a memoria antes de leer, sin pasar por el puerto de ningún PE.
+  DmaAgent dma(bus);
   auto load_double_coherent = [&](uint64_t addr) -> double {
-    uint64_t u = mp0.load64(addr); // usamos PE0 para las lecturas finales
-    double d; std::memcpy(&d, &u, 8);
+    double d = 0.0;
+    dma.read_doubles(addr, &d, 1);
     return d;
   };
 
@@ -0,0 +1,403 @@
+/*
+ * mesi_bench_main.cpp
+ * -------------------
+ * Microbenchmarks de los caminos calientes del simulador (ns/op).
+ *
+ * Casos medidos:
+ *  - lookup_hit / lookup_miss : MESICache::lookupLine sobre una línea presente / ausente.
+ *  - load_hit / store_hit     : load/store de 8B con la línea ya en E/M.
+ *  - load_miss_roundtrip      : miss de conflicto (3 líneas en el mismo set de 2 vías):
+ *                               BusRd -> MesiInterconnect::emit -> SharedMemory -> onDataResponse.
+ *  - store_pingpong_roundtrip : dos cachés escriben la misma línea alternadamente
+ *                               (BusRdX + snoop con Flush + invalidación).
+ *  - snoop_hit / snoop_miss   : MESICache::onSnoop(BusRd) sobre línea en S / ausente.
+ *  - shm_read32 / shm_write32 : SharedMemory::handle_message de una línea completa.
+ *  - shm_write_block4k        : SharedMemory::write_doubles de 512 dobles (4096 B) en una llamada.
+ *  - dma_read_block4k         : DmaAgent::read de 4096 B con 2 líneas en M en una L1$.
+ *  - pe_step_hit              : PE::step ejecutando un bucle LOAD/FMUL/FADD/DEC/JNZ en hits.
+ *  - par_load_hit_tT          : T hilos (PEs) con load hits en su propia L1$ a la vez; ns/op
+ *                               sobre el total de hits (escala si los hits no se serializan).
+ *  - par_load_hit_snoop_t4    : ídem con 4 hilos y otro PE generando snoops (BusRd) a un set
+ *                               que no usan los hits.
+ *
+ * Uso:
+ *   mesi_bench [--filter=substr] [--min-time=ms] [--reps=R]
+ *              [--json=out.json] [--baseline=base.json] [--threshold=pct]
+ *
+ *  --json      : guarda resultados en JSON ({"benchmarks":[{"name","ns_per_op",...}]}).
+ *  --baseline  : compara contra un JSON previo; marca REGRESSION si ns/op empeora
+ *                más de --threshold % (por defecto 10) y devuelve código 1.
+ *
+ * Notas:
+ *  - Cada caso se repite R veces y se reporta el MEJOR ns/op (menos ruido del host).
+ *  - Compilar con -DCMAKE_BUILD_TYPE=Release para números representativos.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include "../src/MesiInterconnect.hpp"
+#include "../src/memory/SharedMemory.h"
+#include "../src/memory/cache/mesi/MESICache.hpp"
+#include "../src/MesiMemoryPort.hpp"
+#include "../src/dma/DmaAgent.hpp"
+#include "../PE/pe/pe.hpp"
+
+// Evita que el compilador elimine el trabajo medido.
+template <class T>
+static inline void do_not_optimize(const T& v) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "g"(&v) : "memory");
+#else
+  static volatile const void* sink; sink = &v;
+#endif
+}
+
+struct BenchResult {
+  std::string name;
+  double      ns_per_op = 0.0;
+  uint64_t    iterations = 0;
+};
+
+struct BenchConfig {
+  std::string filter;
+  double      min_time_ms = 200.0;
+  int         reps = 5;
+};
+
+// Ejecuta 'body(iters)' aumentando iteraciones hasta superar min_time; repite 'reps'
+// veces y se queda con el mejor ns/op.
+static BenchResult run_case(const std::string& name, const BenchConfig& cfg,
+                            const std::function<void(uint64_t)>& body) {
+  using clk = std::chrono::steady_clock;
+  BenchResult r; r.name = name; r.ns_per_op = 1e300;
+
+  uint64_t iters = 1000;
+  body(iters); // calentamiento
+
+  for (int rep = 0; rep < cfg.reps; ++rep) {
+    for (;;) {
+      auto t0 = clk::now();
+      body(iters);
+      auto t1 = clk::now();
+      double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+      if (ns >= cfg.min_time_ms * 1e6 || iters >= (1ull << 34)) {
+        r.ns_per_op  = std::min(r.ns_per_op, ns / double(iters));
+        r.iterations = iters;
+        break;
+      }
+      // Escala hacia el tiempo objetivo (mínimo x2 para converger rápido)
+      double scale = (ns > 0) ? (cfg.min_time_ms * 1e6 * 1.2 / ns) : 10.0;
+      iters = uint64_t(double(iters) * std::clamp(scale, 2.0, 100.0));
+    }
+  }
+  return r;
+}
+
+// ---------------- Fixture común: DRAM + bus + 2 L1$ ----------------
+struct Fixture {
+  SharedMemory     shm;
+  MesiInterconnect bus{0};
+  MESICache        c0{0, bus};
+  MESICache        c1{1, bus};
+
+  Fixture() {
+    bus.set_shared_memory(&shm);
+    bus.connect(&c0);
+    bus.connect(&c1);
+  }
+};
+
+// Direcciones en el MISMO set (stride = kSets * kLineSize) para forzar conflictos.
+static constexpr uint64_t kSetStride = uint64_t(MESICache::kSets) * MESICache::kLineSize;
+
+static std::vector<BenchResult> run_all(const BenchConfig& cfg) {
+  std::vector<BenchResult> out;
+  auto want = [&](const char* n) {
+    return cfg.filter.empty() || std::string(n).find(cfg.filter) != std::string::npos;
+  };
+  auto add = [&](const char* n, const std::function<void(uint64_t)>& body) {
+    if (!want(n)) return;
+    out.push_back(run_case(n, cfg, body));
+    std::printf("%-26s %10.2f ns/op  (%llu iters)\n", n, out.back().ns_per_op,
+                (unsigned long long)out.back().iterations);
+    std::fflush(stdout);
+  };
+
+  // --- lookupLine ---
+  {
+    Fixture f; uint64_t u = 0;
+    while (!f.c0.load(0x40, &u)) {}
+    add("lookup_hit", [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; ++i) { auto L = f.c0.lookupLine(0x40); do_not_optimize(L); }
+    });
+    add("lookup_miss", [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; ++i) { auto L = f.c0.lookupLine(0x40 + kSetStride); do_not_optimize(L); }
+    });
+  }
+
+  // --- load/store hits ---
+  {
+    Fixture f; uint64_t u = 0;
+    while (!f.c0.load(0x80, &u)) {}
+    add("load_hit", [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; ++i) { f.c0.load(0x80 + ((i & 3) << 3), &u); do_not_optimize(u); }
+    });
+    uint64_t v = 7;
+    while (!f.c0.store(0xA0, &v)) {}
+    add("store_hit", [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; ++i) { v = i; f.c0.store(0xA0 + ((i & 3) << 3), &v); }
+    });
+  }
+
+  // --- miss de conflicto: BusRd + emit + SharedMemory + onDataResponse ---
+  {
+    Fixture f; uint64_t u = 0;
+    const uint64_t a[3] = {0x00, kSetStride, 2 * kSetStride};
+    add("load_miss_roundtrip", [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; ++i) {
+        const uint64_t addr = a[i % 3];
+        while (!f.c0.load(addr, &u)) {}
+        do_not_optimize(u);
+      }
+    });
+  }
+
+  // --- ping-pong de escritura entre 2 PEs (BusRdX + Flush + Inv) ---
+  {
+    Fixture f; uint64_t v = 0;
+    add("store_pingpong_roundtrip", [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; ++i) {
+        MESICache& c = (i & 1) ? f.c1 : f.c0;
+        v = i;
+        while (!c.store(0x200, &v)) {}
+      }
+    });
+  }
+
+  // --- onSnoop ---
+  {
+    Fixture f; uint64_t u = 0;
+    while (!f.c0.load(0x300, &u)) {}
+    while (!f.c1.load(0x300, &u)) {}   // ambas en S: el snoop BusRd no cambia estado
+    const BusTransaction hit{BusMsg::BusRd, 0x300, nullptr, 0, 1};
+    const BusTransaction miss{BusMsg::BusRd, 0x300 + kSetStride, nullptr, 0, 1};
+    add("snoop_hit", [&](uint64_t n) { for (uint64_t i = 0; i < n; ++i) f.c0.onSnoop(hit); });
+    add("snoop_miss", [&](uint64_t n) { for (uint64_t i = 0; i < n; ++i) f.c0.onSnoop(miss); });
+  }
+
+  // --- SharedMemory::handle_message (línea de 32B) ---
+  {
+    SharedMemory shm;
+    add("shm_read32", [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; ++i) {
+        auto req = std::make_shared<Message>(MessageType::READ_MEM, -1, -1);
+        req->payload.read_mem.address = static_cast<uint32_t>((i & 63) * 32);
+        req->payload.read_mem.size    = 32;
+        shm.handle_message(req, [&](MessageP resp) { do_not_optimize(resp); });
+      }
+    });
+    std::vector<uint8_t> line(32, 0xAB);
+    add("shm_write32", [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; ++i) {
+        auto req = std::make_shared<Message>(MessageType::WRITE_MEM, -1, -1);
+        req->payload.write_mem.address = static_cast<uint32_t>((i & 63) * 32);
+        req->payload.write_mem.size    = 32;
+        req->data_write = line;
+        shm.handle_message(req, [&](MessageP resp) { do_not_optimize(resp); });
+      }
+    });
+  }
+
+  // --- Transferencias en bloque (inicialización / extracción de resultados) ---
+  {
+    Fixture f;
+    std::vector<double> v(SharedMemory::kDefaultBytes / 8, 1.5);
+    add("shm_write_block4k", [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; ++i) f.shm.write_doubles(0, v.data(), v.size());
+    });
+    DmaAgent dma(f.bus);
+    uint64_t w = 7;
+    add("dma_read_block4k", [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; ++i) {
+        while (!f.c0.store(0x100, &w)) {}   // dos líneas en M: el DMA las hace Flush
+        while (!f.c0.store(0x800, &w)) {}
+        dma.read_doubles(0, v.data(), v.size());
+      }
+    });
+  }
+
+  // --- PE::step sobre hits: bucle LOAD/FMUL/FADD/DEC/JNZ ---
+  {
+    Fixture f;
+    MesiMemoryPort mp(f.c0, f.bus);
+    Program p;
+    p.push_back({Op::LOAD,  4, 1, 0, 0});  // R4 = [R1]
+    p.push_back({Op::FMUL,  4, 4, 4, 0});  // R4 = R4*R4
+    p.push_back({Op::FADD,  3, 3, 4, 0});  // acc += R4
+    p.push_back({Op::DEC,   7, 0, 0, 0});
+    p.push_back({Op::JNZ,   7, 0, 0, -4});
+    p.push_back({Op::HALT,  0, 0, 0, 0});
+    PE pe(0, &mp);
+    pe.load_program(p);
+    pe.set_segment(0x100, 0x100, 0x100, ~0ull >> 1);
+    bool halted = false;
+    add("pe_step_hit", [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; ++i) pe.step(halted);
+      do_not_optimize(pe.regs());
+    });
+  }
+
+  // --- Escalado con hilos: hits sin locks en paralelo (seqlock por set) ---
+  {
+    constexpr int kMaxT = 4;
+    SharedMemory shm;
+    MesiInterconnect bus(0);
+    bus.set_shared_memory(&shm);
+    std::vector<std::unique_ptr<MESICache>> c;
+    for (int k = 0; k <= kMaxT; ++k) {
+      c.push_back(std::make_unique<MESICache>(k, bus));
+      bus.connect(c.back().get());
+    }
+    uint64_t u = 0;
+    for (int k = 0; k < kMaxT; ++k) {
+      while (!c[k]->load(uint64_t(k) * 32, &u)) {}   // set k: la línea de los hits
+      while (!c[k]->load(7 * 32, &u)) {}             // set 7: blanco de los snoops
+    }
+    // ns/op = tiempo / (n hits por hilo * T hilos)
+    auto par = [&](int T, bool snoops) {
+      return [&, T, snoops](uint64_t n) {
+        const uint64_t per = std::max<uint64_t>(1, n / uint64_t(T));
+        std::atomic<bool> done{false};
+        std::thread sn;
+        if (snoops)
+          sn = std::thread([&] {
+            uint64_t x = 0;
+            for (uint64_t i = 0; !done.load(std::memory_order_relaxed); ++i)
+              while (!c[kMaxT]->load(7 * 32 + (i % 3) * 256, &x)) {}
+          });
+        std::vector<std::thread> th;
+        for (int k = 0; k < T; ++k)
+          th.emplace_back([&, k] {
+            uint64_t x = 0;
+            const uint64_t a = uint64_t(k) * 32;
+            for (uint64_t i = 0; i < per; ++i) { c[k]->load(a + ((i & 3) << 3), &x); do_not_optimize(x); }
+          });
+        for (auto& t : th) t.join();
+        done = true;
+        if (sn.joinable()) sn.join();
+      };
+    };
+    add("par_load_hit_t1", par(1, false));
+    add("par_load_hit_t2", par(2, false));
+    add("par_load_hit_t4", par(4, false));
+    add("par_load_hit_snoop_t4", par(4, true));
+  }
+
+  return out;
+}
+
+// ---------------- JSON (escritura + lectura mínima del propio formato) ----------------
+static void write_json(const std::string& path, const std::vector<BenchResult>& rs) {
+  std::ofstream os(path);
+  os << "{\n  \"benchmarks\": [\n";
+  for (size_t i = 0; i < rs.size(); ++i) {
+    os << "    {\"name\": \"" << rs[i].name << "\", \"ns_per_op\": " << rs[i].ns_per_op
+       << ", \"iterations\": " << rs[i].iterations << "}" << (i + 1 < rs.size() ? "," : "") << "\n";
+  }
+  os << "  ]\n}\n";
+}
+
+// Lee pares name/ns_per_op del JSON generado por write_json (no es un parser general).
+static std::map<std::string, double> read_json(const std::string& path) {
+  std::map<std::string, double> m;
+  std::ifstream is(path);
+  if (!is) return m;
+  std::stringstream ss; ss << is.rdbuf();
+  const std::string s = ss.str();
+  size_t pos = 0;
+  while ((pos = s.find("\"name\"", pos)) != std::string::npos) {
+    size_t q1 = s.find('"', s.find(':', pos) + 1);
+    size_t q2 = s.find('"', q1 + 1);
+    size_t k  = s.find("\"ns_per_op\"", q2);
+    if (q1 == std::string::npos || q2 == std::string::npos || k == std::string::npos) break;
+    m[s.substr(q1 + 1, q2 - q1 - 1)] = std::strtod(s.c_str() + s.find(':', k) + 1, nullptr);
+    pos = k;
+  }
+  return m;
+}
+
+// Compara contra baseline; devuelve cuántos casos empeoraron más del umbral.
+static int compare(const std::vector<BenchResult>& rs,
+                   const std::map<std::string, double>& base, double threshold_pct) {
+  int regressions = 0;
+  std::printf("\n%-26s %12s %12s %9s\n", "benchmark", "base ns/op", "new ns/op", "delta");
+  for (const auto& r : rs) {
+    auto it = base.find(r.name);
+    if (it == base.end() || it->second <= 0) {
+      std::printf("%-26s %12s %12.2f %9s\n", r.name.c_str(), "-", r.ns_per_op, "new");
+      continue;
+    }
+    const double delta = 100.0 * (r.ns_per_op - it->second) / it->second;
+    const bool bad = delta > threshold_pct;
+    regressions += bad;
+    std::printf("%-26s %12.2f %12.2f %+8.1f%%%s\n", r.name.c_str(), it->second, r.ns_per_op,
+                delta, bad ? "  REGRESSION" : "");
+  }
+  return regressions;
+}
+
+int main(int argc, char** argv) {
+  BenchConfig cfg;
+  std::string json_out, baseline;
+  double threshold = 10.0;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string a(argv[i]);
+    if      (a.rfind("--filter=", 0) == 0)    cfg.filter = a.substr(9);
+    else if (a.rfind("--min-time=", 0) == 0)  cfg.min_time_ms = std::stod(a.substr(11));
+    else if (a.rfind("--reps=", 0) == 0)      cfg.reps = std::max(1, std::stoi(a.substr(7)));
+    else if (a.rfind("--json=", 0) == 0)      json_out = a.substr(7);
+    else if (a.rfind("--baseline=", 0) == 0)  baseline = a.substr(11);
+    else if (a.rfind("--threshold=", 0) == 0) threshold = std::stod(a.substr(12));
+    else {
+      std::fprintf(stderr, "Uso: %s [--filter=s] [--min-time=ms] [--reps=R] "
+                           "[--json=out.json] [--baseline=base.json] [--threshold=pct]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  auto results = run_all(cfg);
+  if (!json_out.empty()) {
+    write_json(json_out, results);
+    std::printf("Resultados guardados en %s\n", json_out.c_str());
+  }
+
+  if (!baseline.empty()) {
+    auto base = read_json(baseline);
+    if (base.empty()) {
+      std::fprintf(stderr, "No se pudo leer baseline %s\n", baseline.c_str());
+      return 2;
+    }
+    const int bad = compare(results, base, threshold);
+    if (bad) {
+      std::printf("%d regresion(es) sobre el umbral de %.1f%%\n", bad, threshold);
+      return 1;
+    }
+    std::puts("Sin regresiones");
+  }
+  return 0;
+}
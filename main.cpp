@@ -1,11 +1,17 @@
 /*
  * main.cpp (unificado)
  * --------------------
- * Ejecutable con dos modos:
- *   1) --mode=dot  : corre el producto punto en doble precisión con 4 PEs,
+ * Ejecutable con cuatro modos:
+ *   1) --mode=dot  : corre el producto punto en doble precisión con 4 PEs (--pes=P),
  *                    usando L1$ MESI + Interconnect + SharedMemory. Exporta métricas a CSV.
+ *                    Con --record-trace=f graba los accesos de cada PE (ver src/trace/).
  *   2) --mode=demo : igual que dot, pero habilita stepping del BUS (si Stepper está integrado)
  *                    para visualizar las emisiones BusRd/BusRdX/BusUpgr/Flush y los snoops.
+ *                    Con --watch=SPEC solo se detiene cuando se cumple un watchpoint
+ *                    (dirección, evento, PE, transición MESI, cada N) y muestra diffs.
+ *   3) --mode=trace: reproduce una traza (--trace=f) directo sobre las L1$, sin PE::step.
+ *   4) --mode=sync : producto punto multi-fase (parciales -> barrera -> allreduce -> barrera)
+ *                    sincronizado DENTRO del simulador con --barrier=central|tree|dissem|hw.
  *
  * Estructura general:
  *  - SharedMemory: memoria compartida “DRAM” del modelo.
@@ -21,6 +27,63 @@
  *  - Cada PE procesa N/4 (o N/4±1 si N%4!=0) y escribe su parcial en su propia línea (evita false sharing).
  *  - Junta los 4 parciales y valida contra la fórmula cerrada.
  *  - Exporta métricas de cada L1$ a cache_stats.csv (para graficar luego).
+ *  - Con --fsd clasifica cada invalidación como true/false sharing y escribe
+ *    false_sharing.csv (--packed-partials junta los 4 parciales en UNA línea para verlo).
+ *  - Con --mrc perfila la reuse distance de cada PE y escribe mrc.csv (curva miss-ratio
+ *    de FA-LRU para todas las capacidades; también en --mode=sync y --mode=trace).
+ *  - Con --checkpoint=f guarda el estado completo (memoria, L1$, bus, PEs) tras
+ *    --checkpoint-at=S instrucciones por PE; --restore=f continúa desde ese punto.
+ *    --forks=K bifurca K variantes en memoria (copy-on-write) en ese punto y las
+ *    corre en paralelo con la original.
+ *  - Con --metrics=tcp:9464 (o unix:/ruta) un hilo sirve los contadores en vivo
+ *    (GET /metrics en formato Prometheus, GET /json); --metrics-linger=S lo mantiene
+ *    S segundos tras terminar para que el dashboard lea los valores finales.
+ *  - Con --timeline=f se escriben en f (JSON lines) todos los contadores por PE y
+ *    del bus cada --timeline-every=K accesos (o K ciclos con "Kc"); la muestra la
+ *    dispara el acceso que cruza cada múltiplo de K. Sirve para ver las fases de
+ *    la corrida; metrics.py grafica tasa de miss y tráfico en el tiempo.
+ *  - Con --sample=U:W[:C] corre muestreado (SMARTS): avance funcional directo sobre
+ *    SharedMemory y, cada U instrucciones por PE, C de calentamiento + W medidas en
+ *    detalle; informa tasa de miss, CPI y ciclos con intervalo de confianza del 95%.
+ *    La memoria crece para admitir N grandes; --no-warming desactiva el
+ *    calentamiento funcional de las L1$.
+ *  - --index=xor|prime|skew cambia la función de índice de set de las L1$ (por
+ *    defecto corte de bits); --set-stats informa accesos/misses por set y su
+ *    desbalance y escribe cache_sets.csv (en todos los modos).
+ *  - --arb=fcfs|rr|prio|age pone un árbitro explícito en el bus (también en
+ *    --mode=sync) e informa la espera por PE (media, p50/p99, máxima), la
+ *    inanición y la utilización del bus en el tiempo (bus_wait.csv, bus_util.csv).
+ *    --pes=P cambia el número de PEs del modo dot para medir la escalabilidad.
+ *  - --numa=C[:G] reparte los PEs del modo dot en C clusters (un bus local cada
+ *    uno) unidos por un directorio global; la memoria se intercala entre nodos en
+ *    bloques de G bytes y --placement=local fija en su nodo los tramos de cada PE.
+ *    Informa pedidos y latencia local/remota por nodo (numa.csv).
+ *  - --noc=ring|mesh[:COLS] traduce las transacciones del modo dot a paquetes
+ *    por un anillo o una malla 2D (un tile por PE) e informa latencia por PE,
+ *    tráfico por clase y VC y el mapa de uso de enlaces (noc_links.csv).
+ *  - --dram=fcfs|frfcfs pone un controlador DRAM (canales, ranks, bancos con
+ *    buffer de fila, refresco) detrás de SharedMemory en dot, sync y trace;
+ *    --page=open|closed, --dram-map=RoRaBaCoCh y --dram-geom=C:R:B lo configuran.
+ *    Informa tasa de aciertos de fila, latencia media y ancho de banda (dram.csv).
+ *  - --write-policy=wb|wb-na|wt|wt-na cambia la política de escritura de las L1$
+ *    (write-back/write-through, con o sin write-allocate). --store-out cambia el
+ *    kernel del modo dot por C[i] = A[i]*B[i] (salida en flujo, el host suma C);
+ *    --out-policy=P aplica otra política solo a C y --nt escribe C con STNT
+ *    (líneas completas sin read-for-ownership). Informa transacciones y bytes
+ *    de datos por el bus por elemento escrito.
+ *  - --record-grants=f graba el orden global de concesiones del bus (dot y sync)
+ *    en un log compacto; --replay-grants=f lo impone en otra corrida (cada PE
+ *    espera su turno antes de arbitrar) e informa si se repitió la misma
+ *    secuencia de transacciones (hash) o en qué medida divergió.
+ *  - --vm da a los PEs de dot y sync direcciones virtuales: tabla de páginas de 4
+ *    niveles en la memoria simulada, una TLB por PE (--tlb=E[:W] para páginas de
+ *    4 KiB, --tlb-huge=E[:W] para las de 2 MiB) y page walks que leen las PTEs
+ *    por la L1$. --huge mapea los datos con páginas de 2 MiB. Informa tasa de
+ *    fallos de TLB, PTEs leídas y ciclos por recorrido (tlb.csv).
+ *  - Cada L1$ registra la latencia de sus BusRd/BusRdX/BusUpgr/Flush (ciclos del
+ *    modelo y ns del host) en histogramas log-lineales; junto a cache_stats.csv se
+ *    escriben cache_latency.csv (p50/p99/p999 por PE y tipo, más el total) y
+ *    cache_latency_hist.csv (cubos). --lat-stats imprime el total por tipo.
  *
  * Notas importantes:
  *  - Bus “síncrono” simplificado: la primera llamada a cache_.load/store puede devolver false
@@ -40,79 +103,220 @@
 #include <fstream>
 #include <string>
 #include <memory>
+#include <algorithm>
+#include <optional>
 
 #include "../src/MesiInterconnect.hpp"
 #include "../src/memory/SharedMemory.h"
 #include "../src/memory/cache/mesi/MESICache.hpp"
 #include "../src/utils/Stepper.hpp"   //  Visualizador del BUS (opcional en --mode=demo)
+#include "../src/MesiMemoryPort.hpp"   // PortMetrics + MesiMemoryPort (IMemoryPort sobre la L1$)
+#include "../src/trace/Trace.hpp"
+#include "../src/trace/TraceReplayer.hpp"
+#include "../src/sync/Barriers.hpp"
+#include "../src/analysis/FalseSharingDetector.hpp"
+#include "../src/analysis/ReuseDistance.hpp"
+#include "../src/telemetry/MetricsExporter.hpp"
+#include "../src/telemetry/IntervalSampler.hpp"
+#include "../src/checkpoint/Checkpoint.hpp"
+#include "../src/checkpoint/Fork.hpp"
+#include "../src/sampling/Sampler.hpp"
+#include "../src/dma/DmaAgent.hpp"
+#include "../src/bus/BusArbiter.hpp"
+#include "../src/bus/GrantLog.hpp"
+#include "../src/numa/NumaDirectory.hpp"
+#include "../src/noc/NocModel.hpp"
+#include "../src/memory/dram/DramController.hpp"
+#include "../src/vm/Mmu.hpp"
+#include <chrono>
+#include <ctime>
 #include "../PE/pe/pe.hpp"
 
-// ---------------- Métricas simples por puerto ----------------
-// Contadores del “front-end” (llamadas del PE al puerto). Son independientes
-// de las métricas internas de la caché (misses, invalidations, etc.).
-struct PortMetrics { uint64_t loads=0, stores=0; };
+// ---------------- Entradas y resultados en bloque ----------------
+// A[i] = i+1 y B[i] = 0.5*(i+1) se arman en el host y se copian a SharedMemory con
+// una escritura en bloque (sin pasar por la caché). El cómputo de los PEs SIEMPRE
+// pasa por la L1$; los resultados se extraen con DmaAgent (coherente con las L1$).
+// Accesos del host a direcciones del programa: con --vm ('as' != nullptr) son
+// virtuales y se parten por páginas con la traducción del AddressSpace.
+static void host_write(SharedMemory& shm, const AddressSpace* as, uint64_t va, const void* in, size_t n) {
+  if (!as) { shm.write_block(va, in, n); return; }
+  as->split(va, n, [&](uint64_t pa, size_t off, size_t len) {
+    shm.write_block(pa, static_cast<const uint8_t*>(in) + off, len);
+  });
+}
+
+static void dma_read(DmaAgent& dma, const AddressSpace* as, uint64_t va, void* out, size_t n) {
+  if (!as) { dma.read(va, out, n); return; }
+  as->split(va, n, [&](uint64_t pa, size_t off, size_t len) {
+    dma.read(pa, static_cast<uint8_t*>(out) + off, len);
+  });
+}
+
+static void init_dot_inputs(SharedMemory& shm, uint64_t baseA, uint64_t baseB, size_t N,
+                            const AddressSpace* as = nullptr) {
+  std::vector<double> a(N), b(N);
+  for (size_t i=0; i<N; ++i) { a[i] = double(i+1); b[i] = 0.5*double(i+1); }
+  host_write(shm, as, baseA, a.data(), N * 8);
+  host_write(shm, as, baseB, b.data(), N * 8);
+}
+
+static double dma_read_double(DmaAgent& dma, uint64_t addr, const AddressSpace* as = nullptr) {
+  double d = 0.0;
+  dma_read(dma, as, addr, &d, 8);
+  return d;
+}
 
-// ---------------- IMemoryPort respaldado por la caché MESI ----------------
-// Adapta la L1$ MESI a la interfaz del PE. Implementa load64/store64 a 8B.
-class MesiMemoryPort : public IMemoryPort {
-public:
-  MesiMemoryPort(MESICache& c, MesiInterconnect& ic, PortMetrics* pm=nullptr)
-  : cache_(c), ic_(ic), pm_(pm) {}
+// ---------------- Latencia por transacción ----------------
+// Percentiles por PE y tipo de transacción (ciclos del modelo y ns del host) y
+// la fila "all" con los histogramas de todas las L1$ sumados; los cubos no
+// vacíos van a cache_latency_hist.csv para graficar la distribución completa.
+using LatTable = std::vector<std::array<LatencyHistogram, MESICache::kLatKinds>>;
 
-  // Lee 8 bytes coherentemente. Si la caché devuelve false, es porque emitió BusRd.
-  // En este modelo, el segundo intento ya es hit (onDataResponse).
-  uint64_t load64(uint64_t addr) override {
-    if (pm_) pm_->loads++;
-    uint64_t u = 0;
-    while (!cache_.load(addr, &u)) { /* bus síncrono: segundo intento ya es hit */ }
-    return u;
+static void merge_latency(const std::vector<const MESICache*>& caches, LatTable& cyc, LatTable& ns) {
+  cyc.assign(caches.size() + 1, {});
+  ns.assign(caches.size() + 1, {});
+  for (size_t pe = 0; pe < caches.size(); ++pe)
+    for (int k = 0; k < MESICache::kLatKinds; ++k) {
+      cyc[pe][k] = caches[pe]->stats().lat_cycles[k];
+      ns[pe][k]  = caches[pe]->stats().lat_ns[k];
+      cyc.back()[k].merge(cyc[pe][k]);
+      ns.back()[k].merge(ns[pe][k]);
+    }
+}
+
+static void export_latency_csv(const std::vector<const MESICache*>& caches,
+                               const char* path = "cache_latency.csv",
+                               const char* hist_path = "cache_latency_hist.csv") {
+  LatTable cyc, ns;
+  merge_latency(caches, cyc, ns);
+  std::ofstream csv(path), hist(hist_path);
+  csv << "PE,Type,Unit,Count,Mean,P50,P99,P999,Max\n";
+  hist << "PE,Type,Unit,Low,High,Count\n";
+  for (size_t pe = 0; pe < cyc.size(); ++pe) {
+    const std::string who = pe + 1 < cyc.size() ? std::to_string(pe) : "all";
+    for (int k = 0; k < MESICache::kLatKinds; ++k)
+      for (const auto* t : {&cyc, &ns}) {
+        const LatencyHistogram& h = (*t)[pe][k];
+        const char* unit = t == &cyc ? "cycles" : "ns";
+        csv << who << "," << MESICache::latKindName(k) << "," << unit << ","
+            << h.count() << "," << h.mean() << "," << h.percentile(0.50) << ","
+            << h.percentile(0.99) << "," << h.percentile(0.999) << "," << h.max() << "\n";
+        for (int b = 0; b < LatencyHistogram::kBuckets; ++b)
+          if (const uint64_t n = h.bucket_count(b))
+            hist << who << "," << MESICache::latKindName(k) << "," << unit << ","
+                 << LatencyHistogram::bucket_low(b) << "," << LatencyHistogram::bucket_high(b)
+                 << "," << n << "\n";
+      }
   }
+}
 
-  // Escribe 8 bytes coherentemente. Si devuelve false, la caché emitió BusRdX/Upgr.
-  void store64(uint64_t addr, uint64_t val) override {
-    if (pm_) pm_->stores++;
-    while (!cache_.store(addr, &val)) { /* write-allocate */ }
+static void report_latency(const std::vector<const MESICache*>& caches) {
+  LatTable cyc, ns;
+  merge_latency(caches, cyc, ns);
+  std::printf("latencia por transacción (todas las L1$; detalle por PE en cache_latency.csv):\n"
+              "  tipo       cantidad | ciclos p50    p99   p999    máx | ns p50      p99     p999      máx\n");
+  for (int k = 0; k < MESICache::kLatKinds; ++k) {
+    const LatencyHistogram& c = cyc.back()[k];
+    const LatencyHistogram& h = ns.back()[k];
+    std::printf("  %-8s %10llu | %10llu %6llu %6llu %6llu | %6llu %8llu %8llu %8llu\n",
+                MESICache::latKindName(k), (unsigned long long)c.count(),
+                (unsigned long long)c.percentile(0.50), (unsigned long long)c.percentile(0.99),
+                (unsigned long long)c.percentile(0.999), (unsigned long long)c.max(),
+                (unsigned long long)h.percentile(0.50), (unsigned long long)h.percentile(0.99),
+                (unsigned long long)h.percentile(0.999), (unsigned long long)h.max());
   }
+}
 
-  // Un bus asíncrono podría requerir “bombear” colas aquí.
-  void service() override { /* vacío para bus síncrono */ }
+// ---------------- Exportar métricas de cada L1$ a CSV ----------------
+// Formato común de todos los modos (lo consume metrics.py).
+static void export_cache_csv(const std::vector<const MESICache*>& caches,
+                             const char* path = "cache_stats.csv") {
+  export_latency_csv(caches);
+  std::ofstream csv(path);
+  csv << "PE,Loads,Stores,RW_Accesses,Cache_Misses,Invalidations,"
+         "BusRd,BusRdX,BusUpgr,Flush,Atomics,CAS_Failures,SC_Failures,"
+         "Atomic_BusOps,Atomic_Bus_ns,Waits,Wait_Checks,Wait_Sleeps,"
+         "Miss_Compulsory,Miss_Capacity,Miss_Conflict,Miss_Coherence,"
+         "Bus_Writes,Write_Arounds,NT_Stores,NT_Lines,Transitions\n";
 
-private:
-  MESICache&        cache_;
-  MesiInterconnect& ic_;
-  PortMetrics*      pm_;
-};
+  for (size_t pe = 0; pe < caches.size(); ++pe) {
+      const MESICache& cache = *caches[pe];
+      const auto& s = cache.stats();
+      csv << pe << ","
+          << s.loads << ","
+          << s.stores << ","
+          << (s.loads + s.stores) << ","
+          << s.cache_misses << ","
+          << s.invalidations << ","
+          << s.busRd << ","
+          << s.busRdX << ","
+          << s.busUpgr << ","
+          << s.flush << ","
+          << s.atomics << ","
+          << s.cas_failures << ","
+          << s.sc_failures << ","
+          << s.atomic_bus_ops << ","
+          << s.atomic_bus_ns << ","
+          << s.waits << ","
+          << s.wait_checks << ","
+          << s.wait_sleeps << ","
+          << s.miss_compulsory << ","
+          << s.miss_capacity << ","
+          << s.miss_conflict << ","
+          << s.miss_coherence << ","
+          << s.bus_writes << ","
+          << s.write_arounds << ","
+          << s.nt_stores << ","
+          << s.nt_lines << ",\""
+          << cache.transition_log() << "\"\n";
+  }
+}
 
-// ---------------- Helpers SharedMemory (acceso directo de 8B) ----------------
-// Se usan para inicializar/verificar memoria compartida sin pasar por la caché.
-// El cómputo de los PEs SIEMPRE pasa por la L1$ a través del MesiMemoryPort.
-static inline void shm_write_double(SharedMemory& shm, uint64_t addr, double v) {
-  uint64_t u; std::memcpy(&u, &v, 8);
-  auto req = std::make_shared<Message>(MessageType::WRITE_MEM, -1, -1);
-  req->payload.write_mem.address = static_cast<uint32_t>(addr);
-  req->payload.write_mem.size    = 8;
-  req->data_write.resize(8);
-  for (int i=0;i<8;++i) req->data_write[i] = static_cast<uint8_t>((u >> (i*8)) & 0xFF);
-  shm.handle_message(req, [&](MessageP){});
-}
-
-static inline double shm_read_double(SharedMemory& shm, uint64_t addr) {
-  auto req = std::make_shared<Message>(MessageType::READ_MEM, -1, -1);
-  req->payload.read_mem.address = static_cast<uint32_t>(addr);
-  req->payload.read_mem.size    = 8;
-  double d = 0.0;
-  shm.handle_message(req, [&](MessageP resp){
-    if (resp && resp->type == MessageType::READ_RESP &&
-        resp->payload.read_resp.status && resp->read_resp_data.size() == 8) {
-      std::memcpy(&d, resp->read_resp_data.data(), 8);
+// ---------------- Distribución por set (--set-stats) ----------------
+// Accesos completados y líneas traídas por set, sumados sobre las L1$, con el
+// desbalance (máximo / media de accesos); detalle por PE en cache_sets.csv.
+static void report_sets(const std::vector<const MESICache*>& caches,
+                        const char* path = "cache_sets.csv") {
+  constexpr int S = MESICache::kSets;
+  uint64_t acc[S] = {}, miss[S] = {};
+  std::ofstream csv(path);
+  csv << "PE,Set,Accesses,Misses\n";
+  for (size_t pe = 0; pe < caches.size(); ++pe) {
+    const auto& st = caches[pe]->stats();
+    for (int s = 0; s < S; ++s) {
+      acc[s]  += st.set_accesses[s];
+      miss[s] += st.set_misses[s];
+      csv << pe << "," << s << "," << st.set_accesses[s] << "," << st.set_misses[s] << "\n";
     }
-  });
-  return d;
+  }
+
+  const IndexFn fn = caches.empty() ? IndexFn::Bits : caches[0]->indexFunction();
+  uint64_t total = 0, peak = 0;
+  int unused = 0;
+  std::printf("sets (índice %s):\n  set   accesos    misses  miss%%\n", index_fn::name(fn));
+  for (int s = 0; s < S; ++s) {
+    total += acc[s];
+    peak = std::max(peak, acc[s]);
+    unused += (acc[s] == 0 && miss[s] == 0);
+    std::printf("  %3d %9llu %9llu %6.2f\n", s, (unsigned long long)acc[s],
+                (unsigned long long)miss[s], acc[s] ? 100.0 * double(miss[s]) / double(acc[s]) : 0.0);
+  }
+  std::printf("  desbalance = %.2f (máx/media), %d sets sin uso; detalle en %s\n",
+              total ? double(peak) * S / double(total) : 0.0, unused, path);
 }
 
 // ---------------- Programa de dot product (mini-ISA) ----------------
 // R0=i, R1=baseA, R2=baseB, R3=acc, R5=partial_out, R7=limit; temporales R4,R6
-static Program make_dot_program() {
+//
+// Estrategia de reducción final (--reduce=...):
+//   host : cada PE guarda su parcial en su propia línea; el host suma tras join().
+//   fadd : FETCH_FADD del acumulador sobre el resultado compartido [R5].
+//   cas  : bucle LOAD / FADD / CAS hasta que nadie haya escrito entre medio.
+//   llsc : bucle LL / FADD / SC hasta que la reserva sobreviva.
+//   lock : spinlock con CAS en [R1] (línea propia) + LOAD/FADD/STORE protegidos.
+enum class Reduce { Host, FetchFAdd, Cas, LlSc, Lock };
+
+static Program make_dot_program(Reduce reduce = Reduce::Host, uint64_t lock_addr = 0) {
   Program p;
   p.push_back({Op::LEA,   4, 1, 0, 3}); // R4 = &A[i]
   p.push_back({Op::LEA,   6, 2, 0, 3}); // R6 = &B[i]
@@ -123,67 +327,715 @@ static Program make_dot_program() {
   p.push_back({Op::INC,   0, 0, 0, 0});
   p.push_back({Op::DEC,   7, 0, 0, 0});
   p.push_back({Op::JNZ,   7, 0, 0,-8});
-  p.push_back({Op::STORE, 3, 5, 0, 0}); // [partial_out] = acc
+
+  switch (reduce) {
+    case Reduce::Host:
+      p.push_back({Op::STORE, 3, 5, 0, 0});       // [partial_out] = acc
+      break;
+    case Reduce::FetchFAdd:
+      p.push_back({Op::FETCH_FADD, 4, 5, 3, 0});  // [R5] += acc (atómico)
+      break;
+    case Reduce::Cas:
+      p.push_back({Op::LI,    0, 0, 0, 0});       // R0 = 0 (para copiar con LEA)
+      p.push_back({Op::LOAD,  4, 5, 0, 0});       // R4 = esperado = [R5]
+      p.push_back({Op::FADD,  6, 4, 3, 0});       // R6 = esperado + acc
+      p.push_back({Op::LEA,   1, 4, 0, 0});       // R1 = copia de esperado
+      p.push_back({Op::CAS,   4, 5, 6, 0});       // R4 = valor visto
+      p.push_back({Op::SUB,   4, 4, 1, 0});       // 0 si el CAS escribió
+      p.push_back({Op::JNZ,   4, 0, 0,-5});       // reintentar
+      break;
+    case Reduce::LlSc:
+      p.push_back({Op::LL,    4, 5, 0, 0});       // R4 = [R5] (reserva)
+      p.push_back({Op::FADD,  4, 4, 3, 0});       // R4 += acc
+      p.push_back({Op::SC,    6, 5, 4, 0});       // R6 = 0 si éxito
+      p.push_back({Op::JNZ,   6, 0, 0,-3});
+      break;
+    case Reduce::Lock:
+      p.push_back({Op::LI,    1, 0, 0, (int64_t)lock_addr}); // R1 = &lock
+      p.push_back({Op::LI,    4, 0, 0, 0});       // esperado = 0 (libre)
+      p.push_back({Op::LI,    6, 0, 0, 1});       // nuevo = 1 (tomado)
+      p.push_back({Op::CAS,   4, 1, 6, 0});       // R4 = valor previo del lock
+      p.push_back({Op::JNZ,   4, 0, 0,-3});       // ocupado => reintentar
+      p.push_back({Op::LOAD,  4, 5, 0, 0});       // sección crítica
+      p.push_back({Op::FADD,  4, 4, 3, 0});
+      p.push_back({Op::STORE, 4, 5, 0, 0});
+      p.push_back({Op::LI,    6, 0, 0, 0});
+      p.push_back({Op::STORE, 6, 1, 0, 0});       // liberar lock
+      break;
+  }
   p.push_back({Op::HALT,  0, 0, 0, 0});
   return p;
 }
 
+// ---------------- Programa de salida en flujo (--store-out) ----------------
+// C[i] = A[i]*B[i]: R0=i, R1=baseA, R2=baseB, R5=&C del tramo, R7=limit; temporales
+// R4,R6. Con --nt los stores son STNT y un FENCE final publica los buffers de
+// write-combining antes de terminar.
+static Program make_mul_program(bool nt) {
+  Program p;
+  p.push_back({Op::LEA,   4, 1, 0, 3}); // R4 = &A[i]
+  p.push_back({Op::LEA,   6, 2, 0, 3}); // R6 = &B[i]
+  p.push_back({Op::LOAD,  4, 4, 0, 0}); // A[i]
+  p.push_back({Op::LOAD,  6, 6, 0, 0}); // B[i]
+  p.push_back({Op::FMUL,  4, 4, 6, 0}); // t = A[i]*B[i]
+  p.push_back({Op::LEA,   6, 5, 0, 3}); // R6 = &C[i]
+  p.push_back({nt ? Op::STNT : Op::STORE, 4, 6, 0, 0}); // C[i] = t
+  p.push_back({Op::INC,   0, 0, 0, 0});
+  p.push_back({Op::DEC,   7, 0, 0, 0});
+  p.push_back({Op::JNZ,   7, 0, 0,-9});
+  if (nt) p.push_back({Op::FENCE, 0, 0, 0, 0});
+  p.push_back({Op::HALT,  0, 0, 0, 0});
+  return p;
+}
+
+static bool parse_reduce(const std::string& s, Reduce& out) {
+  if (s == "host") out = Reduce::Host;
+  else if (s == "fadd") out = Reduce::FetchFAdd;
+  else if (s == "cas")  out = Reduce::Cas;
+  else if (s == "llsc") out = Reduce::LlSc;
+  else if (s == "lock") out = Reduce::Lock;
+  else return false;
+  return true;
+}
+
+// ---------------- Opciones de ejecución (flags de línea de comandos) ----------------
+struct RunOptions {
+  size_t      N = 248;              // tamaño de los vectores
+  std::string record_trace;         // --record-trace=f : graba los accesos de los PEs
+  bool        trace_compress = false; // --trace-compress : chunks de traza con zlib
+  std::string trace_in;             // --trace=f        : traza a reproducir en --mode=trace
+  unsigned    quantum = 1;          // --quantum=Q      : accesos por turno en la reproducción
+  Reduce      reduce = Reduce::Host;  // --reduce=host|fadd|cas|llsc|lock
+  BarrierKind barrier = BarrierKind::Central; // --barrier=central|tree|dissem|hw (modo sync)
+  unsigned    rounds = 3;           // --rounds=R : rondas de (parcial, barrera, allreduce, barrera)
+  bool        spin_wait = false;    // --wait=spin : WAIT por sondeo (comparar con sleep)
+  bool        fsd = false;          // --fsd : detector de false sharing + false_sharing.csv
+  bool        packed_partials = false; // --packed-partials : parciales contiguos (misma línea)
+  bool        mrc = false;          // --mrc : perfil de reuse distance por PE + mrc.csv
+  double      mrc_rate = 1.0;       // --mrc-rate=R : muestreo SHARDS (1.0 = exacto)
+  std::string metrics_endpoint;     // --metrics=tcp:PUERTO|unix:RUTA : exportador en vivo
+  double      metrics_linger = 0.0; // --metrics-linger=S : seguir sirviendo S s al final
+  std::string timeline;             // --timeline=f : serie temporal de contadores (JSON lines)
+  TimelineConfig timeline_cfg;      //   --timeline-every=K[c] : cada K accesos (o K ciclos)
+  std::vector<std::string> watches; // --watch=SPEC (repetible) : watchpoints del stepper (demo)
+  std::string checkpoint_out;       // --checkpoint=f : guarda el estado tras --checkpoint-at pasos
+  uint64_t    checkpoint_at = 1000; // --checkpoint-at=S : instrucciones por PE antes de guardar
+  std::string restore;              // --restore=f : continúa desde un checkpoint (modo dot)
+  unsigned    forks = 0;            // --forks=K : K variantes COW desde --checkpoint-at (modo dot)
+  bool        sampled = false;      // --sample=U:W[:C] : simulación muestreada (modo dot)
+  SamplingConfig sampling;          //   U = period, W = window, C = warmup; --no-warming
+  IndexFn     index = IndexFn::Bits; // --index=bits|xor|prime|skew : índice de set de las L1$
+  bool        set_stats = false;    // --set-stats : accesos/misses por set + cache_sets.csv
+  bool        lat_stats = false;    // --lat-stats : percentiles de latencia por tipo de transacción
+  ArbPolicy   arb = ArbPolicy::None; // --arb=none|fcfs|rr|prio|age : árbitro del bus
+  int         pes = 4;              // --pes=P : PEs en el modo dot
+  int         numa_nodes = 1;       // --numa=C[:G] : C clusters (modo dot), intercalado de G bytes
+  size_t      numa_interleave = SharedMemory::kPageBytes;
+  bool        numa_local = false;   // --placement=local : tramos de cada PE en su nodo
+  bool        noc = false;          // --noc=ring|mesh[:COLS] : modelo de red en chip (modo dot)
+  NocConfig   noc_cfg;              //   --noc-hop=H, --noc-flit=B
+  WritePolicy write_policy = WritePolicy::WriteBack; // --write-policy=wb|wb-na|wt|wt-na : L1$
+  bool        store_out = false;    // --store-out : el modo dot escribe C[i] = A[i]*B[i]
+  bool        nt_stores = false;    // --nt : C con stores no temporales (STNT)
+  bool        out_policy_set = false; // --out-policy=P : política de escritura de la región C
+  WritePolicy out_policy = WritePolicy::WriteBack;
+  bool        dram = false;         // --dram=fcfs|frfcfs : controlador DRAM detrás de SharedMemory
+  DramConfig  dram_cfg;             //   --page=open|closed, --dram-map=M, --dram-geom=C:R:B
+  std::string record_grants;        // --record-grants=f : graba el orden de concesiones del bus
+  std::string replay_grants;        // --replay-grants=f : impone el orden grabado (dot, sync)
+  bool        vm = false;           // --vm : direcciones virtuales, TLB por PE (dot, sync)
+  bool        huge_pages = false;   // --huge : mapea los datos con páginas de 2 MiB
+  TlbConfig   tlb;                  //   --tlb=E[:W], --tlb-huge=E[:W]
+};
+
+// --dram-geom=C:R:B : canales, ranks y bancos por rank
+static bool parse_dram_geom(const std::string& s, DramConfig& cfg) {
+  const size_t a = s.find(':');
+  const size_t b = a == std::string::npos ? a : s.find(':', a + 1);
+  if (b == std::string::npos) return false;
+  try {
+    cfg.channels = std::stoi(s.substr(0, a));
+    cfg.ranks = std::stoi(s.substr(a + 1, b - a - 1));
+    cfg.banks = std::stoi(s.substr(b + 1));
+  } catch (const std::exception&) {
+    return false;
+  }
+  return true;
+}
+
+static bool parse_numa(const std::string& s, RunOptions& opt) {
+  const size_t c = s.find(':');
+  try {
+    opt.numa_nodes = std::stoi(s.substr(0, c));
+    if (c != std::string::npos) opt.numa_interleave = std::stoull(s.substr(c + 1));
+  } catch (const std::exception&) {
+    return false;
+  }
+  return opt.numa_nodes >= 1 && opt.numa_nodes <= 32 && opt.numa_interleave > 0 &&
+         opt.numa_interleave % SharedMemory::kPageBytes == 0;
+}
+
+static bool parse_sample(const std::string& s, SamplingConfig& cfg) {
+  const size_t a = s.find(':');
+  if (a == std::string::npos) return false;
+  const size_t b = s.find(':', a + 1);
+  try {
+    cfg.period = std::stoull(s.substr(0, a));
+    cfg.window = std::stoull(s.substr(a + 1, b == std::string::npos ? std::string::npos : b - a - 1));
+    if (b != std::string::npos) cfg.warmup = std::stoull(s.substr(b + 1));
+    else cfg.warmup = std::min(cfg.warmup, cfg.period - std::min(cfg.period, cfg.window));
+  } catch (const std::exception&) {
+    return false;
+  }
+  return cfg.window > 0 && cfg.warmup + cfg.window <= cfg.period;
+}
+
+// Estimaciones de la simulación muestreada (--sample)
+static void report_sampling(const SamplingReport& r, const SamplingConfig& cfg, double secs) {
+  std::printf("\n=== Simulación muestreada (U=%llu, W=%llu, calentamiento %llu%s) ===\n",
+              (unsigned long long)cfg.period, (unsigned long long)cfg.window,
+              (unsigned long long)cfg.warmup, cfg.functional_warming ? " + funcional" : "");
+  std::printf("  instrucciones: %llu (%.1f%% en detalle), %llu ventanas, %.3f s\n",
+              (unsigned long long)r.instructions,
+              r.instructions ? 100.0 * double(r.detailed_instructions) / double(r.instructions) : 0.0,
+              (unsigned long long)r.windows, secs);
+  std::printf("  tasa de miss:  %.4f ± %.4f\n", r.miss_rate.mean, r.miss_rate.half);
+  std::printf("  CPI:           %.3f ± %.3f\n", r.cpi.mean, r.cpi.half);
+  std::printf("  ciclos por PE: %.0f ± %.0f\n", r.cycles.mean, r.cycles.half);
+}
+
+// Resultado de cada fork (--forks=K): suma de parciales, misses y páginas aún compartidas
+static void report_forks(const std::vector<std::unique_ptr<SimFork>>& forks,
+                         const std::vector<uint64_t>& oK, int partials) {
+  for (size_t k = 0; k < forks.size(); ++k) {
+    SimFork& f = *forks[k];
+    DmaAgent dma(f.bus);
+    double sum = 0.0;
+    for (int p = 0; p < partials; ++p) sum += dma_read_double(dma, oK[p]);
+    int misses = 0, inval = 0;
+    for (const auto& c : f.caches) { misses += c->stats().cache_misses; inval += c->stats().invalidations; }
+    std::printf("fork %zu: result = %.17g, misses = %d, invalidaciones = %d, "
+                "páginas compartidas = %zu/%zu\n", k, sum, misses, inval,
+                f.shm->shared_pages(), f.shm->page_count());
+  }
+}
+
+// Árbitro explícito del bus (--arb=...). Con None el bus queda como siempre.
+static void apply_arbiter(const RunOptions& opt, MesiInterconnect& bus) {
+  if (opt.arb != ArbPolicy::None) bus.set_arbiter(std::make_unique<BusArbiter>(opt.arb));
+}
+
+// Contención del bus (--arb): espera por solicitante, inanición y utilización
+// en el tiempo; histogramas en bus_wait.csv y línea de tiempo en bus_util.csv.
+static void report_arbiter(const BusArbiter::Report& r,
+                           const char* wait_path = "bus_wait.csv",
+                           const char* util_path = "bus_util.csv") {
+  std::printf("\n=== Bus (árbitro %s): utilización %.1f%% (%.3f de %.3f ms) ===\n",
+              arb_policy_name(r.policy), 100.0 * r.utilization(), r.busy_ns / 1e6, r.elapsed_ns / 1e6);
+  std::printf("   PE  concesiones  espera media    p50      p99   máxima (ns)  pasadas máx  inanición\n");
+  std::ofstream wcsv(wait_path);
+  wcsv << "PE,Grants,Wait_ns,Max_Wait_ns,Max_Passed,Starved,Bucket_Upper_ns,Count\n";
+  for (size_t i = 0; i < r.ids.size(); ++i) {
+    const auto& s = r.per[i];
+    char id[8];
+    if (r.ids[i] < 0) std::snprintf(id, sizeof id, "DMA");
+    else              std::snprintf(id, sizeof id, "%d", r.ids[i]);
+    std::printf("  %3s %12llu %12.0f %8llu %8llu %12llu %12llu %10llu\n", id,
+                (unsigned long long)s.grants, s.grants ? double(s.wait_ns) / double(s.grants) : 0.0,
+                (unsigned long long)BusArbiter::percentile(s, 0.50),
+                (unsigned long long)BusArbiter::percentile(s, 0.99),
+                (unsigned long long)s.max_wait_ns, (unsigned long long)s.max_passed,
+                (unsigned long long)s.starved);
+    for (int b = 0; b < BusArbiter::kHistBuckets; ++b)
+      if (s.hist[b])
+        wcsv << id << "," << s.grants << "," << s.wait_ns << "," << s.max_wait_ns << ","
+             << s.max_passed << "," << s.starved << "," << (b ? (uint64_t(1) << b) - 1 : 0)
+             << "," << s.hist[b] << "\n";
+  }
+  std::ofstream ucsv(util_path);
+  ucsv << "Window,Start_ms,Busy_ns,Utilization\n";
+  double peak = 0.0;
+  for (size_t w = 0; w < r.timeline.size(); ++w) {
+    const double u = double(r.timeline[w]) / double(r.window_ns);
+    peak = std::max(peak, u);
+    ucsv << w << "," << double(w * r.window_ns) / 1e6 << "," << r.timeline[w] << "," << u << "\n";
+  }
+  std::printf("  %zu ventanas de %.1f ms, pico %.1f%%; detalle en %s y %s\n", r.timeline.size(),
+              r.window_ns / 1e6, 100.0 * peak, wait_path, util_path);
+}
+
+// Jerarquía NUMA (--numa): pedidos al directorio por nodo, memoria local/remota y
+// latencia modelada (timing.hpp); detalle en numa.csv.
+static void report_numa(const NumaDirectory& dir, const SharedMemory& shm, int P, int C,
+                        const char* path = "numa.csv") {
+  std::printf("\n=== NUMA: %d nodos, %llu líneas en el directorio ===\n", C,
+              (unsigned long long)dir.tracked_lines());
+  std::printf("  nodo  PEs  pedidos  mem loc  mem rem  c2c rem  inval  wb loc  wb rem"
+              "  ciclos loc  ciclos rem  %%rem  mem home L/E\n");
+  std::ofstream csv(path);
+  csv << "Node,PEs,Requests,Local_Mem,Remote_Mem,Remote_C2C,Invals_Sent,WB_Local,WB_Remote,"
+         "Local_Cycles,Remote_Cycles,Home_Reads,Home_Writes\n";
+  uint64_t loc = 0, rem = 0;
+  for (int n = 0; n < C; ++n) {
+    const auto st = dir.stats(n);
+    uint64_t hr = 0, hw = 0;
+    shm.get_node_stats(n, hr, hw);
+    const int pes = (n + 1) * P / C - n * P / C;   // PEs k con k*C/P == n
+    const uint64_t cyc = st.local_cycles + st.remote_cycles;
+    loc += st.local_cycles; rem += st.remote_cycles;
+    std::printf("  %4d %4d %8llu %8llu %8llu %8llu %6llu %7llu %7llu %11llu %11llu %5.1f %6llu/%llu\n",
+                n, pes, (unsigned long long)st.requests, (unsigned long long)st.local_mem,
+                (unsigned long long)st.remote_mem, (unsigned long long)st.remote_c2c,
+                (unsigned long long)st.invals_sent, (unsigned long long)st.wb_local,
+                (unsigned long long)st.wb_remote, (unsigned long long)st.local_cycles,
+                (unsigned long long)st.remote_cycles, cyc ? 100.0 * double(st.remote_cycles) / double(cyc) : 0.0,
+                (unsigned long long)hr, (unsigned long long)hw);
+    csv << n << "," << pes << "," << st.requests << "," << st.local_mem << "," << st.remote_mem << ","
+        << st.remote_c2c << "," << st.invals_sent << "," << st.wb_local << "," << st.wb_remote << ","
+        << st.local_cycles << "," << st.remote_cycles << "," << hr << "," << hw << "\n";
+  }
+  std::printf("  latencia fuera del cluster: %llu ciclos (%.1f%% remota); detalle en %s\n",
+              (unsigned long long)(loc + rem), (loc + rem) ? 100.0 * double(rem) / double(loc + rem) : 0.0, path);
+}
+
+// Red en chip (--noc): latencia por PE, tráfico por clase/VC y mapa de uso de
+// los enlaces (consola: % del tiempo simulado; detalle en noc_links.csv).
+static void report_noc(const NocModel& noc, const char* path = "noc_links.csv") {
+  const NocModel::Totals& t = noc.totals();
+  const uint64_t el = noc.elapsed();
+  std::printf("\n=== Red en chip (%s %dx%d, %d VCs por enlace, salto %u ciclos, flit %u B) ===\n",
+              noc_topology_name(noc.config().topo), noc.cols(), noc.rows(), noc.vcs(),
+              noc.config().hop_cycles, noc.config().flit_bytes);
+  std::printf("  %llu paquetes (Req %llu, Fwd %llu, Resp %llu), %llu flits, %.2f saltos/paquete\n",
+              (unsigned long long)t.packets, (unsigned long long)t.class_packets[NocModel::Req],
+              (unsigned long long)t.class_packets[NocModel::Fwd],
+              (unsigned long long)t.class_packets[NocModel::Resp], (unsigned long long)t.flits,
+              t.packets ? double(t.hops) / double(t.packets) : 0.0);
+  std::printf("  latencia por paquete: media %.1f, máxima %llu ciclos; dependencias entre canales %s\n",
+              t.packets ? double(t.packet_latency) / double(t.packets) : 0.0,
+              (unsigned long long)t.max_packet_latency, noc.deadlock_free() ? "acíclicas" : "CON CICLO");
+  std::printf("   PE  transacciones  latencia media  máxima  reloj (ciclos)\n");
+  for (int k = 0; k < noc.tiles(); ++k) {
+    const NocModel::PeStats s = noc.pe_stats(k);
+    std::printf("  %3d %14llu %15.1f %7llu %15llu\n", k, (unsigned long long)s.transactions,
+                s.transactions ? double(s.latency) / double(s.transactions) : 0.0,
+                (unsigned long long)s.max_latency, (unsigned long long)s.clock);
+  }
+  std::printf("  tiempo de red estimado: %llu ciclos\n", (unsigned long long)el);
+
+  // Mapa de uso: malla con el máximo de los dos sentidos de cada enlace; anillo
+  // con los dos sentidos de cada tramo i -> i+1
+  const auto& L = noc.links();
+  auto pct = [&](int from, int to) {
+    double u = 0.0;
+    for (size_t l = 0; l < L.size(); ++l)
+      if ((L[l].from == from && L[l].to == to) || (L[l].from == to && L[l].to == from))
+        u = std::max(u, noc.utilization(int(l)));
+    return 100.0 * u;
+  };
+  std::printf("  uso de enlaces (%%):\n");
+  if (noc.config().topo == NocTopology::Mesh) {
+    for (int y = 0; y < noc.rows(); ++y) {
+      std::printf("    ");
+      for (int x = 0; x < noc.cols(); ++x) {
+        std::printf("[%2d]", y * noc.cols() + x);
+        if (x + 1 < noc.cols()) std::printf("-%3.0f-", pct(y * noc.cols() + x, y * noc.cols() + x + 1));
+      }
+      std::printf("\n");
+      if (y + 1 == noc.rows()) break;
+      std::printf("    ");
+      for (int x = 0; x < noc.cols(); ++x)
+        std::printf("%3.0f%s", pct(y * noc.cols() + x, (y + 1) * noc.cols() + x),
+                    x + 1 < noc.cols() ? "      " : "\n");
+    }
+  } else {
+    // Enlaces en pares por tile: 2i = i -> i+1 ('+'), 2i+1 = i -> i-1 ('-')
+    const int n = noc.tiles();
+    for (int i = 0; n > 1 && i < n; ++i) {
+      const int j = (i + 1) % n;
+      std::printf("    %2d -> %2d: %5.1f   %2d <- %2d: %5.1f\n", i, j,
+                  100.0 * noc.utilization(2 * i), i, j, 100.0 * noc.utilization(2 * j + 1));
+    }
+  }
+
+  std::ofstream csv(path);
+  csv << "Link,From,To,From_X,From_Y,Dir,Packets,Flits,Wait_Cycles,Utilization";
+  for (int v = 0; v < noc.vcs(); ++v) csv << ",VC" << v << "_Flits";
+  csv << "\n";
+  for (size_t l = 0; l < L.size(); ++l) {
+    csv << l << "," << L[l].from << "," << L[l].to << "," << L[l].from % noc.cols() << ","
+        << L[l].from / noc.cols() << "," << L[l].dir << "," << L[l].packets << "," << L[l].flits << ","
+        << L[l].wait_cycles << "," << noc.utilization(int(l));
+    for (uint64_t f : L[l].vc_flits) csv << "," << f;
+    csv << "\n";
+  }
+  std::printf("  detalle por enlace y VC en %s\n", path);
+}
+
+// Controlador DRAM (--dram=...). Sin la opción la memoria queda con costo fijo.
+static std::unique_ptr<DramController> apply_dram(const RunOptions& opt, SharedMemory& shm) {
+  if (!opt.dram) return nullptr;
+  auto d = std::make_unique<DramController>(opt.dram_cfg);
+  shm.set_dram(d.get());
+  return d;
+}
+
+// Memoria (--dram): aciertos de fila, latencia y ancho de banda; por banco en dram.csv
+static void report_dram(DramController& d, const char* path = "dram.csv") {
+  d.drain();
+  const DramConfig& c = d.config();
+  const DramController::Stats& s = d.stats();
+  std::printf("\n=== DRAM (%s, página %s, %d canales x %d ranks x %d bancos, mapeo %s) ===\n",
+              dram_sched_name(c.sched), dram_page_name(c.page), c.channels, c.ranks, c.banks, c.map.c_str());
+  std::printf("  pedidos: %llu (%llu lecturas, %llu escrituras), %llu refrescos\n",
+              (unsigned long long)s.requests(), (unsigned long long)s.reads,
+              (unsigned long long)s.writes, (unsigned long long)s.refreshes);
+  std::printf("  filas: %llu aciertos, %llu cerradas, %llu conflictos (tasa de aciertos %.1f%%)\n",
+              (unsigned long long)s.row_hits, (unsigned long long)s.row_empty,
+              (unsigned long long)s.row_conflicts, 100.0 * s.row_hit_rate());
+  std::printf("  latencia media %.1f ciclos (máx %llu, %.1f en cola), cola llena %llu ciclos\n",
+              s.avg_latency(), (unsigned long long)s.max_latency,
+              s.requests() ? double(s.queue_cycles) / double(s.requests()) : 0.0,
+              (unsigned long long)s.stall_cycles);
+  std::printf("  ancho de banda %.2f B/ciclo en %llu ciclos\n", d.bytes_per_cycle(),
+              (unsigned long long)d.elapsed());
+  std::ofstream csv(path);
+  csv << "Channel,Rank,Bank,Reads,Writes,Row_Hits,Row_Empty,Row_Conflicts,Hit_Rate,Avg_Latency\n";
+  for (int ch = 0; ch < c.channels; ++ch)
+    for (int r = 0; r < c.ranks; ++r)
+      for (int b = 0; b < c.banks; ++b) {
+        const DramController::Stats& x = d.bank_stats(ch, r, b);
+        csv << ch << "," << r << "," << b << "," << x.reads << "," << x.writes << "," << x.row_hits
+            << "," << x.row_empty << "," << x.row_conflicts << "," << x.row_hit_rate() << ","
+            << x.avg_latency() << "\n";
+      }
+  std::printf("  detalle por banco en %s\n", path);
+}
+
+// Memoria virtual (--vm): espacio de direcciones con los datos del programa
+// mapeados desde 0 (páginas de 4 KiB, o de 2 MiB con --huge) y una Mmu por PE
+static std::unique_ptr<AddressSpace> apply_vm(const RunOptions& opt, SharedMemory& shm, uint64_t virt_bytes) {
+  if (!opt.vm) return nullptr;
+  auto as = std::make_unique<AddressSpace>(shm);
+  std::string err;
+  if (!as->map(0, virt_bytes, opt.huge_pages, &err)) {
+    std::fprintf(stderr, "ERROR: --vm: %s\n", err.c_str());
+    return nullptr;
+  }
+  return as;
+}
+
+// TLB y page walks por PE; detalle en tlb.csv
+static void report_vm(const RunOptions& opt, const AddressSpace& as, const MesiInterconnect& bus,
+                      const std::vector<std::unique_ptr<Mmu>>& mmus, const char* path = "tlb.csv") {
+  std::printf("\n=== Memoria virtual (páginas de %s, TLB %d:%d + %d:%d de 2 MiB) ===\n",
+              opt.huge_pages ? "2 MiB" : "4 KiB", opt.tlb.entries, opt.tlb.ways, opt.tlb.huge_entries,
+              opt.tlb.huge_ways);
+  std::printf("  %llu páginas mapeadas, %llu páginas de tablas, %llu shootdowns por el bus\n",
+              (unsigned long long)as.pages(), (unsigned long long)as.table_pages(),
+              (unsigned long long)bus.stats().tlb_shootdowns);
+  std::ofstream csv(path);
+  csv << "PE,Accesses,TLB_Misses,Miss_Rate,Huge_Misses,Walk_Loads,Walk_L1_Misses,Walk_Cycles,"
+         "Cycles_Per_Walk,Faults,Shootdowns_Sent,Shootdowns_Recv\n";
+  for (const auto& m : mmus) {
+    const Mmu::Stats& s = m->stats();
+    const double per_walk = s.misses ? double(s.walk_cycles) / double(s.misses) : 0.0;
+    std::printf("  PE%d: %llu accesos, %llu fallos de TLB (%.3f%%), %llu PTEs leídas (%llu fallaron en L1$), "
+                "%.1f ciclos por recorrido, %llu fallos de página\n",
+                m->pe(), (unsigned long long)s.accesses, (unsigned long long)s.misses, 100.0 * s.miss_rate(),
+                (unsigned long long)s.walk_loads, (unsigned long long)s.walk_l1_misses, per_walk,
+                (unsigned long long)s.faults);
+    csv << m->pe() << "," << s.accesses << "," << s.misses << "," << s.miss_rate() << "," << s.huge_misses
+        << "," << s.walk_loads << "," << s.walk_l1_misses << "," << s.walk_cycles << "," << per_walk << ","
+        << s.faults << "," << s.shootdowns_sent << "," << s.shootdowns_recv << "\n";
+  }
+  std::printf("  detalle por PE en %s\n", path);
+}
+
+// Log del orden de concesiones (--record-grants / --replay-grants), compartido por
+// todos los buses. nullptr sin las opciones; false si no se pudo abrir.
+static bool open_grant_log(const RunOptions& opt, std::unique_ptr<GrantLog>& out) {
+  if (opt.record_grants.empty() && opt.replay_grants.empty()) return true;
+  const bool rec = !opt.record_grants.empty();
+  out = std::make_unique<GrantLog>(rec ? GrantLog::Mode::Record : GrantLog::Mode::Replay,
+                                   rec ? opt.record_grants : opt.replay_grants);
+  if (out->ok()) return true;
+  std::fprintf(stderr, "ERROR: %s: %s\n", rec ? "--record-grants" : "--replay-grants",
+               out->error().c_str());
+  return false;
+}
+
+// Cierra el log (con los PEs detenidos) y resume la grabación o la reproducción
+static void report_grants(GrantLog& g, const RunOptions& opt) {
+  std::string err;
+  if (!g.close(&err)) std::fprintf(stderr, "ERROR: log de concesiones: %s\n", err.c_str());
+  const GrantLog::Report r = g.report();
+  if (g.mode() == GrantLog::Mode::Record) {
+    std::printf("\n=== Concesiones del bus grabadas en %s ===\n", opt.record_grants.c_str());
+    std::printf("  %llu concesiones en %llu B (%.3f B/concesión), hash 0x%016llx\n",
+                (unsigned long long)r.grants, (unsigned long long)r.bytes,
+                r.grants ? double(r.bytes) / double(r.grants) : 0.0, (unsigned long long)r.hash);
+    return;
+  }
+  std::printf("\n=== Reproducción de concesiones de %s: %s ===\n", opt.replay_grants.c_str(),
+              r.reproduced() ? "misma secuencia" : "DIVERGIÓ");
+  std::printf("  concesiones: %llu (log: %llu); %llu siguieron el log, %llu sin log\n",
+              (unsigned long long)r.grants, (unsigned long long)r.log_grants,
+              (unsigned long long)r.followed, (unsigned long long)r.free_run);
+  std::printf("  entradas descartadas %llu, sin consumir %llu; hash 0x%016llx (log 0x%016llx)\n",
+              (unsigned long long)r.skipped, (unsigned long long)r.unused,
+              (unsigned long long)r.hash, (unsigned long long)r.log_hash);
+}
+
+// Escrituras (--store-out, --write-policy): transacciones y bytes de datos por el
+// bus (sumados sobre los buses de todos los clusters) y su costo por elemento de C
+static void report_writes(const RunOptions& opt, const std::vector<const MesiInterconnect*>& buses,
+                          const std::vector<const MESICache*>& caches, size_t out_elems) {
+  uint64_t rd = 0, rdx = 0, upgr = 0, flush = 0, wr = 0, wrl = 0, bytes = 0;
+  for (const MesiInterconnect* b : buses) {
+    const auto& s = b->stats();
+    rd += s.busRd; rdx += s.busRdX; upgr += s.busUpgr; flush += s.flush;
+    wr += s.busWr; wrl += s.busWrLine; bytes += s.data_bytes;
+  }
+  uint64_t stores = 0, nt = 0, arounds = 0, partial = 0;
+  for (const MESICache* c : caches) {
+    const auto& s = c->stats();
+    stores += s.stores; nt += s.nt_stores; arounds += s.write_arounds; partial += s.nt_partial;
+  }
+  std::printf("\n=== Escrituras (L1$ %s", write_policy::name(opt.write_policy));
+  if (opt.out_policy_set) std::printf(", C %s", write_policy::name(opt.out_policy));
+  std::printf("%s) ===\n", opt.nt_stores ? ", STNT" : "");
+  std::printf("  stores: %llu (%llu no temporales, %llu sin asignar línea, %llu buffers WC parciales)\n",
+              (unsigned long long)stores, (unsigned long long)nt, (unsigned long long)arounds,
+              (unsigned long long)partial);
+  std::printf("  bus: %llu BusRd, %llu BusRdX, %llu BusUpgr, %llu Flush, %llu BusWr, %llu BusWrLine\n",
+              (unsigned long long)rd, (unsigned long long)rdx, (unsigned long long)upgr,
+              (unsigned long long)flush, (unsigned long long)wr, (unsigned long long)wrl);
+  std::printf("  datos por el bus: %llu B", (unsigned long long)bytes);
+  if (out_elems)
+    std::printf(" (%.2f B y %.3f transacciones por elemento de C)", double(bytes) / double(out_elems),
+                double(rd + rdx + upgr + flush + wr + wrl) / double(out_elems));
+  std::printf("\n");
+}
+
+// Exportador de métricas en vivo (--metrics=...). Se arranca antes de lanzar los PEs.
+static std::unique_ptr<MetricsExporter> start_exporter(const RunOptions& opt,
+                                                       const MesiInterconnect& bus) {
+  if (opt.metrics_endpoint.empty()) return nullptr;
+  auto ex = std::make_unique<MetricsExporter>(bus);
+  if (!ex->start(opt.metrics_endpoint)) {
+    std::fprintf(stderr, "WARN: exportador de métricas desactivado (%s)\n", ex->error().c_str());
+    return nullptr;
+  }
+  if (ex->port()) std::printf("metrics: http://127.0.0.1:%u/metrics (y /json)\n", ex->port());
+  else            std::printf("metrics: %s (GET /metrics, GET /json)\n", opt.metrics_endpoint.c_str());
+  std::fflush(stdout);
+  return ex;
+}
+
+static void finish_exporter(std::unique_ptr<MetricsExporter>& ex, const RunOptions& opt) {
+  if (!ex) return;
+  if (opt.metrics_linger > 0)
+    std::this_thread::sleep_for(std::chrono::duration<double>(opt.metrics_linger));
+  ex->stop();
+}
+
+// Serie temporal de contadores (--timeline=f). Se abre antes de crear los puertos,
+// que la disparan desde el camino de acceso.
+static std::unique_ptr<IntervalSampler> start_timeline(const RunOptions& opt,
+                                                       const MesiInterconnect& bus) {
+  if (opt.timeline.empty()) return nullptr;
+  auto ts = std::make_unique<IntervalSampler>(bus, opt.timeline_cfg);
+  if (!ts->open(opt.timeline)) {
+    std::fprintf(stderr, "WARN: --timeline desactivado (%s)\n", ts->error().c_str());
+    return nullptr;
+  }
+  return ts;
+}
+
+static void finish_timeline(std::unique_ptr<IntervalSampler>& ts, const std::string& opt_path) {
+  if (!ts) return;
+  ts->close();
+  const TimelineConfig& c = ts->config();
+  std::printf(" Serie temporal en %s: %llu muestras cada %llu %s", opt_path.c_str(),
+              (unsigned long long)ts->samples(), (unsigned long long)c.every,
+              c.unit == TimelineConfig::Unit::Cycles ? "ciclos" : "accesos");
+  if (ts->skipped())
+    std::printf(" (%llu intervalos sin muestra propia: un acceso saltó varios límites)",
+                (unsigned long long)ts->skipped());
+  std::printf("\n");
+  if (!ts->error().empty()) std::fprintf(stderr, "WARN: --timeline: %s\n", ts->error().c_str());
+}
+
+// Curva miss-ratio (modo --mrc): resumen en consola + mrc.csv
+static void report_mrc(const std::vector<ReuseDistanceProfiler>& rd,
+                       const std::string& path = "mrc.csv") {
+  ReuseDistanceProfiler all(rd.empty() ? 1.0 : rd.front().sample_rate());
+  for (const auto& p : rd) all.merge(p);
+  std::printf("\n=== MRC (FA-LRU, muestreo %.3g): %llu accesos, %llu perfilados ===\n",
+              all.sample_rate(), (unsigned long long)all.accesses(), (unsigned long long)all.sampled());
+  for (uint64_t c : {4, 8, 16, 32, 64, 128})
+    std::printf("  %4llu líneas (%5llu B): miss ratio %.4f\n", (unsigned long long)c,
+                (unsigned long long)(c * MESICache::kLineSize), all.miss_ratio(c));
+  if (write_mrc_csv(path, rd, MESICache::kLineSize)) std::cout << " MRC exportada a " << path << "\n";
+}
+
+// Informe del detector de false sharing (modo --fsd)
+static void report_false_sharing(const FalseSharingDetector& fsd,
+                                 const std::string& path = "false_sharing.csv") {
+  fsd.printReport(std::cout);
+  if (fsd.writeCsv(path)) std::cout << " Informe de false sharing en " << path << "\n";
+}
+
 // ===================================================================
 // ============================= MODO DOT =============================
 // ===================================================================
-// Ejecuta el dot product con 4 PEs y exporta cache_stats.csv
-int run_dot_mode(size_t N) {
-  static constexpr uint64_t MEM_BYTES = 4096;
+// Ejecuta el dot product con P PEs (--pes, 4 por defecto) y exporta cache_stats.csv
+int run_dot_mode(const RunOptions& opt) {
+  const size_t N = opt.N;
+  const int P = opt.pes;
+  const int C = opt.numa_nodes;   // clusters (1 = bus plano)
   static constexpr uint64_t LINE      = 32;
+  // Una línea de parcial por PE (al menos 4: el lock de --reduce=lock usa la segunda)
+  const int PL = std::max(P, 4);
+  // Vectores: A y B (y C, alineado a línea, con --store-out)
+  const uint64_t VEC_BYTES = (opt.store_out ? 3 : 2) * N*8 + (opt.store_out ? LINE : 0);
+  // Muestreado, NUMA, red en chip o salida en flujo: la memoria crece (en páginas)
+  // para admitir N grandes
+  const uint64_t MEM_BYTES = (opt.sampled || C > 1 || opt.noc || opt.store_out || opt.vm)
+      ? std::max<uint64_t>(SharedMemory::kDefaultBytes,
+                           (VEC_BYTES + PL*LINE + SharedMemory::kPageBytes - 1) /
+                               SharedMemory::kPageBytes * SharedMemory::kPageBytes)
+      : SharedMemory::kDefaultBytes;
 
-  // Layout: A y B contiguos desde 0; parciales en las últimas 4 líneas
+  // Layout: A y B contiguos desde 0 (y C detrás, desde una línea nueva);
+  // parciales en las últimas PL líneas. Con --vm son direcciones virtuales.
   const uint64_t baseA = 0;
   const uint64_t baseB = baseA + N*8;
-  const uint64_t baseP = MEM_BYTES - 4*LINE;
+  const uint64_t baseC = (baseB + N*8 + LINE - 1) & ~(LINE - 1);
+  const uint64_t baseP = MEM_BYTES - PL*LINE;
   const uint64_t o0 = baseP + 0*LINE;
   const uint64_t o1 = baseP + 1*LINE;
-  const uint64_t o2 = baseP + 2*LINE;
-  const uint64_t o3 = baseP + 3*LINE;
 
-  if (!(baseB + N*8 <= baseP)) {
-    std::fprintf(stderr, "ERROR: 2N+4 > 512 palabras (4096B). N=%zu no cabe.\n", N);
+  if (!(baseA + VEC_BYTES <= baseP)) {
+    std::fprintf(stderr, "ERROR: los vectores y %d líneas de parciales no caben en %lluB. N=%zu no cabe.\n",
+                 PL, (unsigned long long)MEM_BYTES, N);
     return 2;
   }
 
-  // DRAM + BUS
-  SharedMemory shm;
-  MesiInterconnect bus(0);
-  bus.set_shared_memory(&shm);
+  // DRAM + BUS. Con --numa=C: un bus local por nodo unidos por el directorio;
+  // el PE k pertenece al nodo k*C/P y 'bus' (nodo 0) atiende al host y al DMA.
+  SharedMemory shm(opt.vm ? AddressSpace::phys_bytes_for(MEM_BYTES, opt.huge_pages) : MEM_BYTES);
+  auto as = apply_vm(opt, shm, MEM_BYTES);
+  if (opt.vm && !as) return 2;
+  NumaDirectory dir(shm);
+  std::vector<std::unique_ptr<MesiInterconnect>> buses;
+  for (int n = 0; n < C; ++n) {
+    buses.push_back(std::make_unique<MesiInterconnect>(0));
+    buses.back()->set_shared_memory(&shm);
+    apply_arbiter(opt, *buses.back());
+    if (C > 1) dir.attach(n, buses.back().get());
+  }
+  if (C > 1) shm.set_numa_nodes(C, opt.numa_interleave);
+  MesiInterconnect& bus = *buses[0];
+  auto dram = apply_dram(opt, shm);
+  std::unique_ptr<GrantLog> glog;
+  if (!open_grant_log(opt, glog)) return 2;
+  for (auto& b : buses) b->set_grant_log(glog.get());
+
+  // (opcional) Red en chip: un tile por PE
+  std::unique_ptr<NocModel> noc;
+  if (opt.noc) {
+    NocConfig nc = opt.noc_cfg;
+    nc.tiles = P;
+    std::string err;
+    if (!NocModel::validate(nc, &err)) {
+      std::fprintf(stderr, "ERROR: --noc: %s\n", err.c_str());
+      return 2;
+    }
+    noc = std::make_unique<NocModel>(nc);
+    bus.set_noc(noc.get());
+  }
+  auto node_of = [&](int k) { return k * C / P; };
 
   // Inicialización A/B y parciales
-  for (size_t i=0; i<N; ++i) {
-    shm_write_double(shm, baseA + i*8, double(i+1));        // A[i] = 1..N
-    shm_write_double(shm, baseB + i*8, 0.5*double(i+1));    // B[i] = 0.5,1.0,1.5,...
+  init_dot_inputs(shm, baseA, baseB, N, as.get());   // A[i] = 1..N, B[i] = 0.5,1.0,1.5,...
+  const std::vector<double> zeros(PL * LINE / 8, 0.0);
+  host_write(shm, as.get(), baseP, zeros.data(), zeros.size() * 8);
+
+  // P L1$ MESI conectadas al bus
+  std::vector<std::unique_ptr<MESICache>> caches;
+  std::vector<const MESICache*> cview;
+  for (int k = 0; k < P; ++k) {
+    MesiInterconnect& b = *buses[node_of(k)];
+    caches.push_back(std::make_unique<MESICache>(k, b));
+    caches.back()->setIndexFunction(opt.index);
+    caches.back()->setWritePolicy(opt.write_policy);
+    if (opt.out_policy_set) caches.back()->addWriteRegion(baseC, N*8, opt.out_policy);
+    b.connect(caches.back().get());
+    cview.push_back(caches.back().get());
   }
-  shm_write_double(shm, o0, 0.0);
-  shm_write_double(shm, o1, 0.0);
-  shm_write_double(shm, o2, 0.0);
-  shm_write_double(shm, o3, 0.0);
 
-  // 4 L1$ MESI conectadas al bus
-  MESICache c0(0,bus), c1(1,bus), c2(2,bus), c3(3,bus);
-  bus.connect(&c0); bus.connect(&c1); bus.connect(&c2); bus.connect(&c3);
+  FalseSharingDetector fsd(P);
+  if (opt.fsd) for (auto& b : buses) b->set_false_sharing_detector(&fsd);
+  auto exporter = start_exporter(opt, bus);
+  auto timeline = start_timeline(opt, bus);
 
-  // 4 puertos de memoria (uno por PE)
-  PortMetrics pm0, pm1, pm2, pm3;
-  MesiMemoryPort mp0(c0,bus,&pm0), mp1(c1,bus,&pm1), mp2(c2,bus,&pm2), mp3(c3,bus,&pm3);
+  // Un puerto de memoria por PE
+  std::vector<PortMetrics> pm(P);
+  std::vector<std::unique_ptr<MesiMemoryPort>> mps;
+  std::vector<IMemoryPort*> ports;
+  for (int k = 0; k < P; ++k) {
+    mps.push_back(std::make_unique<MesiMemoryPort>(*caches[k], *buses[node_of(k)], &pm[k]));
+    mps.back()->set_timeline(timeline.get());
+    ports.push_back(mps.back().get());
+  }
+  std::vector<std::unique_ptr<Mmu>> mmus;
+  for (int k = 0; as && k < P; ++k) {
+    mmus.push_back(std::make_unique<Mmu>(k, *as, *caches[k], bus, opt.tlb));
+    mps[k]->set_mmu(mmus.back().get());
+  }
 
-  // Programa mini-ISA y PEs
-  Program prog = make_dot_program();
-  PE pe0(0,&mp0), pe1(1,&mp1), pe2(2,&mp2), pe3(3,&mp3);
-  pe0.load_program(prog); pe1.load_program(prog); pe2.load_program(prog); pe3.load_program(prog);
+  // (opcional) Grabación de la traza de accesos de los P PEs
+  std::unique_ptr<TraceWriter> tw;
+  if (!opt.record_trace.empty()) {
+    tw = std::make_unique<TraceWriter>(opt.record_trace, P, opt.trace_compress);
+    if (!tw->ok()) {
+      std::fprintf(stderr, "ERROR: no se pudo crear %s\n", opt.record_trace.c_str());
+      return 2;
+    }
+    for (auto& mp : mps) mp->set_trace_writer(tw.get());
+  }
 
-  // Segmentación: reparte N entre 4 (balancea si N%4!=0)
-  const size_t base_chunk = N/4, rem = N%4;
-  auto len_k = [&](int k){ return base_chunk + (k<rem ? 1 : 0); };
+  // (opcional) Perfil de reuse distance por PE
+  std::vector<ReuseDistanceProfiler> rd(P, ReuseDistanceProfiler(opt.mrc_rate));
+  if (opt.mrc)
+    for (int k = 0; k < P; ++k) mps[k]->set_reuse_profiler(&rd[k]);
 
-  uint64_t aK[4], bK[4], oK[4] = {o0,o1,o2,o3}; size_t off=0;
-  for (int k=0;k<4;++k) {
+  // Programa mini-ISA y PEs.
+  // Con reducción atómica todos los PEs acumulan sobre o0; el lock usa la línea o1.
+  const bool atomic_reduce = (opt.reduce != Reduce::Host);
+  Program prog = opt.store_out ? make_mul_program(opt.nt_stores) : make_dot_program(opt.reduce, o1);
+  std::vector<std::unique_ptr<PE>> pes;
+  std::vector<PE*> pv;
+  std::vector<const PE*> cpv;
+  for (int k = 0; k < P; ++k) {
+    pes.push_back(std::make_unique<PE>(k, mps[k].get()));
+    pes.back()->load_program(prog);
+    pv.push_back(pes.back().get());
+    cpv.push_back(pes.back().get());
+  }
+
+  // Segmentación: reparte N entre P (balancea si N%P!=0)
+  const size_t base_chunk = N/P, rem = N%P;
+  auto len_k = [&](int k){ return base_chunk + (size_t(k)<rem ? 1 : 0); };
+
+  std::vector<uint64_t> aK(P), bK(P), oK(P); size_t off=0;
+  for (int k=0;k<P;++k) {
+    if (opt.store_out)            oK[k] = baseC + off*8;   // tramo de C
+    else if (atomic_reduce)       oK[k] = o0;
+    else if (opt.packed_partials) oK[k] = o0 + 8*k;   // misma línea (de a 4)
+    else                          oK[k] = baseP + k*LINE;
     size_t len = len_k(k);
     aK[k] = baseA + off*8;
     bK[k] = baseB + off*8;
@@ -194,61 +1046,164 @@ int run_dot_mode(size_t N) {
   }
 
   // Asignar tramos
-  pe0.set_segment(aK[0], bK[0], oK[0], len_k(0));
-  pe1.set_segment(aK[1], bK[1], oK[1], len_k(1));
-  pe2.set_segment(aK[2], bK[2], oK[2], len_k(2));
-  pe3.set_segment(aK[3], bK[3], oK[3], len_k(3));
+  for (int k=0;k<P;++k) pes[k]->set_segment(aK[k], bK[k], oK[k], len_k(k));
 
-  // Ejecutar en paralelo
-  std::thread t0([&]{ pe0.run(0); });
-  std::thread t1([&]{ pe1.run(0); });
-  std::thread t2([&]{ pe2.run(0); });
-  std::thread t3([&]{ pe3.run(0); });
-  t0.join(); t1.join(); t2.join(); t3.join();
+  // --placement=local: los tramos de A/B y el parcial de cada PE en su nodo
+  if (C > 1 && opt.numa_local)
+    for (int k=0;k<P;++k) {
+      if (len_k(k)) {
+        shm.bind(aK[k], len_k(k)*8, node_of(k));
+        shm.bind(bK[k], len_k(k)*8, node_of(k));
+      }
+      if (opt.store_out && len_k(k)) shm.bind(oK[k], len_k(k)*8, node_of(k));
+      else if (!atomic_reduce && !opt.packed_partials) shm.bind(oK[k], 8, node_of(k));
+    }
+
+  // (opcional) Continuar desde un checkpoint: pisa memoria, L1$, bus y PEs
+  if (!opt.restore.empty()) {
+    std::string err;
+    if (!load_checkpoint(opt.restore, shm, bus, pv, &err)) {
+      std::fprintf(stderr, "ERROR: --restore=%s: %s\n", opt.restore.c_str(), err.c_str());
+      return 2;
+    }
+    std::printf("Estado restaurado de %s\n", opt.restore.c_str());
+  }
 
-  // Leer parciales coherentemente a través del puerto (y por ende de la L1$)
-  auto load_double_coherent = [&](uint64_t addr)->double {
-    uint64_t u = mp0.load64(addr);
-    double d; std::memcpy(&d, &u, 8);
-    return d;
+  // Ejecutar en paralelo (max_steps = 0 => hasta HALT). Con --replay-grants, un
+  // PE que termina deja de tener turnos en el log.
+  auto run_pes = [&](uint64_t max_steps) {
+    std::vector<std::thread> ts;
+    for (PE* pe : pv)
+      ts.emplace_back([pe, max_steps, g = glog.get()] {
+        pe->run(max_steps);
+        if (g) g->retire(pe->id());
+      });
+    for (auto& t : ts) t.join();
   };
-  const double p0 = load_double_coherent(o0);
-  const double p1 = load_double_coherent(o1);
-  const double p2 = load_double_coherent(o2);
-  const double p3 = load_double_coherent(o3);
-  const double result   = p0+p1+p2+p3;
+
+  // (opcional) Checkpoint: S instrucciones por PE, guardar con los hilos detenidos, seguir
+  if (!opt.checkpoint_out.empty()) {
+    run_pes(opt.checkpoint_at);
+    std::string err;
+    if (!save_checkpoint(opt.checkpoint_out, shm, bus, cpv, &err)) {
+      std::fprintf(stderr, "ERROR: %s\n", err.c_str());
+      return 2;
+    }
+    std::printf("Checkpoint guardado en %s (%llu instrucciones por PE)\n",
+                opt.checkpoint_out.c_str(), (unsigned long long)opt.checkpoint_at);
+  }
+
+  // (opcional) Forks en memoria: K variantes desde el mismo punto caliente, en paralelo
+  std::vector<std::unique_ptr<SimFork>> forks;
+  if (opt.forks) {
+    if (opt.checkpoint_out.empty()) run_pes(opt.checkpoint_at);
+    for (unsigned k = 0; k < opt.forks; ++k)
+      forks.push_back(fork_simulation(shm, bus, cpv));
+  }
+  std::vector<std::thread> fork_threads;
+  for (auto& f : forks) fork_threads.emplace_back([&f]{ f->run(0); });
+  for (auto& b : buses)
+    if (b->arbiter()) b->arbiter()->reset();   // solo la corrida principal
+  const auto t_run = std::chrono::steady_clock::now();
+  if (opt.sampled) {
+    SampledRunner sampler(shm, bus, pv, ports);
+    SamplingReport sr;
+    std::string err;
+    if (!sampler.run(opt.sampling, sr, &err)) {
+      std::fprintf(stderr, "ERROR: --sample: %s\n", err.c_str());
+      return 2;
+    }
+    report_sampling(sr, opt.sampling,
+                    std::chrono::duration<double>(std::chrono::steady_clock::now() - t_run).count());
+  } else {
+    run_pes(0);
+  }
+  const double run_secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_run).count();
+  std::vector<BusArbiter::Report> arbs;
+  for (auto& b : buses)
+    if (b->arbiter()) arbs.push_back(b->arbiter()->snapshot());
+  for (auto& t : fork_threads) t.join();
+  if (!forks.empty()) report_forks(forks, oK, atomic_reduce ? 1 : P);
+
+  // La reducción final ocurre después del join: barrera en la traza
+  if (tw) tw->barrier();
+
+  // Leer parciales coherentemente con el agente DMA (las copias en M hacen Flush)
+  DmaAgent dma(bus);
+  // En reducción atómica o0 ya contiene la suma total (o1 es el lock).
+  std::vector<double> partials(P, 0.0);
+  double result = 0.0;
+  size_t bad_out = 0;
+  if (opt.store_out) {
+    // Salida en flujo: el host lee C entero y suma cada tramo
+    std::vector<double> out(N);
+    dma_read(dma, as.get(), baseC, out.data(), N * 8);
+    for (int k = 0; k < P; ++k) {
+      const size_t first = size_t(oK[k] - baseC) / 8;
+      for (size_t i = first; i < first + len_k(k); ++i) {
+        partials[k] += out[i];
+        bad_out += out[i] != 0.5 * double(i + 1) * double(i + 1);
+      }
+      result += partials[k];
+    }
+  } else {
+    for (int k = 0; k < (atomic_reduce ? 1 : P); ++k) result += partials[k] = dma_read_double(dma, oK[k], as.get());
+  }
   const double expected = 0.5 * (double(N)*(N+1)*(2.0*N+1)/6.0);
+  if (glog) for (auto& b : buses) b->set_grant_log(nullptr);
 
-  std::cout << "partials = [" << p0 << ", " << p1 << ", " << p2 << ", " << p3 << "]\n";
+  std::cout << "partials = [";
+  for (int k = 0; k < P; ++k) std::cout << (k ? ", " : "") << partials[k];
+  std::cout << "]\n";
   std::cout << "result   = " << result   << "\n";
   std::cout << "expected = " << expected << "\n";
+  std::printf("tiempo   = %.3f ms con %d PEs\n", run_secs * 1e3, P);
+  if (bad_out) std::printf("ERROR: %zu elementos de C distintos de A[i]*B[i]\n", bad_out);
 
-  // ---------- Exportar métricas de cada L1$ a CSV ----------
-  std::ofstream csv("cache_stats.csv");
-  csv << "PE,Loads,Stores,RW_Accesses,Cache_Misses,Invalidations,"
-         "BusRd,BusRdX,BusUpgr,Flush,Transitions\n";
+  if (atomic_reduce) {
+    uint64_t atom = 0, fails = 0, bus_ops = 0, bus_ns = 0;
+    for (const MESICache* c : cview) {
+      const auto& s = c->stats();
+      atom += s.atomics; fails += s.cas_failures + s.sc_failures;
+      bus_ops += s.atomic_bus_ops; bus_ns += s.atomic_bus_ns;
+    }
+    std::printf("atomics  = %llu ops, %llu fallos, %llu BusRdX/Upgr para propiedad, %.1f us de ping-pong\n",
+                (unsigned long long)atom, (unsigned long long)fails,
+                (unsigned long long)bus_ops, bus_ns / 1e3);
+  }
+  for (size_t n = 0; n < arbs.size(); ++n) {
+    if (C == 1) { report_arbiter(arbs[n]); continue; }
+    const std::string w = "bus_wait_n" + std::to_string(n) + ".csv";
+    const std::string u = "bus_util_n" + std::to_string(n) + ".csv";
+    std::printf("\n-- nodo %zu --", n);
+    report_arbiter(arbs[n], w.c_str(), u.c_str());
+  }
+  if (C > 1) report_numa(dir, shm, P, C);
+  if (noc) report_noc(*noc);
+  if (dram) report_dram(*dram);
+  if (glog) report_grants(*glog, opt);
+  if (as) report_vm(opt, *as, bus, mmus);
+  if (opt.store_out || opt.write_policy != WritePolicy::WriteBack) {
+    std::vector<const MesiInterconnect*> bv;
+    for (auto& b : buses) bv.push_back(b.get());
+    report_writes(opt, bv, cview, opt.store_out ? N : 0);
+  }
 
-  auto write_cache = [&](int pe, const MESICache& cache) {
-      const auto& s = cache.stats();
-      csv << pe << ","
-          << s.loads << ","
-          << s.stores << ","
-          << (s.loads + s.stores) << ","
-          << s.cache_misses << ","
-          << s.invalidations << ","
-          << s.busRd << ","
-          << s.busRdX << ","
-          << s.busUpgr << ","
-          << s.flush << ",\""
-          << cache.transition_log() << "\"\n";
-  };
+  if (tw) {
+    tw->close();
+    std::printf("Traza grabada en %s (%llu registros)\n",
+                opt.record_trace.c_str(), (unsigned long long)tw->records());
+  }
 
-  write_cache(0, c0);
-  write_cache(1, c1);
-  write_cache(2, c2);
-  write_cache(3, c3);
-  csv.close();
-  std::cout << " Métricas exportadas a cache_stats.csv\n";
+  // ---------- Exportar métricas de cada L1$ a CSV ----------
+  export_cache_csv(cview);
+  std::cout << " Métricas exportadas a cache_stats.csv y cache_latency.csv\n";
+  if (opt.set_stats) report_sets(cview);
+  if (opt.lat_stats) report_latency(cview);
+  if (opt.fsd) report_false_sharing(fsd);
+  if (opt.mrc) report_mrc(rd);
+  finish_exporter(exporter, opt);
+  finish_timeline(timeline, opt.timeline);
 
   if (std::abs(result-expected) < 1e-9*std::max(1.0, std::abs(expected))) {
     std::puts("PASS dotprod with MESI");
@@ -265,10 +1220,13 @@ int run_dot_mode(size_t N) {
 // ===================================================================
 // Igual que --mode=dot, pero activa Stepper en el BUS para pausar/avanzar
 // entre emisiones y snoops (útil en presentaciones).
-int run_demo_mode(size_t N, bool stepping) {
+int run_demo_mode(const RunOptions& opt, bool stepping) {
+  const size_t N = opt.N;
   std::cout << "\n===== DEMO: Visualizacion de coherencia MESI =====\n";
   std::cout << "Vector size N = " << N << "\n";
   if (stepping) std::cout << "Presione Siguiente evento para avanzar entre eventos del BUS...\n\n";
+  if (stepping && !opt.watches.empty())
+    std::cout << opt.watches.size() << " watchpoint(s): corre sin pausas hasta que uno se cumpla\n\n";
 
   static constexpr uint64_t MEM_BYTES = 4096;
   static constexpr uint64_t LINE      = 32;
@@ -282,6 +1240,12 @@ int run_demo_mode(size_t N, bool stepping) {
   const uint64_t o2 = baseP + 2*LINE;
   const uint64_t o3 = baseP + 3*LINE;
 
+  if (!(baseB + N*8 <= baseP)) {
+    std::fprintf(stderr, "ERROR: A, B y 4 líneas de parciales no caben en %lluB. N=%zu no cabe (máx. %llu).\n",
+                 (unsigned long long)MEM_BYTES, N, (unsigned long long)((MEM_BYTES - 4*LINE) / 16));
+    return 2;
+  }
+
   SharedMemory shm;
   MesiInterconnect bus(0);
   bus.set_shared_memory(&shm);
@@ -289,17 +1253,22 @@ int run_demo_mode(size_t N, bool stepping) {
   // Stepper para visualización del BUS (si Stepper.hpp soporta set_stepper())
   Stepper step;
   step.enabled = stepping;
+  for (const auto& w : opt.watches) {
+    std::string err;
+    if (!step.add_watch(w, &err)) { std::fprintf(stderr, "%s\n", err.c_str()); return 1; }
+  }
   bus.set_stepper(&step);
 
   // Inicialización
-  for (size_t i=0; i<N; ++i) {
-    shm_write_double(shm, baseA + i*8, double(i+1));
-    shm_write_double(shm, baseB + i*8, 0.5*double(i+1));
-  }
+  init_dot_inputs(shm, baseA, baseB, N);
 
   // Caches + puertos + PEs
   MESICache c0(0,bus), c1(1,bus), c2(2,bus), c3(3,bus);
   bus.connect(&c0); bus.connect(&c1); bus.connect(&c2); bus.connect(&c3);
+  for (MESICache* c : {&c0, &c1, &c2, &c3}) {
+    c->setIndexFunction(opt.index);
+    c->setWritePolicy(opt.write_policy);
+  }
 
   PortMetrics pm0, pm1, pm2, pm3;
   MesiMemoryPort mp0(c0,bus,&pm0), mp1(c1,bus,&pm1), mp2(c2,bus,&pm2), mp3(c3,bus,&pm3);
@@ -334,67 +1303,521 @@ int run_demo_mode(size_t N, bool stepping) {
   std::thread t3([&]{ pe3.run(0); });
   t0.join(); t1.join(); t2.join(); t3.join();
 
-  // En demo leemos parciales directo de DRAM para simplificar la impresión
-  double p0 = shm_read_double(shm, o0);
-  double p1 = shm_read_double(shm, o1);
-  double p2 = shm_read_double(shm, o2);
-  double p3 = shm_read_double(shm, o3);
+  // Parciales vía DMA (coherente: los que siguen en M hacen Flush); sin pausas del stepper
+  step.enabled = false;
+  DmaAgent dma(bus);
+  double p0 = dma_read_double(dma, o0);
+  double p1 = dma_read_double(dma, o1);
+  double p2 = dma_read_double(dma, o2);
+  double p3 = dma_read_double(dma, o3);
   double result = p0 + p1 + p2 + p3;
   double expected = 0.5 * (double(N)*(N+1)*(2.0*N+1)/6.0);
 
   // ---------- Exportar métricas de cada L1$ a CSV ----------
-  std::ofstream csv("cache_stats.csv");
-  csv << "PE,Loads,Stores,RW_Accesses,Cache_Misses,Invalidations,"
-         "BusRd,BusRdX,BusUpgr,Flush,Transitions\n";
-
-  auto write_cache = [&](int pe, const MESICache& cache) {
-      const auto& s = cache.stats();
-      csv << pe << ","
-          << s.loads << ","
-          << s.stores << ","
-          << (s.loads + s.stores) << ","
-          << s.cache_misses << ","
-          << s.invalidations << ","
-          << s.busRd << ","
-          << s.busRdX << ","
-          << s.busUpgr << ","
-          << s.flush << ",\""
-          << cache.transition_log() << "\"\n";
-  };
-
-  write_cache(0, c0);
-  write_cache(1, c1);
-  write_cache(2, c2);
-  write_cache(3, c3);
-  csv.close();
+  export_cache_csv({&c0, &c1, &c2, &c3});
 
   std::cout << "Métricas exportadas\n";
+  if (opt.set_stats) report_sets({&c0, &c1, &c2, &c3});
+  if (opt.lat_stats) report_latency({&c0, &c1, &c2, &c3});
 
   // (En demo no imprimimos PASS/FAIL; puedes añadirlo si deseas)
   (void)result; (void)expected;
   return 0;
 }
 
+// ===================================================================
+// ===================== MODO SYNC (BARRERAS EN EL ISA) ===============
+// ===================================================================
+// Cada ronda r, en el PE k:
+//   acc = total_k(r-1) + sum_{i en tramo k} A[i]*B[i]  -> parcial_k
+//   barrera
+//   total_k(r) = sum_j parcial_j                        (allreduce por memoria)
+//   barrera
+// Por tanto total(r) = 4*total(r-1) + dot: una barrera rota hace leer un parcial
+// viejo y el resultado no coincide.
+int run_sync_mode(const RunOptions& opt) {
+  static constexpr uint64_t LINE = 32;
+  static constexpr int P = 4;
+  const size_t N = opt.N;
+  if (N < P) {
+    std::fprintf(stderr, "ERROR: --mode=sync requiere N >= %d\n", P);
+    return 2;
+  }
+
+  // Layout: A, B, 4 líneas de parciales, 4 líneas de totales, región de barrera
+  auto align = [](uint64_t a) { return (a + LINE - 1) & ~(LINE - 1); };
+  const uint64_t baseA = 0, baseB = N*8;
+  const uint64_t baseP = align(baseB + N*8);
+  const uint64_t baseT = baseP + P*LINE;
+  const uint64_t baseBar = baseT + P*LINE;
+  const uint64_t mem_bytes = std::max<uint64_t>(SharedMemory::kDefaultBytes,
+                                                align(baseBar + barrier_region_bytes(opt.barrier, P)));
+
+  SharedMemory shm(opt.vm ? AddressSpace::phys_bytes_for(mem_bytes, opt.huge_pages) : mem_bytes);
+  auto as = apply_vm(opt, shm, mem_bytes);
+  if (opt.vm && !as) return 2;
+  MesiInterconnect bus(0);
+  bus.set_shared_memory(&shm);
+  apply_arbiter(opt, bus);
+  auto dram = apply_dram(opt, shm);
+  std::unique_ptr<GrantLog> glog;
+  if (!open_grant_log(opt, glog)) return 2;
+  bus.set_grant_log(glog.get());
+  init_dot_inputs(shm, baseA, baseB, N, as.get());
+
+  MESICache c0(0,bus), c1(1,bus), c2(2,bus), c3(3,bus);
+  bus.connect(&c0); bus.connect(&c1); bus.connect(&c2); bus.connect(&c3);
+  for (MESICache* c : {&c0, &c1, &c2, &c3}) {
+    c->setIndexFunction(opt.index);
+    c->setWritePolicy(opt.write_policy);
+  }
+  FalseSharingDetector fsd(P);
+  if (opt.fsd) bus.set_false_sharing_detector(&fsd);
+  auto exporter = start_exporter(opt, bus);
+  auto timeline = start_timeline(opt, bus);
+  PortMetrics pm[P];
+  MesiMemoryPort mp0(c0,bus,&pm[0]), mp1(c1,bus,&pm[1]), mp2(c2,bus,&pm[2]), mp3(c3,bus,&pm[3]);
+  MesiMemoryPort* mps[P] = {&mp0, &mp1, &mp2, &mp3};
+  if (opt.spin_wait) for (auto* mp : mps) mp->set_spin_wait(true);
+  for (auto* mp : mps) mp->set_timeline(timeline.get());
+  std::vector<std::unique_ptr<Mmu>> mmus;
+  for (int k = 0; as && k < P; ++k) {
+    mmus.push_back(std::make_unique<Mmu>(k, *as, mps[k]->cache(), bus, opt.tlb));
+    mps[k]->set_mmu(mmus.back().get());
+  }
+  std::vector<ReuseDistanceProfiler> rd(P, ReuseDistanceProfiler(opt.mrc_rate));
+  if (opt.mrc) for (int k = 0; k < P; ++k) mps[k]->set_reuse_profiler(&rd[k]);
+
+  // Programa por PE (direcciones y episodios como inmediatos)
+  const size_t base_chunk = N/P, rem = N%P;
+  std::vector<std::unique_ptr<PE>> pes;
+  uint64_t episode = 0;
+  size_t off = 0;
+  for (int k = 0; k < P; ++k) {
+    const size_t len = base_chunk + (size_t(k) < rem ? 1 : 0);
+    Program p;
+    for (unsigned r = 0; r < opt.rounds; ++r) {
+      uint64_t ep = 2*r;
+      p.push_back({Op::LI,   0, 0, 0, (int64_t)(baseT + k*LINE)});
+      p.push_back({Op::LOAD, 3, 0, 0, 0});                        // acc = total previo
+      p.push_back({Op::LI,   0, 0, 0, 0});                        // i = 0
+      p.push_back({Op::LI,   1, 0, 0, (int64_t)(baseA + off*8)});
+      p.push_back({Op::LI,   2, 0, 0, (int64_t)(baseB + off*8)});
+      p.push_back({Op::LI,   5, 0, 0, (int64_t)(baseP + k*LINE)});
+      p.push_back({Op::LI,   7, 0, 0, (int64_t)len});
+      p.push_back({Op::LEA,  4, 1, 0, 3});
+      p.push_back({Op::LEA,  6, 2, 0, 3});
+      p.push_back({Op::LOAD, 4, 4, 0, 0});
+      p.push_back({Op::LOAD, 6, 6, 0, 0});
+      p.push_back({Op::FMUL, 4, 4, 6, 0});
+      p.push_back({Op::FADD, 3, 3, 4, 0});
+      p.push_back({Op::INC,  0, 0, 0, 0});
+      p.push_back({Op::DEC,  7, 0, 0, 0});
+      p.push_back({Op::JNZ,  7, 0, 0,-8});
+      p.push_back({Op::STORE,3, 5, 0, 0});                        // parcial_k
+      emit_barrier(p, opt.barrier, baseBar, k, P, ep + 1);
+      p.push_back({Op::LI,   0, 0, 0, (int64_t)baseP});
+      p.push_back({Op::LOAD, 6, 0, 0, 0});
+      for (int j = 1; j < P; ++j) {
+        p.push_back({Op::LI,   0, 0, 0, (int64_t)(baseP + j*LINE)});
+        p.push_back({Op::LOAD, 4, 0, 0, 0});
+        p.push_back({Op::FADD, 6, 6, 4, 0});
+      }
+      p.push_back({Op::LI,   0, 0, 0, (int64_t)(baseT + k*LINE)});
+      p.push_back({Op::STORE,6, 0, 0, 0});                        // total_k
+      emit_barrier(p, opt.barrier, baseBar, k, P, ep + 2);
+    }
+    p.push_back({Op::HALT, 0, 0, 0, 0});
+    off += len;
+    episode = 2ull * opt.rounds;
+
+    pes.push_back(std::make_unique<PE>(k, mps[k]));
+    pes.back()->load_program(p);
+  }
+
+  std::printf("sync: barrera=%s, %u rondas, %llu episodios, memoria=%llu B, espera=%s\n",
+              barrier_kind_name(opt.barrier), opt.rounds, (unsigned long long)episode,
+              (unsigned long long)mem_bytes, opt.spin_wait ? "spin" : "sleep");
+
+  const auto w0 = std::chrono::steady_clock::now();
+  const std::clock_t cpu0 = std::clock();
+  std::vector<std::thread> th;
+  for (auto& pe : pes)
+    th.emplace_back([&pe, g = glog.get()] {
+      pe->run(0);
+      if (g) g->retire(pe->id());
+    });
+  for (auto& t : th) t.join();
+  const double cpu_s  = double(std::clock() - cpu0) / CLOCKS_PER_SEC;
+  const double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - w0).count();
+  std::optional<BusArbiter::Report> arb;
+  if (bus.arbiter()) arb = bus.arbiter()->snapshot();
+
+  // total(r) = 4*total(r-1) + dot
+  const double dot = 0.5 * (double(N)*(N+1)*(2.0*N+1)/6.0);
+  double expected = 0.0;
+  for (unsigned r = 0; r < opt.rounds; ++r) expected = P*expected + dot;
+
+  bool ok = true;
+  DmaAgent dma(bus);
+  for (int k = 0; k < P; ++k) {
+    const double d = dma_read_double(dma, baseT + k*LINE, as.get());
+    std::printf("total[%d] = %.6f\n", k, d);
+    ok = ok && std::abs(d - expected) < 1e-9*std::max(1.0, std::abs(expected));
+  }
+  std::printf("expected = %.6f\n", expected);
+  bus.set_grant_log(nullptr);
+
+  int waits = 0, checks = 0, sleeps = 0;
+  for (const MESICache* c : {&c0, &c1, &c2, &c3}) {
+    waits += c->stats().waits; checks += c->stats().wait_checks; sleeps += c->stats().wait_sleeps;
+  }
+  std::printf("waits=%d checks=%d sleeps=%d | wall=%.3f ms, cpu=%.3f ms\n",
+              waits, checks, sleeps, wall_s*1e3, cpu_s*1e3);
+  if (arb) report_arbiter(*arb);
+  if (dram) report_dram(*dram);
+  if (glog) report_grants(*glog, opt);
+  if (as) report_vm(opt, *as, bus, mmus);
+
+  export_cache_csv({&c0, &c1, &c2, &c3});
+  std::cout << " Métricas exportadas a cache_stats.csv y cache_latency.csv\n";
+  if (opt.set_stats) report_sets({&c0, &c1, &c2, &c3});
+  if (opt.lat_stats) report_latency({&c0, &c1, &c2, &c3});
+  if (opt.fsd) report_false_sharing(fsd);
+  if (opt.mrc) report_mrc(rd);
+  finish_exporter(exporter, opt);
+  finish_timeline(timeline, opt.timeline);
+
+  std::puts(ok ? "PASS sync dotprod" : "FAIL sync dotprod");
+  return ok ? 0 : 1;
+}
+
+// ===================================================================
+// ==================== MODO TRACE (REPRODUCCIÓN) =====================
+// ===================================================================
+// Tope de la memoria densa de la reproducción (páginas de 256 B): una traza que
+// toque más allá (p.ej. direcciones de pila de un proceso real) debe rebasarse
+static constexpr uint64_t kMaxTraceMemBytes = 64ull << 20;
+
+// Fin (exclusivo) de las direcciones de la traza: el de la cabecera o, en trazas
+// de versión 1, una pasada previa de decodificación
+static uint64_t trace_addr_end(const std::string& path, const TraceReader& reader) {
+  if (reader.addr_end()) return reader.addr_end();
+  TraceReader scan(path);
+  uint64_t end = 0;
+  TraceRecord rec;
+  for (int pe = 0; pe < scan.num_pes(); ++pe)
+    while (scan.next(pe, rec))
+      if (rec.kind != TraceKind::Sync) end = std::max(end, rec.addr + 8);
+  return end;
+}
+
+// Alimenta MESICache::load/store de cada PE desde una traza, sin PE::step.
+// La memoria se dimensiona con el rango de direcciones de la traza.
+// Exporta las mismas métricas que --mode=dot (cache_stats.csv).
+int run_trace_mode(const RunOptions& opt) {
+  if (opt.trace_in.empty()) {
+    std::fprintf(stderr, "ERROR: --mode=trace requiere --trace=archivo\n");
+    return 2;
+  }
+  TraceReader reader(opt.trace_in);
+  if (!reader.ok()) {
+    std::fprintf(stderr, "ERROR: %s\n", reader.error().c_str());
+    return 2;
+  }
+
+  const int P = reader.num_pes();
+  const uint64_t addr_end = trace_addr_end(opt.trace_in, reader);
+  if (addr_end > kMaxTraceMemBytes) {
+    std::fprintf(stderr, "ERROR: la traza accede hasta 0x%llx; la reproducción admite hasta "
+                 "0x%llx (%llu MiB). Rebase las direcciones de la traza.\n",
+                 (unsigned long long)addr_end, (unsigned long long)kMaxTraceMemBytes,
+                 (unsigned long long)(kMaxTraceMemBytes >> 20));
+    return 2;
+  }
+  const uint64_t MEM_BYTES = std::max<uint64_t>(
+      SharedMemory::kDefaultBytes,
+      (addr_end + SharedMemory::kPageBytes - 1) / SharedMemory::kPageBytes * SharedMemory::kPageBytes);
+  SharedMemory shm(MEM_BYTES);
+  MesiInterconnect bus(0);
+  bus.set_shared_memory(&shm);
+  auto dram = apply_dram(opt, shm);
+
+  std::vector<std::unique_ptr<MESICache>> caches;
+  std::vector<MESICache*> raw;
+  for (int p = 0; p < P; ++p) {
+    caches.push_back(std::make_unique<MESICache>(p, bus));
+    caches.back()->setIndexFunction(opt.index);
+    caches.back()->setWritePolicy(opt.write_policy);
+    bus.connect(caches.back().get());
+    raw.push_back(caches.back().get());
+  }
+
+  auto exporter = start_exporter(opt, bus);
+  auto timeline = start_timeline(opt, bus);
+  TraceReplayer replayer(raw, opt.quantum);
+  replayer.set_timeline(timeline.get());
+  std::vector<ReuseDistanceProfiler> rd(P, ReuseDistanceProfiler(opt.mrc_rate));
+  if (opt.mrc) {
+    std::vector<ReuseDistanceProfiler*> rdp;
+    for (auto& p : rd) rdp.push_back(&p);
+    replayer.set_reuse_profilers(rdp);
+  }
+  const TraceReplayStats st = replayer.run(reader);
+  if (!reader.error().empty()) {
+    std::fprintf(stderr, "ERROR: traza %s: %s\n", opt.trace_in.c_str(), reader.error().c_str());
+    return 2;
+  }
+
+  std::printf("trace: %d PEs, %llu accesos (%llu loads, %llu stores), %llu barreras%s, memoria %llu B\n",
+              P, (unsigned long long)st.accesses, (unsigned long long)st.loads,
+              (unsigned long long)st.stores, (unsigned long long)st.barriers,
+              reader.compressed() ? ", comprimida" : "", (unsigned long long)MEM_BYTES);
+  std::printf("trace: %.3f s, %.2f Macc/s, %.2f bytes/acceso\n", st.seconds,
+              st.seconds > 0 ? st.accesses / st.seconds / 1e6 : 0.0,
+              st.accesses ? double(st.bytes_read) / double(st.accesses) : 0.0);
+
+  if (dram) report_dram(*dram);
+
+  std::vector<const MESICache*> out(raw.begin(), raw.end());
+  export_cache_csv(out);
+  std::cout << " Métricas exportadas a cache_stats.csv y cache_latency.csv\n";
+  if (opt.set_stats) report_sets(out);
+  if (opt.lat_stats) report_latency(out);
+  if (opt.mrc) report_mrc(rd);
+  finish_exporter(exporter, opt);
+  finish_timeline(timeline, opt.timeline);
+  return 0;
+}
+
 // ===================================================================
 // ================================ MAIN ==============================
 // ===================================================================
 int main(int argc, char** argv) {
   std::string mode = "dot";  // por defecto ejecuta dot product
-  size_t N = 248;            // valor por defecto del enunciado
+  RunOptions opt;            // N=248 por defecto (valor del enunciado)
   bool stepping = true;      // stepping del BUS en --mode=demo (desactivable con --nostep)
 
   // Parseo de flags
   for (int i=1;i<argc;++i) {
     std::string a(argv[i]);
-    if      (a.rfind("--mode=",0)==0) mode = a.substr(7);     // dot | demo
-    else if (a.rfind("--N=",0)==0)    N = std::stoul(a.substr(4));
+    if      (a.rfind("--mode=",0)==0) mode = a.substr(7);     // dot | demo | trace | sync
+    else if (a.rfind("--N=",0)==0)    opt.N = std::stoul(a.substr(4));
     else if (a=="--nostep")           stepping = false;       // solo relevante en demo
+    else if (a.rfind("--watch=",0)==0) opt.watches.push_back(a.substr(8)); // repetible (demo)
+    else if (a.rfind("--checkpoint=",0)==0)    opt.checkpoint_out = a.substr(13);
+    else if (a.rfind("--checkpoint-at=",0)==0) opt.checkpoint_at = std::stoull(a.substr(16));
+    else if (a.rfind("--restore=",0)==0)       opt.restore = a.substr(10);
+    else if (a.rfind("--forks=",0)==0)         opt.forks = unsigned(std::stoul(a.substr(8)));
+    else if (a.rfind("--sample=",0)==0) {
+      if (!parse_sample(a.substr(9), opt.sampling)) {
+        std::fprintf(stderr, "--sample debe ser U:W[:C] con W > 0 y C + W <= U\n");
+        return 1;
+      }
+      opt.sampled = true;
+    }
+    else if (a=="--no-warming")       opt.sampling.functional_warming = false;
+    else if (a.rfind("--index=",0)==0) {
+      if (!index_fn::parse(a.substr(8), opt.index)) {
+        std::fprintf(stderr, "--index debe ser bits|xor|prime|skew\n");
+        return 1;
+      }
+    }
+    else if (a=="--set-stats")        opt.set_stats = true;
+    else if (a=="--lat-stats")        opt.lat_stats = true;
+    else if (a.rfind("--write-policy=",0)==0 || a.rfind("--out-policy=",0)==0) {
+      const bool out = a[2] == 'o';
+      if (!write_policy::parse(a.substr(a.find('=') + 1), out ? opt.out_policy : opt.write_policy)) {
+        std::fprintf(stderr, "%s debe ser wb|wb-na|wt|wt-na\n", out ? "--out-policy" : "--write-policy");
+        return 1;
+      }
+      if (out) opt.out_policy_set = true;
+    }
+    else if (a=="--store-out")        opt.store_out = true;
+    else if (a=="--nt")               opt.nt_stores = true;
+    else if (a.rfind("--arb=",0)==0) {
+      if (!parse_arb_policy(a.substr(6), opt.arb)) {
+        std::fprintf(stderr, "--arb debe ser none|fcfs|rr|prio|age\n");
+        return 1;
+      }
+    }
+    else if (a.rfind("--numa=",0)==0) {
+      if (!parse_numa(a.substr(7), opt)) {
+        std::fprintf(stderr, "--numa debe ser C[:G] con 1 <= C <= 32 y G múltiplo de %zu\n",
+                     SharedMemory::kPageBytes);
+        return 1;
+      }
+    }
+    else if (a=="--placement=local")      opt.numa_local = true;
+    else if (a=="--placement=interleave") opt.numa_local = false;
+    else if (a.rfind("--noc=",0)==0) {
+      if (!parse_noc_topology(a.substr(6), opt.noc_cfg)) {
+        std::fprintf(stderr, "--noc debe ser ring|mesh[:COLS]\n");
+        return 1;
+      }
+      opt.noc = true;
+    }
+    else if (a.rfind("--noc-hop=",0)==0)  opt.noc_cfg.hop_cycles = uint32_t(std::stoul(a.substr(10)));
+    else if (a.rfind("--noc-flit=",0)==0) opt.noc_cfg.flit_bytes = uint32_t(std::stoul(a.substr(11)));
+    else if (a.rfind("--dram=",0)==0) {
+      if (!parse_dram_sched(a.substr(7), opt.dram_cfg.sched)) {
+        std::fprintf(stderr, "--dram debe ser fcfs|frfcfs\n");
+        return 1;
+      }
+      opt.dram = true;
+    }
+    else if (a.rfind("--page=",0)==0) {
+      if (!parse_dram_page(a.substr(7), opt.dram_cfg.page)) {
+        std::fprintf(stderr, "--page debe ser open|closed\n");
+        return 1;
+      }
+    }
+    else if (a.rfind("--dram-map=",0)==0) opt.dram_cfg.map = a.substr(11);
+    else if (a.rfind("--dram-geom=",0)==0) {
+      if (!parse_dram_geom(a.substr(12), opt.dram_cfg)) {
+        std::fprintf(stderr, "--dram-geom debe ser C:R:B\n");
+        return 1;
+      }
+    }
+    else if (a.rfind("--pes=",0)==0) {
+      opt.pes = std::stoi(a.substr(6));
+      if (opt.pes < 1 || opt.pes > 32) {
+        std::fprintf(stderr, "--pes debe estar entre 1 y 32\n");
+        return 1;
+      }
+    }
+    else if (a.rfind("--record-trace=",0)==0) opt.record_trace = a.substr(15);
+    else if (a.rfind("--record-grants=",0)==0) opt.record_grants = a.substr(16);
+    else if (a=="--vm")   opt.vm = true;
+    else if (a=="--huge") opt.vm = opt.huge_pages = true;
+    else if (a.rfind("--tlb=",0)==0 || a.rfind("--tlb-huge=",0)==0) {
+      const bool h = a[5] == '-';
+      if (!parse_tlb_geom(a.substr(h ? 11 : 6), h ? opt.tlb.huge_entries : opt.tlb.entries,
+                          h ? opt.tlb.huge_ways : opt.tlb.ways)) {
+        std::fprintf(stderr, "%s debe ser E[:W] con E múltiplo de W\n", h ? "--tlb-huge" : "--tlb");
+        return 1;
+      }
+      opt.vm = true;
+    }
+    else if (a.rfind("--replay-grants=",0)==0) opt.replay_grants = a.substr(16);
+    else if (a=="--trace-compress")   opt.trace_compress = true;
+    else if (a.rfind("--trace=",0)==0) opt.trace_in = a.substr(8);
+    else if (a.rfind("--quantum=",0)==0) opt.quantum = unsigned(std::stoul(a.substr(10)));
+    else if (a.rfind("--barrier=",0)==0) {
+      if (!parse_barrier_kind(a.substr(10), opt.barrier)) {
+        std::fprintf(stderr, "--barrier debe ser central|tree|dissem|hw\n");
+        return 1;
+      }
+    }
+    else if (a.rfind("--rounds=",0)==0) opt.rounds = unsigned(std::stoul(a.substr(9)));
+    else if (a=="--fsd")             opt.fsd = true;
+    else if (a=="--packed-partials") opt.packed_partials = true;
+    else if (a=="--mrc")             opt.mrc = true;
+    else if (a.rfind("--metrics=",0)==0) opt.metrics_endpoint = a.substr(10);
+    else if (a.rfind("--metrics-linger=",0)==0) opt.metrics_linger = std::stod(a.substr(17));
+    else if (a.rfind("--timeline=",0)==0) opt.timeline = a.substr(11);
+    else if (a.rfind("--timeline-every=",0)==0) {
+      if (!parse_timeline_every(a.substr(17), opt.timeline_cfg)) {
+        std::fprintf(stderr, "--timeline-every debe ser K (accesos) o Kc (ciclos), K >= 1\n");
+        return 1;
+      }
+    }
+    else if (a.rfind("--mrc-rate=",0)==0) { opt.mrc = true; opt.mrc_rate = std::stod(a.substr(11)); }
+    else if (a=="--wait=spin")  opt.spin_wait = true;
+    else if (a=="--wait=sleep") opt.spin_wait = false;
+    else if (a.rfind("--reduce=",0)==0) {
+      if (!parse_reduce(a.substr(9), opt.reduce)) {
+        std::fprintf(stderr, "--reduce debe ser host|fadd|cas|llsc|lock\n");
+        return 1;
+      }
+    }
+  }
+
+  if (opt.numa_nodes > 1) {
+    if (mode != "dot" || opt.numa_nodes > opt.pes || !opt.checkpoint_out.empty() ||
+        !opt.restore.empty() || opt.forks || opt.sampled || !opt.metrics_endpoint.empty()) {
+      std::fprintf(stderr, "--numa: solo en --mode=dot, con C <= --pes y sin --checkpoint/"
+                           "--restore/--forks/--sample/--metrics\n");
+      return 1;
+    }
+  }
+
+  if (!opt.timeline.empty() && ((mode != "dot" && mode != "sync" && mode != "trace") ||
+                                opt.numa_nodes > 1 || opt.forks || opt.sampled)) {
+    std::fprintf(stderr, "--timeline: solo en --mode=dot|sync|trace, sin --numa/--forks/--sample\n");
+    return 1;
+  }
+
+  if (opt.noc && (mode != "dot" || opt.numa_nodes > 1 || opt.forks || opt.sampled)) {
+    std::fprintf(stderr, "--noc: solo en --mode=dot, sin --numa/--forks/--sample\n");
+    return 1;
+  }
+
+  if ((opt.nt_stores || opt.out_policy_set) && !opt.store_out) {
+    std::fprintf(stderr, "--nt y --out-policy requieren --store-out\n");
+    return 1;
+  }
+  if (opt.store_out && (mode != "dot" || opt.reduce != Reduce::Host || opt.packed_partials ||
+                        opt.forks || (opt.nt_stores && !opt.checkpoint_out.empty()))) {
+    std::fprintf(stderr, "--store-out: solo en --mode=dot, sin --reduce/--packed-partials/--forks "
+                         "(y --nt sin --checkpoint)\n");
+    return 1;
+  }
+
+  if (!opt.record_grants.empty() || !opt.replay_grants.empty()) {
+    if ((mode != "dot" && mode != "sync") || (!opt.record_grants.empty() && !opt.replay_grants.empty()) ||
+        !opt.checkpoint_out.empty() || !opt.restore.empty() || opt.forks || opt.sampled) {
+      std::fprintf(stderr, "--record-grants/--replay-grants: uno solo, en --mode=dot|sync y sin "
+                           "--checkpoint/--restore/--forks/--sample\n");
+      return 1;
+    }
+  }
+
+  if (opt.vm) {
+    std::string err;
+    if ((mode != "dot" && mode != "sync") || opt.numa_nodes > 1 || !opt.checkpoint_out.empty() ||
+        !opt.restore.empty() || opt.forks || opt.sampled) {
+      std::fprintf(stderr, "--vm/--huge/--tlb: solo en --mode=dot|sync, sin --numa/--checkpoint/"
+                           "--restore/--forks/--sample\n");
+      return 1;
+    }
+    if (!Tlb::validate(opt.tlb, &err)) {
+      std::fprintf(stderr, "--tlb: %s\n", err.c_str());
+      return 1;
+    }
+  }
+
+  if (opt.dram) {
+    std::string err;
+    if (!DramController::validate(opt.dram_cfg, &err)) {
+      std::fprintf(stderr, "--dram: %s\n", err.c_str());
+      return 1;
+    }
   }
 
-  if (mode == "dot")  return run_dot_mode(N);
-  if (mode == "demo") return run_demo_mode(N, stepping);
+  if (mode == "dot")   return run_dot_mode(opt);
+  if (mode == "demo")  return run_demo_mode(opt, stepping);
+  if (mode == "trace") return run_trace_mode(opt);
+  if (mode == "sync")  return run_sync_mode(opt);
 
-  std::fprintf(stderr,"Uso: %s [--mode=dot|demo] [--N=248] [--nostep]\n", argv[0]);
+  std::fprintf(stderr,"Uso: %s [--mode=dot|demo|trace|sync] [--N=248] [--nostep] [--watch=SPEC]...\n"
+                      "       [--record-trace=f.trc] [--trace-compress] [--trace=f.trc] [--quantum=Q]\n"
+                      "       [--reduce=host|fadd|cas|llsc|lock]\n"
+                      "       [--barrier=central|tree|dissem|hw] [--rounds=R] [--wait=sleep|spin]\n"
+                      "       [--fsd] [--packed-partials] [--mrc] [--mrc-rate=R]\n"
+                      "       [--metrics=tcp:PUERTO|unix:RUTA] [--metrics-linger=S]\n"
+                      "       [--timeline=f.jsonl] [--timeline-every=K|Kc]\n"
+                      "       [--checkpoint=f.ckp] [--checkpoint-at=S] [--restore=f.ckp] [--forks=K]\n"
+                      "       [--sample=U:W[:C]] [--no-warming]\n"
+                      "       [--index=bits|xor|prime|skew] [--set-stats] [--lat-stats]\n"
+                      "       [--arb=none|fcfs|rr|prio|age] [--pes=P]\n"
+                      "       [--numa=C[:G]] [--placement=interleave|local]\n"
+                      "       [--noc=ring|mesh[:COLS]] [--noc-hop=H] [--noc-flit=B]\n"
+                      "       [--dram=fcfs|frfcfs] [--page=open|closed] [--dram-map=RoRaBaCoCh]\n"
+                      "       [--dram-geom=C:R:B]\n"
+                      "       [--write-policy=wb|wb-na|wt|wt-na] [--store-out] [--out-policy=P] [--nt]\n"
+                      "       [--record-grants=f.gnt | --replay-grants=f.gnt]\n"
+                      "       [--vm] [--huge] [--tlb=E[:W]] [--tlb-huge=E[:W]]\n", argv[0]);
   return 1;
 }
 
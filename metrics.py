@@ -1,6 +1,12 @@
+import argparse
 import pandas as pd
 import matplotlib.pyplot as plt
 
+ap = argparse.ArgumentParser(description="Gráficas de cache_stats.csv y demás salidas de mp_main")
+ap.add_argument("--timeline", default="timeline.jsonl",
+                help="serie temporal de --timeline (JSON lines; por defecto timeline.jsonl)")
+args = ap.parse_args()
+
 # ---------- Carga ----------
 df = pd.read_csv("cache_stats.csv")
 
@@ -32,6 +38,25 @@ plt.tight_layout()
 plt.savefig("metrics_by_PE.png")
 plt.close()
 
+# ---------- Gráfica 1b: Desglose de misses por PE (barras apiladas) ----------
+miss_cols = ["Miss_Compulsory","Miss_Capacity","Miss_Conflict","Miss_Coherence"]
+if all(c in df.columns for c in miss_cols):
+    for c in miss_cols:
+        df[c] = pd.to_numeric(df[c], errors="coerce").fillna(0).astype(int)
+    plt.figure(figsize=(8,6))
+    bottom = [0]*len(df)
+    for col in miss_cols:
+        vals = df[col].tolist()
+        plt.bar(pe_labels, vals, bottom=bottom, label=col.replace("Miss_", ""))
+        bottom = [b + v for b, v in zip(bottom, vals)]
+    plt.xlabel("PE")
+    plt.ylabel("Misses")
+    plt.title("Clasificación de misses por PE")
+    plt.legend()
+    plt.tight_layout()
+    plt.savefig("miss_breakdown.png")
+    plt.close()
+
 # ---------- Gráfica 2: Transiciones MESI totales ----------
 # Tu CSV trae algo como:
 # "MESI: 2->1; MESI: 1->0; MESI: 1->3; MESI: 3->1"
@@ -72,5 +97,67 @@ if transition_counts:
 else:
     print("No hay transiciones MESI registradas en el CSV.")
 
-print("Listo: metrics_by_PE.png y (si aplica) mesi_transitions.png")
+# ---------- Gráfica 3: Curva miss-ratio (si se corrió con --mrc) ----------
+import os
+if os.path.exists("mrc.csv"):
+    mrc = pd.read_csv("mrc.csv")
+    plt.figure(figsize=(8,6))
+    for col in [c for c in mrc.columns if c.startswith("PE") or c == "All"]:
+        plt.plot(mrc["Bytes"], mrc[col], label=col, linewidth=2.5 if col == "All" else 1.0)
+    plt.xscale("log", base=2)
+    plt.xlabel("Capacidad FA-LRU (bytes)")
+    plt.ylabel("Miss ratio")
+    plt.title("Curva miss-ratio (reuse distance)")
+    plt.legend()
+    plt.tight_layout()
+    plt.savefig("mrc.png")
+    plt.close()
+
+# ---------- Gráfica 4: Serie temporal (si se corrió con --timeline=f; ver --timeline) ----------
+# Cada línea trae contadores acumulados; cada intervalo es la diferencia entre
+# dos muestras seguidas. Eje x: la unidad de --timeline-every ("unit" de cada
+# línea): accesos totales o ciclos del modelo.
+import json
+if os.path.exists(args.timeline):
+    with open(args.timeline) as f:
+        samples = [json.loads(l) for l in f if l.strip()]
+    if len(samples) >= 2:
+        x_key = samples[0].get("unit", "accesses")
+        per = "ciclo" if x_key == "cycles" else "acceso"
+        xs, miss_pe, bus_tx, bus_bytes = [], {}, [], []
+        tx_types = ["BusRd", "BusRdX", "BusUpgr", "Flush", "BusWr", "BusWrLine"]
+        for prev, cur in zip(samples, samples[1:]):
+            d_x = cur[x_key] - prev[x_key]
+            if d_x <= 0:
+                continue
+            xs.append(cur[x_key])
+            for p0, p1 in zip(prev["pes"], cur["pes"]):
+                acc = p1["accesses"] - p0["accesses"]
+                rate = (p1["misses"] - p0["misses"]) / acc if acc > 0 else 0.0
+                miss_pe.setdefault(p1["pe"], []).append(rate)
+            bus_tx.append({t: (cur["bus"].get(t, 0) - prev["bus"].get(t, 0)) / d_x for t in tx_types})
+            bus_bytes.append((cur["bus"].get("data_bytes", 0) - prev["bus"].get("data_bytes", 0)) / d_x)
+
+        fig, (ax1, ax2) = plt.subplots(2, 1, figsize=(10, 8), sharex=True)
+        for pe, rates in sorted(miss_pe.items()):
+            ax1.plot(xs, rates, label=f"PE{pe}")
+        ax1.set_ylabel("Tasa de miss del intervalo")
+        ax1.set_title("Serie temporal (--timeline)")
+        ax1.legend()
+        for t in tx_types:
+            vals = [b[t] for b in bus_tx]
+            if any(vals):
+                ax2.plot(xs, vals, label=t)
+        ax2.set_ylabel(f"Transacciones por {per}")
+        ax2b = ax2.twinx()
+        ax2b.plot(xs, bus_bytes, "k--", linewidth=1.0, label="bytes")
+        ax2b.set_ylabel(f"Bytes de datos por {per}")
+        ax2.legend(loc="upper left")
+        ax2.set_xlabel("Ciclos del modelo (acumulados)" if x_key == "cycles"
+                       else "Accesos (RW_Accesses acumulados)")
+        plt.tight_layout()
+        plt.savefig("timeline.png")
+        plt.close()
+
+print("Listo: metrics_by_PE.png, miss_breakdown.png y (si aplica) mesi_transitions.png / mrc.png / timeline.png")
 
@@ -2,6 +2,11 @@
 #include "../src/memory/SharedMemory.h" 
 #include "../src/memory/cache/mesi/MESICache.hpp"  
 #include "../src/utils/Stepper.hpp"     
+#include "checkpoint/Checkpoint.hpp"
+#include "numa/NumaDirectory.hpp"
+#include "noc/NocModel.hpp"
+#include "vm/Mmu.hpp"
+#include "sampling/Timing.hpp"
 
 #include <memory>
 #include <cstring>
@@ -15,13 +20,140 @@ MesiInterconnect::MesiInterconnect(size_t ) {
 }
 
 void MesiInterconnect::connect(MESICache* c) {
-  std::lock_guard<std::recursive_mutex> lk(mtx_);
+  std::lock_guard<std::recursive_mutex> lk(lock_());
   caches_.push_back(c);
+  ids_.push_back(c->id());
+  if (fsd_) c->setFalseSharingDetector(fsd_);
+}
+
+void MesiInterconnect::add_mmu(Mmu* m) {
+  std::lock_guard<std::recursive_mutex> lk(lock_());
+  mmus_.push_back(m);
+}
+
+void MesiInterconnect::tlb_shootdown(int src_pe, uint64_t va, bool huge) {
+  Grant g = hold(src_pe);
+  ++stats_.tlb_shootdowns;
+  for (Mmu* m : mmus_) m->invalidate(va, huge);
+}
+
+void MesiInterconnect::set_directory(NumaDirectory* d, int node) {
+  std::lock_guard<std::recursive_mutex> lk(mtx_);
+  dir_ = d;
+  dir_mtx_ = d ? &d->mutex() : nullptr;
+  node_ = node;
+}
+
+bool MesiInterconnect::remote_snoop(BusMsg type, uint64_t addr, bool* dirty, uint8_t words) {
+  ++remote_depth_;   // los Flush que provoque no arbitran en este bus
+  bool cached = false;
+  {
+    std::lock_guard<std::recursive_mutex> lk(lock_());
+    const uint64_t b = base_(addr);
+    const uint64_t flushes = stats_.flush;
+    cached = any_other_has_line_(-1, b);
+    if (cached) snoop_others_(BusTransaction{type, b, nullptr, MESICache::kLineSize, -1, words});
+    last_flush_.erase(b);   // ya en memoria; el solicitante está en otro bus
+    if (dirty) *dirty = stats_.flush != flushes;
+  }
+  --remote_depth_;
+  return cached;
+}
+
+void MesiInterconnect::set_false_sharing_detector(FalseSharingDetector* d) {
+  std::lock_guard<std::recursive_mutex> lk(lock_());
+  fsd_ = d;
+  for (auto* c : caches_) if (c) c->setFalseSharingDetector(d);
+}
+
+// Contadores del bus en orden fijo (el mismo para save y load)
+using BusCounter = RelaxedCounter<uint64_t> MesiInterconnect::BusStats::*;
+static constexpr BusCounter kBusCounters[] = {
+  &MesiInterconnect::BusStats::busRd,   &MesiInterconnect::BusStats::busRdX,
+  &MesiInterconnect::BusStats::busUpgr, &MesiInterconnect::BusStats::inv,
+  &MesiInterconnect::BusStats::flush,   &MesiInterconnect::BusStats::data_responses,
+  &MesiInterconnect::BusStats::shared_responses, &MesiInterconnect::BusStats::flush_forwards,
+  &MesiInterconnect::BusStats::mem_reads, &MesiInterconnect::BusStats::mem_writes,
+  &MesiInterconnect::BusStats::busWr,   &MesiInterconnect::BusStats::busWrLine,
+  &MesiInterconnect::BusStats::data_bytes, &MesiInterconnect::BusStats::tlb_shootdowns,
+};
+static_assert(sizeof(MesiInterconnect::BusStats) ==
+              sizeof(kBusCounters) / sizeof(kBusCounters[0]) * sizeof(RelaxedCounter<uint64_t>),
+              "agregar el contador nuevo a kBusCounters (checkpoint)");
+
+void MesiInterconnect::save(CheckpointWriter& w) const {
+  std::lock_guard<std::recursive_mutex> lk(lock_());
+  std::vector<uint64_t> keys;
+  for (const auto& kv : last_flush_) keys.push_back(kv.first);
+  std::sort(keys.begin(), keys.end());
+  w.pod(uint64_t(keys.size()));
+  for (uint64_t k : keys) {
+    w.pod(k);
+    w.put(last_flush_.at(k).data(), MESICache::kLineSize);
+  }
+  for (BusCounter c : kBusCounters) w.pod((stats_.*c).load());
+}
+
+bool MesiInterconnect::load(CheckpointReader& r) {
+  std::lock_guard<std::recursive_mutex> lk(lock_());
+  uint64_t count = 0;
+  if (!r.pod(count)) return false;
+  last_flush_.clear();
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t k = 0;
+    std::array<uint8_t, MESICache::kLineSize> line{};
+    if (!r.pod(k) || !r.get(line.data(), line.size())) return false;
+    last_flush_[k] = line;
+  }
+  for (BusCounter c : kBusCounters) {
+    uint64_t v = 0;
+    if (!r.pod(v)) return false;
+    stats_.*c = v;
+  }
+  return true;
+}
+
+void MesiInterconnect::copy_state_from(const MesiInterconnect& o) {
+  std::scoped_lock lk(lock_(), o.lock_());
+  last_flush_ = o.last_flush_;
+  for (BusCounter c : kBusCounters) stats_.*c = o.stats_.*c;
+}
+
+bool MesiInterconnect::dma_snoop(BusMsg type, uint64_t addr, uint8_t words) {
+  Grant g = hold(-1);
+  const uint64_t b = base_(addr);
+  if (dir_) return dir_->dma_snoop(type, b, words);   // todos los clusters con copia
+  const bool cached = any_other_has_line_(-1, b);
+  if (cached) snoop_others_(BusTransaction{type, b, nullptr, MESICache::kLineSize, -1, words});
+  last_flush_.erase(b);
+  return cached;
+}
+
+void MesiInterconnect::drain_caches() {
+  std::lock_guard<std::recursive_mutex> lk(lock_());
+  assert(shm_ && "SharedMemory no adjunta: llama set_shared_memory(&shm) antes de usar el bus");
+  for (MESICache* c : caches_) {
+    if (!c) continue;
+    c->drainLines([this](uint64_t b, const uint8_t* d) {
+      for (int w = 0; w < MESICache::kLineSize; w += 8) {
+        uint64_t u; std::memcpy(&u, d + w, 8);
+        shm_->store64(b + w, u);
+      }
+    });
+  }
+  last_flush_.clear();   // ya persistidas en la memoria por el Flush original
+}
+
+MESICache* MesiInterconnect::cache_of_(int pe) const {
+  if (pe >= 0 && pe < (int)caches_.size() && ids_[pe] == pe) return caches_[pe];
+  for (size_t i = 0; i < caches_.size(); ++i)
+    if (ids_[i] == pe) return caches_[i];
+  return nullptr;
 }
 
 bool MesiInterconnect::any_other_has_line_(int except_id, uint64_t addr) const {
   for (int i = 0; i < (int)caches_.size(); ++i) {
-    if (i == except_id) continue;
+    if (ids_[i] == except_id) continue;
     auto* cc = caches_[i];
     if (!cc) continue;
     if (cc->hasLine(addr)) return true;
@@ -31,7 +163,7 @@ bool MesiInterconnect::any_other_has_line_(int except_id, uint64_t addr) const {
 
 void MesiInterconnect::snoop_others_(const BusTransaction& t) {
   for (int i = 0; i < (int)caches_.size(); ++i) {
-    if (i == t.src_pe) continue;
+    if (ids_[i] == t.src_pe) continue;
     if (!caches_[i]) continue;
     caches_[i]->onSnoop(t);
   }
@@ -40,6 +172,7 @@ void MesiInterconnect::snoop_others_(const BusTransaction& t) {
 // --- Helpers de acceso a memoria compartida (línea completa de 32B) ---
 void MesiInterconnect::read_line_from_mem_(uint64_t b, uint8_t* out) {
   assert(shm_ && "SharedMemory no adjunta: llama set_shared_memory(&shm) antes de usar el bus");
+  ++stats_.mem_reads;
 
   auto req = std::make_shared<Message>(MessageType::READ_MEM, /*dst*/-1, /*src*/-1);
   req->payload.read_mem.address = static_cast<uint32_t>(b);
@@ -61,42 +194,90 @@ void MesiInterconnect::read_line_from_mem_(uint64_t b, uint8_t* out) {
 }
 
 void MesiInterconnect::write_line_to_mem_(uint64_t b, const uint8_t* in) {
-  assert(shm_ && "SharedMemory no adjunta: llama set_shared_memory(&shm) antes de usar el bus");
+  ++stats_.mem_writes;
+  write_to_mem_(b, in, MESICache::kLineSize);
+}
 
+void MesiInterconnect::write_to_mem_(uint64_t addr, const uint8_t* in, uint32_t n) {
+  assert(shm_ && "SharedMemory no adjunta: llama set_shared_memory(&shm) antes de usar el bus");
   auto req = std::make_shared<Message>(MessageType::WRITE_MEM, /*dst*/-1, /*src*/-1);
-  req->payload.write_mem.address = static_cast<uint32_t>(b);
-  req->payload.write_mem.size    = MESICache::kLineSize;
-  req->data_write.assign(in, in + MESICache::kLineSize);
+  req->payload.write_mem.address = static_cast<uint32_t>(addr);
+  req->payload.write_mem.size    = n;
+  req->data_write.assign(in, in + n);
 
   // SharedMemory es síncrona
   shm_->handle_message(req, [&](MessageP /*resp*/) {});
 }
 
 // --- Camino principal del bus ---
-void MesiInterconnect::emit(const BusTransaction& t) {
-  std::lock_guard<std::recursive_mutex> lk(mtx_);
+// Ciclos cobrados hasta ahora por el directorio al nodo (con el bus tomado)
+uint64_t MesiInterconnect::dir_cycles_() const {
+  if (!dir_) return 0;
+  const NumaDirectory::NodeStats s = dir_->stats(node_);
+  return s.local_cycles + s.remote_cycles;
+}
+
+uint64_t MesiInterconnect::emit(const BusTransaction& t) {
+  Grant g = hold(t.src_pe);   // arbitra solo la primera retención del hilo
+  if (glog_) glog_->note(t);
   const uint64_t b = base_(t.addr);
+  const uint64_t dir0 = dir_cycles_();
+  // Palabras que escribe (las ven los clusters que el directorio invalida)
+  const uint8_t words = lineWordMask(t.addr, t.type == BusMsg::BusWrLine ? MESICache::kLineSize : 1);
+
+  switch (t.type) {
+    case BusMsg::BusRd:   ++stats_.busRd;   break;
+    case BusMsg::BusRdX:  ++stats_.busRdX;  break;
+    case BusMsg::BusUpgr: ++stats_.busUpgr; break;
+    case BusMsg::Inv:     ++stats_.inv;     break;
+    case BusMsg::Flush:   ++stats_.flush;   break;
+    case BusMsg::BusWr:     ++stats_.busWr;     break;
+    case BusMsg::BusWrLine: ++stats_.busWrLine; break;
+    default: break;
+  }
 
   // A) Intervención/Flush: cache en M escribe la línea de vuelta
   if (t.type == BusMsg::Flush && t.payload && t.size == MESICache::kLineSize) {
     auto& slot = last_flush_[b];
     std::memcpy(slot.data(), t.payload, MESICache::kLineSize);
+    stats_.data_bytes += MESICache::kLineSize;
 
     // Persistir al backing store real (SharedMemory)
     write_line_to_mem_(b, slot.data());
+    if (dir_) dir_->write_back(node_, b);
+    if (noc_) noc_->flush(t.src_pe, b);
 
-   
-    if (stepper_) stepper_->pause("Flush", caches_, shm_);
-    return;
+    if (stepper_) stepper_->pause(t, caches_, shm_);
+    return dir_ ? dir_cycles_() - dir0 : timing::kWriteBackCycles;
   }
 
   // B) Snoop a las demás cachés (invalidaciones/observaciones)
+  if (noc_ && t.type != BusMsg::Data && t.type != BusMsg::Flush) noc_->begin(t.src_pe);
   snoop_others_(t);
 
+  // Escritura sin la línea (write-through/-around o store no temporal): las
+  // copias ajenas ya se invalidaron (un dueño en M hizo Flush antes si la
+  // escritura es parcial); los datos van directo a memoria y el reenvío
+  // pendiente de last_flush_ deja de ser la versión actual.
+  if (t.type == BusMsg::BusWr || t.type == BusMsg::BusWrLine) {
+    assert(t.payload && t.size);
+    if (dir_) dir_->acquire(node_, b, /*exclusive*/true, /*needs_data*/false, words);
+    write_to_mem_(t.addr, t.payload, t.size);
+    stats_.data_bytes += t.size;
+    last_flush_.erase(b);
+    uint64_t cycles = timing::kWriteBackCycles;
+    if (noc_) cycles = noc_->end(t.type, b, /*from_memory*/false);
+    if (stepper_) stepper_->pause(t, caches_, shm_);
+    return cycles + dir_cycles_() - dir0;
+  }
+
 
   if (t.type == BusMsg::Inv || t.type == BusMsg::BusUpgr) {
-    if (stepper_) stepper_->pause(
-      (t.type == BusMsg::Inv) ? "Inv" : "BusUpgr", caches_, shm_);
+    uint64_t cycles = timing::kBusUpgrCycles;
+    if (dir_) dir_->acquire(node_, b, /*exclusive*/true, /*needs_data*/false, words);
+    if (noc_) cycles = noc_->end(t.type, b, /*from_memory*/false);
+    if (stepper_) stepper_->pause(t, caches_, shm_);
+    return cycles + dir_cycles_() - dir0;
   }
 
   // C) Lecturas
@@ -106,27 +287,41 @@ void MesiInterconnect::emit(const BusTransaction& t) {
       shared = any_other_has_line_(t.src_pe, t.addr);
     }
 
+    // Fuera del cluster: copias remotas y latencia según el home de la línea
+    if (dir_ && dir_->acquire(node_, b, t.type == BusMsg::BusRdX, !last_flush_.count(b), words) &&
+        t.type == BusMsg::BusRd)
+      shared = true;
+
     std::array<uint8_t, MESICache::kLineSize> line{};
 
     // 1) Si alguien flusheó justo antes, úsalo (ya quedó persistido también)
+    bool from_memory = false;
     if (auto it = last_flush_.find(b); it != last_flush_.end()) {
       line = it->second;
       last_flush_.erase(it);
+      ++stats_.flush_forwards;
     } else {
       // 2) Leer línea desde SharedMemory
       read_line_from_mem_(b, line.data());
+      from_memory = true;
     }
-
-
-    if (stepper_) stepper_->pause(
-      (t.type == BusMsg::BusRd) ? "BusRd" : "BusRdX", caches_, shm_);
+    // Con directorio la lectura de memoria ya la cobró acquire()
+    uint64_t cycles = from_memory ? (dir_ ? 0 : timing::kMemLineCycles) : timing::kCacheToCacheCycles;
+    if (noc_) cycles = noc_->end(t.type, b, from_memory);
+    cycles += dir_cycles_() - dir0;
 
     // D) Responder al solicitante
-    auto* src = (t.src_pe >= 0 && t.src_pe < (int)caches_.size()) ? caches_[t.src_pe] : nullptr;
+    auto* src = cache_of_(t.src_pe);
+    ++stats_.data_responses;
+    stats_.data_bytes += MESICache::kLineSize;
+    if (shared) ++stats_.shared_responses;
     if (src) {
       src->onDataResponse(t.addr, line.data(),
                           (t.type == BusMsg::BusRd) ? shared : false);
     }
-    return;
+    // El stepper ve la línea ya instalada en el solicitante
+    if (stepper_) stepper_->pause(t, caches_, shm_);
+    return cycles;
   }
+  return 0;
 }
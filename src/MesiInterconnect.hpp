@@ -7,28 +7,166 @@
 #include <cstring>
 #include <cassert>
 #include <functional>
+#include <memory>
 #include "../src/memory/SharedMemory.h" 
 #include "../src/memory/cache/mesi/MESICache.hpp"         // BusTransaction, BusMsg, kLineSize
 #include "../src/utils/Stepper.hpp"
+#include "../src/utils/RelaxedCounter.hpp"
+#include "../src/bus/BusArbiter.hpp"
+#include "../src/bus/GrantLog.hpp"
 
 
+class CheckpointWriter;
+class CheckpointReader;
+class NumaDirectory;
+class NocModel;
+class Mmu;
+
 class MesiInterconnect {
 public:
+  // Contadores del bus (se actualizan con el bus tomado; legibles en vivo sin lock)
+  struct BusStats {
+    RelaxedCounter<uint64_t> busRd, busRdX, busUpgr, inv, flush; // transacciones por tipo
+    RelaxedCounter<uint64_t> data_responses;  // respuestas Data a BusRd/BusRdX
+    RelaxedCounter<uint64_t> shared_responses;// ...de ellas, con otra copia (=> S)
+    RelaxedCounter<uint64_t> flush_forwards;  // datos servidos desde el último Flush
+    RelaxedCounter<uint64_t> mem_reads;       // líneas leídas de SharedMemory
+    RelaxedCounter<uint64_t> mem_writes;      // líneas escritas a SharedMemory
+    RelaxedCounter<uint64_t> busWr, busWrLine;// escrituras sin la línea (8 B / línea completa)
+    RelaxedCounter<uint64_t> data_bytes;      // bytes de datos por el bus (Data, Flush, BusWr*)
+    RelaxedCounter<uint64_t> tlb_shootdowns;  // invalidaciones de TLB difundidas (vm/Mmu.hpp)
+  };
+
   explicit MesiInterconnect(size_t /*dram_bytes*/); 
   void set_shared_memory(SharedMemory* shm) { shm_ = shm; }
   void connect(MESICache* cache);
 
-  void emit(const BusTransaction& t);    
+  // Resuelve la transacción (síncrona) y devuelve su latencia en ciclos según el
+  // modelo de tiempo: sampling/Timing.hpp por origen de los datos, más lo que
+  // cobre el directorio NUMA, o la latencia de la red si hay NocModel.
+  uint64_t emit(const BusTransaction& t);
   void attachCachePtr(int id, MESICache* c);
   void set_stepper(Stepper* s) { stepper_ = s; }
 
+  const BusStats& stats() const { return stats_; }
+  const std::vector<MESICache*>& caches() const { return caches_; }
+
+  // Checkpoint del bus: líneas pendientes en last_flush_ y contadores.
+  // Las L1$ se guardan aparte (ver checkpoint/Checkpoint.hpp).
+  void save(CheckpointWriter& w) const;
+  bool load(CheckpointReader& r);
+  // Fork en memoria del estado propio del bus (last_flush_ y contadores)
+  void copy_state_from(const MesiInterconnect& o);
+
+  // Agente DMA (ver dma/DmaAgent.hpp): snoop de la línea de 'addr' sin solicitante
+  // (src_pe = -1) ni respuesta Data. BusRd: las copias en M hacen Flush y quedan
+  // en S; Inv: se invalidan (con Flush si estaban en M). Descarta el reenvío
+  // pendiente de last_flush_ (la memoria ya tiene esos datos) para que una
+  // escritura DMA posterior no quede tapada. 'words': palabras de la línea que
+  // escribe el DMA (ver BusTransaction::words). true si alguna L1$ tenía copia.
+  bool dma_snoop(BusMsg type, uint64_t addr, uint8_t words = 0);
+  SharedMemory* shared_memory() const { return shm_; }
+
+  // Simulación muestreada: escribe a SharedMemory las líneas en M de todas las
+  // L1$ y las vacía (sin transacciones ni contadores). Con los PEs detenidos.
+  void drain_caches();
+
+  // Activa el análisis de false sharing en todas las L1$ conectadas (y las futuras)
+  void set_false_sharing_detector(FalseSharingDetector* d);
+
+  // Concesión del bus: pasa por el árbitro (si hay) y luego toma el lock del
+  // bus. Se suelta en orden inverso para que el siguiente elegido lo encuentre libre.
+  // Con GrantLog, el turno del log se espera antes del árbitro.
+  class Grant {
+  public:
+    Grant(BusArbiter* arb, std::recursive_mutex& m, int requester, GrantLog* glog = nullptr)
+        : arb_(arb), glog_(glog) {
+      if (glog_) glog_->begin(requester);
+      if (arb_) arb_->lock(requester);
+      lk_ = std::unique_lock<std::recursive_mutex>(m);
+      if (glog_) glog_->granted();
+    }
+    Grant(Grant&& o) noexcept : arb_(o.arb_), glog_(o.glog_), lk_(std::move(o.lk_)) {
+      o.arb_ = nullptr;
+      o.glog_ = nullptr;
+    }
+    Grant(const Grant&) = delete;
+    Grant& operator=(const Grant&) = delete;
+    Grant& operator=(Grant&&) = delete;
+    ~Grant() {
+      if (lk_.owns_lock()) lk_.unlock();
+      if (arb_) arb_->unlock();
+      if (glog_) glog_->end();
+    }
+  private:
+    BusArbiter* arb_;
+    GrantLog* glog_;
+    std::unique_lock<std::recursive_mutex> lk_;
+  };
+
+  // Retiene el bus (reentrante) mientras dure el guard: lo usan los atómicos de
+  // MESICache para que ningún snoop se intercale entre obtener M y escribir.
+  // 'requester' es el PE que arbitra (-1 = DMA/host). Dentro de un snoop remoto
+  // (el hilo ya retiene el bus de otro cluster) no se arbitra.
+  Grant hold(int requester = -1) {
+    return Grant(remote_depth_ ? nullptr : arb_.get(), lock_(), requester, glog_);
+  }
+
+  // Cluster NUMA (ver numa/NumaDirectory.hpp): lo llama NumaDirectory::attach,
+  // antes de conectar las L1$. Los pedidos que el bus no resuelve con sus L1$
+  // pasan por el directorio y, desde entonces, el lock del bus es el del
+  // directorio (uno solo para toda la jerarquía).
+  void set_directory(NumaDirectory* d, int node);
+  NumaDirectory* directory() const { return dir_; }
+  int numa_node() const { return node_; }
+
+  // Snoop desde otro cluster (lo usa el directorio con el lock tomado): como
+  // dma_snoop pero sin pasar por el árbitro ni por el directorio. '*dirty'
+  // indica si alguna copia estaba en M (hizo Flush a memoria); 'words', las
+  // palabras que escribe el que invalida.
+  bool remote_snoop(BusMsg type, uint64_t addr, bool* dirty, uint8_t words = 0);
+
+  // Arbitraje explícito (ver bus/BusArbiter.hpp). nullptr = política None: gana
+  // quien tome el lock del bus, sin contabilidad. Antes de arrancar los PEs.
+  void set_arbiter(std::unique_ptr<BusArbiter> a) { arb_ = std::move(a); }
+  BusArbiter* arbiter() const { return arb_.get(); }
+
+  // Modelo de red en chip (ver noc/NocModel.hpp): cada transacción se traduce a
+  // paquetes por un anillo o una malla para estimar latencia y tráfico por
+  // enlace. No cambia el protocolo. nullptr = sin modelo. Antes de arrancar los PEs.
+  void set_noc(NocModel* n) { noc_ = n; }
+  NocModel* noc() const { return noc_; }
+
+  // Memoria virtual (ver vm/Mmu.hpp): cada Mmu se registra al crearse.
+  // tlb_shootdown, con el bus retenido por 'src_pe', invalida la página de 'va'
+  // en todas las TLB registradas (también la del emisor).
+  void add_mmu(Mmu* m);
+  void tlb_shootdown(int src_pe, uint64_t va, bool huge);
+
+  // Grabación/reproducción del orden de concesiones (ver bus/GrantLog.hpp).
+  // Con NUMA, el mismo log en todos los clusters. Antes de arrancar los PEs.
+  void set_grant_log(GrantLog* g) { glog_ = g; }
+  GrantLog* grant_log() const { return glog_; }
+
 private:
   // por-id
   std::vector<std::function<void(const BusTransaction&)>> snoop_sinks_; // callbacks de snoop
   std::vector<MESICache*> caches_;   
   std::unordered_map<uint64_t, std::array<uint8_t, MESICache::kLineSize>> last_flush_;
-  std::recursive_mutex mtx_; 
+  mutable std::recursive_mutex mtx_; 
+  std::recursive_mutex& lock_() const { return dir_mtx_ ? *dir_mtx_ : mtx_; }
   Stepper* stepper_ = nullptr;
+  BusStats stats_;
+  FalseSharingDetector* fsd_ = nullptr;
+  std::unique_ptr<BusArbiter> arb_;
+  NocModel* noc_ = nullptr;
+  GrantLog* glog_ = nullptr;
+  std::vector<Mmu*> mmus_;
+  NumaDirectory* dir_ = nullptr;
+  std::recursive_mutex* dir_mtx_ = nullptr;
+  int node_ = 0;
+  static inline thread_local int remote_depth_ = 0;
+  std::vector<int> ids_;   // id de cada L1$ de caches_ (los PEs de un cluster no empiezan en 0)
 
   //dirección base de una línea de caché.
   SharedMemory* shm_ = nullptr;
@@ -38,8 +176,11 @@ private:
 
   void read_line_from_mem_(uint64_t base_addr, uint8_t out[32]);
   void write_line_to_mem_(uint64_t base_addr, const uint8_t in[32]);
+  void write_to_mem_(uint64_t addr, const uint8_t* in, uint32_t n);
 
    // implementación real
+  MESICache* cache_of_(int pe) const;
+  uint64_t dir_cycles_() const;
   bool any_other_has_line_(int except_id, uint64_t addr) const;
   void snoop_others_(const BusTransaction& t);
 };
\ No newline at end of file
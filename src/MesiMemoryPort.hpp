@@ -0,0 +1,170 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "MesiInterconnect.hpp"
+#include "memory/cache/mesi/MESICache.hpp"
+#include "trace/Trace.hpp"
+#include "analysis/ReuseDistance.hpp"
+#include "vm/Mmu.hpp"
+#include "telemetry/IntervalSampler.hpp"
+#include "../PE/pe/pe.hpp"
+
+/*
+ * MesiMemoryPort.hpp
+ * ==================
+ * Adaptador entre el PE (interfaz IMemoryPort) y su L1$ MESI.
+ *
+ * - load64/store64 de 8 bytes coherentes a través de la caché.
+ * - Bus "síncrono" simplificado: si la caché devuelve false es porque emitió
+ *   BusRd/BusRdX; el reintento ya es hit tras onDataResponse() del bus.
+ *
+ * Lo comparten main.cpp, apps/ y el benchmark (antes cada ejecutable tenía su copia).
+ *
+ * Opcional: set_trace_writer() registra cada load/store del PE en una traza
+ * compacta (ver trace/Trace.hpp) para reproducirla luego con --mode=trace.
+ * Opcional: set_reuse_profiler() alimenta un perfil de reuse distance con el mismo
+ * flujo de accesos (curva miss-ratio para todas las capacidades, --mrc).
+ * Opcional: set_mmu() hace virtuales las direcciones del PE; cada acceso pasa
+ * por la TLB (y el page walk) antes de la L1$. Traza y perfil ven la física.
+ * Un fallo de página sin resolver se imprime y queda en fault(): el PE se
+ * detiene (ver IMemoryPort::fault).
+ * Opcional: set_timeline() cuenta el avance de la L1$ en cada acceso y dispara
+ * las muestras de --timeline al cruzar cada múltiplo de K (IntervalSampler.hpp).
+ */
+
+// ---------------- Métricas simples por puerto ----------------
+// Contadores del “front-end” (llamadas del PE al puerto). Son independientes
+// de las métricas internas de la caché (misses, invalidations, etc.).
+struct PortMetrics { uint64_t loads=0, stores=0, atomics=0; };
+
+// ---------------- IMemoryPort respaldado por la caché MESI ----------------
+class MesiMemoryPort : public IMemoryPort {
+public:
+  MesiMemoryPort(MESICache& c, MesiInterconnect& ic, PortMetrics* pm=nullptr)
+  : cache_(c), ic_(ic), pm_(pm) {}
+
+  // Lee 8 bytes coherentemente. Si la caché devuelve false, es porque emitió BusRd.
+  // En este modelo, el segundo intento ya es hit (onDataResponse).
+  uint64_t load64(uint64_t addr) override {
+    if (pm_) pm_->loads++;
+    if (!xlate_(addr)) return 0;
+    note_(addr, false);
+    uint64_t u = 0;
+    while (!cache_.load(addr, &u)) { /* bus síncrono: segundo intento ya es hit */ }
+    return u;
+  }
+
+  // Escribe 8 bytes coherentemente. Si devuelve false, la caché emitió BusRdX/Upgr.
+  void store64(uint64_t addr, uint64_t val) override {
+    if (pm_) pm_->stores++;
+    if (!xlate_(addr)) return;
+    note_(addr, true);
+    while (!cache_.store(addr, &val)) { /* write-allocate */ }
+  }
+
+  // Store no temporal: buffer de write-combining de la L1$ (siempre completa)
+  void store_nt64(uint64_t addr, uint64_t val) override {
+    if (pm_) pm_->stores++;
+    if (!xlate_(addr)) return;
+    note_(addr, true);
+    cache_.storeNonTemporal(addr, &val);
+  }
+  void fence() override { cache_.fence(); }
+
+  // Atómicos: la L1$ obtiene M reteniendo el bus (ver MESICache::atomicRMW).
+  uint64_t cas64(uint64_t addr, uint64_t expected, uint64_t desired) override {
+    if (pm_) pm_->atomics++;
+    if (!xlate_(addr)) return 0;
+    note_(addr, true);
+    return cache_.atomicRMW(addr, MESICache::AtomicOp::CAS, desired, expected);
+  }
+  uint64_t fetch_add64(uint64_t addr, uint64_t delta) override {
+    if (pm_) pm_->atomics++;
+    if (!xlate_(addr)) return 0;
+    note_(addr, true);
+    return cache_.atomicRMW(addr, MESICache::AtomicOp::FetchAdd, delta);
+  }
+  uint64_t fetch_fadd64(uint64_t addr, double delta) override {
+    if (pm_) pm_->atomics++;
+    if (!xlate_(addr)) return 0;
+    note_(addr, true);
+    uint64_t u; std::memcpy(&u, &delta, 8);
+    return cache_.atomicRMW(addr, MESICache::AtomicOp::FetchFAdd, u);
+  }
+  uint64_t ll64(uint64_t addr) override {
+    if (pm_) pm_->atomics++;
+    if (!xlate_(addr)) return 0;
+    note_(addr, false);
+    return cache_.loadLinked(addr);
+  }
+  bool sc64(uint64_t addr, uint64_t val) override {
+    if (pm_) pm_->atomics++;
+    if (!xlate_(addr)) return false;
+    note_(addr, true);
+    return cache_.storeConditional(addr, val);
+  }
+
+  // Espera coherente (WAIT/BARRIER): duerme entre invalidaciones, no hace spin.
+  void wait_eq64(uint64_t addr, uint64_t val) override {
+    if (spin_wait_) {
+      while (load64(addr) != val && !fault()) std::this_thread::yield();
+      return;
+    }
+    if (!xlate_(addr)) return;
+    note_(addr, false);
+    cache_.waitEq(addr, val);
+  }
+
+  // true => WAIT por sondeo (implementación base), útil para comparar costo de host
+  void set_spin_wait(bool on) { spin_wait_ = on; }
+
+  const char* fault() const override { return fault_.empty() ? nullptr : fault_.c_str(); }
+
+  // Un bus asíncrono podría requerir “bombear” colas aquí.
+  void service() override { /* vacío para bus síncrono */ }
+
+  // Registro de traza (nullptr = desactivado)
+  void set_trace_writer(TraceWriter* tw) { tw_ = tw; }
+
+  // Perfil de reuse distance de este PE (nullptr = desactivado)
+  void set_reuse_profiler(ReuseDistanceProfiler* rd) { rd_ = rd; }
+
+  // Serie temporal de contadores (nullptr = desactivada)
+  void set_timeline(IntervalSampler* ts) { tl_.attach(ts, cache_); }
+
+  // Memoria virtual de este PE (nullptr = direcciones físicas)
+  void set_mmu(Mmu* m) { mmu_ = m; }
+  Mmu* mmu() const { return mmu_; }
+
+  MESICache&        cache()        { return cache_; }
+  MesiInterconnect& interconnect() { return ic_; }
+
+private:
+  // Dirección virtual -> física. Si el fallo de página no se resuelve, guarda
+  // el error (el PE se detiene) y el acceso no se hace.
+  bool xlate_(uint64_t& addr) {
+    if (!mmu_ || mmu_->translate(addr, addr, &fault_)) return true;
+    std::fprintf(stderr, "ERROR: PE%d: %s\n", mmu_->pe(), fault_.c_str());
+    return false;
+  }
+
+  // Cada acceso del PE va a la traza y al perfil de reuse distance (si están
+  // activos); el tap de la serie temporal ve el avance hasta el acceso anterior
+  void note_(uint64_t addr, bool store) {
+    if (tw_) tw_->record(cache_.id(), store ? TraceKind::Store : TraceKind::Load, addr);
+    if (rd_) rd_->access(addr);
+    if (tl_) tl_.tick(cache_);
+  }
+
+  MESICache&        cache_;
+  MesiInterconnect& ic_;
+  PortMetrics*      pm_;
+  TraceWriter*      tw_ = nullptr;
+  ReuseDistanceProfiler* rd_ = nullptr;
+  Mmu*              mmu_ = nullptr;
+  TimelineTap       tl_;
+  bool              spin_wait_ = false;
+  std::string       fault_;            // error del puerto (vacío = ninguno)
+};
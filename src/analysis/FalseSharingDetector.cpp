@@ -0,0 +1,140 @@
+#include "FalseSharingDetector.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+FalseSharingDetector::FalseSharingDetector(int num_pes) : P_(num_pes) {}
+
+auto FalseSharingDetector::info_(uint64_t line) -> LineInfo& {
+  auto& li = lines_[line];
+  if (li.pe.empty()) {
+    li.pe.resize(P_);
+    li.pair_false.assign(size_t(P_) * P_, 0);
+  }
+  return li;
+}
+
+void FalseSharingDetector::onAccess(int pe, uint64_t addr, bool write) {
+  if (pe < 0 || pe >= P_) return;
+  std::lock_guard<std::mutex> lk(mtx_);
+  auto& p = info_(base_(addr)).pe[pe];
+  const uint8_t b = bit_(addr);
+  if (write) p.wmask |= b; else p.rmask |= b;
+  p.ever |= b;
+}
+
+void FalseSharingDetector::onInvalidate(int victim, int writer, uint64_t addr) {
+  invalidate_(victim, writer, addr, bit_(addr));
+}
+
+void FalseSharingDetector::onInvalidateLine(int victim, int writer, uint64_t addr) {
+  invalidate_(victim, writer, addr, uint8_t((1u << kWordsPerLine) - 1));
+}
+
+void FalseSharingDetector::onInvalidateWords(int victim, int writer, uint64_t addr, uint8_t words) {
+  invalidate_(victim, writer, addr, words);
+}
+
+// 'words': palabras de la línea que escribe 'writer'
+void FalseSharingDetector::invalidate_(int victim, int writer, uint64_t addr, uint8_t words) {
+  if (victim < 0 || victim >= P_) return;
+  std::lock_guard<std::mutex> lk(mtx_);
+  auto& li = info_(base_(addr));
+  auto& v = li.pe[victim];
+  if ((v.rmask | v.wmask) & words) {
+    li.true_inv++;
+  } else {
+    li.false_inv++;
+    if (writer >= 0 && writer < P_) li.pair_false[size_t(victim) * P_ + writer]++;
+  }
+  v.rmask = v.wmask = 0;
+}
+
+std::vector<FalseSharingDetector::LineReport> FalseSharingDetector::ranked() const {
+  std::lock_guard<std::mutex> lk(mtx_);
+  std::vector<LineReport> out;
+  for (const auto& [line, li] : lines_) {
+    if (li.true_inv + li.false_inv == 0) continue;
+    LineReport r;
+    r.line = line;
+    r.true_inv = li.true_inv;
+    r.false_inv = li.false_inv;
+    r.words.resize(P_);
+    for (int p = 0; p < P_; ++p) {
+      r.words[p] = li.pe[p].ever;
+      if (li.pe[p].ever) r.pe_mask |= 1u << p;
+    }
+    for (int v = 0; v < P_; ++v)
+      for (int w = 0; w < P_; ++w)
+        if (li.pair_false[size_t(v) * P_ + w] > r.top_pair_count) {
+          r.top_pair_count = li.pair_false[size_t(v) * P_ + w];
+          r.top_victim = v; r.top_writer = w;
+        }
+    out.push_back(std::move(r));
+  }
+  std::sort(out.begin(), out.end(), [](const LineReport& a, const LineReport& b) {
+    if (a.false_inv != b.false_inv) return a.false_inv > b.false_inv;
+    if (a.true_inv != b.true_inv) return a.true_inv > b.true_inv;
+    return a.line < b.line;
+  });
+  return out;
+}
+
+uint64_t FalseSharingDetector::total_true() const {
+  std::lock_guard<std::mutex> lk(mtx_);
+  uint64_t n = 0;
+  for (const auto& kv : lines_) n += kv.second.true_inv;
+  return n;
+}
+
+uint64_t FalseSharingDetector::total_false() const {
+  std::lock_guard<std::mutex> lk(mtx_);
+  uint64_t n = 0;
+  for (const auto& kv : lines_) n += kv.second.false_inv;
+  return n;
+}
+
+// "P0:w0 P1:w1w2" (palabras de 8 B tocadas por cada PE)
+static std::string words_str(const std::vector<uint8_t>& words) {
+  std::string s;
+  for (size_t p = 0; p < words.size(); ++p) {
+    if (!words[p]) continue;
+    if (!s.empty()) s += ' ';
+    s += 'P' + std::to_string(p) + ':';
+    for (int w = 0; w < FalseSharingDetector::kWordsPerLine; ++w)
+      if (words[p] & (1u << w)) s += 'w' + std::to_string(w);
+  }
+  return s;
+}
+
+void FalseSharingDetector::printReport(std::ostream& os, size_t top) const {
+  const auto rows = ranked();
+  const uint64_t t = total_true(), f = total_false();
+  os << "\n=== False sharing: " << f << " invalidaciones falsas, " << t << " verdaderas ===\n";
+  char buf[160];
+  for (size_t i = 0; i < rows.size() && i < top; ++i) {
+    const auto& r = rows[i];
+    if (r.false_inv == 0) break;
+    const double pct = 100.0 * double(r.false_inv) / double(r.false_inv + r.true_inv);
+    std::snprintf(buf, sizeof buf, "  #%zu linea 0x%04llx  falsas=%llu verdaderas=%llu (%.0f%% falsas)",
+                  i + 1, (unsigned long long)r.line, (unsigned long long)r.false_inv,
+                  (unsigned long long)r.true_inv, pct);
+    os << buf << "  " << words_str(r.words);
+    if (r.top_victim >= 0)
+      os << "  [P" << r.top_victim << " <- P" << r.top_writer << " x" << r.top_pair_count << "]";
+    os << "\n";
+  }
+}
+
+bool FalseSharingDetector::writeCsv(const std::string& path) const {
+  std::ofstream f(path);
+  if (!f) return false;
+  f << "Line,False_Inv,True_Inv,PEs,Words,Top_Victim,Top_Writer,Top_Pair_Count\n";
+  for (const auto& r : ranked()) {
+    f << r.line << "," << r.false_inv << "," << r.true_inv << "," << r.pe_mask << ",\""
+      << words_str(r.words) << "\"," << r.top_victim << "," << r.top_writer << ","
+      << r.top_pair_count << "\n";
+  }
+  return true;
+}
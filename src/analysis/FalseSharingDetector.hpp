@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * FalseSharingDetector
+ * ====================
+ * Análisis opcional (se activa con MesiInterconnect::set_false_sharing_detector).
+ *
+ * Por cada (línea, PE) guarda qué palabras de 8 B leyó/escribió el PE desde el
+ * último evento de coherencia que le quitó la línea (invalidación por snoop).
+ * Cuando otro PE invalida esa copia (BusRdX/BusUpgr/Inv) para escribir la palabra
+ * w (t.addr lleva la dirección completa):
+ *   - TRUE sharing  : la víctima había tocado w  => comunicación real.
+ *   - FALSE sharing : la víctima sólo usó otras palabras de la línea.
+ * Si la escritura cubre la línea entera (BusWrLine de un store no temporal),
+ * onInvalidateLine cuenta TRUE sharing si la víctima tocó cualquier palabra. Un
+ * DMA o un snoop desde otro cluster NUMA trae la máscara de palabras escritas
+ * (onInvalidateWords): una escritura DMA de 8 B es false sharing para una
+ * víctima que usó otra palabra de la línea.
+ * Luego las máscaras de la víctima se reinician (empieza un nuevo intervalo).
+ *
+ * El informe ordena las líneas por invalidaciones falsas y lista los PEs que
+ * tocaron cada palabra y el par (víctima <- escritor) más frecuente.
+ *
+ * Hilos: los PEs reportan accesos desde sus hilos; todo pasa por un mutex propio
+ * (es un modo de análisis, no el camino rápido).
+ */
+class FalseSharingDetector {
+public:
+  static constexpr int kLineSize = 32;
+  static constexpr int kWordsPerLine = kLineSize / 8;
+
+  struct LineReport {
+    uint64_t line = 0;            // dirección base de la línea
+    uint64_t true_inv = 0;
+    uint64_t false_inv = 0;
+    uint32_t pe_mask = 0;         // PEs que accedieron a la línea (bit i = PE i)
+    std::vector<uint8_t> words;   // por PE: palabras tocadas en toda la corrida
+    int top_victim = -1, top_writer = -1;
+    uint64_t top_pair_count = 0;  // invalidaciones falsas del par más frecuente
+  };
+
+  explicit FalseSharingDetector(int num_pes = 4);
+
+  // Acceso completado (hit) de 'pe' a la palabra de 'addr'.
+  void onAccess(int pe, uint64_t addr, bool write);
+
+  // La copia de 'victim' fue invalidada por 'writer', que escribirá en 'addr'.
+  void onInvalidate(int victim, int writer, uint64_t addr);
+  // Igual, pero la escritura cubre toda la línea de 'addr' (BusWrLine).
+  void onInvalidateLine(int victim, int writer, uint64_t addr);
+  // Igual, con las palabras escritas en 'words' (bit i = palabra i; writer -1 =
+  // DMA o snoop desde otro cluster).
+  void onInvalidateWords(int victim, int writer, uint64_t addr, uint8_t words);
+
+  // Líneas con al menos una invalidación, ordenadas por false_inv (desc).
+  std::vector<LineReport> ranked() const;
+
+  uint64_t total_true() const;
+  uint64_t total_false() const;
+
+  void printReport(std::ostream& os, size_t top = 10) const;
+  bool writeCsv(const std::string& path) const;
+
+private:
+  struct PerPE { uint8_t rmask = 0, wmask = 0, ever = 0; };
+  struct LineInfo {
+    std::vector<PerPE> pe;
+    uint64_t true_inv = 0, false_inv = 0;
+    std::vector<uint64_t> pair_false;     // [victim * P + writer]
+  };
+
+  LineInfo& info_(uint64_t line);          // requiere mtx_
+  void invalidate_(int victim, int writer, uint64_t addr, uint8_t words);
+  static uint64_t base_(uint64_t a) { return a & ~uint64_t(kLineSize - 1); }
+  static uint8_t  bit_(uint64_t a)  { return uint8_t(1u << ((a & (kLineSize - 1)) >> 3)); }
+
+  int P_;
+  mutable std::mutex mtx_;
+  std::unordered_map<uint64_t, LineInfo> lines_;
+};
@@ -0,0 +1,108 @@
+#include "MissClassifier.hpp"
+#include "../checkpoint/Checkpoint.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+MissClassifier::MissClassifier(int capacity_lines)
+  : cap_(std::clamp(capacity_lines, 1, kMaxLines)) {}
+
+void MissClassifier::onEvict(uint64_t line, uint64_t stamp) {
+  int i = 0;
+  while (i < n_ && evicted_[i].line != line) ++i;
+  if (i == n_) {
+    if (n_ < cap_) ++n_;
+    else {   // llena: sólo cuentan los cap_ usos más recientes, reemplazar el más viejo
+      i = 0;
+      for (int j = 1; j < n_; ++j)
+        if (evicted_[j].stamp < evicted_[i].stamp) i = j;
+      if (evicted_[i].stamp >= stamp) return;
+    }
+  } else if (evicted_[i].stamp >= stamp) {
+    return;
+  }
+  evicted_[i] = {line, stamp};
+}
+
+// ¿Menos de cap_ líneas distintas se usaron después del último uso de 'line'?
+// Una línea puede aparecer repetida (tag viejo en I en otra vía, o ya desalojada):
+// cuenta su uso más reciente.
+bool MissClassifier::shadowHas_(uint64_t line, const Use* resident, int n) const {
+  uint64_t last = 0;
+  bool found = false;
+  auto see = [&](const Use& u) {
+    if (u.line == line && (!found || u.stamp > last)) { last = u.stamp; found = true; }
+  };
+  for (int i = 0; i < n; ++i) see(resident[i]);
+  for (int i = 0; i < n_; ++i) see(evicted_[i]);
+  if (!found) return false;
+
+  std::array<uint64_t, 2 * kMaxLines> newer;
+  int k = 0;
+  auto add = [&](const Use& u) { if (u.line != line && u.stamp > last) newer[k++] = u.line; };
+  for (int i = 0; i < n; ++i) add(resident[i]);
+  for (int i = 0; i < n_; ++i) add(evicted_[i]);
+  std::sort(newer.begin(), newer.begin() + k);
+  return std::unique(newer.begin(), newer.begin() + k) - newer.begin() < cap_;
+}
+
+MissKind MissClassifier::onMiss(uint64_t line, const Use* resident, int n) {
+  assert(n <= kMaxLines);
+  MissKind k;
+  if (invalidated_.erase(line)) { seen_.insert(line); k = MissKind::Coherence; }
+  else if (seen_.insert(line).second) k = MissKind::Compulsory;
+  else k = shadowHas_(line, resident, n) ? MissKind::Conflict : MissKind::Capacity;
+  // La línea vuelve a la L1$: desde ahora su recencia la lleva la estampa de su vía
+  for (int i = 0; i < n_; ++i)
+    if (evicted_[i].line == line) { evicted_[i] = evicted_[--n_]; break; }
+  return k;
+}
+
+// Los conjuntos se guardan ordenados: el mismo estado produce el mismo archivo
+static void save_set(CheckpointWriter& w, const std::unordered_set<uint64_t>& s) {
+  std::vector<uint64_t> v(s.begin(), s.end());
+  std::sort(v.begin(), v.end());
+  w.pod(uint64_t(v.size()));
+  w.put(v.data(), v.size() * sizeof(uint64_t));
+}
+
+static bool load_set(CheckpointReader& r, std::unordered_set<uint64_t>& s) {
+  uint64_t n = 0;
+  if (!r.pod(n)) return false;
+  if (n > r.remaining() / sizeof(uint64_t)) return r.fail("conjunto de MissClassifier más grande que el archivo");
+  s.clear();
+  s.reserve(n);
+  for (uint64_t i = 0, line; i < n; ++i) {
+    if (!r.pod(line)) return false;
+    s.insert(line);
+  }
+  return true;
+}
+
+void MissClassifier::save(CheckpointWriter& w) const {
+  w.pod(int32_t(cap_));
+  w.pod(int32_t(n_));
+  w.put(evicted_.data(), sizeof(Use) * n_);
+  save_set(w, seen_);
+  save_set(w, invalidated_);
+}
+
+bool MissClassifier::load(CheckpointReader& r) {
+  int32_t cap = 0, n = 0;
+  if (!r.pod(cap) || !r.pod(n)) return false;
+  if (cap != cap_ || n < 0 || n > cap_) return r.fail("sombra de MissClassifier incompatible");
+  n_ = n;
+  return r.get(evicted_.data(), sizeof(Use) * n_) &&
+         load_set(r, seen_) && load_set(r, invalidated_);
+}
+
+const char* MissClassifier::name(MissKind k) {
+  switch (k) {
+    case MissKind::Compulsory: return "compulsory";
+    case MissKind::Capacity:   return "capacity";
+    case MissKind::Conflict:   return "conflict";
+    case MissKind::Coherence:  return "coherence";
+  }
+  return "?";
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <unordered_set>
+
+/*
+ * MissClassifier
+ * ==============
+ * Clasificación de misses (3C + coherencia) que corre junto a cada MESICache:
+ *
+ *   1) Coherence  : la línea estaba en la L1$ y un snoop ajeno la invalidó.
+ *   2) Compulsory : primera vez que este PE toca la línea (conjunto first-touch).
+ *   3) Conflict   : una caché totalmente asociativa LRU de igual capacidad
+ *                   (caché sombra) SÍ la tenía => faltan vías / mejor índice.
+ *   4) Capacity   : ni la sombra la tenía => falta capacidad.
+ *
+ * La sombra es la LRU de los mismos accesos que la L1$ real (hits y misses) y
+ * no recibe invalidaciones: modela sólo capacidad. No se mantiene en cada hit:
+ * la L1$ ya estampa cada vía con su último uso (touchLRU), y al desalojar una
+ * línea su estampa pasa aquí (onEvict). onMiss() reconstruye la posición LRU
+ * con esas estampas: la línea está en la sombra si menos de 'capacity' líneas
+ * distintas se usaron después de ella. El hit no paga nada extra.
+ *
+ * Hilos: todo lo llama el hilo del PE dueño o un snoop con el bus retenido
+ * (onDataResponse / onSnoop / desalojos de installLine); ninguno corre en el
+ * camino de hit, que no necesita mutex.
+ */
+class CheckpointWriter;
+class CheckpointReader;
+
+enum class MissKind : uint8_t { Compulsory, Capacity, Conflict, Coherence };
+
+class MissClassifier {
+public:
+  static constexpr int kMaxLines = 64;   // capacidad máxima de la sombra (líneas)
+
+  explicit MissClassifier(int capacity_lines);
+
+  // Último uso de una línea (estampa de touchLRU)
+  struct Use { uint64_t line; uint64_t stamp; };
+
+  // 'line' deja la L1$ real (desalojo, vaciado): su último uso sigue en la sombra
+  void onEvict(uint64_t line, uint64_t stamp);
+
+  // Línea instalada sin miss (calentamiento funcional de la simulación
+  // muestreada): ya fue tocada; su recencia la da la estampa de la vía.
+  void onWarm(uint64_t line) { seen_.insert(line); }
+
+  // Miss real sobre 'line': devuelve su clase. 'resident' son los últimos usos
+  // de las líneas que siguen en la L1$ real (con tag, aunque estén en I).
+  MissKind onMiss(uint64_t line, const Use* resident, int n);
+
+  // Un snoop ajeno invalidó nuestra copia de 'line'.
+  void onInvalidate(uint64_t line) { invalidated_.insert(line); }
+
+  static const char* name(MissKind k);
+
+  // Checkpoint: sombra LRU, first-touch e invalidadas pendientes
+  void save(CheckpointWriter& w) const;
+  bool load(CheckpointReader& r);
+
+private:
+  bool shadowHas_(uint64_t line, const Use* resident, int n) const;
+
+  int cap_;
+  int n_ = 0;
+  std::array<Use, kMaxLines> evicted_{};      // los cap_ desalojos más recientes
+  std::unordered_set<uint64_t> seen_;         // first-touch
+  std::unordered_set<uint64_t> invalidated_;  // invalidadas por coherencia, aún sin re-miss
+};
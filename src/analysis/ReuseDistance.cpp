@@ -0,0 +1,128 @@
+#include "ReuseDistance.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+static constexpr size_t   kInitialSlots = 1u << 12;
+static constexpr uint64_t kHashSpace    = 1ull << 24;
+static constexpr uint64_t kMaxHist      = 1ull << 22;   // distancias mayores cuentan como frías
+
+static uint64_t mix64(uint64_t x) {   // splitmix64
+  x += 0x9E3779B97F4A7C15ull;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+  return x ^ (x >> 31);
+}
+
+ReuseDistanceProfiler::ReuseDistanceProfiler(double sample_rate, unsigned line_bytes)
+  : rate_(std::clamp(sample_rate, 1e-6, 1.0)),
+    threshold_(uint64_t(std::clamp(sample_rate, 1e-6, 1.0) * double(kHashSpace))),
+    line_shift_(0),
+    bit_(kInitialSlots + 1, 0) {
+  while ((1u << line_shift_) < line_bytes) ++line_shift_;
+}
+
+void ReuseDistanceProfiler::bitAdd_(size_t i, int32_t v) {
+  for (++i; i < bit_.size(); i += i & (~i + 1)) bit_[i] += v;
+}
+
+uint64_t ReuseDistanceProfiler::bitSum_(size_t i) const {
+  int64_t s = 0;
+  for (++i; i > 0; i -= i & (~i + 1)) s += bit_[i];
+  return uint64_t(s);
+}
+
+/* compact_()
+ * ----------
+ * Renumera las ranuras vivas (una por línea) en orden de último acceso y
+ * reconstruye el Fenwick. Si más de la mitad de las ranuras siguen vivas se
+ * duplica el tamaño, así el costo amortizado por acceso sigue siendo O(log n).
+ */
+void ReuseDistanceProfiler::compact_() {
+  std::vector<std::pair<uint64_t, uint64_t>> live;   // (ranura, línea)
+  live.reserve(last_.size());
+  for (const auto& [line, slot] : last_) live.emplace_back(slot, line);
+  std::sort(live.begin(), live.end());
+
+  size_t slots = bit_.size() - 1;
+  if (live.size() * 2 > slots) slots *= 2;
+  bit_.assign(slots + 1, 0);
+  now_ = 0;
+  for (const auto& e : live) {
+    last_[e.second] = now_;
+    bitAdd_(now_, 1);
+    ++now_;
+  }
+}
+
+void ReuseDistanceProfiler::access(uint64_t addr) {
+  ++total_;
+  const uint64_t line = addr >> line_shift_;
+  if ((mix64(line) & (kHashSpace - 1)) >= threshold_) return;
+  ++sampled_;
+
+  if (now_ + 1 >= bit_.size()) compact_();
+
+  auto it = last_.find(line);
+  if (it == last_.end()) {
+    ++cold_;
+    last_.emplace(line, now_);
+  } else {
+    const uint64_t prev = it->second;
+    const uint64_t between = bitSum_(now_ - 1) - bitSum_(prev);   // líneas distintas en medio
+    const uint64_t d = uint64_t(std::llround(double(between) / rate_));
+    if (d >= kMaxHist) {
+      ++cold_;
+    } else {
+      if (d >= hist_.size()) hist_.resize(d + 1, 0);
+      hist_[d]++;
+    }
+    bitAdd_(prev, -1);
+    it->second = now_;
+  }
+  bitAdd_(now_, 1);
+  ++now_;
+}
+
+void ReuseDistanceProfiler::merge(const ReuseDistanceProfiler& o) {
+  if (o.hist_.size() > hist_.size()) hist_.resize(o.hist_.size(), 0);
+  for (size_t d = 0; d < o.hist_.size(); ++d) hist_[d] += o.hist_[d];
+  total_ += o.total_; sampled_ += o.sampled_; cold_ += o.cold_;
+}
+
+double ReuseDistanceProfiler::miss_ratio(uint64_t capacity_lines) const {
+  if (sampled_ == 0) return 0.0;
+  uint64_t misses = cold_;
+  for (size_t d = capacity_lines; d < hist_.size(); ++d) misses += hist_[d];
+  return double(misses) / double(sampled_);
+}
+
+/* write_mrc_csv(path, per_pe)
+ * ---------------------------
+ * Capacidades 1..64 líneas una por una y luego potencias de 2 hasta cubrir la
+ * mayor distancia observada (la curva ya es plana más allá).
+ */
+bool write_mrc_csv(const std::string& path, const std::vector<ReuseDistanceProfiler>& per_pe,
+                   unsigned line_bytes) {
+  std::ofstream f(path);
+  if (!f) return false;
+
+  ReuseDistanceProfiler all(per_pe.empty() ? 1.0 : per_pe.front().sample_rate(), line_bytes);
+  uint64_t max_d = 0;
+  for (const auto& p : per_pe) { all.merge(p); max_d = std::max(max_d, p.max_distance()); }
+
+  std::vector<uint64_t> caps;
+  for (uint64_t c = 1; c <= 64; ++c) caps.push_back(c);
+  for (uint64_t c = 128; c <= 2 * (max_d + 1); c *= 2) caps.push_back(c);
+
+  f << "Lines,Bytes";
+  for (size_t p = 0; p < per_pe.size(); ++p) f << ",PE" << p;
+  f << ",All\n";
+  for (uint64_t c : caps) {
+    f << c << "," << c * line_bytes;
+    for (const auto& p : per_pe) f << "," << p.miss_ratio(c);
+    f << "," << all.miss_ratio(c) << "\n";
+  }
+  return true;
+}
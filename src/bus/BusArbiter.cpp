@@ -0,0 +1,183 @@
+#include "bus/BusArbiter.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <tuple>
+
+bool parse_arb_policy(const std::string& s, ArbPolicy& out) {
+  if (s == "none")      out = ArbPolicy::None;
+  else if (s == "fcfs") out = ArbPolicy::FCFS;
+  else if (s == "rr")   out = ArbPolicy::RoundRobin;
+  else if (s == "prio") out = ArbPolicy::FixedPriority;
+  else if (s == "age")  out = ArbPolicy::Age;
+  else return false;
+  return true;
+}
+
+const char* arb_policy_name(ArbPolicy p) {
+  switch (p) {
+    case ArbPolicy::None:          return "none";
+    case ArbPolicy::FCFS:          return "fcfs";
+    case ArbPolicy::RoundRobin:    return "rr";
+    case ArbPolicy::FixedPriority: return "prio";
+    case ArbPolicy::Age:           return "age";
+  }
+  return "?";
+}
+
+BusArbiter::BusArbiter(ArbPolicy p, uint32_t age_limit, uint32_t starve_limit, uint64_t window_ns)
+    : policy_(p), age_limit_(std::max<uint32_t>(1, age_limit)),
+      starve_limit_(std::max<uint32_t>(1, starve_limit)),
+      window_ns_(std::max<uint64_t>(1, window_ns)), epoch_(now_ns()) {}
+
+uint64_t BusArbiter::now_ns() {
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/* lock(requester) ----------------------------------------------------------
+ * Si el hilo ya es dueño solo sube la profundidad. Si el bus está libre y nadie
+ * espera, se concede al instante; si no, el pedido se encola y el hilo duerme
+ * hasta que el dueño saliente lo elija en unlock() (cesión directa: busy_ no
+ * baja entre ambos, así que nadie puede colarse).
+ */
+void BusArbiter::lock(int requester) {
+  assert(requester < kMaxRequesters - 1);
+  const std::thread::id me = std::this_thread::get_id();
+  if (owner_.load(std::memory_order_relaxed) == me) { ++depth_; return; }
+
+  std::unique_lock<std::mutex> lk(m_);
+  const uint64_t t0 = now_ns();
+  if (!busy_ && waiting_.empty()) {
+    busy_ = true;
+    grant_(requester, 0, 0, t0);
+  } else {
+    Waiter w{requester, seq_++, t0};
+    waiting_.push_back(&w);
+    cv_.wait(lk, [&] { return w.granted; });
+  }
+  owner_.store(me, std::memory_order_relaxed);
+  depth_ = 1;
+}
+
+/* unlock() -----------------------------------------------------------------
+ * Al soltar la última retención: se contabiliza el tramo ocupado y, si hay
+ * cola, se elige al ganador; los demás suman una "pasada" (inanición al llegar
+ * a starve_limit).
+ */
+void BusArbiter::unlock() {
+  assert(depth_ > 0);
+  if (--depth_ > 0) return;
+  owner_.store(std::thread::id{}, std::memory_order_relaxed);
+
+  std::lock_guard<std::mutex> lk(m_);
+  const uint64_t t = now_ns();
+  account_busy_(grant_t_, t);
+  if (waiting_.empty()) { busy_ = false; return; }
+
+  const size_t win = pick_();
+  Waiter* w = waiting_[win];
+  waiting_.erase(waiting_.begin() + ptrdiff_t(win));
+  for (Waiter* o : waiting_)
+    if (++o->passed == starve_limit_) ++stats_[slot(o->requester)].starved;
+
+  grant_(w->requester, t - w->t0, w->passed, t);
+  w->granted = true;
+  cv_.notify_all();
+}
+
+size_t BusArbiter::pick_() const {
+  auto key = [&](const Waiter* w) -> std::tuple<uint64_t, uint64_t, uint64_t> {
+    switch (policy_) {
+      case ArbPolicy::RoundRobin: {
+        const uint64_t d = uint64_t(slot(w->requester) - slot(last_) - 1 + kMaxRequesters) % kMaxRequesters;
+        return {d, w->seq, 0};
+      }
+      case ArbPolicy::FixedPriority:
+        return {uint64_t(int64_t(w->requester) + 1), w->seq, 0};
+      case ArbPolicy::Age:
+        if (w->passed >= age_limit_) return {0, w->seq, 0};
+        return {1, uint64_t(int64_t(w->requester) + 1), w->seq};
+      case ArbPolicy::None:
+      case ArbPolicy::FCFS:
+        break;
+    }
+    return {w->seq, 0, 0};
+  };
+  size_t best = 0;
+  for (size_t i = 1; i < waiting_.size(); ++i)
+    if (key(waiting_[i]) < key(waiting_[best])) best = i;
+  return best;
+}
+
+void BusArbiter::grant_(int requester, uint64_t wait, uint64_t passed, uint64_t now) {
+  const int k = slot(requester);
+  RequesterStats& s = stats_[k];
+  seen_[k] = true;
+  ++s.grants;
+  s.wait_ns += wait;
+  s.max_wait_ns = std::max(s.max_wait_ns, wait);
+  s.passed += passed;
+  s.max_passed = std::max(s.max_passed, passed);
+  ++s.hist[std::min<int>(std::bit_width(wait), kHistBuckets - 1)];
+  last_ = requester;
+  grant_t_ = now;
+}
+
+// Reparte [from, to) entre las ventanas de la línea de tiempo que toca
+void BusArbiter::account_busy_(uint64_t from, uint64_t to) {
+  if (to <= from) return;
+  busy_ns_ += to - from;
+  from = std::max(from, epoch_);
+  while (from < to) {
+    const uint64_t win = (from - epoch_) / window_ns_;
+    const uint64_t end = std::min(to, epoch_ + (win + 1) * window_ns_);
+    if (timeline_.size() <= win) timeline_.resize(win + 1, 0);
+    timeline_[win] += end - from;
+    from = end;
+  }
+}
+
+size_t BusArbiter::queued() const {
+  std::lock_guard<std::mutex> lk(m_);
+  return waiting_.size();
+}
+
+void BusArbiter::reset() {
+  std::lock_guard<std::mutex> lk(m_);
+  epoch_ = now_ns();
+  if (busy_) grant_t_ = epoch_;
+  busy_ns_ = 0;
+  timeline_.clear();
+  for (auto& s : stats_) s = RequesterStats{};
+  for (bool& b : seen_) b = false;
+}
+
+BusArbiter::Report BusArbiter::snapshot() const {
+  std::lock_guard<std::mutex> lk(m_);
+  Report r;
+  r.policy = policy_;
+  r.elapsed_ns = now_ns() - epoch_;
+  r.busy_ns = busy_ns_;
+  r.window_ns = window_ns_;
+  r.timeline = timeline_;
+  if (seen_[slot(-1)]) { r.ids.push_back(-1); r.per.push_back(stats_[slot(-1)]); }
+  for (int k = 0; k < kMaxRequesters - 1; ++k)
+    if (seen_[k]) { r.ids.push_back(k); r.per.push_back(stats_[k]); }
+  return r;
+}
+
+uint64_t BusArbiter::percentile(const RequesterStats& s, double q) {
+  uint64_t total = 0;
+  for (uint64_t h : s.hist) total += h;
+  if (!total) return 0;
+  const uint64_t target = uint64_t(q * double(total - 1)) + 1;
+  uint64_t acc = 0;
+  for (int b = 0; b < kHistBuckets; ++b) {
+    acc += s.hist[b];
+    if (acc >= target) return b ? (uint64_t(1) << b) - 1 : 0;
+  }
+  return s.max_wait_ns;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * BusArbiter.hpp
+ * ==============
+ * Árbitro explícito del bus (MesiInterconnect). Sin árbitro, gana el bus quien
+ * gane el mutex del interconnect y no queda registro de la espera; con él, cada
+ * solicitante (PE k, o -1 = DMA/host) hace cola y, al liberar el bus, el dueño
+ * saliente elige al siguiente según la política y se lo cede directamente.
+ *
+ * Políticas:
+ *  - FCFS          : por orden de llegada.
+ *  - RoundRobin    : el siguiente id después del último servido (circular).
+ *  - FixedPriority : id menor primero (DMA = -1 es el más prioritario). Puede
+ *                    dejar sin servicio a los ids altos: ver 'starved'.
+ *  - Age           : prioridad fija con envejecimiento: un pedido al que le
+ *                    pasaron por delante 'age_limit' veces sube de clase y, entre
+ *                    los promovidos, gana el más antiguo.
+ *
+ * La retención es reentrante por hilo (como el recursive_mutex del bus): solo la
+ * primera adquisición de un hilo arbitra. Los tiempos son del host (ns de
+ * steady_clock); no hay modelo de ciclos del bus.
+ *
+ * Estadísticas (por solicitante): concesiones, espera total/máxima, histograma
+ * log2 de la espera, veces que otro pasó por delante y eventos de inanición
+ * (un pedido que acumula 'starve_limit' pasadas). Del bus: tiempo ocupado,
+ * utilización y ocupación por ventana de 'window_ns' (línea de tiempo).
+ */
+enum class ArbPolicy : uint8_t { None, FCFS, RoundRobin, FixedPriority, Age };
+
+bool        parse_arb_policy(const std::string& s, ArbPolicy& out);
+const char* arb_policy_name(ArbPolicy p);
+
+class BusArbiter {
+public:
+  static constexpr int kMaxRequesters = 64;   // PEs 0..62 y el slot del DMA (-1)
+  static constexpr int kHistBuckets   = 40;   // bucket b: espera en [2^(b-1), 2^b) ns
+
+  struct RequesterStats {
+    uint64_t grants = 0;
+    uint64_t wait_ns = 0, max_wait_ns = 0;
+    uint64_t passed = 0;       // concesiones a otros mientras esperaba
+    uint64_t max_passed = 0;   // peor pedido individual
+    uint64_t starved = 0;      // pedidos que llegaron a starve_limit pasadas
+    uint64_t hist[kHistBuckets] = {};
+  };
+
+  struct Report {
+    ArbPolicy policy = ArbPolicy::None;
+    uint64_t elapsed_ns = 0;   // desde reset() (o la creación) hasta snapshot()
+    uint64_t busy_ns = 0;      // bus concedido a alguien
+    uint64_t window_ns = 0;
+    std::vector<uint64_t> timeline;  // ns ocupados por ventana
+    std::vector<int> ids;            // solicitantes con actividad (-1 = DMA)
+    std::vector<RequesterStats> per; // paralelo a 'ids'
+    double utilization() const { return elapsed_ns ? double(busy_ns) / double(elapsed_ns) : 0.0; }
+  };
+
+  explicit BusArbiter(ArbPolicy p, uint32_t age_limit = 8, uint32_t starve_limit = 32,
+                      uint64_t window_ns = 1000000);
+
+  // Retiene / suelta el bus para 'requester'. Reentrante en el mismo hilo.
+  void lock(int requester);
+  void unlock();
+
+  ArbPolicy policy() const { return policy_; }
+  uint32_t age_limit() const { return age_limit_; }
+  uint32_t starve_limit() const { return starve_limit_; }
+
+  // Pedidos en cola (sin contar al dueño)
+  size_t queued() const;
+
+  // Pone a cero las estadísticas y el origen de la línea de tiempo
+  void reset();
+  Report snapshot() const;
+
+  // Percentil q (0..1) de un histograma log2: cota superior del bucket, en ns
+  static uint64_t percentile(const RequesterStats& s, double q);
+
+private:
+  struct Waiter {
+    int requester;
+    uint64_t seq;        // orden de llegada
+    uint64_t t0;         // ns de llegada
+    uint64_t passed = 0;
+    bool granted = false;
+  };
+
+  static uint64_t now_ns();
+  static int slot(int requester) { return requester < 0 ? kMaxRequesters - 1 : requester; }
+  size_t pick_() const;                          // índice en waiting_ del ganador
+  void grant_(int requester, uint64_t wait, uint64_t passed, uint64_t now);
+  void account_busy_(uint64_t from, uint64_t to);
+
+  const ArbPolicy policy_;
+  const uint32_t age_limit_, starve_limit_;
+  const uint64_t window_ns_;
+
+  // Dueño actual (solo su hilo lo compara consigo mismo) y profundidad reentrante
+  std::atomic<std::thread::id> owner_{};
+  int depth_ = 0;
+
+  mutable std::mutex m_;
+  std::condition_variable cv_;
+  bool busy_ = false;
+  std::vector<Waiter*> waiting_;
+  uint64_t seq_ = 0;
+  int last_ = -1;               // último solicitante servido (RoundRobin)
+  uint64_t grant_t_ = 0;        // ns de la concesión en curso
+  uint64_t epoch_ = 0;
+  uint64_t busy_ns_ = 0;
+  std::vector<uint64_t> timeline_;
+  RequesterStats stats_[kMaxRequesters];
+  bool seen_[kMaxRequesters] = {};
+};
@@ -0,0 +1,209 @@
+#include "bus/GrantLog.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "trace/Trace.hpp"   // varints LEB128
+
+GrantLog::GrantLog(Mode m, const std::string& path, uint32_t stall_ms)
+    : mode_(m), retired_(kMaxRequesters, false), stall_(std::max<uint32_t>(1, stall_ms)) {
+  if (mode_ == Mode::Replay) { ok_ = load_(path); return; }
+
+  f_ = std::fopen(path.c_str(), "wb");
+  if (!f_) { err_ = "no se pudo crear " + path; return; }
+  uint8_t hdr[16] = {};
+  std::memcpy(hdr, kMagic, 8);
+  std::memcpy(hdr + 8, &kVersion, 4);
+  if (std::fwrite(hdr, 1, sizeof(hdr), f_) != sizeof(hdr)) { err_ = "error de escritura en " + path; return; }
+  bytes_ = sizeof(hdr);
+  buf_.reserve(kChunkBytes + 32);
+  ok_ = true;
+}
+
+GrantLog::~GrantLog() {
+  if (f_) close();
+}
+
+/* load_(path) --------------------------------------------------------------
+ * Lee el log completo a runs_ y valida cabecera, corridas y pie.
+ * ------------------------------------------------------------------------- */
+bool GrantLog::load_(const std::string& path) {
+  std::FILE* f = std::fopen(path.c_str(), "rb");
+  if (!f) { err_ = "no se pudo abrir " + path; return false; }
+  std::vector<uint8_t> data;
+  uint8_t tmp[64 * 1024];
+  for (size_t n; (n = std::fread(tmp, 1, sizeof(tmp), f)) > 0;) data.insert(data.end(), tmp, tmp + n);
+  std::fclose(f);
+
+  uint32_t ver = 0;
+  if (data.size() < 16 || std::memcmp(data.data(), kMagic, 8) != 0) { err_ = "cabecera de log de concesiones inválida"; return false; }
+  std::memcpy(&ver, data.data() + 8, 4);
+  if (ver != kVersion) { err_ = "versión de log de concesiones no soportada"; return false; }
+
+  const uint8_t* p = data.data() + 16;
+  const uint8_t* end = data.data() + data.size();
+  auto next = [&](uint64_t& v) {
+    const size_t n = trace::get_varint(p, end, v);
+    p += n;
+    return n != 0;
+  };
+  uint64_t sum = 0;
+  for (;;) {
+    uint64_t req = 0, n = 0;
+    if (!next(req)) { err_ = "log de concesiones truncado"; return false; }
+    if (req == 0) break;
+    if (req - 1 >= retired_.size() || !next(n) || n == 0) { err_ = "corrida inválida en el log de concesiones"; return false; }
+    runs_.push_back({int(int64_t(req) - 2), n});
+    sum += n;
+  }
+  if (!next(log_grants_) || end - p != 8) { err_ = "pie del log de concesiones inválido"; return false; }
+  std::memcpy(&log_hash_, p, 8);
+  if (sum != log_grants_) { err_ = "el log de concesiones no suma su total"; return false; }
+  left_ = runs_.empty() ? 0 : runs_[0].n;
+  return true;
+}
+
+/* begin(requester) / granted() / end() -------------------------------------
+ * Solo la retención de primer nivel del hilo cuenta. En Record, granted corre
+ * con el bus tomado (sin lock propio); en Replay, begin bloquea hasta el turno
+ * y end cede el turno al siguiente del log.
+ * ------------------------------------------------------------------------- */
+void GrantLog::begin(int requester) {
+  if (++depth_ != 1) return;
+  req_ = requester;
+  if (mode_ == Mode::Replay) wait_turn_(requester);
+}
+
+void GrantLog::granted() {
+  if (depth_ != 1) return;
+  ++grants_;
+  if (mode_ != Mode::Record) return;
+  if (cur_n_ && req_ == cur_req_) { ++cur_n_; return; }
+  flush_run_();
+  cur_req_ = req_;
+  cur_n_ = 1;
+}
+
+void GrantLog::end() {
+  if (--depth_ != 0 || mode_ != Mode::Replay) return;
+  {
+    std::lock_guard<std::mutex> lk(m_);
+    if (in_turn_) {
+      consume_();
+      ++followed_;
+      in_turn_ = false;
+    }
+    ++progress_;
+  }
+  cv_.notify_all();
+}
+
+/* wait_turn_(requester) ----------------------------------------------------
+ * Espera a que la cabeza del log sea 'requester'. Si en stall_ nadie avanza y
+ * el dueño de la cabeza no tiene el bus, la corrida divergió: se descarta esa
+ * entrada para no quedar bloqueados.
+ * ------------------------------------------------------------------------- */
+void GrantLog::wait_turn_(int requester) {
+  std::unique_lock<std::mutex> lk(m_);
+  uint64_t seen = progress_;
+  auto deadline = std::chrono::steady_clock::now() + stall_;
+  for (;;) {
+    skip_retired_();
+    if (head_ >= runs_.size()) { ++free_; return; }
+    if (runs_[head_].req == requester && !in_turn_) { in_turn_ = true; return; }
+
+    if (cv_.wait_until(lk, deadline) == std::cv_status::timeout && progress_ == seen && !in_turn_ &&
+        head_ < runs_.size() && runs_[head_].req != requester) {
+      consume_();
+      ++skipped_;
+      ++progress_;
+      cv_.notify_all();
+    }
+    if (progress_ != seen) {
+      seen = progress_;
+      deadline = std::chrono::steady_clock::now() + stall_;
+    }
+  }
+}
+
+void GrantLog::consume_() {
+  if (head_ >= runs_.size()) return;
+  if (--left_ == 0 && ++head_ < runs_.size()) left_ = runs_[head_].n;
+}
+
+void GrantLog::skip_retired_() {
+  bool any = false;
+  while (!in_turn_ && head_ < runs_.size() && retired_[size_t(runs_[head_].req + 1)]) {
+    skipped_ += left_;
+    left_ = ++head_ < runs_.size() ? runs_[head_].n : 0;
+    any = true;
+  }
+  if (any) {
+    ++progress_;
+    cv_.notify_all();
+  }
+}
+
+void GrantLog::retire(int requester) {
+  if (mode_ != Mode::Replay || requester + 1 < 0 || size_t(requester + 1) >= retired_.size()) return;
+  std::lock_guard<std::mutex> lk(m_);
+  retired_[size_t(requester + 1)] = true;
+  skip_retired_();
+}
+
+/* Record: corridas al buffer y buffer al archivo ------------------------- */
+bool GrantLog::flush_run_() {
+  if (!cur_n_) return true;
+  uint8_t tmp[20];
+  size_t n = trace::put_varint(tmp, uint64_t(int64_t(cur_req_) + 2));
+  n += trace::put_varint(tmp + n, cur_n_);
+  buf_.insert(buf_.end(), tmp, tmp + n);
+  cur_n_ = 0;
+  return buf_.size() < kChunkBytes || write_buf_();
+}
+
+bool GrantLog::write_buf_() {
+  if (!f_ || !ok_) return false;
+  if (!buf_.empty() && std::fwrite(buf_.data(), 1, buf_.size(), f_) != buf_.size()) {
+    err_ = "error de escritura en el log de concesiones";
+    ok_ = false;
+    return false;
+  }
+  bytes_ += buf_.size();
+  buf_.clear();
+  return true;
+}
+
+bool GrantLog::close(std::string* err) {
+  if (mode_ == Mode::Record && f_) {
+    flush_run_();
+    uint8_t tmp[24];
+    size_t n = trace::put_varint(tmp, 0);
+    n += trace::put_varint(tmp + n, grants_);
+    std::memcpy(tmp + n, &hash_, 8);
+    buf_.insert(buf_.end(), tmp, tmp + n + 8);
+    write_buf_();
+    if (std::fclose(f_) != 0 && ok_) { err_ = "error al cerrar el log de concesiones"; ok_ = false; }
+    f_ = nullptr;
+  }
+  if (!ok_ && err) *err = err_;
+  return ok_;
+}
+
+GrantLog::Report GrantLog::report() const {
+  std::lock_guard<std::mutex> lk(m_);
+  Report r;
+  r.grants = grants_;
+  r.hash = hash_;
+  r.bytes = bytes_;
+  if (mode_ == Mode::Replay) {
+    r.log_grants = log_grants_;
+    r.log_hash = log_hash_;
+    r.followed = followed_;
+    r.skipped = skipped_;
+    r.free_run = free_;
+    r.unused = left_;
+    for (size_t i = head_ + 1; i < runs_.size(); ++i) r.unused += runs_[i].n;
+  }
+  return r;
+}
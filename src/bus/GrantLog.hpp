@@ -0,0 +1,140 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "memory/cache/mesi/MesiTypes.hpp"
+
+/*
+ * GrantLog.hpp
+ * ============
+ * Grabación y reproducción del orden global de concesiones del bus
+ * (MesiInterconnect::Grant), para repetir una corrida multihilo.
+ *
+ * - Record: cada concesión de primer nivel (la primera retención del hilo; las
+ *           anidadas —Flush dentro de un snoop, emit dentro de un atómico— no
+ *           cuentan) anota el solicitante. Se llama con el bus tomado, así que
+ *           no hay lock propio: un contador de corrida y un buffer en memoria
+ *           que se vuelca al archivo cada kChunkBytes.
+ * - Replay: antes de arbitrar, cada hilo espera a que la cabeza del log sea su
+ *           solicitante; al soltar el bus avanza el cursor y despierta al
+ *           siguiente. Con el log agotado, el resto corre libre.
+ *
+ * Además se lleva un hash FNV-1a de las transacciones emitidas (tipo, línea,
+ * PE). Al reproducir, hash y número de concesiones iguales a los grabados
+ * indican que la corrida repitió la misma secuencia del bus.
+ *
+ * Alcance: se ordenan las concesiones, no los hits locales. Un PE que lee una
+ * línea propia antes de que llegue la invalidación que en la grabación le ganó
+ * puede ver el valor viejo; los bucles de espera (spin, barreras, WAIT) lo
+ * toleran porque solo repiten hits. Si la corrida diverge (un PE pide el bus
+ * cuando el log espera a otro que no lo va a pedir), tras 'stall_ms' sin
+ * avances se descarta la cabeza y se cuenta en 'skipped'; un solicitante
+ * retirado (retire: el PE terminó) descarta sus entradas pendientes.
+ *
+ * Todos los buses que comparten un log deben compartir también el lock (un
+ * solo bus, o los clusters de NumaDirectory).
+ *
+ * Archivo:
+ *   Cabecera (16 B): "MESIGNT1" | u32 versión | u32 flags (0)
+ *   Corridas:        varint (solicitante + 2) | varint largo   (-1 = DMA/host)
+ *   Fin:             varint 0 | varint concesiones | u64 hash (LE)
+ * Concesiones consecutivas del mismo solicitante ocupan una sola corrida: un
+ * PE con varios misses seguidos cuesta 2 B en total.
+ */
+class GrantLog {
+public:
+  enum class Mode : uint8_t { Record, Replay };
+
+  static constexpr char     kMagic[8]   = {'M','E','S','I','G','N','T','1'};
+  static constexpr uint32_t kVersion    = 1;
+  static constexpr size_t   kChunkBytes = 64 * 1024;
+  static constexpr int      kMaxRequesters = 65;   // ids -1 (DMA/host) .. 63
+
+  // Record: crea 'path'. Replay: lee el log completo. Ver ok()/error().
+  GrantLog(Mode m, const std::string& path, uint32_t stall_ms = 1000);
+  ~GrantLog();
+  GrantLog(const GrantLog&) = delete;
+  GrantLog& operator=(const GrantLog&) = delete;
+
+  bool ok() const { return ok_; }
+  const std::string& error() const { return err_; }
+  Mode mode() const { return mode_; }
+
+  // Ganchos de MesiInterconnect::Grant: begin antes del árbitro (en Replay
+  // espera el turno), granted con el bus tomado, end después de soltarlo.
+  void begin(int requester);
+  void granted();
+  void end();
+
+  // Transacción emitida (con el bus tomado): entra al hash de la corrida
+  void note(const BusTransaction& t) {
+    const uint64_t w[3] = {uint64_t(t.type), t.addr, uint64_t(int64_t(t.src_pe))};
+    for (uint64_t v : w)
+      for (int i = 0; i < 8; ++i) { hash_ ^= (v >> (8 * i)) & 0xFF; hash_ *= 0x100000001B3ull; }
+  }
+
+  // El solicitante ya no va a pedir el bus (PE detenido). Solo afecta a Replay.
+  void retire(int requester);
+
+  // Record: vuelca la última corrida y el pie. Con los PEs detenidos.
+  bool close(std::string* err = nullptr);
+
+  struct Report {
+    uint64_t grants = 0;        // concesiones de primer nivel de esta corrida
+    uint64_t hash = 0;          // de las transacciones de esta corrida
+    uint64_t bytes = 0;         // Record: tamaño del archivo
+    // Replay
+    uint64_t log_grants = 0, log_hash = 0;
+    uint64_t followed = 0;      // concesiones que siguieron el log
+    uint64_t skipped = 0;       // entradas descartadas (watchdog o retirados)
+    uint64_t unused = 0;        // entradas que quedaron sin consumir
+    uint64_t free_run = 0;      // concesiones con el log agotado
+    bool reproduced() const {
+      return skipped == 0 && unused == 0 && free_run == 0 && grants == log_grants && hash == log_hash;
+    }
+  };
+  Report report() const;
+
+private:
+  struct Run { int req; uint64_t n; };
+
+  Mode mode_;
+  bool ok_ = false;
+  std::string err_;
+  uint64_t grants_ = 0;
+  uint64_t hash_ = 0xCBF29CE484222325ull;
+
+  // Record
+  std::FILE* f_ = nullptr;
+  std::vector<uint8_t> buf_;
+  int cur_req_ = 0;
+  uint64_t cur_n_ = 0;
+  uint64_t bytes_ = 0;
+  bool flush_run_();
+  bool write_buf_();
+
+  // Replay
+  std::vector<Run> runs_;
+  size_t head_ = 0;
+  uint64_t left_ = 0;            // concesiones que quedan en runs_[head_]
+  uint64_t log_grants_ = 0, log_hash_ = 0;
+  uint64_t followed_ = 0, skipped_ = 0, free_ = 0;
+  uint64_t progress_ = 0;        // avances del cursor (para el watchdog)
+  bool in_turn_ = false;         // el dueño de la cabeza tiene el bus
+  std::vector<bool> retired_;    // índice requester + 1
+  std::chrono::milliseconds stall_;
+  mutable std::mutex m_;
+  std::condition_variable cv_;
+  bool load_(const std::string& path);
+  void wait_turn_(int requester);
+  void consume_();               // con m_ tomado
+  void skip_retired_();          // con m_ tomado
+
+  static inline thread_local int depth_ = 0;
+  static inline thread_local int req_ = 0;
+};
@@ -0,0 +1,111 @@
+#include "Checkpoint.hpp"
+
+#include <cstdio>
+
+#include "../MesiInterconnect.hpp"
+#include "../memory/SharedMemory.h"
+#include "../memory/cache/mesi/MESICache.hpp"
+#include "../../PE/pe/pe.hpp"
+
+static constexpr char     kMagic[8] = {'M','E','S','I','C','K','P','1'};
+static constexpr uint32_t kVersion  = 5;   // 5: política y regiones de escritura de cada L1$
+
+bool CheckpointWriter::write_file(const std::string& path) const {
+  FILE* f = std::fopen(path.c_str(), "wb");
+  if (!f) return false;
+  const uint32_t hdr[2] = {kVersion, 0};
+  bool ok = std::fwrite(kMagic, 1, 8, f) == 8 &&
+            std::fwrite(hdr, 1, sizeof hdr, f) == sizeof hdr &&
+            std::fwrite(buf_.data(), 1, buf_.size(), f) == buf_.size();
+  ok = (std::fclose(f) == 0) && ok;
+  return ok;
+}
+
+CheckpointReader::CheckpointReader(const std::string& path) {
+  FILE* f = std::fopen(path.c_str(), "rb");
+  if (!f) { err_ = "no se pudo abrir " + path; return; }
+  std::fseek(f, 0, SEEK_END);
+  const long n = std::ftell(f);
+  std::fseek(f, 0, SEEK_SET);
+  if (n < 16) { std::fclose(f); err_ = "archivo demasiado corto"; return; }
+  buf_.resize(size_t(n));
+  const size_t got = std::fread(buf_.data(), 1, buf_.size(), f);
+  std::fclose(f);
+  if (got != buf_.size()) { err_ = "lectura incompleta"; return; }
+
+  uint32_t version = 0;
+  if (std::memcmp(buf_.data(), kMagic, 8) != 0) { err_ = "no es un checkpoint MESICKP1"; return; }
+  std::memcpy(&version, buf_.data() + 8, 4);
+  if (version != kVersion) { err_ = "versión de checkpoint no soportada"; return; }
+  pos_ = 16;
+}
+
+bool CheckpointReader::section(const char tag[4]) {
+  char got[4];
+  if (!get(got, 4)) return false;
+  if (std::memcmp(got, tag, 4) != 0)
+    return fail("se esperaba la sección '" + std::string(tag, 4) + "'");
+  return true;
+}
+
+/* save_checkpoint(path, shm, bus, pes)
+ * ------------------------------------
+ * Cada clase serializa su propio estado (save/load); aquí solo se ordenan las
+ * secciones y se cuentan L1$/PEs para validar la forma al restaurar.
+ */
+bool save_checkpoint(const std::string& path, const SharedMemory& shm,
+                     const MesiInterconnect& bus, const std::vector<const PE*>& pes,
+                     std::string* err) {
+  CheckpointWriter w;
+  w.section("SHM ");
+  shm.save(w);
+  w.section("BUS ");
+  bus.save(w);
+
+  const auto& caches = bus.caches();
+  w.pod(uint32_t(caches.size()));
+  for (const MESICache* c : caches) {
+    w.section("L1$ ");
+    c->save(w);
+  }
+
+  w.pod(uint32_t(pes.size()));
+  for (const PE* pe : pes) {
+    w.section("PE  ");
+    pe->save(w);
+  }
+  w.section("END ");
+
+  if (!w.write_file(path)) {
+    if (err) *err = "no se pudo escribir " + path;
+    return false;
+  }
+  return true;
+}
+
+bool load_checkpoint(const std::string& path, SharedMemory& shm, MesiInterconnect& bus,
+                     const std::vector<PE*>& pes, std::string* err) {
+  CheckpointReader r(path);
+  auto done = [&](bool ok) {
+    if (!ok && r.ok()) r.fail("estado inconsistente");
+    if (!ok && err) *err = r.error();
+    return ok;
+  };
+
+  if (!r.section("SHM ") || !shm.load(r)) return done(false);
+  if (!r.section("BUS ") || !bus.load(r)) return done(false);
+
+  const auto& caches = bus.caches();
+  uint32_t n = 0;
+  if (!r.pod(n)) return done(false);
+  if (n != caches.size()) { r.fail("número de L1$ distinto al del checkpoint"); return done(false); }
+  for (MESICache* c : caches)
+    if (!r.section("L1$ ") || !c->load(r)) return done(false);
+
+  if (!r.pod(n)) return done(false);
+  if (n != pes.size()) { r.fail("número de PEs distinto al del checkpoint"); return done(false); }
+  for (PE* pe : pes)
+    if (!r.section("PE  ") || !pe->load(r)) return done(false);
+
+  return done(r.section("END "));
+}
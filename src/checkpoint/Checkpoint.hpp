@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+class SharedMemory;
+class MesiInterconnect;
+class PE;
+
+/*
+ * Checkpoint.hpp
+ * ==============
+ * Volcado/restauración del estado completo del simulador a un archivo binario:
+ * contenido de SharedMemory, cada MESICache (función de índice, política y
+ * regiones de escritura, estado/tag/datos de cada vía, LRU, reserva LL/SC,
+ * métricas y sombra del clasificador de misses), el bus (líneas de last_flush_
+ * y contadores) y cada PE (programa, registros, pc_).
+ *
+ * Archivo:
+ *   Cabecera (16 B): "MESICKP1" | u32 versión | u32 reservado
+ *   Secciones: tag de 4 B + campos POD en little-endian nativo (sin padding
+ *   implícito: cada clase escribe sus campos uno a uno).
+ *     "SHM " memoria | "BUS " interconnect | "L1$ " x caches | "PE  " x PEs | "END "
+ *
+ * El escritor arma todo en memoria y hace un único fwrite; el lector lee el
+ * archivo entero con un fread y copia de ahí (el tiempo de carga es E/S).
+ *
+ * Debe usarse con la simulación detenida (hilos de PE unidos): no se sincroniza
+ * con PEs en ejecución. El log textual de transiciones MESI no se guarda.
+ */
+
+class CheckpointWriter {
+public:
+  void section(const char tag[4]) { put(tag, 4); }
+  void put(const void* p, size_t n) {
+    if (!n) return;
+    const size_t at = buf_.size();
+    buf_.resize(at + n);
+    std::memcpy(buf_.data() + at, p, n);
+  }
+  template <class T> void pod(const T& v) {
+    static_assert(std::is_trivially_copyable<T>::value, "pod() requiere tipo trivial");
+    put(&v, sizeof v);
+  }
+
+  // Escribe cabecera + secciones en 'path'. false si falla la E/S.
+  bool write_file(const std::string& path) const;
+  size_t size() const { return buf_.size(); }
+
+private:
+  std::vector<uint8_t> buf_;
+};
+
+class CheckpointReader {
+public:
+  // Lee el archivo completo y valida la cabecera (ver ok()/error()).
+  explicit CheckpointReader(const std::string& path);
+
+  bool ok() const { return err_.empty(); }
+  const std::string& error() const { return err_; }
+
+  // Consume el tag esperado; si no coincide marca error.
+  bool section(const char tag[4]);
+  bool get(void* p, size_t n) {
+    if (!ok()) return false;
+    if (n > buf_.size() - pos_) return fail("archivo truncado");
+    std::memcpy(p, buf_.data() + pos_, n);
+    pos_ += n;
+    return true;
+  }
+  template <class T> bool pod(T& v) {
+    static_assert(std::is_trivially_copyable<T>::value, "pod() requiere tipo trivial");
+    return get(&v, sizeof v);
+  }
+  bool fail(const std::string& why) { if (err_.empty()) err_ = why; return false; }
+  size_t remaining() const { return buf_.size() - pos_; }   // bytes sin consumir
+
+private:
+  std::vector<uint8_t> buf_;
+  size_t pos_ = 0;
+  std::string err_;
+};
+
+// Guarda memoria, bus, las L1$ conectadas al bus y los PEs (en ese orden).
+bool save_checkpoint(const std::string& path, const SharedMemory& shm,
+                     const MesiInterconnect& bus, const std::vector<const PE*>& pes,
+                     std::string* err = nullptr);
+
+// Restaura sobre un sistema ya construido con la misma forma (tamaño de memoria,
+// número de L1$ conectadas y de PEs). false (y *err) si el archivo no coincide.
+bool load_checkpoint(const std::string& path, SharedMemory& shm, MesiInterconnect& bus,
+                     const std::vector<PE*>& pes, std::string* err = nullptr);
@@ -0,0 +1,41 @@
+#include "Fork.hpp"
+
+#include <thread>
+
+void SimFork::run(uint64_t max_steps) {
+  std::vector<std::thread> th;
+  th.reserve(pes.size());
+  for (auto& pe : pes) th.emplace_back([&pe, max_steps] { pe->run(max_steps); });
+  for (auto& t : th) t.join();
+}
+
+/* fork_simulation(shm, bus, pes)
+ * ------------------------------
+ * La L1$ i del fork copia a bus.caches()[i] y el PE k usa la L1$ de igual id que
+ * el original (mismo cableado PE -> puerto -> L1$).
+ */
+std::unique_ptr<SimFork> fork_simulation(const SharedMemory& shm, const MesiInterconnect& bus,
+                                         const std::vector<const PE*>& pes) {
+  auto f = std::make_unique<SimFork>();
+  f->shm = shm.fork();
+  f->bus.set_shared_memory(f->shm.get());
+  f->bus.copy_state_from(bus);
+
+  const auto& src = bus.caches();
+  for (const MESICache* c : src) {
+    f->caches.push_back(std::make_unique<MESICache>(c->id(), f->bus));
+    f->caches.back()->copyStateFrom(*c);
+    f->bus.connect(f->caches.back().get());
+  }
+
+  f->pm.resize(pes.size());
+  for (size_t k = 0; k < pes.size(); ++k) {
+    MESICache* c = nullptr;
+    for (auto& fc : f->caches) if (fc->id() == pes[k]->id()) c = fc.get();
+    if (!c) return nullptr;   // PE sin L1$ del mismo id: no se puede replicar el cableado
+    f->ports.push_back(std::make_unique<MesiMemoryPort>(*c, f->bus, &f->pm[k]));
+    f->pes.push_back(std::make_unique<PE>(pes[k]->id(), f->ports.back().get()));
+    f->pes.back()->copy_state_from(*pes[k]);
+  }
+  return f;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../MesiInterconnect.hpp"
+#include "../MesiMemoryPort.hpp"
+#include "../memory/SharedMemory.h"
+#include "../memory/cache/mesi/MESICache.hpp"
+#include "../../PE/pe/pe.hpp"
+
+/*
+ * Fork.hpp
+ * ========
+ * Bifurcación en memoria de una simulación detenida (what-if baratos).
+ *
+ * fork_simulation() arma un sistema nuevo (bus, L1$, puertos y PEs propios) con
+ * el mismo estado que el original:
+ *   - SharedMemory::fork(): comparte todas las páginas; cada variante copia una
+ *     página de 256 B solo la primera vez que la escribe (copy-on-write).
+ *   - MESICache::copyStateFrom / PE::copy_state_from / bus copy_state_from:
+ *     mismo estado que guarda el checkpoint (sin el log textual de transiciones).
+ *
+ * Las variantes son independientes: pueden cambiar de política y correr en
+ * paralelo entre sí y con el original. El original debe estar detenido mientras
+ * se bifurca (hilos de PE unidos).
+ */
+struct SimFork {
+  std::unique_ptr<SharedMemory> shm;
+  MesiInterconnect bus{0};
+  std::vector<std::unique_ptr<MESICache>> caches;
+  std::vector<PortMetrics> pm;
+  std::vector<std::unique_ptr<MesiMemoryPort>> ports;
+  std::vector<std::unique_ptr<PE>> pes;
+
+  // Un hilo por PE (max_steps = 0 => hasta HALT); retorna al unirse todos.
+  void run(uint64_t max_steps = 0);
+};
+
+std::unique_ptr<SimFork> fork_simulation(const SharedMemory& shm, const MesiInterconnect& bus,
+                                         const std::vector<const PE*>& pes);
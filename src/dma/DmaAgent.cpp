@@ -0,0 +1,41 @@
+#include "DmaAgent.hpp"
+
+#include "../MesiInterconnect.hpp"
+#include "../memory/SharedMemory.h"
+
+#include <algorithm>
+
+/* snoop_range_(write, addr, n)
+ * ----------------------------
+ * Con el bus retenido: snoop (BusRd o Inv) a cada línea de [addr, addr+n). El
+ * Inv lleva las palabras que escribe el DMA en esa línea (análisis de false
+ * sharing).
+ */
+bool DmaAgent::snoop_range_(bool write, uint64_t addr, size_t n) {
+  SharedMemory* shm = bus_.shared_memory();
+  if (!shm || addr > shm->size() || n > shm->size() - addr) return false;
+  if (n == 0) return true;
+  const uint64_t line = MESICache::kLineSize;
+  for (uint64_t b = addr & ~(line - 1); b < addr + n; b += line) {
+    const uint64_t lo = std::max(b, addr), hi = std::min(b + line, addr + n);
+    const uint8_t words = write ? lineWordMask(lo, hi - lo) : 0;
+    if (bus_.dma_snoop(write ? BusMsg::Inv : BusMsg::BusRd, b, words)) ++stats_.lines_snooped;
+  }
+  return true;
+}
+
+bool DmaAgent::read(uint64_t addr, void* out, size_t n) {
+  auto grant = bus_.hold();
+  if (!snoop_range_(false, addr, n) || !bus_.shared_memory()->read_block(addr, out, n)) return false;
+  ++stats_.reads;
+  stats_.bytes_read += n;
+  return true;
+}
+
+bool DmaAgent::write(uint64_t addr, const void* in, size_t n) {
+  auto grant = bus_.hold();
+  if (!snoop_range_(true, addr, n) || !bus_.shared_memory()->write_block(addr, in, n)) return false;
+  ++stats_.writes;
+  stats_.bytes_written += n;
+  return true;
+}
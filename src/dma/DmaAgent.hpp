@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+class MesiInterconnect;
+
+/*
+ * DmaAgent.hpp
+ * ============
+ * Agente DMA colgado del interconnect: transfiere rangos contiguos entre el host
+ * y SharedMemory de forma coherente con las L1$, sin pasar palabra por palabra
+ * por el puerto de un PE.
+ *
+ *   read : cada línea del rango con copia en alguna L1$ recibe un snoop BusRd
+ *          (las copias en M hacen Flush y quedan en S); luego un único
+ *          SharedMemory::read_block.
+ *   write: snoop Inv sobre las líneas cacheadas (las que estaban en M se
+ *          escriben antes, así una escritura parcial de línea no pierde datos);
+ *          luego un único SharedMemory::write_block.
+ *
+ * El bus queda retenido durante toda la transferencia, así que es atómica frente
+ * a los PEs (puede usarse con la simulación en marcha). Las líneas sin copia no
+ * generan tráfico. Los contadores son del hilo que usa el agente.
+ */
+class DmaAgent {
+public:
+  struct Stats {
+    uint64_t reads = 0, writes = 0;               // transferencias
+    uint64_t bytes_read = 0, bytes_written = 0;
+    uint64_t lines_snooped = 0;                   // líneas que tenían copia en alguna L1$
+  };
+
+  explicit DmaAgent(MesiInterconnect& bus) : bus_(bus) {}
+
+  // false si el rango se sale de la memoria (no se transfiere nada)
+  bool read(uint64_t addr, void* out, size_t n);
+  bool write(uint64_t addr, const void* in, size_t n);
+  bool read_doubles(uint64_t addr, double* out, size_t count) {
+    return read(addr, out, count * sizeof(double));
+  }
+  bool write_doubles(uint64_t addr, const double* in, size_t count) {
+    return write(addr, in, count * sizeof(double));
+  }
+
+  const Stats& stats() const { return stats_; }
+
+private:
+  bool snoop_range_(bool write, uint64_t addr, size_t n);
+
+  MesiInterconnect& bus_;
+  Stats stats_;
+};
@@ -1,13 +1,142 @@
 #include "SharedMemory.h"
+#include "../checkpoint/Checkpoint.hpp"
+#include "dram/DramController.hpp"
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 
-static constexpr size_t MEM_WORDS = 512;            // 512 posiciones de 64 bits
-static constexpr size_t WORD_BYTES = 8;             // 64 bits = 8 bytes
-static constexpr size_t MEM_BYTES = MEM_WORDS * WORD_BYTES; // 512 * 8 = 4096
 static constexpr size_t CACHE_LINE_SIZE = 32;       // Tamaño estándar de línea de caché
 
-SharedMemory::SharedMemory() : memory(MEM_BYTES, 0) {}
+// Por defecto 512 posiciones de 64 bits = 4096 B; modos con más estado
+// (p.ej. regiones de barreras) pueden pedir más.
+SharedMemory::SharedMemory(size_t bytes) : bytes_(bytes) {
+    pages_.resize((bytes + kPageBytes - 1) / kPageBytes);
+    for (auto &p : pages_) p = PageRef(Page{});   // ceros
+    home_.assign(pages_.size(), 0);
+    node_reads_.assign(1, 0);
+    node_writes_.assign(1, 0);
+}
+
+std::unique_ptr<SharedMemory> SharedMemory::fork() const {
+    auto f = std::make_unique<SharedMemory>(0);
+    std::lock_guard<std::mutex> lock(memory_mutex);
+    f->bytes_ = bytes_;
+    f->pages_ = pages_;          // solo copia referencias (contador++)
+    f->total_reads = total_reads;
+    f->total_writes = total_writes;
+    f->numa_nodes_ = numa_nodes_;
+    f->home_ = home_;
+    f->node_reads_ = node_reads_;
+    f->node_writes_ = node_writes_;
+    return f;
+}
+
+// Con los PEs detenidos (antes de simular)
+void SharedMemory::set_dram(DramController *d) {
+    std::lock_guard<std::mutex> lock(memory_mutex);
+    dram_ = d;
+}
+
+// Con los PEs detenidos (antes de simular): reinicia los contadores por nodo
+bool SharedMemory::set_numa_nodes(int nodes, size_t interleave) {
+    if (nodes < 1 || nodes > 255 || interleave == 0 || interleave % kPageBytes) return false;
+    std::lock_guard<std::mutex> lock(memory_mutex);
+    numa_nodes_ = nodes;
+    const size_t per = interleave / kPageBytes;
+    for (size_t pg = 0; pg < home_.size(); ++pg) home_[pg] = uint8_t((pg / per) % size_t(nodes));
+    node_reads_.assign(size_t(nodes), 0);
+    node_writes_.assign(size_t(nodes), 0);
+    return true;
+}
+
+bool SharedMemory::bind(uint64_t addr, size_t n, int node) {
+    if (node < 0 || node >= numa_nodes_ || n == 0 || !in_range_(addr, n)) return false;
+    std::lock_guard<std::mutex> lock(memory_mutex);
+    for (size_t pg = addr / kPageBytes; pg <= (addr + n - 1) / kPageBytes; ++pg)
+        home_[pg] = uint8_t(node);
+    return true;
+}
+
+void SharedMemory::get_node_stats(int node, uint64_t &reads, uint64_t &writes) const {
+    std::lock_guard<std::mutex> lock(memory_mutex);
+    const bool ok = node >= 0 && node < numa_nodes_;
+    reads = ok ? node_reads_[size_t(node)] : 0;
+    writes = ok ? node_writes_[size_t(node)] : 0;
+}
+
+size_t SharedMemory::shared_pages() const {
+    std::lock_guard<std::mutex> lock(memory_mutex);
+    size_t n = 0;
+    for (const auto &p : pages_) n += p.shared();
+    return n;
+}
+
+// Con memory_mutex tomado
+void SharedMemory::read_bytes_(size_t addr, uint8_t *out, size_t n) const {
+    while (n) {
+        const size_t pg = addr / kPageBytes, off = addr % kPageBytes;
+        const size_t k = std::min(n, kPageBytes - off);
+        std::memcpy(out, pages_[pg].data() + off, k);
+        addr += k; out += k; n -= k;
+    }
+}
+
+// Con memory_mutex tomado. shared() => otra copia la ve: duplicarla antes de
+// escribir. Otra copia solo puede bajar el contador (nunca subirlo: fork() toma
+// nuestro mutex), así que un 1 leído con acquire garantiza que la página es solo
+// nuestra y que la otra copia ya terminó de leerla (ver PageRef).
+void SharedMemory::write_bytes_(size_t addr, const uint8_t *in, size_t n) {
+    while (n) {
+        const size_t pg = addr / kPageBytes, off = addr % kPageBytes;
+        const size_t k = std::min(n, kPageBytes - off);
+        auto &p = pages_[pg];
+        if (p.shared()) p = PageRef(p.page());
+        std::memcpy(p.data() + off, in, k);
+        addr += k; in += k; n -= k;
+    }
+}
+
+bool SharedMemory::read_block(uint64_t addr, void *out, size_t n) const {
+    if (!in_range_(addr, n)) {
+        std::cerr << "[SharedMemory] Error: lectura fuera de rango\n";
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(memory_mutex);
+    read_bytes_(addr, static_cast<uint8_t *>(out), n);
+    return true;
+}
+
+bool SharedMemory::write_block(uint64_t addr, const void *in, size_t n) {
+    if (!in_range_(addr, n)) {
+        std::cerr << "[SharedMemory] Error: escritura fuera de rango\n";
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(memory_mutex);
+    write_bytes_(addr, static_cast<const uint8_t *>(in), n);
+    return true;
+}
+
+uint64_t SharedMemory::load64(uint64_t addr) const {
+    uint64_t v = 0;
+    read_block(addr, &v, 8);
+    return v;
+}
+
+void SharedMemory::store64(uint64_t addr, uint64_t val) {
+    write_block(addr, &val, 8);
+}
+
+uint64_t SharedMemory::cas64(uint64_t addr, uint64_t expected, uint64_t desired) {
+    uint64_t old = 0;
+    if (!in_range_(addr, 8)) {
+        std::cerr << "[SharedMemory] Error: escritura fuera de rango\n";
+        return old;
+    }
+    std::lock_guard<std::mutex> lock(memory_mutex);
+    read_bytes_(addr, reinterpret_cast<uint8_t *>(&old), 8);
+    if (old == expected) write_bytes_(addr, reinterpret_cast<const uint8_t *>(&desired), 8);
+    return old;
+}
 
 void SharedMemory::handle_message(MessageP msg, std::function<void(MessageP)> send_response) {
     if (!msg) return;
@@ -33,6 +162,7 @@ void SharedMemory::handle_read(MessageP msg, std::function<void(MessageP)> send_
     resp->payload.read_resp.address = addr;
     resp->payload.read_resp.size = size;
 
+    const size_t MEM_BYTES = bytes_;
     if (size == 0 || addr > MEM_BYTES || size > MEM_BYTES || addr > MEM_BYTES - size) {
         std::cerr << "[SharedMemory] Error: lectura fuera de rango\n";
         resp->payload.read_resp.status = 0x0;
@@ -43,8 +173,10 @@ void SharedMemory::handle_read(MessageP msg, std::function<void(MessageP)> send_
     std::vector<uint8_t> buffer(size);
     {
         std::lock_guard<std::mutex> lock(memory_mutex);
-        std::memcpy(buffer.data(), memory.data() + addr, size);
+        read_bytes_(addr, buffer.data(), size);
         total_reads++;
+        node_reads_[home_[addr / kPageBytes]]++;
+        if (dram_) dram_->access(addr, false);
     }
 
     resp->read_resp_data = std::move(buffer);
@@ -60,6 +192,7 @@ void SharedMemory::handle_write(MessageP msg, std::function<void(MessageP)> send
     MessageP resp = std::make_shared<Message>(MessageType::WRITE_RESP, msg->src, -1);
     resp->payload.write_resp.address = addr;
 
+    const size_t MEM_BYTES = bytes_;
     if (size == 0 || addr > MEM_BYTES || size > MEM_BYTES || addr > MEM_BYTES - size) {
         std::cerr << "[SharedMemory] Error: escritura fuera de rango\n";
         resp->payload.write_resp.status = 0x0;
@@ -76,8 +209,10 @@ void SharedMemory::handle_write(MessageP msg, std::function<void(MessageP)> send
 
     {
         std::lock_guard<std::mutex> lock(memory_mutex);
-        std::memcpy(memory.data() + addr, data.data(), size);
+        write_bytes_(addr, data.data(), size);
         total_writes++;
+        node_writes_[home_[addr / kPageBytes]]++;
+        if (dram_) dram_->access(addr, true);
     }
 
     resp->payload.write_resp.status = 0x1;
@@ -89,4 +224,32 @@ void SharedMemory::dump_stats(std::ostream &os) {
     os << "\n=== Estadisticas de SharedMemory ===\n";
     os << "Total de lecturas: " << total_reads << "\n";
     os << "Total de escrituras: " << total_writes << "\n";
+}
+
+void SharedMemory::save(CheckpointWriter &w) const {
+    std::lock_guard<std::mutex> lock(memory_mutex);
+    w.pod(uint64_t(bytes_));
+    for (size_t pg = 0; pg < pages_.size(); ++pg)
+        w.put(pages_[pg].data(), std::min(kPageBytes, bytes_ - pg * kPageBytes));
+    w.pod(total_reads);
+    w.pod(total_writes);
+}
+
+bool SharedMemory::load(CheckpointReader &r) {
+    std::lock_guard<std::mutex> lock(memory_mutex);
+    uint64_t n = 0;
+    if (!r.pod(n)) return false;
+    if (n != bytes_) return r.fail("tamaño de SharedMemory distinto al del checkpoint");
+    for (size_t pg = 0; pg < pages_.size(); ++pg) {
+        PageRef page(Page{});   // el checkpoint no comparte páginas
+        if (!r.get(page.data(), std::min(kPageBytes, bytes_ - pg * kPageBytes))) return false;
+        pages_[pg] = std::move(page);
+    }
+    return r.pod(total_reads) && r.pod(total_writes);
+}
+
+void SharedMemory::get_stats(uint64_t &reads, uint64_t &writes) {
+    std::lock_guard<std::mutex> lock(memory_mutex);
+    reads = total_reads;
+    writes = total_writes;
 }
\ No newline at end of file
@@ -1,12 +1,15 @@
 #ifndef SHARED_MEMORY_H
 #define SHARED_MEMORY_H
 
+#include <array>
+#include <atomic>
 #include <vector>
 #include <mutex>
 #include <functional>
 #include <cstdint>
 #include <memory>
 #include <unordered_map>
+#include <utility>
 #include <iostream>
 
 // -------------------------
@@ -40,21 +43,128 @@ struct Message {
 
 using MessageP = std::shared_ptr<Message>;
 
+class CheckpointWriter;
+class CheckpointReader;
+class DramController;
+
 // -------------------------
 // Clase SharedMemory
 // -------------------------
+// El contenido vive en páginas de kPageBytes compartidas por referencia: fork()
+// crea otra SharedMemory que comparte todas las páginas y cada escritura copia
+// la página solo si sigue compartida (copy-on-write). Así una simulación
+// "caliente" puede bifurcarse en muchas variantes sin copiar toda la imagen.
 class SharedMemory {
 public:
-    SharedMemory();
+    // Tamaño por defecto: 512 palabras de 64 bits (4096 B, especificación).
+    static constexpr size_t kDefaultBytes = 4096;
+    // Granularidad del copy-on-write (8 líneas de 32 B; una línea nunca cruza páginas)
+    static constexpr size_t kPageBytes = 256;
+
+    explicit SharedMemory(size_t bytes = kDefaultBytes);
+    size_t size() const { return bytes_; }
+
+    // Copia lógica que comparte las páginas (con sus contadores de acceso).
+    // Las dos memorias pueden usarse desde hilos distintos a partir de aquí.
+    std::unique_ptr<SharedMemory> fork() const;
+    size_t page_count() const { return pages_.size(); }
+    size_t shared_pages() const;   // páginas que aún comparte con otra copia
+
     void handle_message(MessageP msg, std::function<void(MessageP)> send_response);
     void dump_stats(std::ostream &os = std::cout);
+    void get_stats(uint64_t &reads, uint64_t &writes);
+
+    // Acceso en bloque del host (inicializar entradas, extraer resultados): un solo
+    // lock y un memcpy por página, sin mensajes ni contadores de DRAM. NO es
+    // coherente con las L1$: para eso está dma/DmaAgent.hpp. false si [addr, addr+n)
+    // se sale de la memoria (no se copia nada).
+    bool read_block(uint64_t addr, void *out, size_t n) const;
+    bool write_block(uint64_t addr, const void *in, size_t n);
+    bool read_doubles(uint64_t addr, double *out, size_t count) const {
+        return read_block(addr, out, count * sizeof(double));
+    }
+    bool write_doubles(uint64_t addr, const double *in, size_t count) {
+        return write_block(addr, in, count * sizeof(double));
+    }
+
+    // Acceso funcional directo de 8 B (avance rápido de la simulación muestreada,
+    // ver sampling/Sampler.hpp): sin mensajes y sin contar lecturas/escrituras de
+    // DRAM. Fuera de rango: load64 devuelve 0 y store64/cas64 no escriben.
+    uint64_t load64(uint64_t addr) const;
+    void     store64(uint64_t addr, uint64_t val);
+    uint64_t cas64(uint64_t addr, uint64_t expected, uint64_t desired);  // devuelve el previo
+
+    // Particiones NUMA (ver numa/NumaDirectory.hpp): cada página tiene un nodo
+    // "home". set_numa_nodes reparte la memoria entre 'nodes' nodos intercalando
+    // bloques de 'interleave' bytes (múltiplo de kPageBytes); bind() fija el home
+    // de las páginas que toca [addr, addr+n) (ubicación explícita, como mbind).
+    // Las lecturas/escrituras de línea se cuentan por nodo home.
+    bool set_numa_nodes(int nodes, size_t interleave = kPageBytes);
+    bool bind(uint64_t addr, size_t n, int node);
+    int  numa_nodes() const { return numa_nodes_; }
+    int  home_node(uint64_t addr) const {
+        return addr < bytes_ ? home_[addr / kPageBytes] : 0;
+    }
+    void get_node_stats(int node, uint64_t &reads, uint64_t &writes) const;
+
+    // Controlador DRAM (ver memory/dram/DramController.hpp): cada lectura y
+    // escritura de línea por mensaje se le pasa, con el mutex tomado, para
+    // modelar su tiempo. Los accesos en bloque y de 8 B no pasan por él; fork()
+    // no lo hereda. nullptr = costo fijo (sin modelo).
+    void set_dram(DramController *d);
+    DramController *dram() const { return dram_; }
+
+    // Checkpoint (ver checkpoint/Checkpoint.hpp): tamaño, contenido y contadores
+    void save(CheckpointWriter &w) const;
+    bool load(CheckpointReader &r);
 
 private:
     void handle_read(MessageP msg, std::function<void(MessageP)> send_response);
     void handle_write(MessageP msg, std::function<void(MessageP)> send_response);
 
-    std::vector<uint8_t> memory;
-    std::mutex memory_mutex;
+    using Page = std::array<uint8_t, kPageBytes>;
+
+    // Referencia contada a una página. El contador es el número de SharedMemory
+    // que la comparten: copiar la referencia (fork) lo incrementa y soltarla
+    // (destrucción, copy-on-write, load) lo decrementa con acq_rel. La mitad
+    // release publica las lecturas de la página de quien la suelta; la acquire
+    // hace que la última referencia, que la libera, vea las de todas las demás
+    // antes del delete. shared() lo lee con acquire por lo mismo: si otra copia
+    // acaba de soltarla, sus lecturas de la página ocurren antes de que esta la
+    // escriba en el lugar (un use_count() relajado no da esa garantía).
+    class PageRef {
+    public:
+        PageRef() = default;
+        explicit PageRef(const Page &p) : b_(new Block{p}) {}
+        PageRef(const PageRef &o) : b_(o.b_) {
+            if (b_) b_->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        PageRef(PageRef &&o) noexcept : b_(std::exchange(o.b_, nullptr)) {}
+        PageRef &operator=(PageRef o) noexcept { std::swap(b_, o.b_); return *this; }
+        ~PageRef() {
+            if (b_ && b_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete b_;
+        }
+        bool shared() const { return b_->refs.load(std::memory_order_acquire) > 1; }
+        const Page &page() const { return b_->page; }
+        uint8_t *data() const { return b_->page.data(); }
+    private:
+        struct Block { Page page; std::atomic<uint32_t> refs{1}; };
+        Block *b_ = nullptr;
+    };
+
+    bool in_range_(uint64_t addr, size_t n) const { return addr <= bytes_ && n <= bytes_ - addr; }
+    void read_bytes_(size_t addr, uint8_t *out, size_t n) const;
+    void write_bytes_(size_t addr, const uint8_t *in, size_t n);   // copia la página si es compartida
+
+    size_t bytes_ = 0;
+    std::vector<PageRef> pages_;
+    mutable std::mutex memory_mutex;
+
+    // Nodo home por página y contadores por nodo (una sola partición por defecto)
+    int numa_nodes_ = 1;
+    std::vector<uint8_t> home_;
+    std::vector<uint64_t> node_reads_, node_writes_;
+    DramController *dram_ = nullptr;
 
     // Estadísticas básicas
     uint64_t total_reads = 0;
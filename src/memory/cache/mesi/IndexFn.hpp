@@ -0,0 +1,89 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <string>
+
+/*
+ * IndexFn.hpp
+ * ===========
+ * Funciones de índice de set de la L1$ (MESICache::setIndexFunction). Todas
+ * reciben el número de línea (addr >> kOffsetBits) y devuelven un set en
+ * [0, sets); 'bits' = log2(sets).
+ *
+ * - Bits   : corte de bits (clásico). Arreglos cuyas bases difieren en un
+ *            múltiplo de sets*línea (256 B aquí) caen en los mismos sets.
+ * - Xor    : XOR de todos los trozos de 'bits' bits del número de línea; los
+ *            bits altos desplazan el set y rompen esos alias de potencia de 2.
+ * - Prime  : número de línea módulo el mayor primo < sets (7 de 8 sets: uno
+ *            queda sin usar a cambio de no tener strides patológicos de 2^k).
+ * - Skewed : asociativa sesgada (Seznec): cada vía usa su propia función,
+ *            lo ^ rot_w(hi), de modo que dos líneas que chocan en una vía casi
+ *            nunca chocan en las demás. El reemplazo pasa a ser LRU entre los
+ *            candidatos de cada vía (ver MESICache::installLine).
+ *
+ * Con Bits el tag guardado es addr >> (offset + índice); con las demás el set
+ * no basta para reconstruir la dirección y el tag es el número de línea entero.
+ */
+enum class IndexFn : uint8_t { Bits, Xor, Prime, Skewed };
+
+namespace index_fn {
+
+// XOR de los trozos de 'bits' bits de 'x'
+inline uint32_t fold(uint64_t x, int bits) {
+    uint64_t h = 0;
+    for (; x; x >>= bits) h ^= x;
+    return uint32_t(h & ((uint64_t(1) << bits) - 1));
+}
+
+// Mayor primo menor o igual que n (n pequeño: número de sets)
+constexpr uint32_t prime_below(uint32_t n) {
+    for (uint32_t p = n; p > 2; --p) {
+        bool is_prime = true;
+        for (uint32_t d = 2; d * d <= p; ++d)
+            if (p % d == 0) { is_prime = false; break; }
+        if (is_prime) return p;
+    }
+    return 2;
+}
+
+// Set de la línea 'line' en la vía 'way' (solo Skewed depende de la vía)
+template <int bits>
+inline uint32_t set_of(IndexFn f, uint64_t line, int way) {
+    constexpr uint32_t mask  = (1u << bits) - 1;
+    constexpr uint32_t prime = prime_below(1u << bits);
+    switch (f) {
+        case IndexFn::Bits:  return uint32_t(line) & mask;
+        case IndexFn::Xor:   return fold(line, bits);
+        case IndexFn::Prime: return uint32_t(line % prime);
+        case IndexFn::Skewed: {
+            const uint32_t lo = uint32_t(line) & mask;
+            const uint32_t hi = fold(line >> bits, bits);
+            assert(way >= 0 && "set_of: vía negativa (¿miss?)");
+            const uint32_t r = unsigned(way) % bits;
+            const uint32_t rot = r ? (((hi << r) | (hi >> (bits - r))) & mask) : hi;
+            return lo ^ rot;
+        }
+    }
+    return uint32_t(line) & mask;
+}
+
+inline const char* name(IndexFn f) {
+    switch (f) {
+        case IndexFn::Bits:   return "bits";
+        case IndexFn::Xor:    return "xor";
+        case IndexFn::Prime:  return "prime";
+        case IndexFn::Skewed: return "skew";
+    }
+    return "?";
+}
+
+inline bool parse(const std::string& s, IndexFn& out) {
+    if (s == "bits")       out = IndexFn::Bits;
+    else if (s == "xor")   out = IndexFn::Xor;
+    else if (s == "prime") out = IndexFn::Prime;
+    else if (s == "skew")  out = IndexFn::Skewed;
+    else return false;
+    return true;
+}
+
+}  // namespace index_fn
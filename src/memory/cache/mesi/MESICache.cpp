@@ -1,18 +1,29 @@
 #include "MESICache.hpp"
 #include "MesiDebug.hpp"
+#include <bit>
 #include <cstring>
 #include <cassert>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
+#include <chrono>
+#include <thread>
+#include <utility>
 #include "MesiInterconnect.hpp"
+#include "analysis/FalseSharingDetector.hpp"
+#include "checkpoint/Checkpoint.hpp"
 
 /*
  * MESICache
  * =========
  * Controlador de cache L1 privado por PE con coherencia MESI (M/E/S/I),
- * 2 vías por set, línea de 32B, políticas write-allocate + write-back.
- * - Emite transacciones al bus: BusRd, BusRdX, BusUpgr, Flush (y opcional Inv).
+ * 2 vías por set, línea de 32B. Política de escritura seleccionable por L1$ o
+ * por región (WritePolicy.hpp): write-back o write-through, con o sin
+ * write-allocate (write-back + allocate por defecto).
+ * - Emite transacciones al bus: BusRd, BusRdX, BusUpgr, Flush (y opcional Inv);
+ *   BusWr para write-through/write-around.
+ * - storeNonTemporal/fence: stores no temporales juntados en buffers de
+ *   write-combining que salen como BusWrLine (línea completa, sin RFO) o BusWr.
  * - Responde snoops de otros PEs en onSnoop(...).
  * - onDataResponse(...) instala la línea en E o S según el bit "shared".
  * - load/store devuelven false en miss o falta de exclusividad para que
@@ -24,36 +35,177 @@
 MESICache::MESICache(int pe_id, MesiInterconnect& bus)
   : pe_id_(pe_id), bus_(&bus) {}
 
+auto MESICache::initialMeta() -> TagStore {
+    TagStore m{};
+    for (auto& row : m.tag)
+        for (uint64_t& t : row) t = kNoTag;
+    return m;
+}
+
+/* setState(s, w, st)
+ * ------------------
+ * Único punto que escribe meta_.state: mantiene el bit 'live' de la vía.
+ * 'live' se publica con release: un hit de load que la lee con acquire
+ * vuelve a leer después el seqlock del set y ve al escritor.
+ */
+void MESICache::setState(uint32_t s, int w, MESI st) {
+    std::atomic_ref<MESI>(meta_.state[s][w]).store(st, std::memory_order_relaxed);
+    const uint32_t live = st == MESI::I ? meta_.live[s] & ~(1u << w) : meta_.live[s] | (1u << w);
+    std::atomic_ref<uint32_t>(meta_.live[s]).store(live, std::memory_order_release);
+}
+
+/* setsOf(addr) / readBegin(sets) / readRetry(sets, snap) / lockSets / unlockSets
+ * -------------------------------------------------------------------------------
+ * Seqlocks por set (ver "Hilos" en el header). Un escritor lleva el contador
+ * de par a impar con CAS y lo devuelve a par (+2) al terminar; dos escritores
+ * del mismo set (el dueño con un store y un snoop) se excluyen ahí. Con sesgo
+ * una dirección abarca varios sets: se toman en orden creciente.
+ */
+uint32_t MESICache::setsOf(uint64_t addr) const {
+    if (index_fn_ != IndexFn::Skewed) return 1u << setOf(addr);
+    uint32_t m = 0;
+    for (int w = 0; w < kWays; ++w) m |= 1u << setOf(addr, w);
+    return m;
+}
+
+uint32_t MESICache::readBegin(uint32_t sets) const {
+    for (;;) {
+        uint32_t sum = 0, busy = 0;
+        for (uint32_t m = sets; m; m &= m - 1) {
+            const uint32_t v = seq_[std::countr_zero(m)].v.load(std::memory_order_acquire);
+            busy |= v & 1;
+            sum += v;
+        }
+        if (!busy) return sum;
+        std::this_thread::yield();   // el snoop corre en otro hilo (quizá en este núcleo)
+    }
+}
+
+bool MESICache::readRetry(uint32_t sets, uint32_t snap) const {
+    uint32_t sum = 0;
+    for (uint32_t m = sets; m; m &= m - 1)
+        sum += seq_[std::countr_zero(m)].v.load(std::memory_order_acquire);
+    return sum != snap;
+}
+
+void MESICache::lockSets(uint32_t sets) const {
+    for (uint32_t m = sets; m; m &= m - 1) {
+        std::atomic<uint32_t>& q = seq_[std::countr_zero(m)].v;
+        uint32_t v = q.load(std::memory_order_relaxed);
+        while ((v & 1) || !q.compare_exchange_weak(v, v + 1, std::memory_order_acquire,
+                                                   std::memory_order_relaxed)) {
+            if (v & 1) {
+                std::this_thread::yield();
+                v = q.load(std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+void MESICache::unlockSets(uint32_t sets) const {
+    // Con el contador impar solo escribe quien lo tiene: basta un store
+    for (uint32_t m = sets; m; m &= m - 1) {
+        std::atomic<uint32_t>& q = seq_[std::countr_zero(m)].v;
+        q.store(q.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+}
+
+/* setIndexFunction(f)
+ * -------------------
+ * Cambia la función de índice. Con otra función las mismas vías significarían
+ * otras direcciones, así que se exige la L1$ sin copias vivas y se descartan
+ * los tags de las vías en I.
+ */
+void MESICache::setIndexFunction(IndexFn f) {
+    for (uint32_t s = 0; s < kSets; ++s)
+        assert(meta_.live[s] == 0 && "setIndexFunction con líneas en la L1$");
+    for (uint32_t s = 0; s < kSets; ++s)
+        for (int w = 0; w < kWays; ++w) retireWay(s, w);
+    meta_ = initialMeta();
+    index_fn_ = f;
+}
+
+/* lineAt(set, way)
+ * ----------------
+ * Reconstruye la vista CacheLine (válida/dirty/estado/tag/datos) de una vía.
+ */
+CacheLine MESICache::lineAt(int set, int way) const {
+    CacheLine L;
+    L.valid = meta_.tag[set][way] != kNoTag;
+    L.dirty = meta_.dirty[set][way];
+    L.state = meta_.state[set][way];
+    L.tag   = L.valid ? meta_.tag[set][way] : 0;
+    L.data  = data_[set][way];
+    return L;
+}
+
+/* snapshotLines()
+ * ---------------
+ * Copia de todas las vías con los seqlocks de los 8 sets tomados: ningún store
+ * hit del dueño ni snoop escribe mientras tanto. El llamador retiene el bus, así
+ * que el resto de las escrituras (instalaciones, S->M) tampoco corre. Orden de
+ * locks: bus -> sets, igual que los snoops (que ya soltaron su set al emitir el
+ * Flush, ver onSnoop).
+ */
+auto MESICache::snapshotLines() const -> LineSnapshot {
+    LineSnapshot out;
+    lockSets(kAllSets);
+    for (int s = 0; s < kSets; ++s)
+        for (int w = 0; w < kWays; ++w) {
+            out.line[s][w] = lineAt(s, w);
+            out.base[s][w] = lineBase(s, w);
+        }
+    unlockSets(kAllSets);
+    return out;
+}
+
+uint64_t MESICache::lineBase(int set, int way) const {
+    const uint64_t t = meta_.tag[set][way];
+    return index_fn_ == IndexFn::Bits ? lineAddress(t, uint32_t(set)) : (t << kOffsetBits);
+}
+
+/* tagWays(addr) / hitWays(addr)
+ * -----------------------------
+ * Máscara de vías con el tag de 'addr' (ver el comentario en el header).
+ */
+uint32_t MESICache::tagWays(uint64_t addr) const {
+    const uint64_t t = tagOf(addr);
+    if (index_fn_ != IndexFn::Skewed) return tag_match<kWays>(meta_.tag[setOf(addr)], t);
+    uint32_t m = 0;
+    for (int w = 0; w < kWays; ++w) m |= uint32_t(meta_.tag[setOf(addr, w)][w] == t) << w;
+    return m;
+}
+
+uint32_t MESICache::hitWays(uint64_t addr) const {
+    if (index_fn_ != IndexFn::Skewed) {
+        const uint32_t s = setOf(addr);
+        return tag_match<kWays>(meta_.tag[s], tagOf(addr)) & liveOf(s);
+    }
+    uint32_t live = 0;
+    for (int w = 0; w < kWays; ++w) live |= liveOf(setOf(addr, w)) & (1u << w);
+    return tagWays(addr) & live;
+}
+
 /* hasLine(addr)
  * -------------
  * Devuelve true si existe en el set correspondiente una línea válida con el tag
  * buscado y con estado distinto de I (Invalid).
  */
 bool MESICache::hasLine(uint64_t addr) const {
-    const uint32_t s = idx(addr);
-    const uint64_t t = tag(addr);
-    for (int w = 0; w < kWays; ++w) {
-        const auto& L = sets_[s].way[w];
-        if (L.valid && L.tag == t && L.state != MESI::I)
-            return true;
-    }
-    return false;
+    // Lo llama el bus (retenido): el dueño no puede instalar ni desalojar, y un
+    // store suyo en curso no cambia si la copia está viva
+    return hitWays(addr) != 0;
 }
 
 /* lookupLine(addr)
  * ----------------
- * Busca una línea por (set, tag). Si la encuentra y no está en I, retorna hit=true,
- * la vía y el puntero a la línea. Si no, retorna hit=false.
+ * Busca una línea por (set, tag) comparando todas las vías a la vez. Si la
+ * encuentra y no está en I, retorna hit=true y la vía. Si no, retorna hit=false.
  */
 auto MESICache::lookupLine(uint64_t addr) -> Lookup {
-    uint32_t s = idx(addr);
-    uint64_t t = tag(addr);
-    for (int w = 0; w < kWays; ++w) {
-        auto& L = sets_[s].way[w];
-        if (L.valid && L.tag == t && L.state != MESI::I)
-            return {true, w, &L};
-    }
-    return {false, -1, nullptr};
+    const uint32_t m = hitWays(addr);
+    if (!m) return {false, -1};
+    return {true, std::countr_zero(m)};
 }
 
 /* touchLRU(s, way_mru)
@@ -61,7 +213,8 @@ auto MESICache::lookupLine(uint64_t addr) -> Lookup {
  * Marca la vía usada como MRU. Para 2 vías, un bit/índice por set es suficiente.
  */
 void MESICache::touchLRU(uint32_t s, int way_mru) {
-    sets_[s].lru = (way_mru == 0) ? 1 : 0;
+    meta_.lru[s] = (way_mru == 0) ? 1 : 0;
+    stamp_[s][way_mru] = ++use_clock_;
 }
 
 /* victimWay(s)
@@ -69,19 +222,43 @@ void MESICache::touchLRU(uint32_t s, int way_mru) {
  * Devuelve la vía víctima (la menos recientemente usada) para un set.
  */
 int MESICache::victimWay(uint32_t s) const {
-    return sets_[s].lru == 0 ? 0 : 1;
+    return meta_.lru[s] == 0 ? 0 : 1;
+}
+
+/* chooseWay(addr, s)
+ * ------------------
+ * Primera vía libre (no válida o en I) para 'addr'; si no hay, la víctima LRU.
+ * Con índice sesgado los candidatos están en sets distintos (uno por vía) y la
+ * víctima es el de uso más antiguo.
+ */
+int MESICache::chooseWay(uint64_t addr, uint32_t* s) const {
+    if (index_fn_ != IndexFn::Skewed) {
+        *s = setOf(addr);
+        if (const uint32_t free = ~meta_.live[*s] & ((1u << kWays) - 1))
+            return std::countr_zero(free);
+        return victimWay(*s);
+    }
+    int best = -1;
+    for (int w = 0; w < kWays; ++w) {
+        const uint32_t sw = setOf(addr, w);
+        if (!((meta_.live[sw] >> w) & 1)) { *s = sw; return w; }
+        if (best < 0 || stamp_[sw][w] < stamp_[*s][best]) { best = w; *s = sw; }
+    }
+    return best;
 }
 
-/* recordTrans(from, to)
- * ---------------------
- * Registra una transición de estado MESI en una matriz de conteo
- * y también en una lista legible tipo "MESI: 1->3" (para CSV/gráficas).
+/* logTrans(from, to)
+ * ------------------
+ * Agrega una transición de estado MESI a la lista legible tipo "MESI: 1->3"
+ * (para CSV/gráficas). El conteo en la matriz lo hace countTrans (recordTrans
+ * hace ambos).
  */
-void MESICache::recordTrans(MESI from, MESI to) {
-    metrics_.mesi_trans[(int)from][(int)to]++;
-    std::stringstream ss;
-    ss << "MESI: " << (int)from << "->" << (int)to;
-    metrics_.mesi_transitions.push_back(ss.str());
+void MESICache::logTrans(MESI from, MESI to) {
+    std::string e = "MESI: 0->0";   // cabe en el buffer corto de std::string
+    e[6] = char('0' + int(from));
+    e[9] = char('0' + int(to));
+    std::lock_guard<std::mutex> lk(trans_log_mtx_);
+    metrics_.mesi_transitions.push_back(std::move(e));
 }
 
 /* Emisores de mensajes al bus
@@ -90,27 +267,41 @@ void MESICache::recordTrans(MESI from, MESI to) {
  */
 void MESICache::emitBusRd(uint64_t addr) {
     metrics_.busRd++;
-    assert(bus_);
-    bus_->emit({BusMsg::BusRd, addr, nullptr, 0, pe_id_});
+    timedEmit(LatBusRd, {BusMsg::BusRd, addr, nullptr, 0, pe_id_});
 }
 
 void MESICache::emitBusRdX(uint64_t addr) {
     metrics_.busRdX++;
-    assert(bus_);
-    bus_->emit({BusMsg::BusRdX, addr, nullptr, 0, pe_id_});
+    timedEmit(LatBusRdX, {BusMsg::BusRdX, addr, nullptr, 0, pe_id_});
 }
 
 void MESICache::emitBusUpgr(uint64_t addr) {
     metrics_.busUpgr++;
-    assert(bus_);
-    bus_->emit({BusMsg::BusUpgr, addr, nullptr, 0, pe_id_});
+    timedEmit(LatBusUpgr, {BusMsg::BusUpgr, addr, nullptr, 0, pe_id_});
 }
 
 void MESICache::emitFlush(uint64_t addr, const uint8_t* data) {
     metrics_.flush++;
-    assert(bus_);
     // En Flush enviamos línea completa (32B)
-    bus_->emit({BusMsg::Flush, addr, data, kLineSize, pe_id_});
+    timedEmit(LatFlush, {BusMsg::Flush, addr, data, kLineSize, pe_id_});
+}
+
+/* timedEmit(k, t)
+ * ---------------
+ * El bus es síncrono: cuando emit() retorna, onDataResponse ya instaló la línea
+ * (o el upgrade/write-back terminó), así que el tiempo alrededor de la llamada es
+ * la latencia de extremo a extremo. Incluye la espera por el bus (árbitro/lock).
+ * Un Flush por snoop corre en el hilo del solicitante: por eso los histogramas
+ * son multi-escritor.
+ */
+void MESICache::timedEmit(LatKind k, const BusTransaction& t) {
+    assert(bus_);
+    const auto t0 = std::chrono::steady_clock::now();
+    const uint64_t cycles = bus_->emit(t);
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+    metrics_.lat_cycles[k].record(cycles);
+    metrics_.lat_ns[k].record(uint64_t(ns));
 }
 
 void MESICache::emitInv(uint64_t addr) {
@@ -118,6 +309,18 @@ void MESICache::emitInv(uint64_t addr) {
     bus_->emit({BusMsg::Inv, addr, nullptr, 0, pe_id_});
 }
 
+void MESICache::emitBusWr(uint64_t addr, const void* in8) {
+    metrics_.bus_writes++;
+    assert(bus_);
+    bus_->emit({BusMsg::BusWr, addr, static_cast<const uint8_t*>(in8), 8, pe_id_});
+}
+
+void MESICache::emitBusWrLine(uint64_t base, const uint8_t* data) {
+    metrics_.nt_lines++;
+    assert(bus_);
+    bus_->emit({BusMsg::BusWrLine, base, data, kLineSize, pe_id_});
+}
+
 /* installLine(addr, data, st)
  * ---------------------------
  * Instala una línea en el set de 'addr' con estado 'st' (E/S/M).
@@ -127,39 +330,34 @@ void MESICache::emitInv(uint64_t addr) {
  *
  */
 void MESICache::installLine(uint64_t addr, const uint8_t data[32], MESI st) {
-    uint32_t s = idx(addr);
-    uint64_t t = tag(addr);
-    int way = -1;
+    // 1) vía libre (no válida o en I) o, si no hay, víctima LRU
+    uint32_t s;
+    const int way = chooseWay(addr, &s);
 
-    // 1) buscar hueco (vía no válida o en I)
-    for (int w = 0; w < kWays; ++w) {
-        if (!sets_[s].way[w].valid || sets_[s].way[w].state == MESI::I) {
-            way = w;
-            break;
+    // 2) si la vía está viva (M/E/S) es un desalojo
+    retireWay(s, way);
+    if ((meta_.live[s] >> way) & 1) {
+        const uint64_t vbase = lineBase(int(s), way);
+        // Desalojar la línea reservada rompe la reserva LL
+        if (resv_valid_ && vbase == resv_line_) {
+            resv_valid_ = false;
+            metrics_.resv_lost++;
         }
-    }
-
-    // 2) si no hay hueco, tomar víctima LRU
-    if (way == -1) {
-        way = victimWay(s);
-        auto& V = sets_[s].way[way];
-        if (V.valid && V.state == MESI::M) {
-            // 🔄 Write-back de la víctima sucia antes de sobrescribir
-            // 💡 TIP: la dirección debería ser la base de la línea VÍCTIMA.
-            // Actualmente se usa la base derivada de 'addr' (nueva línea):
-            emitFlush(addr & ~((uint64_t)kLineSize - 1), V.data.data());
+        if (meta_.state[s][way] == MESI::M) {
+            // 🔄 Write-back de la víctima sucia antes de sobrescribir,
+            // en la base de la línea VÍCTIMA, no la de 'addr'
+            emitFlush(vbase, data_[s][way].data());
         }
     }
 
     // 3) instalar nueva línea y estado
-    auto& L = sets_[s].way[way];
-    L.valid = true;
-    L.dirty = (st == MESI::M);
+    metrics_.set_misses[s]++;
+    meta_.tag[s][way]   = tagOf(addr);
+    meta_.dirty[s][way] = (st == MESI::M);
     // Registrar transición desde el estado previo (por defecto suele ser I)
-    recordTrans(L.state, st);
-    L.state = st;
-    L.tag   = t;
-    std::memcpy(L.data.data(), data, kLineSize);
+    recordTrans(meta_.state[s][way], st);
+    setState(s, way, st);
+    std::memcpy(data_[s][way].data(), data, kLineSize);
     touchLRU(s, way);
 }
 
@@ -167,13 +365,17 @@ void MESICache::installLine(uint64_t addr, const uint8_t data[32], MESI st) {
  * ------------
  * Accesos de 8 bytes (útil para double/uint64). write8 marca dirty.
  */
-void MESICache::write8(CacheLine& line, uint32_t line_off, const void* in8) {
-    line.dirty = true;
-    std::memcpy(line.data.data() + line_off, in8, 8);
+void MESICache::write8(uint32_t s, int w, uint32_t line_off, const void* in8) {
+    meta_.dirty[s][w] = true;
+    writeClean8(s, w, line_off, in8);
 }
 
-void MESICache::read8(const CacheLine& line, uint32_t line_off, void* out8) const {
-    std::memcpy(out8, line.data.data() + line_off, 8);
+void MESICache::writeClean8(uint32_t s, int w, uint32_t line_off, const void* in8) {
+    std::memcpy(data_[s][w].data() + line_off, in8, 8);
+}
+
+void MESICache::read8(uint32_t s, int w, uint32_t line_off, void* out8) const {
+    std::memcpy(out8, data_[s][w].data() + line_off, 8);
 }
 
 /* load(addr, out8)
@@ -181,16 +383,25 @@ void MESICache::read8(const CacheLine& line, uint32_t line_off, void* out8) cons
  * Camino de lectura local:
  * - Si hit: lee, toca LRU y retorna true.
  * - Si miss: cuenta miss, emite BusRd y retorna false (el puerto reintenta).
+ * El hit no toma locks: lectura optimista bajo el seqlock del set, que se
+ * repite si un snoop lo modificó mientras tanto. LRU, sombra del clasificador
+ * y contadores por set son solo del dueño: se tocan después de validar.
  */
 bool MESICache::load(uint64_t addr, void* out8) {
     metrics_.loads++; metrics_.rw_accesses++;
-    auto L = lookupLine(addr);
-    uint32_t s = idx(addr);
-    uint32_t o = off(addr);
-
+    if (wc_live_) drainWcLine(addr);
+    const uint32_t sets = setsOf(addr);
+    Lookup L;
+    for (;;) {
+        const uint32_t snap = readBegin(sets);
+        L = lookupLine(addr);
+        if (L.hit) read8(setOf(addr, L.way), L.way, off(addr), out8);
+        if (!readRetry(sets, snap)) break;
+    }
     if (L.hit) {
-        read8(*L.line, o, out8);
+        const uint32_t s = setOf(addr, L.way);
         touchLRU(s, L.way);
+        noteAccess(addr, s, false);
         return true;
     }
 
@@ -201,49 +412,103 @@ bool MESICache::load(uint64_t addr, void* out8) {
 
 /* store(addr, in8)
  * ----------------
- * Camino de escritura local (write-allocate + write-back):
+ * Camino de escritura local según la política de la dirección (WritePolicy.hpp).
+ * Write-back (por defecto, write-allocate):
  * - Si no hay línea o está en I: miss, BusRdX y retorna false (el puerto reintenta).
  * - Si hay línea:
  *     M: escribe directo (M→M).
  *     E: eleva a M (E→M), escribe.
  *     S: emite BusUpgr, eleva a M (S→M), escribe.
+ * Write-through: hit en E/S => escribe la copia (sigue limpia) y emite BusWr;
+ * miss => BusRd y reintento. Sin allocate, un miss solo emite BusWr y completa.
  */
 bool MESICache::store(uint64_t addr, const void* in8) {
     metrics_.stores++; metrics_.rw_accesses++;
-    auto L = lookupLine(addr);
-    uint32_t s = idx(addr);
+    if (wc_live_) drainWcLine(addr);
     uint32_t o = off(addr);
+    const WritePolicy wp = writePolicyFor(addr);
+    const bool through = write_policy::through(wp);
+
+    // Hit en M/E: se completa localmente con el seqlock del set tomado (un snoop
+    // concurrente al mismo set espera; los de otros sets no)
+    if (!through) {
+        bool done = false, upgraded = false;
+        {
+            SetGuard g(*this, setsOf(addr));
+            auto L = lookupLine(addr);
+            const uint32_t s = L.hit ? setOf(addr, L.way) : 0;
+            if (L.hit && (meta_.state[s][L.way] == MESI::M || meta_.state[s][L.way] == MESI::E)) {
+                if (meta_.state[s][L.way] == MESI::E) {
+                    countTrans(MESI::E, MESI::M);
+                    setState(s, L.way, MESI::M);
+                    upgraded = true;
+                }
+                write8(s, L.way, o, in8);
+                touchLRU(s, L.way);
+                noteAccess(addr, s, true);
+                done = true;
+            }
+        }
+        if (upgraded) logTrans(MESI::E, MESI::M);
+        if (done) return true;
+    }
+
+    // S o miss: con el bus retenido el estado ya no cambia entre la decisión y
+    // la escritura (sin esto un BusUpgr ajeno podía invalidar la línea después
+    // de leer S y el store se escribía sobre una copia ya inválida).
+    auto grant = bus_->hold(pe_id_);
+    auto L = lookupLine(addr);
 
     // Miss o línea inválida: pedir exclusividad vía BusRdX y reintentar luego
-    if (!L.hit || L.line->state == MESI::I) {
+    // (write-through: la línea se trae compartible con BusRd)
+    if (!L.hit) {
+        if (!write_policy::allocates(wp)) {
+            metrics_.write_arounds++;
+            emitBusWr(addr, in8);
+            return true;
+        }
         metrics_.cache_misses++;
-        emitBusRdX(addr);
+        if (through) emitBusRd(addr);
+        else         emitBusRdX(addr);
         return false;
     }
+    const uint32_t s = setOf(addr, L.way);   // sólo con hit: la vía es válida
+
+    // Write-through sobre una copia limpia: la memoria recibe los 8 B y las
+    // copias ajenas se invalidan; la propia no pasa a M. (Una línea en M, p.ej.
+    // tras un atómico, sigue como write-back.)
+    if (through && meta_.state[s][L.way] != MESI::M) {
+        writeClean8(s, L.way, o, in8);
+        touchLRU(s, L.way);
+        noteAccess(addr, s, true);
+        emitBusWr(addr, in8);
+        return true;
+    }
 
     // Hit: actuar según estado MESI
-    switch (L.line->state) {
+    switch (meta_.state[s][L.way]) {
         case MESI::M:
             // Ya exclusiva y modificable
-            write8(*L.line, o, in8);
+            write8(s, L.way, o, in8);
             touchLRU(s, L.way);
+            noteAccess(addr, s, true);
             return true;
         case MESI::E:
             // Elevar E->M y escribir
             recordTrans(MESI::E, MESI::M);
-            L.line->state = MESI::M;
-            L.line->dirty = true;
-            write8(*L.line, o, in8);
+            setState(s, L.way, MESI::M);
+            write8(s, L.way, o, in8);
             touchLRU(s, L.way);
+            noteAccess(addr, s, true);
             return true;
         case MESI::S:
             // Pedir upgrade para invalidar copias ajenas, S->M y escribir
             emitBusUpgr(addr);
             recordTrans(MESI::S, MESI::M);
-            L.line->state = MESI::M;
-            L.line->dirty = true;
-            write8(*L.line, o, in8);
+            setState(s, L.way, MESI::M);
+            write8(s, L.way, o, in8);
             touchLRU(s, L.way);
+            noteAccess(addr, s, true);
             return true;
         case MESI::I:
             // No debería suceder aquí (ya lo cubrimos arriba)
@@ -252,12 +517,257 @@ bool MESICache::store(uint64_t addr, const void* in8) {
     return false;
 }
 
+/* storeNonTemporal(addr, in8) / fence()
+ * -------------------------------------
+ * Buffers de write-combining: uno por línea, hasta kWcBuffers. Al completarse
+ * la línea sale como BusWrLine (32 B, sin leerla antes); si hace falta el
+ * buffer (más líneas abiertas que buffers) se vacía el más antiguo palabra a
+ * palabra. Los buffers no tienen copia en la L1$, así que los snoops no los ven.
+ * Con la línea ya en la L1$ es un store normal (reintentado hasta completar).
+ */
+bool MESICache::storeNonTemporal(uint64_t addr, const void* in8) {
+    const uint32_t o = off(addr);
+    assert(o % 8 == 0 && "store no temporal desalineado");
+    metrics_.nt_stores++;
+    if (hitWays(addr)) {   // solo este hilo instala líneas aquí
+        // Un snoop puede invalidarla antes de que store() tome el bus: entonces
+        // emite BusRdX y retorna false, igual que para el puerto
+        while (!store(addr, in8)) {}
+        return true;
+    }
+
+    metrics_.stores++; metrics_.rw_accesses++;
+    const uint64_t base = addr & ~((uint64_t)kLineSize - 1);
+    WcBuffer* w = nullptr;
+    for (WcBuffer& b : wc_)
+        if (b.mask && b.base == base) { w = &b; break; }
+    if (!w) {
+        for (WcBuffer& b : wc_)
+            if (!b.mask) { w = &b; break; }
+        if (!w) {
+            w = &wc_[0];
+            for (WcBuffer& b : wc_)
+                if (b.stamp < w->stamp) w = &b;
+            drainWc(*w);
+        }
+        w->base = base;
+        ++wc_live_;
+    }
+    std::memcpy(w->data.data() + o, in8, 8);
+    w->mask |= uint8_t(1u << (o / 8));
+    w->stamp = ++wc_clock_;
+    if (w->mask == kWcFull) drainWc(*w);
+    return true;
+}
+
+void MESICache::fence() {
+    while (wc_live_) {
+        WcBuffer* w = nullptr;
+        for (WcBuffer& b : wc_)
+            if (b.mask && (!w || b.stamp < w->stamp)) w = &b;
+        drainWc(*w);
+    }
+}
+
+void MESICache::drainWc(WcBuffer& w) {
+    if (w.mask == kWcFull) {
+        emitBusWrLine(w.base, w.data.data());
+    } else {
+        metrics_.nt_partial++;
+        for (int k = 0; k < kLineSize / 8; ++k)
+            if (w.mask & (1u << k)) emitBusWr(w.base + 8 * k, w.data.data() + 8 * k);
+    }
+    w.mask = 0;
+    --wc_live_;
+}
+
+// Un acceso propio a una línea con stores no temporales pendientes los publica antes
+void MESICache::drainWcLine(uint64_t addr) {
+    const uint64_t base = addr & ~((uint64_t)kLineSize - 1);
+    for (WcBuffer& b : wc_)
+        if (b.mask && b.base == base) { drainWc(b); return; }
+}
+
+/* acquireOwnership(addr)
+ * -----------------------
+ * Precondición: el llamador retiene el bus (bus_->hold()).
+ * Deja la línea en M: E->M local; S->M con BusUpgr; miss/I con BusRdX (la
+ * respuesta llega síncrona en onDataResponse y se instala en E -> M).
+ * Como el bus está retenido, ningún snoop puede arrebatarnos la línea hasta
+ * que el llamador termine su lectura-modificación-escritura.
+ */
+auto MESICache::acquireOwnership(uint64_t addr) -> Lookup {
+    std::chrono::steady_clock::time_point t0{};
+    bool used_bus = false;
+    for (;;) {
+        auto L = lookupLine(addr);
+        const uint32_t s = L.hit ? setOf(addr, L.way) : 0;
+        const MESI st = L.hit ? meta_.state[s][L.way] : MESI::I;
+        if (st == MESI::M) break;
+        if (st == MESI::E) {
+            recordTrans(MESI::E, MESI::M);
+            setState(s, L.way, MESI::M);
+            meta_.dirty[s][L.way] = true;
+            break;
+        }
+        if (!used_bus) { t0 = std::chrono::steady_clock::now(); used_bus = true; }
+        metrics_.atomic_bus_ops++;
+        if (st == MESI::S) {
+            emitBusUpgr(addr);
+            recordTrans(MESI::S, MESI::M);
+            setState(s, L.way, MESI::M);
+            meta_.dirty[s][L.way] = true;
+            break;
+        }
+        metrics_.cache_misses++;
+        emitBusRdX(addr);
+    }
+    if (used_bus) {
+        metrics_.atomic_bus_ns += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - t0).count();
+    }
+    return lookupLine(addr);
+}
+
+/* atomicRMW(addr, op, operand, expected, ok)
+ * ------------------------------------------
+ * CAS / fetch-add entero / fetch-add double sobre 8B, con el bus retenido
+ * durante toda la operación. Cuenta como un acceso R/W.
+ */
+uint64_t MESICache::atomicRMW(uint64_t addr, AtomicOp op, uint64_t operand,
+                              uint64_t expected, bool* ok) {
+    assert(bus_);
+    if (wc_live_) drainWcLine(addr);
+    auto grant = bus_->hold(pe_id_);
+    metrics_.atomics++; metrics_.rw_accesses++;
+
+    auto L = acquireOwnership(addr);
+    assert(L.hit);
+    const uint32_t o = off(addr);
+    uint64_t old = 0, nv = 0;
+    const uint32_t s = setOf(addr, L.way);
+    read8(s, L.way, o, &old);
+
+    bool wrote = true;
+    switch (op) {
+        case AtomicOp::CAS:
+            wrote = (old == expected);
+            nv = operand;
+            if (!wrote) metrics_.cas_failures++;
+            break;
+        case AtomicOp::FetchAdd:
+            nv = old + operand;
+            break;
+        case AtomicOp::FetchFAdd: {
+            double a, b;
+            std::memcpy(&a, &old, 8); std::memcpy(&b, &operand, 8);
+            a += b;
+            std::memcpy(&nv, &a, 8);
+        } break;
+    }
+    if (wrote) write8(s, L.way, o, &nv);
+    touchLRU(s, L.way);
+    noteAccess(addr, s, true);
+    if (ok) *ok = wrote;
+    return old;
+}
+
+/* loadLinked(addr) / storeConditional(addr, val)
+ * ----------------------------------------------
+ * LL: lectura coherente normal + reserva de la línea.
+ * SC: si la reserva sigue viva (ningún BusRdX/BusUpgr/Inv ajeno ni evicción
+ * desde el LL), obtiene M y escribe; la reserva se consume en ambos casos.
+ */
+uint64_t MESICache::loadLinked(uint64_t addr) {
+    assert(bus_);
+    auto grant = bus_->hold(pe_id_);
+    metrics_.atomics++;
+    uint64_t v = 0;
+    while (!load(addr, &v)) {}
+    resv_line_  = addr & ~((uint64_t)kLineSize - 1);
+    resv_valid_ = true;
+    return v;
+}
+
+bool MESICache::storeConditional(uint64_t addr, uint64_t val) {
+    assert(bus_);
+    if (wc_live_) drainWcLine(addr);
+    auto grant = bus_->hold(pe_id_);
+    metrics_.atomics++; metrics_.rw_accesses++;
+    const uint64_t line = addr & ~((uint64_t)kLineSize - 1);
+    if (!resv_valid_ || resv_line_ != line) {
+        resv_valid_ = false;
+        metrics_.sc_failures++;
+        return false;
+    }
+    resv_valid_ = false;
+    auto L = acquireOwnership(addr);
+    assert(L.hit);
+    const uint32_t s = setOf(addr, L.way);
+    write8(s, L.way, off(addr), &val);
+    touchLRU(s, L.way);
+    noteAccess(addr, s, true);
+    return true;
+}
+
+/* waitEq(addr, val)
+ * -----------------
+ * Lee [addr] a través de la caché; si no vale 'val', duerme (std::atomic::wait)
+ * hasta la siguiente invalidación recibida por snoop y vuelve a comprobar.
+ * El epoch se lee ANTES de la comprobación: si la invalidación llega entre la
+ * lectura y el wait, el wait retorna de inmediato (no se pierde el aviso).
+ */
+void MESICache::waitEq(uint64_t addr, uint64_t val) {
+    metrics_.waits++;
+    for (;;) {
+        const uint32_t ep = inval_epoch_.load(std::memory_order_acquire);
+        uint64_t v = 0;
+        while (!load(addr, &v)) {}
+        metrics_.wait_checks++;
+        if (v == val) return;
+        metrics_.wait_sleeps++;
+        inval_epoch_.wait(ep, std::memory_order_acquire);
+    }
+}
+
+void MESICache::noteAccess(uint64_t addr, uint32_t s, bool write) {
+    metrics_.set_accesses[s]++;
+    if (fsd_) fsd_->onAccess(pe_id_, addr, write);
+}
+
+void MESICache::retireWay(uint32_t s, int w) {
+    if (meta_.tag[s][w] != kNoTag) miss_cls_.onEvict(lineBase(int(s), w), stamp_[s][w]);
+}
+
+MissKind MESICache::classifyMiss(uint64_t base) {
+    MissClassifier::Use resident[kSets * kWays];
+    int n = 0;
+    for (uint32_t s = 0; s < kSets; ++s)
+        for (int w = 0; w < kWays; ++w)
+            if (meta_.tag[s][w] != kNoTag) resident[n++] = {lineBase(int(s), w), stamp_[s][w]};
+    return miss_cls_.onMiss(base, resident, n);
+}
+
+void MESICache::breakReservation(uint64_t addr) {
+    if (resv_valid_ && resv_line_ == (addr & ~((uint64_t)kLineSize - 1))) {
+        resv_valid_ = false;
+        metrics_.resv_lost++;
+    }
+}
+
 /* onDataResponse(addr, lineData, shared)
  * --------------------------------------
  * El bus entrega datos tras BusRd/BusRdX. Si shared=true, instalamos en S;
  * si shared=false, en E. (La escritura local posterior podrá llevar E->M).
+ * Cada respuesta corresponde a un miss: aquí se clasifica (el bus está retenido).
  */
 void MESICache::onDataResponse(uint64_t addr, const uint8_t lineData[32], bool shared) {
+    switch (classifyMiss(addr & ~((uint64_t)kLineSize - 1))) {
+        case MissKind::Compulsory: metrics_.miss_compulsory++; break;
+        case MissKind::Capacity:   metrics_.miss_capacity++;   break;
+        case MissKind::Conflict:   metrics_.miss_conflict++;   break;
+        case MissKind::Coherence:  metrics_.miss_coherence++;  break;
+    }
     installLine(addr, lineData, shared ? MESI::S : MESI::E);
 }
 
@@ -265,57 +775,113 @@ void MESICache::onDataResponse(uint64_t addr, const uint8_t lineData[32], bool s
  * ----------
  * Reacción a tráfico de otros PEs sobre nuestra copia:
  * - BusRd   : si estoy en M => Flush y M->S; si en E => E->S.
- * - BusRdX/Inv/BusUpgr: si estoy en M => Flush; si S/E/M => invalidar -> I.
+ * - BusRdX/Inv/BusUpgr/BusWr: si estoy en M => Flush; si S/E/M => invalidar -> I.
+ * - BusWrLine: invalidar sin Flush (la línea entera se sobrescribe).
  * Se cuentan invalidaciones y transiciones.
  */
 void MESICache::onSnoop(const BusTransaction& t) {
-    uint32_t s = idx(t.addr);
-    uint64_t ttag = tag(t.addr);
-    for (int w = 0; w < kWays; ++w) {
-        auto& L = sets_[s].way[w];
-        if (!(L.valid && L.tag == ttag)) continue;
-
-        switch (t.type) {
-            case BusMsg::BusRd:
-                // Otro PE lee: si soy dueño sucio (M), debo proveer datos y degradar a S
-                if (L.state == MESI::M) {
-                    emitFlush(t.addr, L.data.data());
-                    recordTrans(MESI::M, MESI::S);
-                    L.state = MESI::S; L.dirty = false;
-                } else if (L.state == MESI::E) {
-                    // Exclusivo limpio -> compartido
-                    recordTrans(MESI::E, MESI::S);
-                    L.state = MESI::S;
-                }
-                break;
-            case BusMsg::BusRdX:
-            case BusMsg::Inv:
-            case BusMsg::BusUpgr:
-                // Otro PE quiere exclusividad: si estoy en M, write-back; luego invalidar
-                if (L.state == MESI::M) emitFlush(t.addr, L.data.data());
-                if (L.state != MESI::I) {
-                    metrics_.invalidations++;
-                    recordTrans(L.state, MESI::I);
-                    L.state = MESI::I;
-                    L.dirty = false;
-                }
-                break;
-            default:
-                break;
+    // Vías con el tag (también en I: un BusRdX sobre ellas aún rompe la reserva).
+    // Los tags no cambian con el bus retenido: sin coincidencia no hay nada que
+    // tocar y el set ni se bloquea.
+    const uint32_t ways = tagWays(t.addr);
+    if (!ways) return;
+    // BusRd sobre copias en S/I no cambia nada, y el dueño no puede llevarlas a
+    // M/E sin el bus: tampoco hace falta el seqlock (lectura compartida común)
+    if (t.type == BusMsg::BusRd) {
+        bool owned = false;
+        for (uint32_t m = ways; m; m &= m - 1) {
+            const int w = std::countr_zero(m);
+            const MESI st = stateOf(setOf(t.addr, w), w);
+            owned |= st == MESI::M || st == MESI::E;
         }
+        if (!owned) return;
     }
+    // El Flush de una copia en M sale después de soltar el seqlock: con la vía
+    // ya en S/I el dueño no puede escribirla sin el bus (retenido aquí), así que
+    // la copia tomada con el set bloqueado es la versión final. Emitirlo con el
+    // set tomado haría que el Stepper (snapshotLines) esperara a este mismo hilo.
+    // Igual el log legible de las transiciones (ver countTrans).
+    std::array<uint8_t, kLineSize> wb;
+    bool flush = false;
+    std::array<std::pair<MESI, MESI>, kWays> trans;
+    int ntrans = 0;
+    {
+        SetGuard g(*this, setsOf(t.addr));
+        for (uint32_t m = ways; m; m &= m - 1) {
+            const int w = std::countr_zero(m);
+            const uint32_t s = setOf(t.addr, w);
+            const MESI st = meta_.state[s][w];
+
+            switch (t.type) {
+                case BusMsg::BusRd:
+                    // Otro PE lee: si soy dueño sucio (M), debo proveer datos y degradar a S
+                    if (st == MESI::M) {
+                        wb = data_[s][w];
+                        flush = true;
+                        countTrans(MESI::M, MESI::S);
+                        trans[ntrans++] = {MESI::M, MESI::S};
+                        setState(s, w, MESI::S);
+                        meta_.dirty[s][w] = false;
+                    } else if (st == MESI::E) {
+                        // Exclusivo limpio -> compartido
+                        countTrans(MESI::E, MESI::S);
+                        trans[ntrans++] = {MESI::E, MESI::S};
+                        setState(s, w, MESI::S);
+                    }
+                    break;
+                case BusMsg::BusRdX:
+                case BusMsg::Inv:
+                case BusMsg::BusUpgr:
+                case BusMsg::BusWr:
+                case BusMsg::BusWrLine:
+                    // Otro PE quiere exclusividad: se pierde cualquier reserva LL sobre la línea
+                    breakReservation(t.addr);
+                    // Si estoy en M, write-back (salvo que la línea entera se sobrescriba); luego invalidar
+                    if (st == MESI::M && t.type != BusMsg::BusWrLine) { wb = data_[s][w]; flush = true; }
+                    if (st != MESI::I) {
+                        metrics_.invalidations++;
+                        countTrans(st, MESI::I);
+                        trans[ntrans++] = {st, MESI::I};
+                        setState(s, w, MESI::I);
+                        meta_.dirty[s][w] = false;
+                        // Modo análisis: ¿la víctima usaba la palabra que se va a escribir?
+                        // BusWrLine escribe la línea entera; DMA y snoops remotos
+                        // (src_pe -1) traen la base y las palabras escritas en 'words'
+                        if (fsd_) {
+                            if (t.type == BusMsg::BusWrLine)
+                                fsd_->onInvalidateLine(pe_id_, t.src_pe, t.addr);
+                            else if (t.words)
+                                fsd_->onInvalidateWords(pe_id_, t.src_pe, t.addr, t.words);
+                            else
+                                fsd_->onInvalidate(pe_id_, t.src_pe, t.addr);
+                        }
+                        miss_cls_.onInvalidate(t.addr & ~((uint64_t)kLineSize - 1));
+                        // Despierta a un posible waitEq() del PE dueño
+                        inval_epoch_.fetch_add(1, std::memory_order_release);
+                        inval_epoch_.notify_all();
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    for (int i = 0; i < ntrans; ++i) logTrans(trans[i].first, trans[i].second);
+    if (flush) emitFlush(t.addr, wb.data());
 }
 
 /* dumpCacheState(os)
  * ------------------
  * Utilidad de depuración: imprime set/vía con estado MESI, tag y dirty.
+ * Con los PEs detenidos, o desde un hilo que retiene el bus (snapshotLines).
  */
 void MESICache::dumpCacheState(std::ostream& os) const {
     os << "=== Estado Cache PE" << pe_id_ << " ===\n";
+    const LineSnapshot snap = snapshotLines();   // el stepper la imprime con los PEs corriendo
     for (size_t s = 0; s < kSets; ++s) {
         os << "Set " << s << ":\n";
         for (int w = 0; w < kWays; ++w) {
-            const auto& L = sets_[s].way[w];
+            const CacheLine& L = snap.line[s][w];
             os << "  Way " << w << ": ";
             if (!L.valid) { os << "Invalid\n"; continue; }
 
@@ -333,3 +899,182 @@ void MESICache::dumpCacheState(std::ostream& os) const {
     }
 }
 
+
+// Contadores escalares de CacheMetrics en orden fijo (el mismo para save y load)
+using MetricCounter = MESICache::Counter MESICache::CacheMetrics::*;
+static constexpr MetricCounter kMetricCounters[] = {
+    &MESICache::CacheMetrics::cache_misses,    &MESICache::CacheMetrics::miss_compulsory,
+    &MESICache::CacheMetrics::miss_capacity,   &MESICache::CacheMetrics::miss_conflict,
+    &MESICache::CacheMetrics::miss_coherence,  &MESICache::CacheMetrics::invalidations,
+    &MESICache::CacheMetrics::loads,           &MESICache::CacheMetrics::stores,
+    &MESICache::CacheMetrics::rw_accesses,     &MESICache::CacheMetrics::busRd,
+    &MESICache::CacheMetrics::busRdX,          &MESICache::CacheMetrics::busUpgr,
+    &MESICache::CacheMetrics::flush,           &MESICache::CacheMetrics::atomics,
+    &MESICache::CacheMetrics::cas_failures,    &MESICache::CacheMetrics::sc_failures,
+    &MESICache::CacheMetrics::resv_lost,       &MESICache::CacheMetrics::atomic_bus_ops,
+    &MESICache::CacheMetrics::waits,           &MESICache::CacheMetrics::wait_checks,
+    &MESICache::CacheMetrics::wait_sleeps,     &MESICache::CacheMetrics::bus_writes,
+    &MESICache::CacheMetrics::write_arounds,   &MESICache::CacheMetrics::nt_stores,
+    &MESICache::CacheMetrics::nt_lines,        &MESICache::CacheMetrics::nt_partial,
+};
+
+/* save(w) / load(r)
+ * -----------------
+ * Estado arquitectónico (vías + LRU + reserva) y de medición (métricas, sombra
+ * del clasificador). load() exige el mismo id de PE que el checkpoint.
+ */
+void MESICache::save(CheckpointWriter& w) const {
+    w.pod(int32_t(pe_id_));
+    w.pod(index_fn_);
+    w.pod(write_policy_);
+    w.pod(uint32_t(write_regions_.size()));
+    for (const WriteRegion& wr : write_regions_) {
+        w.pod(wr.base);
+        w.pod(wr.len);
+        w.pod(wr.policy);
+    }
+    for (int s = 0; s < kSets; ++s) {
+        for (int way = 0; way < kWays; ++way) {
+            const CacheLine L = lineAt(s, way);
+            w.pod(uint8_t(L.valid));
+            w.pod(uint8_t(L.dirty));
+            w.pod(L.state);
+            w.pod(L.tag);
+            w.put(L.data.data(), kLineSize);
+        }
+        w.pod(meta_.lru[s]);
+    }
+    for (const auto& row : stamp_)
+        for (uint64_t st : row) w.pod(st);
+    w.pod(use_clock_);
+    w.pod(resv_line_);
+    w.pod(uint8_t(resv_valid_));
+
+    for (MetricCounter c : kMetricCounters) w.pod(int32_t((metrics_.*c).load()));
+    for (int s = 0; s < kSets; ++s) {
+        w.pod(int32_t(metrics_.set_accesses[s].load()));
+        w.pod(int32_t(metrics_.set_misses[s].load()));
+    }
+    w.pod(metrics_.atomic_bus_ns.load());
+    for (const auto& row : metrics_.mesi_trans)
+        for (const auto& t : row) w.pod(int32_t(t.load()));
+
+    miss_cls_.save(w);
+}
+
+bool MESICache::load(CheckpointReader& r) {
+    int32_t id = -1;
+    if (!r.pod(id)) return false;
+    if (id != pe_id_) return r.fail("id de L1$ distinto al del checkpoint");
+    if (!r.pod(index_fn_)) return false;
+    if (index_fn_ > IndexFn::Skewed) return r.fail("función de índice desconocida");
+    uint32_t regions = 0;
+    if (!r.pod(write_policy_) || !r.pod(regions)) return false;
+    if (write_policy_ > WritePolicy::WriteThroughNoAlloc) return r.fail("política de escritura desconocida");
+    static constexpr size_t kRegionBytes = 2 * sizeof(uint64_t) + sizeof(WritePolicy);
+    if (regions > r.remaining() / kRegionBytes) return r.fail("regiones de escritura más que el archivo");
+    write_regions_.resize(regions);
+    for (WriteRegion& wr : write_regions_) {
+        if (!r.pod(wr.base) || !r.pod(wr.len) || !r.pod(wr.policy)) return false;
+        if (wr.policy > WritePolicy::WriteThroughNoAlloc) return r.fail("política de escritura desconocida");
+    }
+
+    for (int s = 0; s < kSets; ++s) {
+        for (int way = 0; way < kWays; ++way) {
+            uint8_t valid = 0, dirty = 0;
+            MESI st = MESI::I;
+            uint64_t t = 0;
+            if (!r.pod(valid) || !r.pod(dirty) || !r.pod(st) || !r.pod(t) ||
+                !r.get(data_[s][way].data(), kLineSize)) return false;
+            if (uint8_t(st) > uint8_t(MESI::M)) return r.fail("estado MESI fuera de rango");
+            if (!valid && st != MESI::I) return r.fail("vía no válida con estado MESI");
+            meta_.tag[s][way]   = valid ? t : kNoTag;
+            meta_.dirty[s][way] = dirty != 0;
+            setState(s, way, st);
+        }
+        if (!r.pod(meta_.lru[s])) return false;
+    }
+    for (auto& row : stamp_)
+        for (uint64_t& st : row)
+            if (!r.pod(st)) return false;
+    if (!r.pod(use_clock_)) return false;
+    uint8_t rv = 0;
+    if (!r.pod(resv_line_) || !r.pod(rv)) return false;
+    resv_valid_ = rv != 0;
+
+    int32_t v = 0;
+    for (MetricCounter c : kMetricCounters) {
+        if (!r.pod(v)) return false;
+        metrics_.*c = v;
+    }
+    for (int s = 0; s < kSets; ++s) {
+        if (!r.pod(v)) return false;
+        metrics_.set_accesses[s] = v;
+        if (!r.pod(v)) return false;
+        metrics_.set_misses[s] = v;
+    }
+    uint64_t ns = 0;
+    if (!r.pod(ns)) return false;
+    metrics_.atomic_bus_ns = ns;
+    for (auto& row : metrics_.mesi_trans)
+        for (auto& t : row) {
+            if (!r.pod(v)) return false;
+            t = v;
+        }
+    metrics_.mesi_transitions.clear();
+
+    return miss_cls_.load(r);
+}
+
+void MESICache::copyStateFrom(const MESICache& o) {
+    index_fn_ = o.index_fn_;
+    write_policy_ = o.write_policy_;
+    write_regions_ = o.write_regions_;
+    meta_ = o.meta_;
+    std::memcpy(data_, o.data_, sizeof data_);
+    std::memcpy(stamp_, o.stamp_, sizeof stamp_);
+    use_clock_ = o.use_clock_;
+    resv_line_  = o.resv_line_;
+    resv_valid_ = o.resv_valid_;
+    for (MetricCounter c : kMetricCounters) metrics_.*c = o.metrics_.*c;
+    for (int s = 0; s < kSets; ++s) {
+        metrics_.set_accesses[s] = o.metrics_.set_accesses[s];
+        metrics_.set_misses[s]   = o.metrics_.set_misses[s];
+    }
+    metrics_.atomic_bus_ns = o.metrics_.atomic_bus_ns;
+    for (int f = 0; f < 4; ++f)
+        for (int t = 0; t < 4; ++t) metrics_.mesi_trans[f][t] = o.metrics_.mesi_trans[f][t];
+    metrics_.mesi_transitions.clear();
+    miss_cls_ = o.miss_cls_;
+}
+
+/* drainLines(writeback) / warmLine(addr, data, st)
+ * -----------------------------------------------
+ * Cambio de modo de la simulación muestreada. No pasan por el bus ni tocan
+ * métricas ni la matriz de transiciones: no son accesos del programa.
+ */
+void MESICache::drainLines(const std::function<void(uint64_t, const uint8_t*)>& writeback) {
+    SetGuard g(*this, kAllSets);
+    for (uint32_t s = 0; s < kSets; ++s)
+        for (int w = 0; w < kWays; ++w) {
+            if (meta_.state[s][w] == MESI::M) writeback(lineBase(int(s), w), data_[s][w].data());
+            retireWay(s, w);
+        }
+    meta_ = initialMeta();
+    std::memset(data_, 0, sizeof data_);
+    resv_valid_ = false;
+}
+
+void MESICache::warmLine(uint64_t addr, const uint8_t data[32], MESI st) {
+    SetGuard g(*this, kAllSets);
+    uint32_t s;
+    const int way = chooseWay(addr, &s);
+    retireWay(s, way);
+
+    meta_.tag[s][way]   = tagOf(addr);
+    meta_.dirty[s][way] = (st == MESI::M);
+    setState(s, way, st);
+    std::memcpy(data_[s][way].data(), data, kLineSize);
+    touchLRU(s, way);
+    miss_cls_.onWarm(addr & ~uint64_t(kLineSize - 1));
+}
@@ -1,12 +1,25 @@
 #pragma once
 #include "MesiTypes.hpp"
+#include "TagMatch.hpp"
+#include "IndexFn.hpp"
+#include "WritePolicy.hpp"
+#include "../../../analysis/MissClassifier.hpp"
+#include "../../../utils/RelaxedCounter.hpp"
+#include "../../../utils/LatencyHistogram.hpp"
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <functional>
+#include <mutex>
 #include <optional>
 #include <ostream>
 #include <vector>
 #include <sstream>
 
 class MesiInterconnect; 
+class FalseSharingDetector;
+class CheckpointWriter;
+class CheckpointReader;
 
 /*
  * MESICache (header)
@@ -19,7 +32,12 @@ class MesiInterconnect;
  * - Tamaño de línea: 32 bytes (offset=5 bits)
  *
  * Política:
- * - write-allocate + write-back
+ * - write-allocate + write-back por defecto; write-through y/o no-allocate por
+ *   L1$ o por región de direcciones (ver WritePolicy.hpp)
+ * - stores no temporales: líneas completas sin read-for-ownership vía buffers
+ *   de write-combining (storeNonTemporal/fence)
+ * - índice de set configurable (setIndexFunction, ver IndexFn.hpp): corte de
+ *   bits por defecto, XOR-folding, primo o asociativa sesgada
  *
  * Interacción con el bus:
  * - Emite BusRd/BusRdX/BusUpgr/Flush según necesidad
@@ -29,15 +47,43 @@ class MesiInterconnect;
  * API de acceso:
  * - load/store de 8B: devuelven true si hit y se completó; false si se emitió una
  *   operación al bus (el puerto debe reintentar cuando llegue Data).
+ * - atomicRMW (CAS / fetch-add) y loadLinked/storeConditional: obtienen la línea
+ *   en M reteniendo el bus, de modo que ningún snoop intercala entre la lectura y
+ *   la escritura. Siempre completan (no requieren reintento del puerto).
+ *
+ * Organización interna:
+ * - Tag y estado de cada vía viven en arreglos densos por set (TagStore), aparte
+ *   de los datos: una búsqueda solo lee los kWays tags contiguos del set (un tag
+ *   match SIMD, ver TagMatch.hpp) y no arrastra las líneas de datos a la caché
+ *   del host. Cada instancia queda alineada a 64 B, así que las L1$ de PEs que
+ *   corren en hilos distintos no comparten líneas de la caché del host.
+ *
+ * Hilos:
+ * - La L1$ la usan el hilo del PE dueño (load/store) y, dentro de
+ *   MesiInterconnect::emit, los hilos de los demás PEs (onSnoop, hasLine).
+ * - Cada set tiene un seqlock (contador par = libre, impar = un escritor
+ *   modificándolo). Los hits de load no escriben nada compartido: leen el
+ *   contador, el tag y la máscara 'live', copian el dato y vuelven a leer el
+ *   contador; si cambió (un snoop tocó el set en el medio) reintentan. Corren
+ *   sin locks y en paralelo con snoops a otros sets.
+ * - Escriben el set con su seqlock tomado los snoops y los hits de store en
+ *   M/E (camino rápido, sin bus); un BusRd sobre copias en S/I no cambia nada y
+ *   no lo toma. El resto de los stores (S->M, write-through, miss) y
+ *   acquireOwnership modifican el set solo con el bus retenido: ningún snoop
+ *   corre mientras tanto y los hits de load son del mismo hilo dueño. Los tags
+ *   y los datos solo los escribe el dueño, y las instalaciones/desalojos
+ *   retienen el bus, así que ningún snoop los ve a medias. Orden de locks:
+ *   bus -> seqlocks de los sets (en orden).
  *
  * Métricas:
  * - loads, stores, rw_accesses, cache_misses, invalidations, busRd/RdX/Upgr/Flush,
+ * - misses clasificados compulsory/capacity/conflict/coherence (MissClassifier),
  *   matriz de transiciones MESI y log legible de transiciones (para CSV/gráficas).
  */
 class MESICache {
 public:
-    // Resultado de una búsqueda: ¿hubo hit?, ¿en qué vía?, puntero a la línea.
-    struct Lookup { bool hit; int way; CacheLine* line; };
+    // Resultado de una búsqueda: ¿hubo hit? y ¿en qué vía? (set: setIndex(.., way))
+    struct Lookup { bool hit; int way; };
 
     // Parámetros fijos (especificación): 16 líneas totales, 2-way, línea de 32B
     static constexpr int kSets = 8;
@@ -55,6 +101,46 @@ public:
     bool load(uint64_t addr, void* out8);
     bool store(uint64_t addr, const void* in8);
 
+    // Store no temporal de 8 bytes alineado. Si la L1$ tiene la línea es un
+    // store normal; si no, se junta en un buffer de write-combining (kWcBuffers
+    // líneas) que sale al bus como BusWrLine al completarse la línea (sin
+    // read-for-ownership ni instalarla) o como un BusWr por palabra si hay que
+    // vaciarlo incompleto. Siempre completa. Orden débil: los demás PEs no ven
+    // esos datos hasta que el buffer se vacía; fence() los vacía todos y un
+    // acceso propio a la línea vacía el suyo.
+    bool storeNonTemporal(uint64_t addr, const void* in8);
+    void fence();
+
+    // Política de escritura de la L1$ y excepciones por región [base, base+len)
+    // (la última región agregada que contiene la dirección gana). Antes de
+    // arrancar el PE; los forks las copian.
+    void setWritePolicy(WritePolicy p) { write_policy_ = p; }
+    WritePolicy writePolicy() const { return write_policy_; }
+    void addWriteRegion(uint64_t base, uint64_t len, WritePolicy p) {
+        write_regions_.push_back({base, len, p});
+    }
+    WritePolicy writePolicyFor(uint64_t addr) const {
+        for (auto it = write_regions_.rbegin(); it != write_regions_.rend(); ++it)
+            if (addr - it->base < it->len) return it->policy;
+        return write_policy_;
+    }
+
+    // Atómicos read-modify-write de 8 bytes. Devuelven el valor previo.
+    // En CAS, *ok (si no es null) indica si se escribió 'operand'.
+    enum class AtomicOp : uint8_t { CAS, FetchAdd, FetchFAdd };
+    uint64_t atomicRMW(uint64_t addr, AtomicOp op, uint64_t operand,
+                       uint64_t expected = 0, bool* ok = nullptr);
+
+    // LL/SC: la reserva se pierde si otro PE pide exclusividad de la línea
+    // (BusRdX/BusUpgr/Inv) o si la línea es desalojada.
+    uint64_t loadLinked(uint64_t addr);
+    bool     storeConditional(uint64_t addr, uint64_t val);
+
+    // Espera coherente: bloquea el hilo hasta que [addr] == val. Entre
+    // comprobaciones duerme hasta que un snoop invalide alguna línea de esta L1$
+    // (una copia válida no puede cambiar de valor sin ser invalidada antes).
+    void waitEq(uint64_t addr, uint64_t val);
+
     // Búsqueda por (set,tag). Útil para depuración o comprobaciones locales.
     Lookup lookupLine(uint64_t addr);
 
@@ -72,28 +158,120 @@ public:
     // Dump amigable del estado de la caché (sets, ways, MESI, tag, dirty)
     void dumpCacheState(std::ostream& os) const;
 
+    // Copia de una vía (sin locks: solo con la L1$ detenida o desde su hilo dueño)
+    CacheLine lineAt(int set, int way) const;
+    // Copia consistente de todas las vías y sus direcciones base, tomada con los
+    // seqlocks de todos los sets: se puede llamar con el PE corriendo (stores
+    // hit concurrentes) desde un hilo que retiene el bus (Stepper)
+    struct LineSnapshot {
+        CacheLine line[kSets][kWays];
+        uint64_t  base[kSets][kWays];
+    };
+    LineSnapshot snapshotLines() const;
+    // Dirección base de la línea guardada en (set, way) (válida si lineAt().valid)
+    uint64_t lineBase(int set, int way) const;
+    // Base a partir de (tag, set) con el índice por corte de bits (IndexFn::Bits)
+    static uint64_t lineAddress(uint64_t tag, uint32_t set) {
+        return ((tag << kIndexBits) | set) << kOffsetBits;
+    }
+
+    // Función de índice de set. Solo se puede cambiar con la L1$ vacía (recién
+    // creada o tras drainLines); los forks y checkpoints la conservan.
+    void    setIndexFunction(IndexFn f);
+    IndexFn indexFunction() const { return index_fn_; }
+    // Set que ocupa 'addr' en la vía 'way' con la función 'f'
+    static uint32_t setIndex(IndexFn f, uint64_t addr, int way = 0) {
+        return index_fn::set_of<kIndexBits>(f, addr >> kOffsetBits, way);
+    }
+
     // Métricas y depuración (se imprimen/guardan en CSV o consola)
+    // Contadores legibles en vivo desde otro hilo (ver utils/RelaxedCounter.hpp)
+    using Counter      = RelaxedCounter<int>;
+    using Counter64    = RelaxedCounter<uint64_t>;
+    using TransCounter = RelaxedCounter<int, true>;   // lo tocan dueño (hit) y snoop
+
+    // Transacciones propias con histograma de latencia (índice de lat_cycles/lat_ns)
+    enum LatKind : int { LatBusRd, LatBusRdX, LatBusUpgr, LatFlush, kLatKinds };
+    static const char* latKindName(int k) {
+        static const char* kNames[kLatKinds] = {"BusRd", "BusRdX", "BusUpgr", "Flush"};
+        return (k >= 0 && k < kLatKinds) ? kNames[k] : "?";
+    }
+
     struct CacheMetrics {
-        int cache_misses = 0;     // misses totales (load+store)
-        int invalidations = 0;    // veces que esta L1$ invalida por snoop/upgrade ajeno
-        int loads = 0;            // lecturas locales (intentos)
-        int stores = 0;           // escrituras locales (intentos)
-        int rw_accesses = 0;      // loads + stores
-        int busRd = 0;            // emisiones de BusRd (lectura al bus)
-        int busRdX = 0;           // emisiones de BusRdX (lectura con exclusividad)
-        int busUpgr = 0;          // emisiones de BusUpgr (upgrade S->M)
-        int flush = 0;            // emisiones de Flush (write-back de línea M)
-        int mesi_trans[4][4] = {{0}};          // matriz de transición MESI (conteo from->to)
+        Counter cache_misses;     // misses totales (load+store)
+        Counter miss_compulsory;  //   primera referencia a la línea
+        Counter miss_capacity;    //   tampoco cabría en una FA-LRU de 16 líneas
+        Counter miss_conflict;    //   la FA-LRU sí la tenía (choque de set)
+        Counter miss_coherence;   //   invalidada por snoop ajeno
+        Counter invalidations;    // veces que esta L1$ invalida por snoop/upgrade ajeno
+        Counter loads;            // lecturas locales (intentos)
+        Counter stores;           // escrituras locales (intentos)
+        Counter rw_accesses;      // loads + stores
+        Counter busRd;            // emisiones de BusRd (lectura al bus)
+        Counter busRdX;           // emisiones de BusRdX (lectura con exclusividad)
+        Counter busUpgr;          // emisiones de BusUpgr (upgrade S->M)
+        Counter flush;            // emisiones de Flush (write-back de línea M)
+        Counter atomics;          // operaciones atómicas (CAS/fetch-add/LL/SC)
+        Counter cas_failures;     // CAS cuyo valor esperado no coincidió
+        Counter sc_failures;      // SC fallidos (reserva perdida)
+        Counter resv_lost;        // reservas LL rotas por snoop/evicción
+        Counter atomic_bus_ops;   // BusRdX/BusUpgr emitidos para obtener M en un atómico
+        Counter64 atomic_bus_ns;  // tiempo (host) obteniendo propiedad: costo del ping-pong
+        Counter waits;            // instrucciones WAIT/BARRIER que esperaron en esta L1$
+        Counter wait_checks;      // lecturas de comprobación durante esperas
+        Counter wait_sleeps;      // veces que el hilo durmió hasta una invalidación
+        Counter bus_writes;       // BusWr emitidos (write-through, write-around, WC parcial)
+        Counter write_arounds;    // store misses sin asignar línea (no cuentan en cache_misses)
+        Counter nt_stores;        // stores no temporales
+        Counter nt_lines;         //   líneas completas escritas con BusWrLine (sin RFO)
+        Counter nt_partial;       //   buffers WC vaciados incompletos (BusWr por palabra)
+        Counter set_accesses[kSets];  // accesos completados por set (desbalance de sets)
+        Counter set_misses[kSets];    //   y líneas traídas a cada set (misses servidos)
+        TransCounter mesi_trans[4][4];             // matriz de transición MESI (conteo from->to)
         std::vector<std::string> mesi_transitions; // historial legible ("MESI: 1->3")
+        // Latencia de extremo a extremo de cada transacción emitida (emit* ->
+        // datos instalados): ciclos del modelo de tiempo que devuelve el bus y ns
+        // del host. No van al checkpoint ni al fork (son de esta corrida).
+        LatencyHistogram lat_cycles[kLatKinds];
+        LatencyHistogram lat_ns[kLatKinds];
     };
 
     // Lectura inmutable de métricas (para informes/CSV)
     const CacheMetrics& stats() const { return metrics_; }
 
+    // Identificador del PE dueño de esta L1$
+    int id() const { return pe_id_; }
+
+    // Checkpoint (ver checkpoint/Checkpoint.hpp): función de índice, vías con
+    // estado/tag/datos, LRU, reserva LL/SC, contadores (también por set) y sombra
+    // del clasificador. No guarda el log textual.
+    void save(CheckpointWriter& w) const;
+    bool load(CheckpointReader& r);
+
+    // Fork en memoria: copia el mismo estado que save/load desde otra L1$ (de otro
+    // bus) sin pasar por disco. Ambas deben estar detenidas.
+    void copyStateFrom(const MESICache& o);
+
+    // Simulación muestreada (ver sampling/Sampler.hpp), sin bus ni métricas y con
+    // los PEs detenidos:
+    // - drainLines: entrega cada línea en M a writeback(base, datos) e invalida todo
+    //   (la memoria pasa a ser la única copia durante el avance funcional).
+    // - warmLine: instala una línea con estado 'st' sin emitir nada (calentamiento
+    //   funcional). Llamar de LRU a MRU por set sobre una L1$ vaciada.
+    void drainLines(const std::function<void(uint64_t, const uint8_t*)>& writeback);
+    void warmLine(uint64_t addr, const uint8_t data[32], MESI st);
+
+    // Análisis de false sharing (nullptr = desactivado); ver analysis/FalseSharingDetector.hpp
+    void setFalseSharingDetector(FalseSharingDetector* d) { fsd_ = d; }
+
     // Impresión directa de estadísticas (útil para depurar rápidamente)
     void dumpStats(std::ostream& os) const {
         os << "\n=== Estadísticas Cache PE" << pe_id_ << " ===\n";
-        os << "Cache misses: " << metrics_.cache_misses << "\n";
+        os << "Cache misses: " << metrics_.cache_misses
+           << " (compulsory " << metrics_.miss_compulsory
+           << ", capacity " << metrics_.miss_capacity
+           << ", conflict " << metrics_.miss_conflict
+           << ", coherence " << metrics_.miss_coherence << ")\n";
         os << "Invalidaciones: " << metrics_.invalidations << "\n";
         os << "Loads: " << metrics_.loads << "\n";
         os << "Stores: " << metrics_.stores << "\n";
@@ -102,6 +280,11 @@ public:
            << ", BusRdX: " << metrics_.busRdX
            << ", BusUpgr: " << metrics_.busUpgr
            << ", Flush: " << metrics_.flush << "\n";
+        if (metrics_.atomics)
+            os << "Atomicos: " << metrics_.atomics
+               << " (CAS fallidos: " << metrics_.cas_failures
+               << ", SC fallidos: " << metrics_.sc_failures
+               << ", bus para propiedad: " << metrics_.atomic_bus_ops << ")\n";
         os << "Transiciones MESI:\n";
         for (const auto& t : metrics_.mesi_transitions)
             os << "  " << t << "\n";
@@ -124,14 +307,135 @@ private:
     // Puntero al interconect (para emitir y recibir mensajes coherentes)
     MesiInterconnect* bus_ = nullptr;
 
-    // Arreglo de sets (cada set tiene 2 vías y un bit/índice LRU)
-    Set sets_[kSets]{};
+    // Metadatos de las vías, separados de los datos (ver "Organización interna").
+    // Una vía nunca llenada (o vaciada por drainLines) tiene tag kNoTag: los tags
+    // reales son addr >> 8 y nunca valen ~0. 'live' resume "válida y no I" por set
+    // para que el hit sea un AND con la máscara de tag_match.
+    static constexpr uint64_t kNoTag = ~uint64_t(0);
+    struct alignas(64) TagStore {
+        uint64_t tag[kSets][kWays];
+        MESI     state[kSets][kWays];
+        bool     dirty[kSets][kWays];
+        uint32_t live[kSets];   // bit w: vía w válida y en M/E/S
+        uint8_t  lru[kSets];    // vía víctima (2-way => basta con un índice)
+    };
+    TagStore meta_ = initialMeta();
+    alignas(64) std::array<uint8_t, kLineSize> data_[kSets][kWays]{};
+
+    // Función de índice y, para Skewed, último uso de cada vía (LRU entre los
+    // candidatos de distintos sets; con un único set basta meta_.lru)
+    IndexFn  index_fn_ = IndexFn::Bits;
+    uint64_t stamp_[kSets][kWays]{};
+    uint64_t use_clock_ = 0;
 
     // Contador de métricas
     CacheMetrics metrics_;
 
+    // Reserva de LL/SC (dirección base de línea); se manipula con el bus retenido
+    uint64_t resv_line_ = 0;
+    bool     resv_valid_ = false;
+
+    // Seqlock por set (ver "Hilos"): par = libre, impar = con escritor. Cada uno
+    // en su línea del host para que un snoop a un set no invalide el contador
+    // que lee el dueño en otro.
+    struct alignas(64) SetSeq { std::atomic<uint32_t> v{0}; };
+    mutable SetSeq seq_[kSets];
+
+    // Sets en los que puede estar 'addr' (uno sin sesgo; uno por vía con sesgo)
+    uint32_t setsOf(uint64_t addr) const;
+    // Lectura optimista: espera a que los sets estén libres y devuelve la suma
+    // de sus contadores; readRetry() dice si algún escritor pasó desde entonces
+    // (los contadores solo crecen, así que basta comparar la suma).
+    uint32_t readBegin(uint32_t sets) const;
+    bool readRetry(uint32_t sets, uint32_t snap) const;
+    // Escritura: toma los seqlocks de 'sets' en orden creciente de set (const:
+    // snapshotLines también excluye a los escritores)
+    void lockSets(uint32_t sets) const;
+    void unlockSets(uint32_t sets) const;
+    class SetGuard {
+    public:
+        SetGuard(MESICache& c, uint32_t sets) : c_(c), sets_(sets) { c_.lockSets(sets_); }
+        ~SetGuard() { c_.unlockSets(sets_); }
+        SetGuard(const SetGuard&) = delete;
+        SetGuard& operator=(const SetGuard&) = delete;
+    private:
+        MESICache& c_;
+        uint32_t sets_;
+    };
+    static constexpr uint32_t kAllSets = (1u << kSets) - 1;
+
+    // El historial legible de transiciones lo agregan el dueño y los snoops
+    // (nunca con el seqlock de un set tomado, ver countTrans/logTrans)
+    std::mutex trans_log_mtx_;
+
+    // Se incrementa (y despierta a waitEq) con cada invalidación por snoop
+    std::atomic<uint32_t> inval_epoch_{0};
+
+    // Detector de false sharing (opcional)
+    FalseSharingDetector* fsd_ = nullptr;
+
+    // Política de escritura y regiones con otra política
+    struct WriteRegion { uint64_t base, len; WritePolicy policy; };
+    WritePolicy write_policy_ = WritePolicy::WriteBack;
+    std::vector<WriteRegion> write_regions_;
+
+    // Buffers de write-combining de los stores no temporales. Solo los toca el
+    // hilo dueño; no van al checkpoint (se vacían con fence()).
+    static constexpr int kWcBuffers = 4;
+    static constexpr uint8_t kWcFull = (1u << (kLineSize / 8)) - 1;   // una marca por palabra
+    struct WcBuffer {
+        uint64_t base = 0, stamp = 0;
+        uint8_t  mask = 0;                     // palabras escritas (0 = libre)
+        std::array<uint8_t, kLineSize> data{};
+    };
+    WcBuffer wc_[kWcBuffers];
+    int      wc_live_ = 0;
+    uint64_t wc_clock_ = 0;
+    void drainWc(WcBuffer& w);
+    void drainWcLine(uint64_t addr);
+
+    // Clasificador de misses (sombra FA-LRU de igual capacidad + first-touch)
+    MissClassifier miss_cls_{kSets * kWays};
+
+    // Reporta un acceso completado en el set 's' (detector de false sharing y
+    // conteo por set; la sombra del clasificador usa las estampas de touchLRU)
+    void noteAccess(uint64_t addr, uint32_t s, bool write);
+    // La vía (s, w) va a perder su tag: su último uso pasa a la sombra
+    void retireWay(uint32_t s, int w);
+    // Clase del miss sobre la línea 'base' (bus retenido)
+    MissKind classifyMiss(uint64_t base);
+
+    static TagStore initialMeta();
+
+    // Set de 'addr' en la vía 'way' y tag a guardar (ver IndexFn.hpp)
+    uint32_t setOf(uint64_t addr, int way = 0) const {
+        if (index_fn_ == IndexFn::Bits) return uint32_t(addr >> kOffsetBits) & (kSets - 1);
+        return setIndex(index_fn_, addr, way);
+    }
+    uint64_t tagOf(uint64_t addr) const {
+        return index_fn_ == IndexFn::Bits ? tag(addr) : (addr >> kOffsetBits);
+    }
+
+    // Vías de 'addr' que tienen su tag (con o sin copia viva) / con copia viva.
+    // Sin sesgo todas las vías están en setOf(addr): un tag match SIMD; con sesgo
+    // cada vía w se mira en setOf(addr, w).
+    uint32_t tagWays(uint64_t addr) const;
+    uint32_t hitWays(uint64_t addr) const;
+
+    // Cambia el estado de una vía manteniendo la máscara 'live'
+    void setState(uint32_t s, int w, MESI st);
+    // Máscara 'live' del set: la lee el dueño sin lock mientras un snoop puede
+    // estar cambiándola (acquire: ver readRetry)
+    uint32_t liveOf(uint32_t s) const {
+        return std::atomic_ref<uint32_t>(const_cast<uint32_t&>(meta_.live[s])).load(std::memory_order_acquire);
+    }
+    // Estado de una vía leído sin el seqlock del set (un store del dueño puede
+    // estar pasándola de E a M)
+    MESI stateOf(uint32_t s, int w) const {
+        return std::atomic_ref<MESI>(const_cast<MESI&>(meta_.state[s][w])).load(std::memory_order_relaxed);
+    }
+
     // Helpers de direccionamiento para separar offset/index/tag
-    static uint32_t idx(uint64_t addr) { return (addr >> kOffsetBits) & ((1u<<kIndexBits)-1); }
     static uint64_t tag(uint64_t addr) { return addr >> (kOffsetBits + kIndexBits); }
     static uint32_t off(uint64_t addr) { return addr & (kLineSize-1); }
 
@@ -141,15 +445,31 @@ private:
     // Devuelve la vía víctima (LRU) del set 's'
     int  victimWay(uint32_t s) const;
 
-    // Registra transición de estado en matriz/log
-    void recordTrans(MESI from, MESI to);
+    // Vía (y set en *s) donde instalar 'addr': una libre o la víctima LRU
+    int  chooseWay(uint64_t addr, uint32_t* s) const;
+
+    // Registra transición de estado en matriz/log. Con el seqlock de un set
+    // tomado solo se cuenta (countTrans) y el log se agrega al soltarlo (logTrans):
+    // el log arma un string y toma trans_log_mtx_. La matriz es exacta; en el log,
+    // el E->M de un store y el snoop que lo sigue pueden quedar en cualquier orden.
+    void recordTrans(MESI from, MESI to) { countTrans(from, to); logTrans(from, to); }
+    void countTrans(MESI from, MESI to) { metrics_.mesi_trans[(int)from][(int)to]++; }
+    void logTrans(MESI from, MESI to);
 
     // Instalar o reemplazar línea (si víctima en M => Flush antes de sobrescribir)
     void installLine(uint64_t addr, const uint8_t data[32], MESI st);
 
-    // helpers R/W de 8 bytes dentro de la línea (útil para double/uint64)
-    void write8(CacheLine& line, uint32_t line_off, const void* in8);
-    void read8(const CacheLine& line, uint32_t line_off, void* out8) const;
+    // Con el bus retenido: deja la línea de 'addr' en M (BusUpgr/BusRdX si hace falta)
+    Lookup acquireOwnership(uint64_t addr);
+
+    // Rompe la reserva LL si coincide con la línea de 'addr'
+    void breakReservation(uint64_t addr);
+
+    // helpers R/W de 8 bytes dentro de la línea (útil para double/uint64);
+    // writeClean8 no marca la línea sucia (write-through: la memoria ya la tiene)
+    void write8(uint32_t s, int w, uint32_t line_off, const void* in8);
+    void writeClean8(uint32_t s, int w, uint32_t line_off, const void* in8);
+    void read8(uint32_t s, int w, uint32_t line_off, void* out8) const;
 
     // Emisiones de bus (atajos encapsulados)
     void emitBusRd(uint64_t addr);
@@ -157,6 +477,9 @@ private:
     void emitBusUpgr(uint64_t addr);
     void emitFlush(uint64_t addr, const uint8_t data[32]);
     void emitInv(uint64_t addr); // opcional (si el bus lo requiere)
+    void emitBusWr(uint64_t addr, const void* in8);
+    void emitBusWrLine(uint64_t base, const uint8_t data[32]);
+    void timedEmit(LatKind k, const BusTransaction& t);
 };
 
 
@@ -13,17 +13,27 @@ enum class BusMsg : uint8_t {
   BusUpgr,   // upgrade S->M
   Data,      // datos de respuesta (32 B)
   Flush,     // write-back de una línea sucia
-  Inv        // invalidación a terceros
+  Inv,       // invalidación a terceros
+  BusWr,     // escritura de 8 B a memoria sin traer la línea (write-through/-around)
+  BusWrLine  // escritura de una línea completa sin read-for-ownership (store no temporal)
 };
 
 struct BusTransaction {
   BusMsg    type;
   uint64_t  addr;
-  const uint8_t* payload; // 32B si Data/Flush, null si no aplica
+  const uint8_t* payload; // 32B si Data/Flush/BusWrLine, 8B si BusWr, null si no aplica
   uint32_t  size;         // normalmente 32
   int       src_pe;       // PE emisor
+  uint8_t   words = 0;    // Inv sin PE emisor (DMA, otro cluster): palabras de 8 B que
+                          // se escriben (bit i = palabra i); 0 = la palabra de 'addr'
 };
 
+// Palabras de 8 B de la línea de 'addr' que cubre [addr, addr+n), n > 0
+inline uint8_t lineWordMask(uint64_t addr, uint64_t n) {
+  const uint64_t off = addr & 31, end = off + n < 32 ? off + n : 32;
+  return uint8_t(((1u << ((end + 7) >> 3)) - 1) & ~((1u << (off >> 3)) - 1));
+}
+
 // Métricas por PE (requeridas en la especificación)
 struct CacheMetrics {
   uint64_t loads=0, stores=0, misses=0, invalidations=0;
@@ -32,7 +42,8 @@ struct CacheMetrics {
   uint64_t rw_accesses=0; // registro total de accesos (R/W)
 };
 
-// Línea y set de la caché (2 vías)
+// Vista de una vía de la caché (MESICache::lineAt); internamente tag/estado y
+// datos se guardan por separado
 struct CacheLine {
   bool     valid=false;
   bool     dirty=false;
@@ -40,8 +51,3 @@ struct CacheLine {
   uint64_t tag=0;
   std::array<uint8_t,32> data{};
 };
-
-struct Set {
-  CacheLine way[2];
-  uint8_t   lru=0; // 0 -> way0 es LRU; 1 -> way1 es LRU
-};
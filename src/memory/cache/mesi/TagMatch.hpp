@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * TagMatch.hpp
+ * ============
+ * Comparación de un tag contra todas las vías de un set a la vez. Devuelve una
+ * máscara con el bit w encendido si tags[w] == t (sin ramas por vía).
+ *
+ * - AVX2 (-mavx2 / -march=native): 4 vías por instrucción (_mm256_cmpeq_epi64).
+ * - SSE2 (base de x86-64): 2 vías por instrucción; SSE2 no compara 64 bits, así
+ *   que se comparan mitades de 32 bits y se combinan con sus vecinas.
+ * - Resto (o vías sobrantes): bucle escalar que el compilador puede vectorizar.
+ *
+ * 'tags' son las N vías contiguas de un set (ver MESICache::TagStore).
+ */
+template <int N>
+inline uint32_t tag_match(const uint64_t* tags, uint64_t t) {
+    static_assert(N > 0 && N <= 32, "la máscara de vías es de 32 bits");
+    uint32_t m = 0;
+    int w = 0;
+#if defined(__AVX2__)
+    const __m256i k4 = _mm256_set1_epi64x(static_cast<long long>(t));
+    for (; w + 4 <= N; w += 4) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tags + w));
+        const __m256i e = _mm256_cmpeq_epi64(v, k4);
+        m |= uint32_t(_mm256_movemask_pd(_mm256_castsi256_pd(e))) << w;
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i k2 = _mm_set1_epi64x(static_cast<long long>(t));
+    for (; w + 2 <= N; w += 2) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags + w));
+        __m128i e = _mm_cmpeq_epi32(v, k2);
+        e = _mm_and_si128(e, _mm_shuffle_epi32(e, _MM_SHUFFLE(2, 3, 0, 1)));
+        m |= uint32_t(_mm_movemask_pd(_mm_castsi128_pd(e))) << w;
+    }
+#endif
+    for (; w < N; ++w) m |= uint32_t(tags[w] == t) << w;
+    return m;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/*
+ * WritePolicy.hpp
+ * ===============
+ * Políticas de escritura de la L1$ (MESICache::setWritePolicy y
+ * addWriteRegion: por L1$ y por rango de direcciones).
+ *
+ * - WriteBack         : write-allocate + write-back (por defecto). Un store que
+ *                       falla pide la línea con BusRdX (read-for-ownership) y la
+ *                       deja en M; la memoria se actualiza al desalojar (Flush).
+ * - WriteBackNoAlloc  : write-around. Los hits se comportan como WriteBack; un
+ *                       store que falla escribe sus 8 B en memoria con BusWr sin
+ *                       traer ni instalar la línea.
+ * - WriteThrough      : cada store escribe también en memoria (BusWr, invalida
+ *                       las demás copias); la línea nunca queda en M. Un miss
+ *                       trae la línea con BusRd y luego escribe a través.
+ * - WriteThroughNoAlloc: como WriteThrough, pero un miss solo emite BusWr.
+ *
+ * Las políticas conviven con MESI: BusWr invalida las copias ajenas (con Flush
+ * previo si alguna estaba en M), así que una L1$ write-back y otra
+ * write-through pueden compartir datos.
+ */
+enum class WritePolicy : uint8_t { WriteBack, WriteBackNoAlloc, WriteThrough, WriteThroughNoAlloc };
+
+namespace write_policy {
+
+inline bool through(WritePolicy p) {
+    return p == WritePolicy::WriteThrough || p == WritePolicy::WriteThroughNoAlloc;
+}
+inline bool allocates(WritePolicy p) {
+    return p == WritePolicy::WriteBack || p == WritePolicy::WriteThrough;
+}
+
+inline const char* name(WritePolicy p) {
+    switch (p) {
+        case WritePolicy::WriteBack:           return "wb";
+        case WritePolicy::WriteBackNoAlloc:    return "wb-na";
+        case WritePolicy::WriteThrough:        return "wt";
+        case WritePolicy::WriteThroughNoAlloc: return "wt-na";
+    }
+    return "?";
+}
+
+inline bool parse(const std::string& s, WritePolicy& out) {
+    if (s == "wb")         out = WritePolicy::WriteBack;
+    else if (s == "wb-na") out = WritePolicy::WriteBackNoAlloc;
+    else if (s == "wt")    out = WritePolicy::WriteThrough;
+    else if (s == "wt-na") out = WritePolicy::WriteThroughNoAlloc;
+    else return false;
+    return true;
+}
+
+}  // namespace write_policy
@@ -0,0 +1,202 @@
+#include "memory/dram/DramController.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+bool parse_dram_sched(const std::string& s, DramSched& out) {
+  if (s == "fcfs")        out = DramSched::FCFS;
+  else if (s == "frfcfs") out = DramSched::FRFCFS;
+  else return false;
+  return true;
+}
+
+bool parse_dram_page(const std::string& s, DramPage& out) {
+  if (s == "open")        out = DramPage::Open;
+  else if (s == "closed") out = DramPage::Closed;
+  else return false;
+  return true;
+}
+
+const char* dram_sched_name(DramSched s) { return s == DramSched::FCFS ? "fcfs" : "frfcfs"; }
+const char* dram_page_name(DramPage p)   { return p == DramPage::Open ? "abierta" : "cerrada"; }
+
+// "RoRaBaChCo" -> campos de más a menos significativo; false si falta o sobra alguno
+static bool parse_map(const std::string& s, std::vector<uint8_t>& msb_first) {
+  static const char* kNames[] = {"Ro", "Ra", "Ba", "Ch", "Co"};
+  if (s.size() != 10) return false;
+  msb_first.clear();
+  unsigned seen = 0;
+  for (size_t i = 0; i < s.size(); i += 2) {
+    int f = -1;
+    for (int k = 0; k < 5; ++k)
+      if (s.compare(i, 2, kNames[k]) == 0) f = k;
+    if (f < 0 || (seen & (1u << f))) return false;
+    seen |= 1u << f;
+    msb_first.push_back(uint8_t(f));
+  }
+  return true;
+}
+
+bool DramController::validate(const DramConfig& c, std::string* err) {
+  auto fail = [&](const char* m) { if (err) *err = m; return false; };
+  auto pow2 = [](uint64_t v) { return v && std::has_single_bit(v); };
+  if (c.channels < 1 || c.ranks < 1 || c.banks < 1 || !pow2(uint64_t(c.channels)) ||
+      !pow2(uint64_t(c.ranks)) || !pow2(uint64_t(c.banks)) || c.channels * c.ranks * c.banks > 1024)
+    return fail("canales, ranks y bancos deben ser potencias de 2 (a lo sumo 1024 bancos)");
+  if (!pow2(c.row_bytes) || c.row_bytes < 32) return fail("la fila debe ser potencia de 2 >= 32 B");
+  std::vector<uint8_t> f;
+  if (!parse_map(c.map, f)) return fail("mapeo inválido: permutación de Ro, Ra, Ba, Ch y Co");
+  if (f.front() != Ro) return fail("el mapeo debe empezar por Ro (la fila toma los bits altos)");
+  if (c.queue_depth < 1 || c.issue_cycles < 1 || c.tCCD < 1 || c.tBURST < 1)
+    return fail("queue_depth, issue_cycles, tCCD y tBURST deben ser >= 1");
+  if (c.tREFI && c.tRFC >= c.tREFI) return fail("tRFC debe ser menor que tREFI");
+  return true;
+}
+
+DramController::DramController(const DramConfig& c) : cfg_(c) {
+  assert(validate(c, nullptr));
+  std::vector<uint8_t> f;
+  parse_map(cfg_.map, f);
+  for (auto it = f.rbegin(); it != f.rend(); ++it) fields_.push_back(Field(*it));
+  bits_[Ra] = std::countr_zero(unsigned(cfg_.ranks));
+  bits_[Ba] = std::countr_zero(unsigned(cfg_.banks));
+  bits_[Ch] = std::countr_zero(unsigned(cfg_.channels));
+  bits_[Co] = std::countr_zero(cfg_.row_bytes / 32);
+  ch_.resize(size_t(cfg_.channels));
+  banks_.resize(size_t(cfg_.channels * cfg_.ranks * cfg_.banks));
+  bank_stats_.resize(banks_.size());
+  next_refresh_.assign(size_t(cfg_.channels * cfg_.ranks), cfg_.tREFI);
+}
+
+DramController::Coord DramController::decode(uint64_t addr) const {
+  Coord c;
+  uint64_t line = addr >> 5;
+  for (Field f : fields_) {
+    if (f == Ro) { c.row = line; break; }   // siempre el último (más significativo)
+    const uint64_t v = line & ((uint64_t(1) << bits_[f]) - 1);
+    line >>= bits_[f];
+    switch (f) {
+      case Ra: c.rank = int(v); break;
+      case Ba: c.bank = int(v); break;
+      case Ch: c.channel = int(v); break;
+      case Co: c.column = uint32_t(v); break;
+      default: break;
+    }
+  }
+  return c;
+}
+
+// Refrescos del rank vencidos hasta 'now': bancos ocupados tRFC y filas cerradas
+void DramController::refresh_(int channel, int rank, uint64_t now) {
+  if (!cfg_.tREFI) return;
+  uint64_t& next = next_refresh_[size_t(channel * cfg_.ranks + rank)];
+  Bank* b = &banks_[size_t((channel * cfg_.ranks + rank) * cfg_.banks)];
+  while (next <= now) {
+    uint64_t start = next;
+    for (int k = 0; k < cfg_.banks; ++k) start = std::max(start, b[k].ready);
+    for (int k = 0; k < cfg_.banks; ++k) { b[k].ready = start + cfg_.tRFC; b[k].open = false; }
+    ++stats_.refreshes;
+    next += cfg_.tREFI;
+  }
+}
+
+/* issue_one_(channel, limit) -----------------------------------------------
+ * Elige y emite el próximo pedido de la cola del canal. Decide en el primer
+ * ciclo t >= next_issue en que haya un pedido llegado con su banco libre; si t
+ * supera 'limit' no emite nada (puede llegar otro pedido antes) y devuelve
+ * UINT64_MAX. Devuelve el ciclo de emisión.
+ */
+uint64_t DramController::issue_one_(int channel, uint64_t limit) {
+  Channel& ch = ch_[size_t(channel)];
+  assert(!ch.q.empty());
+  uint64_t t = std::max(ch.next_issue, ch.q.front().arrival);
+
+  size_t pick = 0;
+  if (cfg_.sched == DramSched::FCFS) {
+    t = std::max(t, bank_(ch.q[0].c).ready);
+  } else {
+    // FR-FCFS: el primer ciclo con algún candidato listo; en él, aciertos de
+    // fila antes que el resto y, a igualdad, el más antiguo (la cola está en
+    // orden de llegada)
+    uint64_t ready_at = UINT64_MAX;
+    for (const Request& q : ch.q) ready_at = std::min(ready_at, std::max(q.arrival, bank_(q.c).ready));
+    t = std::max(t, ready_at);
+    bool hit = false, found = false;
+    for (size_t i = 0; i < ch.q.size(); ++i) {
+      const Request& q = ch.q[i];
+      const Bank& b = bank_(q.c);
+      if (q.arrival > t || b.ready > t) continue;
+      const bool h = b.open && b.row == q.c.row;
+      if (!found || (h && !hit)) { pick = i; hit = h; found = true; }
+      if (hit) break;
+    }
+  }
+  if (t > limit) return UINT64_MAX;
+  for (int r = 0; r < cfg_.ranks; ++r) refresh_(channel, r, t);   // retrasa 'start' si toca
+
+  const Request req = ch.q[pick];
+  ch.q.erase(ch.q.begin() + std::ptrdiff_t(pick));
+  Bank& b = bank_(req.c);
+  Stats& bs = bank_stats_[size_t((req.c.channel * cfg_.ranks + req.c.rank) * cfg_.banks + req.c.bank)];
+  const uint64_t start = std::max(t, b.ready);
+
+  uint64_t cas = start;
+  if (b.open && b.row == req.c.row) {
+    ++stats_.row_hits; ++bs.row_hits;
+  } else if (!b.open) {
+    ++stats_.row_empty; ++bs.row_empty;
+    b.act = start;
+    cas = start + cfg_.tRCD;
+  } else {
+    ++stats_.row_conflicts; ++bs.row_conflicts;
+    const uint64_t pre = std::max(start, b.act + cfg_.tRAS);
+    b.act = pre + cfg_.tRP;
+    cas = b.act + cfg_.tRCD;
+  }
+  const uint64_t data = std::max(cas + cfg_.tCL, ch.bus_free);
+  ch.bus_free = data + cfg_.tBURST;
+  if (cfg_.page == DramPage::Open) {
+    b.open = true;
+    b.row = req.c.row;
+    b.ready = cas + cfg_.tCCD;
+  } else {   // auto-precarga
+    b.open = false;
+    b.ready = std::max(ch.bus_free, b.act + cfg_.tRAS) + cfg_.tRP;
+  }
+  ch.next_issue = t + cfg_.tCCD;
+
+  const uint64_t done = ch.bus_free + cfg_.tCtrl;
+  const uint64_t lat = done - req.arrival;
+  for (Stats* s : {&stats_, &bs}) {
+    if (req.write) ++s->writes; else ++s->reads;
+    s->latency += lat;
+    s->max_latency = std::max(s->max_latency, lat);
+    s->queue_cycles += t - req.arrival;
+  }
+  last_done_ = std::max(last_done_, done);
+  ch.inflight.push(done);
+  return t;
+}
+
+void DramController::access(uint64_t addr, bool write) {
+  const Coord c = decode(addr);
+  Channel& ch = ch_[size_t(c.channel)];
+  // Un pedido ocupa su lugar en la cola hasta entregar el dato: con la cola
+  // llena la llegada espera a la próxima entrega
+  for (;;) {
+    while (!ch.q.empty() && issue_one_(c.channel, clock_) != UINT64_MAX) {}
+    while (!ch.inflight.empty() && ch.inflight.top() <= clock_) ch.inflight.pop();
+    if (ch.q.size() + ch.inflight.size() < cfg_.queue_depth) break;
+    if (ch.inflight.empty()) { issue_one_(c.channel, UINT64_MAX); continue; }
+    stats_.stall_cycles += ch.inflight.top() - clock_;
+    clock_ = ch.inflight.top();
+  }
+  ch.q.push_back(Request{c, write, clock_});
+  clock_ += cfg_.issue_cycles;
+}
+
+void DramController::drain() {
+  for (int k = 0; k < cfg_.channels; ++k)
+    while (!ch_[size_t(k)].q.empty()) issue_one_(k, UINT64_MAX);
+}
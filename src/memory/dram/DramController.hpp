@@ -0,0 +1,145 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <string>
+#include <vector>
+
+/*
+ * DramController.hpp
+ * ==================
+ * Modelo de tiempo del controlador de memoria detrás de SharedMemory: canales,
+ * ranks, bancos con buffer de fila, política de página abierta/cerrada,
+ * planificación FCFS o FR-FCFS, refresco y mapeo de direcciones configurable.
+ * Los datos siguen saliendo de SharedMemory al instante (el modelo funcional no
+ * cambia); cada lectura/escritura de línea se encola aquí para calcular cuándo
+ * la habría servido la DRAM.
+ *
+ * Tiempo: ciclos del procesador (la escala de sampling/Timing.hpp). Los pedidos
+ * llegan con un reloj lógico que avanza 'issue_cycles' por pedido (la tasa
+ * máxima a la que el bus los entrega). Cada canal tiene una cola de hasta
+ * 'queue_depth' pedidos (un pedido ocupa su lugar hasta entregar el dato); el
+ * planificador emite a lo sumo uno cada 'tCCD' ciclos:
+ *   - FCFS    : el más antiguo.
+ *   - FR-FCFS : entre los pedidos con el banco libre, primero los que aciertan
+ *               en la fila abierta y, entre ellos (o si no hay), el más antiguo.
+ * Con la cola llena el reloj de llegada espera al planificador (backpressure),
+ * así el ancho de banda sostenido sale de los tiempos de la DRAM.
+ *
+ * Servicio de un pedido en su banco:
+ *   acierto de fila : tCL
+ *   banco cerrado   : tRCD + tCL
+ *   conflicto       : tRP + tRCD + tCL (precarga no antes de tRAS tras el ACT)
+ * más tBURST en el bus de datos del canal (compartido por sus bancos) y tCtrl
+ * de ida y vuelta por el controlador. Con página cerrada cada acceso precarga
+ * la fila al terminar (nunca hay aciertos ni conflictos). Cada rank se refresca
+ * cada tREFI ciclos: sus bancos quedan tRFC ciclos ocupados y con la fila cerrada.
+ *
+ * Mapeo: campos de la dirección de línea (32 B) de más a menos significativo,
+ * p. ej. "RoRaBaCoCh" (por defecto: canales intercalados por línea y líneas
+ * consecutivas de un canal en la misma fila), "RoRaBaChCo" (una fila entera por
+ * canal) o "RoCoRaBaCh" (también los bancos intercalados por línea). La fila se
+ * queda con los bits sobrantes.
+ *
+ * No es thread-safe: SharedMemory lo llama con su mutex tomado.
+ */
+enum class DramSched : uint8_t { FCFS, FRFCFS };
+enum class DramPage : uint8_t { Open, Closed };
+
+struct DramConfig {
+  int channels = 2, ranks = 1, banks = 8;   // potencias de 2
+  uint32_t row_bytes = 2048;                // buffer de fila (potencia de 2, >= 32)
+  DramSched sched = DramSched::FRFCFS;
+  DramPage page = DramPage::Open;
+  std::string map = "RoRaBaCoCh";
+  uint32_t queue_depth = 16;                // por canal
+  uint32_t issue_cycles = 2;                // entre llegadas de pedidos
+  // Tiempos en ciclos del procesador
+  uint32_t tCtrl = 20, tCL = 42, tRCD = 42, tRP = 42, tRAS = 100;
+  uint32_t tBURST = 6, tCCD = 4;
+  uint32_t tREFI = 23400, tRFC = 1050;      // 0 = sin refresco
+};
+
+bool parse_dram_sched(const std::string& s, DramSched& out);   // "fcfs" | "frfcfs"
+bool parse_dram_page(const std::string& s, DramPage& out);     // "open" | "closed"
+const char* dram_sched_name(DramSched s);
+const char* dram_page_name(DramPage p);
+
+class DramController {
+public:
+  struct Stats {
+    uint64_t reads = 0, writes = 0;
+    uint64_t row_hits = 0, row_empty = 0, row_conflicts = 0;
+    uint64_t refreshes = 0;
+    uint64_t latency = 0, max_latency = 0;   // llegada -> último dato, en ciclos
+    uint64_t queue_cycles = 0;               // llegada -> emisión
+    uint64_t stall_cycles = 0;               // llegadas demoradas por cola llena
+    uint64_t requests() const { return reads + writes; }
+    double row_hit_rate() const {
+      const uint64_t n = row_hits + row_empty + row_conflicts;
+      return n ? double(row_hits) / double(n) : 0.0;
+    }
+    double avg_latency() const { return requests() ? double(latency) / double(requests()) : 0.0; }
+  };
+
+  // Campos de una dirección según el mapeo
+  struct Coord { int channel = 0, rank = 0, bank = 0; uint64_t row = 0; uint32_t column = 0; };
+
+  static bool validate(const DramConfig& c, std::string* err);
+  explicit DramController(const DramConfig& c);
+
+  const DramConfig& config() const { return cfg_; }
+  Coord decode(uint64_t addr) const;
+
+  // Encola la lectura/escritura de la línea de 'addr' y emite lo que el
+  // planificador ya pueda emitir antes de su llegada
+  void access(uint64_t addr, bool write);
+  // Emite todo lo pendiente (antes de leer los informes)
+  void drain();
+
+  const Stats& stats() const { return stats_; }
+  // Por banco (índice (channel * ranks + rank) * banks + bank)
+  const Stats& bank_stats(int channel, int rank, int bank) const {
+    return bank_stats_[size_t((channel * cfg_.ranks + rank) * cfg_.banks + bank)];
+  }
+  // Ciclo del último dato entregado; ancho de banda = bytes / elapsed()
+  uint64_t elapsed() const { return last_done_; }
+  double bytes_per_cycle() const {
+    return last_done_ ? double(stats_.requests()) * 32.0 / double(last_done_) : 0.0;
+  }
+
+private:
+  enum Field : uint8_t { Ro, Ra, Ba, Ch, Co };
+
+  struct Request { Coord c; bool write; uint64_t arrival; };
+  struct Bank {
+    bool open = false;
+    uint64_t row = 0;
+    uint64_t ready = 0;      // puede recibir el próximo comando
+    uint64_t act = 0;        // ciclo del último ACT (tRAS)
+  };
+  struct Channel {
+    std::deque<Request> q;
+    uint64_t next_issue = 0; // el planificador puede emitir (tCCD)
+    uint64_t bus_free = 0;   // bus de datos libre
+    // Entregas pendientes de los pedidos emitidos (ocupan lugar en la cola)
+    std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> inflight;
+  };
+
+  Bank& bank_(const Coord& c) { return banks_[size_t((c.channel * cfg_.ranks + c.rank) * cfg_.banks + c.bank)]; }
+  uint64_t issue_one_(int channel, uint64_t limit);
+  void refresh_(int channel, int rank, uint64_t now);
+
+  DramConfig cfg_;
+  std::vector<Field> fields_;          // de menos a más significativo
+  std::array<int, 5> bits_{};          // bits de cada campo (la fila: el resto)
+  std::vector<Channel> ch_;
+  std::vector<Bank> banks_;
+  std::vector<uint64_t> next_refresh_; // por (channel, rank)
+  uint64_t clock_ = 0;                 // llegada del próximo pedido
+  uint64_t last_done_ = 0;
+  Stats stats_;
+  std::vector<Stats> bank_stats_;
+};
@@ -0,0 +1,259 @@
+#include "noc/NocModel.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+bool parse_noc_topology(const std::string& s, NocConfig& out) {
+  const size_t c = s.find(':');
+  const std::string t = s.substr(0, c);
+  if (t == "ring")      out.topo = NocTopology::Ring;
+  else if (t == "mesh") out.topo = NocTopology::Mesh;
+  else return false;
+  out.cols = 0;
+  if (c != std::string::npos) {
+    if (out.topo != NocTopology::Mesh) return false;
+    try {
+      out.cols = std::stoi(s.substr(c + 1));
+    } catch (const std::exception&) {
+      return false;
+    }
+    if (out.cols < 1) return false;
+  }
+  return true;
+}
+
+const char* noc_topology_name(NocTopology t) {
+  switch (t) {
+    case NocTopology::Ring: return "anillo";
+    case NocTopology::Mesh: return "malla";
+  }
+  return "?";
+}
+
+bool NocModel::validate(const NocConfig& c, std::string* err) {
+  auto fail = [&](const char* m) { if (err) *err = m; return false; };
+  if (c.tiles < 1 || c.tiles > 1024) return fail("tiles fuera de rango (1..1024)");
+  if (c.hop_cycles < 1) return fail("hop_cycles debe ser >= 1");
+  if (c.flit_bytes < 4 || c.flit_bytes > 64) return fail("flit_bytes debe estar entre 4 y 64");
+  if (c.topo == NocTopology::Mesh && c.cols && c.tiles % c.cols)
+    return fail("las columnas de la malla deben dividir al número de tiles");
+  return true;
+}
+
+NocModel::NocModel(const NocConfig& c) : cfg_(c) {
+  assert(validate(c, nullptr));
+  const int n = cfg_.tiles;
+  out_.assign(size_t(n) * 4, -1);
+  auto add = [&](int from, int to, int port, char dir) {
+    out_[size_t(from) * 4 + size_t(port)] = int(links_.size());
+    Link l;
+    l.from = from; l.to = to; l.dir = dir;
+    links_.push_back(l);
+  };
+
+  if (cfg_.topo == NocTopology::Ring) {
+    cols_ = n;
+    vpc_ = cfg_.dateline ? 2 : 1;
+    if (n > 1)
+      for (int i = 0; i < n; ++i) {
+        add(i, (i + 1) % n, 0, '+');
+        add(i, (i + n - 1) % n, 1, '-');
+      }
+  } else {
+    // Sin columnas explícitas: el divisor de n más cercano a sqrt(n) desde arriba
+    cols_ = cfg_.cols;
+    if (!cols_) {
+      cols_ = int(std::ceil(std::sqrt(double(n))));
+      while (n % cols_) ++cols_;
+    }
+    rows_ = n / cols_;
+    for (int y = 0; y < rows_; ++y)
+      for (int x = 0; x < cols_; ++x) {
+        const int t = y * cols_ + x;
+        if (x + 1 < cols_) add(t, t + 1, 0, 'E');
+        if (x > 0)         add(t, t - 1, 1, 'W');
+        if (y > 0)         add(t, t - cols_, 2, 'N');
+        if (y + 1 < rows_) add(t, t + cols_, 3, 'S');
+      }
+  }
+  for (Link& l : links_) l.vc_flits.assign(size_t(vcs()), 0);
+  win_.assign(links_.size() * kWindows, Window{});
+  cdg_.assign(links_.size() * size_t(vcs()), {});
+  pes_.assign(size_t(n), PeStats{});
+}
+
+int NocModel::link_id_(int from, char dir) const {
+  int port = 0;
+  switch (dir) {
+    case '+': case 'E': port = 0; break;
+    case '-': case 'W': port = 1; break;
+    case 'N': port = 2; break;
+    case 'S': port = 3; break;
+    default: return -1;
+  }
+  return out_[size_t(from) * 4 + size_t(port)];
+}
+
+std::vector<int> NocModel::route(int src, int dst) const {
+  std::vector<int> r;
+  if (cfg_.topo == NocTopology::Ring) {
+    const int n = cfg_.tiles;
+    const int cw = (dst - src + n) % n;
+    const bool plus = cw <= n - cw;
+    for (int t = src; t != dst; t = plus ? (t + 1) % n : (t + n - 1) % n)
+      r.push_back(link_id_(t, plus ? '+' : '-'));
+    return r;
+  }
+  int x = src % cols_, y = src / cols_;
+  const int dx = dst % cols_, dy = dst / cols_;
+  for (; x != dx; x += (dx > x ? 1 : -1)) r.push_back(link_id_(y * cols_ + x, dx > x ? 'E' : 'W'));
+  for (; y != dy; y += (dy > y ? 1 : -1)) r.push_back(link_id_(y * cols_ + x, dy > y ? 'S' : 'N'));
+  return r;
+}
+
+/* reserve_(link, t, flits) -------------------------------------------------
+ * Reserva 'flits' ciclos del enlace a partir de t en la primera ventana con
+ * capacidad; devuelve el ciclo de salida. Una ventana más vieja que las
+ * kWindows recordadas no se contabiliza (se asume libre).
+ */
+uint64_t NocModel::reserve_(int link, uint64_t t, uint32_t flits) {
+  for (uint64_t w = t / kWindowCycles;; ++w) {
+    Window& x = win_[size_t(link) * kWindows + size_t(w % kWindows)];
+    if (x.tag != w) {
+      if (x.tag != ~uint64_t(0) && x.tag > w) return t;
+      x.tag = w;
+      x.used = 0;
+    }
+    if (x.used + flits <= kWindowCycles) {
+      x.used += flits;
+      return std::max(t, w * kWindowCycles);
+    }
+  }
+}
+
+uint64_t NocModel::send_(int src, int dst, MsgClass cls, uint32_t flits, uint64_t t) {
+  const uint64_t t0 = t;
+  const std::vector<int> r = route(src, dst);
+  bool high = false;
+  int prev = -1;
+  for (int l : r) {
+    Link& L = links_[size_t(l)];
+    // Línea de fecha: los enlaces que cierran el anillo pasan al segundo VC
+    if (cfg_.topo == NocTopology::Ring && cfg_.dateline &&
+        ((L.dir == '+' && L.to == 0) || (L.dir == '-' && L.from == 0)))
+      high = true;
+    const int ch = channel_(l, cls, high);
+    if (prev >= 0) {
+      std::vector<int>& next = cdg_[size_t(prev)];
+      if (std::find(next.begin(), next.end(), ch) == next.end()) next.push_back(ch);
+    }
+    prev = ch;
+
+    const uint64_t start = reserve_(l, t, flits);
+    L.wait_cycles += start - t;
+    ++L.packets;
+    L.flits += flits;
+    L.vc_flits[size_t(ch % vcs())] += flits;
+    t = start + cfg_.hop_cycles;
+  }
+  if (!r.empty()) t += flits - 1;
+
+  ++tot_.packets;
+  ++tot_.class_packets[cls];
+  tot_.flits += flits;
+  tot_.hops += r.size();
+  tot_.packet_latency += t - t0;
+  tot_.max_packet_latency = std::max(tot_.max_packet_latency, t - t0);
+  return t;
+}
+
+void NocModel::begin(int pe) {
+  assert(!in_txn_ && "transacción de red anidada");
+  in_txn_ = true;
+  cur_pe_ = pe;
+  owner_ = -1;
+}
+
+void NocModel::flush(int pe, uint64_t base) {
+  if (in_txn_) { owner_ = pe; return; }   // intervención: se envía en end()
+  const int s = tile_of(pe);
+  send_(s, home_tile(base), Resp, data_flits(), pes_[size_t(s)].clock);   // desalojo sucio
+}
+
+/* end(type, base, from_memory) ---------------------------------------------
+ * Envía los mensajes de la transacción abierta con begin() y avanza el reloj
+ * del solicitante hasta el último ack o dato recibido. 'from_memory': los
+ * datos salieron de SharedMemory (no de un Flush). Devuelve la latencia.
+ */
+uint64_t NocModel::end(BusMsg type, uint64_t base, bool from_memory) {
+  assert(in_txn_);
+  in_txn_ = false;
+  const int s = tile_of(cur_pe_), h = home_tile(base);
+  const int o = owner_ >= 0 ? tile_of(owner_) : -1;
+  PeStats& ps = pes_[size_t(s)];
+  const uint64_t t0 = ps.clock;
+
+  const uint64_t th = send_(s, h, Req, 1, t0);
+  uint64_t done = th, t_owner = th;
+  for (int q = 0; q < cfg_.tiles; ++q) {
+    if (q == s) continue;
+    const uint64_t tq = send_(h, q, Fwd, 1, th);
+    if (q == o) t_owner = tq;
+    done = std::max(done, send_(q, s, Resp, 1, tq));
+  }
+  if (o >= 0) send_(o, h, Resp, data_flits(), t_owner);   // write-back del dueño
+
+  if (type == BusMsg::BusWr || type == BusMsg::BusWrLine) {   // datos del solicitante al home
+    const uint32_t fl = type == BusMsg::BusWrLine ? data_flits() : 1 + (8 + cfg_.flit_bytes - 1) / cfg_.flit_bytes;
+    done = std::max(done, send_(s, h, Resp, fl, t0));
+  }
+  if (type == BusMsg::BusRd || type == BusMsg::BusRdX) {
+    const uint64_t td = (!from_memory && o >= 0)
+        ? send_(o, s, Resp, data_flits(), t_owner)
+        : send_(h, s, Resp, data_flits(), th + (from_memory ? cfg_.mem_cycles : 0));
+    done = std::max(done, td);
+  }
+
+  ++ps.transactions;
+  ps.latency += done - t0;
+  ps.max_latency = std::max(ps.max_latency, done - t0);
+  ps.clock = done;
+  owner_ = -1;
+  return done - t0;
+}
+
+bool NocModel::deadlock_free() const {
+  const size_t n = links_.size() * size_t(vcs());
+  // DFS iterativo: 0 = sin visitar, 1 = en la pila, 2 = terminado
+  std::vector<uint8_t> color(n, 0);
+  std::vector<std::pair<size_t, size_t>> st;
+  for (size_t root = 0; root < n; ++root) {
+    if (color[root]) continue;
+    st.push_back({root, 0});
+    color[root] = 1;
+    while (!st.empty()) {
+      auto& [v, next] = st.back();
+      if (next == cdg_[v].size()) { color[v] = 2; st.pop_back(); continue; }
+      const size_t w = size_t(cdg_[v][next++]);
+      if (color[w] == 1) return false;
+      if (!color[w]) { color[w] = 1; st.push_back({w, 0}); }
+    }
+  }
+  return true;
+}
+
+NocModel::PeStats NocModel::pe_stats(int pe) const {
+  return (pe >= 0 && pe < cfg_.tiles) ? pes_[size_t(pe)] : PeStats{};
+}
+
+uint64_t NocModel::elapsed() const {
+  uint64_t m = 0;
+  for (const PeStats& p : pes_) m = std::max(m, p.clock);
+  return m;
+}
+
+double NocModel::utilization(int link) const {
+  const uint64_t e = elapsed();
+  return e ? double(links_[size_t(link)].flits) / double(e) : 0.0;
+}
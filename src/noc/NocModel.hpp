@@ -0,0 +1,144 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../memory/cache/mesi/MesiTypes.hpp"   // BusMsg
+#include "../sampling/Timing.hpp"
+
+/*
+ * NocModel.hpp
+ * ============
+ * Red en chip por paquetes (anillo o malla 2D) como modelo de tiempo del
+ * interconnect: el protocolo sigue resolviéndose en MesiInterconnect::emit
+ * (síncrono), y cada transacción se traduce a los mensajes que viajarían por
+ * la red para estimar latencia, contención y tráfico por enlace con más PEs de
+ * los que admite un bus real.
+ *
+ * Topología: un tile por PE (PE k -> tile k % tiles). La línea tiene un tile
+ * home (intercalado por línea) que actúa de punto de orden y controlador de
+ * memoria. Por transacción del PE s sobre una línea con home h:
+ *   - Req  : s -> h (1 flit).
+ *   - Fwd  : h -> cada otro PE (snoop/invalidación, 1 flit).
+ *   - Resp : ack de cada PE snoopeado -> s (1 flit); datos (BusRd/BusRdX) desde
+ *            el dueño que hizo Flush o desde h tras mem_cycles; el Flush del
+ *            dueño también viaja a h (write-back). Los desalojos sucios son un
+ *            paquete de datos s -> h fuera de transacción. BusWr/BusWrLine
+ *            llevan además sus datos s -> h (8 B o la línea).
+ * El DMA (dma_snoop) no genera tráfico de red.
+ *
+ * Enrutamiento: anillo bidireccional por el camino más corto (empate: sentido
+ * horario); malla XY (primero X, luego Y), libre de deadlock por construcción.
+ * Canales virtuales: una clase de mensaje por VC (Req, Fwd, Resp) para evitar el
+ * deadlock de protocolo (una respuesta nunca espera detrás de un pedido); en el
+ * anillo cada clase tiene 2 VCs y el paquete pasa al segundo al cruzar la línea
+ * de fecha (enlaces que cierran el anillo). deadlock_free() verifica que el
+ * grafo de dependencias entre canales (enlace, VC) usado sea acíclico.
+ *
+ * Tiempo: cada PE lleva su propio reloj (ciclos de red), que avanza con la
+ * latencia de sus transacciones. Un enlace transporta 1 flit por ciclo; su
+ * capacidad se reserva por ventanas de kWindowCycles ciclos, así PEs con relojes
+ * distintos compiten sin exigir orden global. Latencia por salto: hop_cycles;
+ * el paquete suma además (flits - 1) ciclos de serialización.
+ *
+ * No es thread-safe: lo llama MesiInterconnect con el bus tomado; los informes
+ * se leen con los PEs detenidos.
+ */
+enum class NocTopology : uint8_t { Ring, Mesh };
+
+struct NocConfig {
+  NocTopology topo = NocTopology::Mesh;
+  int tiles = 4;                               // = PEs
+  int cols = 0;                                // malla: columnas (0 = la más cuadrada)
+  uint32_t hop_cycles = 3;                     // router + enlace
+  uint32_t flit_bytes = 16;
+  uint32_t mem_cycles = uint32_t(timing::kMemLineCycles);
+  bool dateline = true;                        // anillo: VCs de línea de fecha
+};
+
+// "ring" | "mesh[:COLS]"
+bool        parse_noc_topology(const std::string& s, NocConfig& out);
+const char* noc_topology_name(NocTopology t);
+
+class NocModel {
+public:
+  enum MsgClass : uint8_t { Req, Fwd, Resp, kClasses };
+  static constexpr uint64_t kWindowCycles = 64;
+  static constexpr size_t   kWindows = 1024;   // ventanas recordadas por enlace
+
+  struct Link {
+    int from = 0, to = 0;
+    char dir = '?';                  // malla: E/W/N/S; anillo: '+' horario, '-' antihorario
+    uint64_t packets = 0, flits = 0;
+    uint64_t wait_cycles = 0;        // espera por capacidad del enlace
+    std::vector<uint64_t> vc_flits;  // por VC: clase * vcs_per_class + índice
+  };
+
+  struct PeStats {
+    uint64_t transactions = 0;
+    uint64_t latency = 0, max_latency = 0;   // ciclos de red por transacción
+    uint64_t clock = 0;                      // reloj del PE al terminar su última transacción
+  };
+
+  struct Totals {
+    uint64_t packets = 0, flits = 0, hops = 0;
+    uint64_t packet_latency = 0, max_packet_latency = 0;
+    uint64_t class_packets[kClasses] = {};
+  };
+
+  // Valida la configuración; cols debe dividir a tiles (malla rectangular)
+  static bool validate(const NocConfig& c, std::string* err);
+  explicit NocModel(const NocConfig& c);
+
+  const NocConfig& config() const { return cfg_; }
+  int tiles() const { return cfg_.tiles; }
+  int rows() const { return rows_; }
+  int cols() const { return cols_; }
+  int vcs_per_class() const { return vpc_; }
+  int vcs() const { return kClasses * vpc_; }
+  int tile_of(int pe) const { return pe < 0 ? 0 : pe % cfg_.tiles; }
+  int home_tile(uint64_t base) const { return int((base / 32) % uint64_t(cfg_.tiles)); }
+  uint32_t data_flits() const { return 1 + (32 + cfg_.flit_bytes - 1) / cfg_.flit_bytes; }
+
+  // --- Llamadas desde MesiInterconnect::emit (bus tomado) ---
+  // begin/end encierran una transacción BusRd/BusRdX/BusUpgr/Inv/BusWr* del PE; los
+  // Flush que lleguen entre ambas son la intervención del dueño. end() devuelve
+  // la latencia de la transacción en ciclos de red.
+  void begin(int pe);
+  void flush(int pe, uint64_t base);
+  uint64_t end(BusMsg type, uint64_t base, bool from_memory);
+
+  // Enlaces (índices de links()) del camino src -> dst
+  std::vector<int> route(int src, int dst) const;
+  // Grafo de dependencias entre canales de los paquetes enviados: sin ciclos
+  bool deadlock_free() const;
+
+  const std::vector<Link>& links() const { return links_; }
+  PeStats pe_stats(int pe) const;
+  const Totals& totals() const { return tot_; }
+  // Ciclos de red simulados: el reloj más avanzado entre los PEs
+  uint64_t elapsed() const;
+  double utilization(int link) const;
+
+private:
+  int link_id_(int from, char dir) const;
+  int channel_(int link, MsgClass cls, bool high) const { return link * vcs() + cls * vpc_ + (high ? 1 : 0); }
+  uint64_t reserve_(int link, uint64_t t, uint32_t flits);
+  uint64_t send_(int src, int dst, MsgClass cls, uint32_t flits, uint64_t t);
+
+  NocConfig cfg_;
+  int rows_ = 1, cols_ = 1, vpc_ = 1;
+  std::vector<Link> links_;
+  std::vector<int> out_;               // tile * 4 + puerto -> enlace (-1 si no hay)
+
+  struct Window { uint64_t tag = ~uint64_t(0); uint32_t used = 0; };
+  std::vector<Window> win_;            // links * kWindows
+  // Dependencias observadas entre canales: por canal, los canales que lo
+  // siguieron en alguna ruta (pocos: los puertos del tile siguiente)
+  std::vector<std::vector<int>> cdg_;
+
+  std::vector<PeStats> pes_;
+  Totals tot_;
+  bool in_txn_ = false;
+  int cur_pe_ = -1, owner_ = -1;
+};
@@ -0,0 +1,105 @@
+#include "numa/NumaDirectory.hpp"
+
+#include <bit>
+#include <cassert>
+
+#include "MesiInterconnect.hpp"
+#include "memory/SharedMemory.h"
+#include "sampling/Timing.hpp"
+
+void NumaDirectory::attach(int node, MesiInterconnect* bus) {
+  assert(node >= 0 && node < kMaxNodes);
+  std::lock_guard<std::recursive_mutex> lk(mtx_);
+  if (int(buses_.size()) <= node) {
+    buses_.resize(size_t(node) + 1, nullptr);
+    stats_.resize(size_t(node) + 1);
+  }
+  buses_[size_t(node)] = bus;
+  bus->set_directory(this, node);
+}
+
+bool NumaDirectory::remote_(int node, uint64_t base) const {
+  return shm_.home_node(base) != node;
+}
+
+// Suma la latencia local o remota según el home de la línea
+void NumaDirectory::charge_(int node, uint64_t base, uint64_t local, uint64_t remote) {
+  NodeStats& s = stats_[size_t(node)];
+  if (remote_(node, base)) s.remote_cycles += remote;
+  else                     s.local_cycles += local;
+}
+
+/* acquire(node, base, exclusive, needs_data) -------------------------------
+ * Resuelve las copias de los demás clusters y deja la entrada con el nodo
+ * como compartidor (o dueño exclusivo). Los snoops remotos se hacen en el hilo
+ * del solicitante (ver MesiInterconnect::remote_snoop).
+ */
+bool NumaDirectory::acquire(int node, uint64_t base, bool exclusive, bool needs_data, uint8_t words) {
+  std::lock_guard<std::recursive_mutex> lk(mtx_);
+  NodeStats& s = stats_[size_t(node)];
+  ++s.requests;
+  charge_(node, base, timing::kDirLookupCycles, timing::kRemoteDirLookupCycles);
+
+  Entry& e = dir_[base];
+  const uint64_t me = uint64_t(1) << node;
+  uint64_t others = e.sharers & ~me;
+  bool shared = false;
+
+  if (exclusive) {
+    for (; others; others &= others - 1) {
+      const int n = std::countr_zero(others);
+      bool dirty = false;
+      buses_[size_t(n)]->remote_snoop(BusMsg::Inv, base, &dirty, words);
+      ++s.invals_sent;
+      s.remote_cycles += timing::kRemoteInvCycles;
+      if (dirty) { ++s.remote_c2c; s.remote_cycles += timing::kRemoteCacheCycles; }
+    }
+    e.sharers = me;
+    e.exclusive = true;
+  } else {
+    if (e.exclusive && others) {   // dueño remoto en E/M: pasa a S (Flush si M)
+      bool dirty = false;
+      buses_[size_t(std::countr_zero(others))]->remote_snoop(BusMsg::BusRd, base, &dirty);
+      if (dirty) { ++s.remote_c2c; s.remote_cycles += timing::kRemoteCacheCycles; }
+    }
+    shared = others != 0;
+    e.sharers |= me;
+    e.exclusive = !shared;
+  }
+
+  if (needs_data) {
+    if (remote_(node, base)) { ++s.remote_mem; s.remote_cycles += timing::kRemoteMemLineCycles; }
+    else                     { ++s.local_mem;  s.local_cycles += timing::kMemLineCycles; }
+  }
+  return shared;
+}
+
+void NumaDirectory::write_back(int node, uint64_t base) {
+  std::lock_guard<std::recursive_mutex> lk(mtx_);
+  NodeStats& s = stats_[size_t(node)];
+  if (remote_(node, base)) ++s.wb_remote;
+  else                     ++s.wb_local;
+  charge_(node, base, timing::kWriteBackCycles, timing::kRemoteWriteBackCycles);
+}
+
+bool NumaDirectory::dma_snoop(BusMsg type, uint64_t base, uint8_t words) {
+  std::lock_guard<std::recursive_mutex> lk(mtx_);
+  auto it = dir_.find(base);
+  if (it == dir_.end()) return false;
+  bool cached = false;
+  for (uint64_t m = it->second.sharers; m; m &= m - 1)
+    cached |= buses_[size_t(std::countr_zero(m))]->remote_snoop(type, base, nullptr, words);
+  if (type == BusMsg::BusRd) it->second.exclusive = false;
+  else dir_.erase(it);
+  return cached;
+}
+
+NumaDirectory::NodeStats NumaDirectory::stats(int node) const {
+  std::lock_guard<std::recursive_mutex> lk(mtx_);
+  return (node >= 0 && node < int(stats_.size())) ? stats_[size_t(node)] : NodeStats{};
+}
+
+size_t NumaDirectory::tracked_lines() const {
+  std::lock_guard<std::recursive_mutex> lk(mtx_);
+  return dir_.size();
+}
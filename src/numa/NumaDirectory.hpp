@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "../memory/cache/mesi/MesiTypes.hpp"   // BusMsg
+
+class MesiInterconnect;
+class SharedMemory;
+
+/*
+ * NumaDirectory.hpp
+ * =================
+ * Topología jerárquica: cada nodo (cluster) tiene su propio MesiInterconnect con
+ * sus L1$ (snoopy dentro del cluster) y los nodos se unen a través de este
+ * directorio global, que guarda por línea qué clusters pueden tener copia.
+ *
+ * Protocolo (por línea, granularidad de cluster):
+ *  - El bus local resuelve primero con sus L1$ (un Flush local sirve los datos).
+ *  - Lo que el cluster no puede resolver pasa por acquire():
+ *      lectura   : si otro cluster la tiene en exclusiva, se le hace un snoop
+ *                  BusRd remoto (M -> Flush a memoria, E/M -> S); el pedido
+ *                  queda compartido si algún otro cluster conserva copia.
+ *      exclusiva : BusRdX/BusUpgr/Inv invalidan las copias de los demás
+ *                  clusters (Flush si estaban en M) y el nodo queda dueño.
+ *  - Los desalojos limpios son silenciosos: el vector de presencia es un
+ *    superconjunto y un snoop remoto a un cluster sin copia no hace nada.
+ *  - El DMA (dma_snoop) alcanza a todos los clusters con copia.
+ *
+ * La memoria es una sola SharedMemory particionada por nodo home
+ * (SharedMemory::set_numa_nodes/bind). Cada pedido cobra latencias del modelo
+ * de timing.hpp según el home de la línea sea el nodo del solicitante (local) o
+ * otro (remoto); así se comparan ubicaciones de datos sin un modelo de ciclos
+ * del bus.
+ *
+ * Concurrencia: mutex() es el lock de toda la jerarquía; al enlazarse, cada bus
+ * local lo usa en lugar del suyo, así que un snoop remoto nunca se cruza con una
+ * transacción de otro cluster (los clusters se serializan en el host; la
+ * latencia NUMA la da el modelo de timing). Orden: árbitro local -> mutex()
+ * -> seqlocks por set de las L1$ (en orden de set; ver "Hilos" en MESICache.hpp).
+ */
+class NumaDirectory {
+public:
+  static constexpr int kMaxNodes = 64;
+
+  // Contadores por nodo solicitante (latencias en ciclos de timing.hpp)
+  struct NodeStats {
+    uint64_t requests = 0;                  // pedidos que salieron del bus local
+    uint64_t local_mem = 0, remote_mem = 0; // líneas leídas de memoria home local/remota
+    uint64_t remote_c2c = 0;                // datos sucios traídos de otro cluster
+    uint64_t invals_sent = 0;               // clusters invalidados por pedidos del nodo
+    uint64_t wb_local = 0, wb_remote = 0;   // write-backs a memoria home local/remota
+    uint64_t local_cycles = 0, remote_cycles = 0;
+  };
+
+  explicit NumaDirectory(SharedMemory& shm) : shm_(shm) {}
+
+  // Registra el bus local del nodo 'node' (0..kMaxNodes-1) y lo enlaza al directorio
+  void attach(int node, MesiInterconnect* bus);
+  int nodes() const { return int(buses_.size()); }
+  std::recursive_mutex& mutex() { return mtx_; }
+
+  // --- Llamadas desde el bus local (con mutex() y el bus del nodo tomados) ---
+  // Pedido de la línea 'base' por el nodo. 'needs_data': los datos vendrán de
+  // memoria (no de un Flush local). 'words': palabras de la línea que escribe
+  // (exclusive), las ve el análisis de false sharing de los clusters invalidados.
+  // true si otro cluster conserva copia (=> S).
+  bool acquire(int node, uint64_t base, bool exclusive, bool needs_data, uint8_t words);
+  // Flush de una línea del nodo a su memoria home
+  void write_back(int node, uint64_t base);
+  // DMA: snoop a cada cluster con copia; true si alguno la tenía
+  bool dma_snoop(BusMsg type, uint64_t base, uint8_t words);
+
+  NodeStats stats(int node) const;
+  size_t tracked_lines() const;
+
+private:
+  struct Entry {
+    uint64_t sharers = 0;    // bit n: el cluster n puede tener copia
+    bool exclusive = false;  // un solo cluster, posiblemente en E/M
+  };
+
+  bool remote_(int node, uint64_t base) const;
+  void charge_(int node, uint64_t base, uint64_t local, uint64_t remote);
+
+  SharedMemory& shm_;
+  std::vector<MesiInterconnect*> buses_;
+  mutable std::recursive_mutex mtx_;
+  std::unordered_map<uint64_t, Entry> dir_;
+  std::vector<NodeStats> stats_;
+};
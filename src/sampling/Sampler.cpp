@@ -0,0 +1,309 @@
+#include "Sampler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#include "Timing.hpp"
+#include "../MesiInterconnect.hpp"
+#include "../memory/SharedMemory.h"
+#include "../memory/cache/mesi/MESICache.hpp"
+#include "../../PE/pe/pe.hpp"
+
+static_assert(MESICache::kWays == 2, "la réplica de LRU asume 2 vías (como Set::lru)");
+
+// ---------------- Réplica funcional de tags/LRU de cada L1$ ----------------
+// Ve los mismos accesos que las L1$ (en ambos modos) y aplica la coherencia de
+// forma abstracta: una escritura invalida las copias ajenas y una lectura baja
+// a "limpia" la copia escrita por otro PE (M -> S con write-back). Usa la misma
+// función de índice que las L1$; con índice sesgado la réplica es de un solo
+// set por línea (el de la vía 0): aproxima el contenido, no la ubicación.
+class SampledRunner::Warmer {
+public:
+  Warmer(size_t pes, IndexFn f) : sets_(pes), fn_(f) {}
+
+  void access(size_t pe, uint64_t addr, bool write) {
+    const uint64_t line = addr & ~uint64_t(MESICache::kLineSize - 1);
+    WSet& S = sets_[pe][set_of(line)];
+    int w = find_(S, line);
+    if (w < 0) {
+      w = S.way[0].valid ? (S.way[1].valid ? S.lru : 1) : 0;
+      S.way[w] = Way{true, false, line};
+    }
+    S.lru = (w == 0) ? 1 : 0;
+    if (write) S.way[w].dirty = true;
+
+    for (size_t q = 0; q < sets_.size(); ++q) {
+      if (q == pe) continue;
+      WSet& O = sets_[q][set_of(line)];
+      const int ow = find_(O, line);
+      if (ow < 0) continue;
+      if (write) O.way[ow].valid = false;
+      else       O.way[ow].dirty = false;
+    }
+  }
+
+  // Instala la réplica en la L1$ (vaciada) del PE 'pe', con datos de memoria.
+  void install(size_t pe, MESICache& c, const SharedMemory& shm) const {
+    for (uint32_t s = 0; s < MESICache::kSets; ++s) {
+      const WSet& S = sets_[pe][s];
+      for (int w : {int(S.lru), 1 - int(S.lru)}) {   // de LRU a MRU
+        const Way& W = S.way[w];
+        if (!W.valid) continue;
+        MESI st = W.dirty ? MESI::M : (shared_(pe, W.line) ? MESI::S : MESI::E);
+        uint8_t data[MESICache::kLineSize];
+        for (int o = 0; o < MESICache::kLineSize; o += 8) {
+          const uint64_t u = shm.load64(W.line + o);
+          std::memcpy(data + o, &u, 8);
+        }
+        c.warmLine(W.line, data, st);
+      }
+    }
+  }
+
+private:
+  struct Way  { bool valid = false, dirty = false; uint64_t line = 0; };
+  struct WSet { Way way[MESICache::kWays]; uint8_t lru = 0; };  // lru = vía víctima
+
+  uint32_t set_of(uint64_t line) const { return MESICache::setIndex(fn_, line); }
+  static int find_(const WSet& S, uint64_t line) {
+    for (int w = 0; w < MESICache::kWays; ++w)
+      if (S.way[w].valid && S.way[w].line == line) return w;
+    return -1;
+  }
+  bool shared_(size_t pe, uint64_t line) const {
+    for (size_t q = 0; q < sets_.size(); ++q)
+      if (q != pe && find_(sets_[q][set_of(line)], line) >= 0) return true;
+    return false;
+  }
+
+  std::vector<std::array<WSet, MESICache::kSets>> sets_;
+  IndexFn fn_;
+};
+
+// ---------------- Puerto de cada PE: funcional o detallado ----------------
+class SampledRunner::Port : public IMemoryPort {
+public:
+  Port(size_t pe, IMemoryPort* detailed, SharedMemory& shm)
+  : pe_(pe), det_(detailed), shm_(shm) {}
+
+  bool     functional = false;
+  Warmer*  warm = nullptr;
+  uint64_t accesses = 0;   // accesos del PE en modo detallado (denominador de la tasa de miss)
+
+  uint64_t load64(uint64_t addr) override {
+    touch_(addr, false);
+    if (!functional) { ++accesses; return det_->load64(addr); }
+    return shm_.load64(addr);
+  }
+  void store64(uint64_t addr, uint64_t val) override {
+    touch_(addr, true);
+    if (!functional) { ++accesses; det_->store64(addr, val); return; }
+    shm_.store64(addr, val);
+  }
+  uint64_t cas64(uint64_t addr, uint64_t expected, uint64_t desired) override {
+    touch_(addr, true);
+    if (!functional) { ++accesses; return det_->cas64(addr, expected, desired); }
+    return shm_.cas64(addr, expected, desired);
+  }
+  uint64_t fetch_add64(uint64_t addr, uint64_t delta) override {
+    touch_(addr, true);
+    if (!functional) { ++accesses; return det_->fetch_add64(addr, delta); }
+    uint64_t old = shm_.load64(addr), seen;
+    while ((seen = shm_.cas64(addr, old, old + delta)) != old) old = seen;
+    return old;
+  }
+  uint64_t fetch_fadd64(uint64_t addr, double delta) override {
+    touch_(addr, true);
+    if (!functional) { ++accesses; return det_->fetch_fadd64(addr, delta); }
+    uint64_t old = shm_.load64(addr), seen;
+    for (;;) {
+      double d; std::memcpy(&d, &old, 8); d += delta;
+      uint64_t nv; std::memcpy(&nv, &d, 8);
+      if ((seen = shm_.cas64(addr, old, nv)) == old) return old;
+      old = seen;
+    }
+  }
+  // LL/SC funcional: el SC es un CAS contra el valor leído por el LL (no detecta
+  // ABA, irrelevante para los bucles de reducción del ISA).
+  uint64_t ll64(uint64_t addr) override {
+    touch_(addr, false);
+    if (!functional) { ++accesses; return det_->ll64(addr); }
+    resv_ = true; resv_addr_ = addr; resv_val_ = shm_.load64(addr);
+    return resv_val_;
+  }
+  bool sc64(uint64_t addr, uint64_t val) override {
+    touch_(addr, true);
+    if (!functional) { ++accesses; return det_->sc64(addr, val); }
+    const bool ok = resv_ && resv_addr_ == addr && shm_.cas64(addr, resv_val_, val) == resv_val_;
+    resv_ = false;
+    return ok;
+  }
+  void wait_eq64(uint64_t addr, uint64_t val) override {
+    if (!functional) { det_->wait_eq64(addr, val); return; }
+    IMemoryPort::wait_eq64(addr, val);
+  }
+  void service() override { if (!functional) det_->service(); }
+
+private:
+  void touch_(uint64_t addr, bool write) { if (warm) warm->access(pe_, addr, write); }
+
+  size_t pe_;
+  IMemoryPort* det_;
+  SharedMemory& shm_;
+  bool     resv_ = false;
+  uint64_t resv_addr_ = 0, resv_val_ = 0;
+};
+
+SampledRunner::SampledRunner(SharedMemory& shm, MesiInterconnect& bus,
+                             const std::vector<PE*>& pes,
+                             const std::vector<IMemoryPort*>& detailed)
+: shm_(shm), bus_(bus), pes_(pes), detailed_(detailed) {
+  for (size_t k = 0; k < pes_.size(); ++k)
+    ports_.push_back(std::make_unique<Port>(k, k < detailed_.size() ? detailed_[k] : nullptr, shm_));
+}
+
+SampledRunner::~SampledRunner() = default;
+
+bool SampledRunner::all_halted_() const {
+  for (const PE* pe : pes_) if (!pe->halted()) return false;
+  return true;
+}
+
+/* run_phase_(steps, quantum)
+ * --------------------------
+ * Avanza cada PE 'steps' instrucciones (o hasta HALT) intercalándolos en turnos
+ * de 'quantum'. Devuelve las instrucciones ejecutadas entre todos.
+ */
+uint64_t SampledRunner::run_phase_(uint64_t steps, unsigned quantum) {
+  std::vector<uint64_t> left(pes_.size(), steps);
+  uint64_t total = 0;
+  for (bool progress = steps > 0; progress;) {
+    progress = false;
+    for (size_t k = 0; k < pes_.size(); ++k) {
+      if (!left[k] || pes_[k]->halted()) continue;
+      const uint64_t n = pes_[k]->run(std::min<uint64_t>(quantum, left[k]));
+      left[k] = n ? left[k] - n : 0;
+      total += n;
+      progress = true;
+    }
+  }
+  return total;
+}
+
+void SampledRunner::to_functional_() {
+  if (functional_) return;
+  bus_.drain_caches();
+  for (auto& p : ports_) p->functional = true;
+  functional_ = true;
+}
+
+void SampledRunner::to_detailed_() {
+  if (!functional_) return;
+  for (auto& p : ports_) p->functional = false;
+  if (warmer_) {
+    for (size_t k = 0; k < pes_.size(); ++k)
+      for (MESICache* c : bus_.caches())
+        if (c && c->id() == pes_[k]->id()) warmer_->install(k, *c, shm_);
+  }
+  functional_ = false;
+}
+
+// Contadores que mide cada ventana (suma de las L1$ y del bus)
+struct WindowSnap {
+  uint64_t misses = 0, accesses = 0, mem_reads = 0, c2c = 0, upgrades = 0, writebacks = 0;
+};
+
+static Estimate estimate(const std::vector<double>& v, double z) {
+  Estimate e;
+  if (v.empty()) return e;
+  for (double x : v) e.mean += x;
+  e.mean /= double(v.size());
+  if (v.size() > 1) {
+    double ss = 0.0;
+    for (double x : v) ss += (x - e.mean) * (x - e.mean);
+    e.half = z * std::sqrt(ss / double(v.size() - 1) / double(v.size()));
+  }
+  return e;
+}
+
+/* run(cfg, out)
+ * -------------
+ * Unidades de 'period' instrucciones por PE: avance funcional, calentamiento en
+ * detalle y ventana medida. Con period == warmup + window no hay avance
+ * funcional: es la simulación detallada completa con el mismo informe
+ * (referencia para validar el muestreo).
+ */
+bool SampledRunner::run(const SamplingConfig& cfg, SamplingReport& out, std::string* err) {
+  auto fail = [&](const std::string& why) { if (err) *err = why; return false; };
+  if (!cfg.window || !cfg.quantum || cfg.warmup + cfg.window > cfg.period)
+    return fail("se requiere window > 0, quantum > 0 y warmup + window <= period");
+  for (size_t k = 0; k < pes_.size(); ++k) {
+    if (k >= detailed_.size() || !detailed_[k]) return fail("falta el puerto detallado de un PE");
+    for (const Instr& I : pes_[k]->program())
+      if (I.op == Op::WAIT || I.op == Op::BARRIER)
+        return fail("WAIT/BARRIER no se admiten en simulación muestreada");
+  }
+
+  const IndexFn fn = bus_.caches().empty() ? IndexFn::Bits : bus_.caches()[0]->indexFunction();
+  warmer_ = cfg.functional_warming ? std::make_unique<Warmer>(pes_.size(), fn) : nullptr;
+  for (size_t k = 0; k < pes_.size(); ++k) {
+    ports_[k]->warm = warmer_.get();
+    ports_[k]->functional = false;
+    pes_[k]->set_memory_port(ports_[k].get());
+  }
+  functional_ = false;
+
+  auto snap = [&] {
+    WindowSnap s;
+    for (const MESICache* c : bus_.caches()) if (c) s.misses += c->stats().cache_misses;
+    for (const auto& p : ports_) s.accesses += p->accesses;
+    const auto& b = bus_.stats();
+    s.mem_reads = b.mem_reads; s.c2c = b.flush_forwards;
+    s.upgrades = b.busUpgr;    s.writebacks = b.flush;
+    return s;
+  };
+
+  out = SamplingReport{};
+  std::vector<double> miss_rate, cpi;
+  const uint64_t ff = cfg.period - cfg.warmup - cfg.window;
+  while (!all_halted_()) {
+    if (ff) {
+      to_functional_();
+      out.instructions += run_phase_(ff, cfg.quantum);
+      if (all_halted_()) break;
+    }
+    to_detailed_();
+    const uint64_t warm = run_phase_(cfg.warmup, cfg.quantum);
+    const WindowSnap a = snap();
+    const uint64_t n = run_phase_(cfg.window, cfg.quantum);
+    const WindowSnap b = snap();
+    out.instructions += warm + n;
+    out.detailed_instructions += warm + n;
+    if (!n) continue;
+
+    ++out.windows;
+    if (b.accesses > a.accesses)
+      miss_rate.push_back(double(b.misses - a.misses) / double(b.accesses - a.accesses));
+    cpi.push_back(double(timing::cycles(n, b.mem_reads - a.mem_reads, b.c2c - a.c2c,
+                                        b.upgrades - a.upgrades, b.writebacks - a.writebacks)) /
+                  double(n));
+  }
+
+  // Resultados a memoria y cada PE vuelve a su puerto detallado
+  bus_.drain_caches();
+  for (size_t k = 0; k < pes_.size(); ++k) {
+    ports_[k]->functional = false;
+    ports_[k]->warm = nullptr;
+    pes_[k]->set_memory_port(detailed_[k]);
+  }
+  functional_ = false;
+
+  out.miss_rate = estimate(miss_rate, cfg.z);
+  out.cpi       = estimate(cpi, cfg.z);
+  const double per_pe = pes_.empty() ? 0.0 : double(out.instructions) / double(pes_.size());
+  out.cycles.mean = out.cpi.mean * per_pe;
+  out.cycles.half = out.cpi.half * per_pe;
+  return true;
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class SharedMemory;
+class MesiInterconnect;
+class IMemoryPort;
+class PE;
+
+/*
+ * Sampler.hpp
+ * ===========
+ * Simulación muestreada estilo SMARTS: en vez de pasar cada acceso por las L1$
+ * MESI, el programa avanza casi todo el tiempo en modo funcional (los PEs leen y
+ * escriben SharedMemory directamente) y cada 'period' instrucciones por PE corre
+ * una ventana corta en detalle (MESICache + MesiInterconnect):
+ *
+ *   | avance funcional ........ | calentamiento | ventana medida | avance ...
+ *   |<------------------------ period (U) -------------------------->|
+ *                                 'warmup'        'window' (W)
+ *
+ * Por cada ventana se mide la tasa de miss (misses / accesos del PE) y el CPI
+ * según sampling/Timing.hpp; el resultado es la media de las ventanas con un
+ * intervalo de confianza normal (media ± z·s/√n) y los ciclos se extrapolan
+ * como CPI · instrucciones por PE.
+ *
+ * Cambio de modo (con los PEs detenidos):
+ *   - detallado -> funcional: MesiInterconnect::drain_caches() escribe las líneas
+ *     en M y vacía las L1$; la memoria queda como única copia.
+ *   - funcional -> detallado: con calentamiento funcional, una réplica de tags/LRU
+ *     de cada L1$ (con invalidación entre PEs en escrituras) seguida durante el
+ *     avance se instala en las L1$ con datos de memoria (M si la escribió, S si la
+ *     comparte otro PE, E si no). Sin él las L1$ arrancan frías y el calentamiento
+ *     en detalle ('warmup') es lo único que las llena.
+ *
+ * Los PEs se intercalan en el hilo llamador en turnos de 'quantum' instrucciones
+ * (resultado determinista). Por eso no se admiten programas con WAIT/BARRIER:
+ * un PE bloqueado esperando a otro no cede el hilo. Los atómicos y LL/SC sí
+ * funcionan en ambos modos.
+ */
+struct SamplingConfig {
+  uint64_t period  = 20000;  // U: instrucciones por PE de cada unidad de muestreo
+  uint64_t window  = 1000;   // W: instrucciones por PE medidas en detalle
+  uint64_t warmup  = 500;    // instrucciones por PE en detalle (no medidas) antes de W
+  unsigned quantum = 16;     // instrucciones por turno al intercalar PEs
+  bool     functional_warming = true;  // réplica de tags/LRU durante el avance
+  double   z = 1.96;         // cuantil normal del intervalo (1.96 => 95%)
+};
+
+// Estimación "media ± half" (half = 0 con menos de dos ventanas)
+struct Estimate {
+  double mean = 0.0, half = 0.0;
+};
+
+struct SamplingReport {
+  uint64_t instructions = 0;           // total ejecutado (todos los PEs)
+  uint64_t detailed_instructions = 0;  // de ellas en detalle (calentamiento + ventanas)
+  uint64_t windows = 0;                // ventanas medidas
+  Estimate miss_rate;                  // misses L1$ / accesos del PE
+  Estimate cpi;                        // ciclos / instrucción (sampling/Timing.hpp)
+  Estimate cycles;                     // ciclos por PE extrapolados (CPI · instr / PEs)
+};
+
+class SampledRunner {
+public:
+  // detailed[k]: puerto detallado (p.ej. MesiMemoryPort) del PE k, cuya L1$ está
+  // conectada a 'bus'. Los PEs ya deben tener programa y registros cargados.
+  SampledRunner(SharedMemory& shm, MesiInterconnect& bus, const std::vector<PE*>& pes,
+                const std::vector<IMemoryPort*>& detailed);
+  ~SampledRunner();
+
+  // Corre hasta que todos los PEs lleguen a HALT. Al volver las L1$ están
+  // vaciadas (resultados en SharedMemory) y cada PE tiene su puerto detallado.
+  // false (y *err) si la configuración o el programa no son admisibles.
+  bool run(const SamplingConfig& cfg, SamplingReport& out, std::string* err = nullptr);
+
+private:
+  class Port;
+  class Warmer;
+
+  uint64_t run_phase_(uint64_t steps, unsigned quantum);
+  void to_functional_();
+  void to_detailed_();
+  bool all_halted_() const;
+
+  SharedMemory& shm_;
+  MesiInterconnect& bus_;
+  std::vector<PE*> pes_;
+  std::vector<IMemoryPort*> detailed_;
+  std::unique_ptr<Warmer> warmer_;
+  std::vector<std::unique_ptr<Port>> ports_;
+  bool functional_ = false;
+};
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+
+/*
+ * Timing.hpp
+ * ==========
+ * Modelo de ciclos mínimo para estimar CPI (el simulador es funcional: el bus
+ * síncrono no tiene noción de tiempo). Cada evento del bus suma una latencia
+ * fija sobre el CPI base; los valores son de orden de magnitud (L1$ con bus
+ * snoopy y DRAM), no de un procesador concreto.
+ *
+ *   ciclos = instr * kInstrCycles
+ *          + lecturas de DRAM * kMemLineCycles
+ *          + datos servidos por Flush de otra L1$ * kCacheToCacheCycles
+ *          + BusUpgr * kBusUpgrCycles + Flush (write-back) * kWriteBackCycles
+ */
+namespace timing {
+
+constexpr uint64_t kInstrCycles        = 1;    // ALU y hit de L1$
+constexpr uint64_t kMemLineCycles      = 100;  // miss servido por SharedMemory
+constexpr uint64_t kCacheToCacheCycles = 40;   // miss servido por el Flush de otra L1$
+constexpr uint64_t kBusUpgrCycles      = 20;   // S->M: invalidar copias ajenas
+constexpr uint64_t kWriteBackCycles    = 20;   // Flush de una línea en M
+
+// NUMA (numa/NumaDirectory.hpp): el directorio global cobra estas latencias a
+// cada pedido que sale del bus local, según el nodo home de la línea.
+constexpr uint64_t kDirLookupCycles       = 10;   // consulta al directorio (home local)
+constexpr uint64_t kRemoteDirLookupCycles = 60;   // ...con home en otro nodo
+constexpr uint64_t kRemoteMemLineCycles   = 250;  // línea leída de la memoria de otro nodo
+constexpr uint64_t kRemoteCacheCycles     = 180;  // datos sucios traídos de otro cluster
+constexpr uint64_t kRemoteInvCycles       = 60;   // invalidar las copias de otro cluster
+constexpr uint64_t kRemoteWriteBackCycles = 60;   // write-back a la memoria de otro nodo
+
+inline uint64_t cycles(uint64_t instr, uint64_t mem_reads, uint64_t c2c,
+                       uint64_t upgrades, uint64_t writebacks) {
+  return instr * kInstrCycles + mem_reads * kMemLineCycles + c2c * kCacheToCacheCycles +
+         upgrades * kBusUpgrCycles + writebacks * kWriteBackCycles;
+}
+
+}  // namespace timing
@@ -0,0 +1,117 @@
+#include "Barriers.hpp"
+
+static constexpr uint64_t kLine = 32;
+
+static int log2_ceil(int P) {
+  int r = 0;
+  while ((1 << r) < P) ++r;
+  return r;
+}
+
+bool parse_barrier_kind(const std::string& s, BarrierKind& out) {
+  if (s == "central")     out = BarrierKind::Central;
+  else if (s == "tree")   out = BarrierKind::Tree;
+  else if (s == "dissem") out = BarrierKind::Dissem;
+  else if (s == "hw")     out = BarrierKind::Hw;
+  else return false;
+  return true;
+}
+
+const char* barrier_kind_name(BarrierKind k) {
+  switch (k) {
+    case BarrierKind::Central: return "central";
+    case BarrierKind::Tree:    return "tree";
+    case BarrierKind::Dissem:  return "dissem";
+    case BarrierKind::Hw:      return "hw";
+  }
+  return "?";
+}
+
+/* Layout de cada región (una línea por palabra):
+ *  Central/Hw : [0] contador, [1] liberación (= kBarrierReleaseOffset)
+ *  Tree       : [i] llegada del nodo i, [P+i] wake del nodo i
+ *  Dissem     : [(par*P + i)*R + k] flag de la ronda k del PE i, paridad par
+ */
+uint64_t barrier_region_bytes(BarrierKind k, int P) {
+  switch (k) {
+    case BarrierKind::Central:
+    case BarrierKind::Hw:     return 2 * kLine;
+    case BarrierKind::Tree:   return uint64_t(2 * P) * kLine;
+    case BarrierKind::Dissem: return uint64_t(2 * P * (log2_ceil(P) ? log2_ceil(P) : 1)) * kLine;
+  }
+  return 0;
+}
+
+/* emit_barrier(...)
+ * -----------------
+ * Genera el código de un episodio. Convención de WAIT: espera [Ra] == Rd.
+ */
+void emit_barrier(Program& p, BarrierKind k, uint64_t base, int pe, int P,
+                  uint64_t episode, BarrierRegs r) {
+  auto li = [&](uint8_t d, uint64_t v) { p.push_back({Op::LI, d, 0, 0, static_cast<int64_t>(v)}); };
+
+  switch (k) {
+    case BarrierKind::Hw: {
+      li(r.t0, base);
+      p.push_back({Op::BARRIER, 0, r.t0, 0, P});
+    } break;
+
+    case BarrierKind::Central: {
+      const uint64_t cnt = base, rel = base + kLine;
+      li(r.t0, cnt);
+      li(r.t1, 1);
+      p.push_back({Op::FETCH_ADD, r.t1, r.t0, r.t1, 0}); // t1 = llegados antes que yo
+      li(r.t2, uint64_t(P - 1));
+      p.push_back({Op::SUB, r.t1, r.t1, r.t2, 0});       // 0 => soy el último
+      p.push_back({Op::JNZ, r.t1, 0, 0, 6});             // no último => a la espera
+      li(r.t1, 0);
+      p.push_back({Op::STORE, r.t1, r.t0, 0, 0});        // contador = 0 (antes de liberar)
+      li(r.t0, rel);
+      li(r.t1, episode);
+      p.push_back({Op::STORE, r.t1, r.t0, 0, 0});        // liberación = episodio
+      // espera (el último la supera con un hit inmediato)
+      li(r.t0, rel);
+      li(r.t1, episode);
+      p.push_back({Op::WAIT, r.t1, r.t0, 0, 0});
+    } break;
+
+    case BarrierKind::Tree: {
+      auto arrive = [&](int i) { return base + uint64_t(i) * kLine; };
+      auto wake   = [&](int i) { return base + uint64_t(P + i) * kLine; };
+      const int c1 = 2 * pe + 1, c2 = 2 * pe + 2;
+      li(r.t1, episode);
+      for (int c : {c1, c2}) {                           // esperar a los hijos
+        if (c >= P) continue;
+        li(r.t0, arrive(c));
+        p.push_back({Op::WAIT, r.t1, r.t0, 0, 0});
+      }
+      if (pe != 0) {                                     // avisar al padre y dormir
+        li(r.t0, arrive(pe));
+        p.push_back({Op::STORE, r.t1, r.t0, 0, 0});
+        li(r.t0, wake(pe));
+        p.push_back({Op::WAIT, r.t1, r.t0, 0, 0});
+      }
+      for (int c : {c1, c2}) {                           // despertar a los hijos
+        if (c >= P) continue;
+        li(r.t0, wake(c));
+        p.push_back({Op::STORE, r.t1, r.t0, 0, 0});
+      }
+    } break;
+
+    case BarrierKind::Dissem: {
+      const int R = log2_ceil(P);
+      const int par = int(episode & 1);
+      auto flag = [&](int i, int round) {
+        return base + uint64_t((par * P + i) * R + round) * kLine;
+      };
+      li(r.t1, episode);
+      for (int round = 0; round < R; ++round) {
+        const int partner = (pe + (1 << round)) % P;
+        li(r.t0, flag(partner, round));
+        p.push_back({Op::STORE, r.t1, r.t0, 0, 0});
+        li(r.t0, flag(pe, round));
+        p.push_back({Op::WAIT, r.t1, r.t0, 0, 0});
+      }
+    } break;
+  }
+}
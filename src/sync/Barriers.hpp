@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "../../PE/pe/pe.hpp"
+
+/*
+ * Barriers.hpp
+ * ============
+ * Biblioteca de barreras simuladas: generan código mini-ISA que sincroniza
+ * PEs únicamente a través de memoria coherente (loads/stores/atómicos + WAIT).
+ *
+ * Algoritmos:
+ *  - Central : sense-reversing centralizada (contador con FETCH_ADD + palabra de
+ *              liberación). El "sentido" es el número de episodio (no hay ABA).
+ *  - Tree    : árbol binario estático; llegada hacia la raíz (flag por nodo) y
+ *              despertar hacia las hojas (flag de wake por nodo).
+ *  - Dissem  : dissemination (ceil(log2 P) rondas; en la ronda k el PE i avisa a
+ *              (i+2^k) mod P). Dos juegos de flags alternados por paridad de episodio.
+ *  - Hw      : instrucción BARRIER del ISA (misma semántica que Central, en 1 op).
+ *
+ * Todas las esperas usan WAIT, que en MesiMemoryPort duerme hasta una invalidación
+ * en lugar de girar sobre hits.
+ *
+ * Cada flag/contador vive en su propia línea de 32 B (sin false sharing).
+ * Como el código se genera por PE y por episodio, las direcciones y el número de
+ * episodio se cargan con LI (no se reservan registros permanentes).
+ */
+enum class BarrierKind { Central, Tree, Dissem, Hw };
+
+bool        parse_barrier_kind(const std::string& s, BarrierKind& out);
+const char* barrier_kind_name(BarrierKind k);
+
+// Bytes de memoria compartida que necesita la barrera para P PEs (múltiplo de 32).
+uint64_t barrier_region_bytes(BarrierKind k, int P);
+
+// Registros temporales que el código generado puede pisar.
+struct BarrierRegs { uint8_t t0 = 0, t1 = 4, t2 = 6; };
+
+// Emite en 'p' el código de UN episodio (episode >= 1, creciente) para el PE 'pe'.
+// 'base' es la dirección de la región (alineada a 32 B, inicializada a 0).
+void emit_barrier(Program& p, BarrierKind k, uint64_t base, int pe, int P,
+                  uint64_t episode, BarrierRegs r = {});
@@ -0,0 +1,52 @@
+#include "CounterFields.hpp"
+
+namespace telemetry {
+namespace {
+
+#define MESI_FIELD(n, h, f) { n, h, [](const MESICache::CacheMetrics& m) -> uint64_t { return uint64_t(m.f); } }
+const CacheField kCacheFields[] = {
+  MESI_FIELD("loads",            "Loads locales (intentos)",                  loads),
+  MESI_FIELD("stores",           "Stores locales (intentos)",                 stores),
+  MESI_FIELD("misses",           "Misses totales",                            cache_misses),
+  MESI_FIELD("miss_compulsory",  "Misses de primera referencia",              miss_compulsory),
+  MESI_FIELD("miss_capacity",    "Misses de capacidad",                       miss_capacity),
+  MESI_FIELD("miss_conflict",    "Misses de conflicto",                       miss_conflict),
+  MESI_FIELD("miss_coherence",   "Misses por invalidacion de coherencia",     miss_coherence),
+  MESI_FIELD("invalidations",    "Invalidaciones recibidas por snoop",        invalidations),
+  MESI_FIELD("bus_rd",           "BusRd emitidos",                            busRd),
+  MESI_FIELD("bus_rdx",          "BusRdX emitidos",                           busRdX),
+  MESI_FIELD("bus_upgr",         "BusUpgr emitidos",                          busUpgr),
+  MESI_FIELD("flush",            "Flush (write-back) emitidos",               flush),
+  MESI_FIELD("bus_writes",       "BusWr emitidos (write-through, write-around, WC parcial)", bus_writes),
+  MESI_FIELD("nt_stores",        "Stores no temporales",                      nt_stores),
+  MESI_FIELD("nt_lines",         "Lineas completas escritas con BusWrLine",   nt_lines),
+  MESI_FIELD("atomics",          "Operaciones atomicas",                      atomics),
+  MESI_FIELD("cas_failures",     "CAS fallidos",                              cas_failures),
+  MESI_FIELD("sc_failures",      "SC fallidos",                               sc_failures),
+  MESI_FIELD("atomic_bus_ops",   "Transacciones para obtener M en atomicos",  atomic_bus_ops),
+  MESI_FIELD("waits",            "Esperas WAIT/BARRIER",                      waits),
+  MESI_FIELD("wait_sleeps",      "Veces que un WAIT durmio",                  wait_sleeps),
+};
+#undef MESI_FIELD
+
+#define BUS_FIELD(n, f) { n, [](const MesiInterconnect::BusStats& s) -> uint64_t { return s.f; } }
+const BusField kBusTx[] = {
+  BUS_FIELD("BusRd", busRd), BUS_FIELD("BusRdX", busRdX), BUS_FIELD("BusUpgr", busUpgr),
+  BUS_FIELD("Inv", inv),     BUS_FIELD("Flush", flush),   BUS_FIELD("BusWr", busWr),
+  BUS_FIELD("BusWrLine", busWrLine),
+};
+const BusField kBusOther[] = {
+  BUS_FIELD("data_responses", data_responses), BUS_FIELD("shared_responses", shared_responses),
+  BUS_FIELD("flush_forwards", flush_forwards), BUS_FIELD("mem_reads", mem_reads),
+  BUS_FIELD("mem_writes", mem_writes),         BUS_FIELD("data_bytes", data_bytes),
+  BUS_FIELD("tlb_shootdowns", tlb_shootdowns),
+};
+#undef BUS_FIELD
+
+}  // namespace
+
+std::span<const CacheField> cache_fields() { return kCacheFields; }
+std::span<const BusField> bus_tx_fields() { return kBusTx; }
+std::span<const BusField> bus_other_fields() { return kBusOther; }
+
+}  // namespace telemetry
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <span>
+
+#include "../MesiInterconnect.hpp"
+#include "../memory/cache/mesi/MESICache.hpp"
+
+/*
+ * CounterFields.hpp
+ * =================
+ * Tablas de contadores que publican MetricsExporter (en vivo) e
+ * IntervalSampler (serie temporal): nombre estable, ayuda y lector. Un
+ * contador agregado aquí aparece en las dos salidas con el mismo nombre.
+ */
+namespace telemetry {
+
+struct CacheField {
+  const char* name;
+  const char* help;
+  uint64_t (*get)(const MESICache::CacheMetrics&);
+};
+
+struct BusField {
+  const char* name;
+  uint64_t (*get)(const MesiInterconnect::BusStats&);
+};
+
+std::span<const CacheField> cache_fields();     // por PE (loads, misses, bus_rd, ...)
+std::span<const BusField>   bus_tx_fields();    // transacciones por tipo: BusRd, BusRdX, ...
+std::span<const BusField>   bus_other_fields(); // respuestas, memoria, bytes de datos, ...
+
+}  // namespace telemetry
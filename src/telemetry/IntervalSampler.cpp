@@ -0,0 +1,143 @@
+#include "IntervalSampler.hpp"
+#include "CounterFields.hpp"
+#include "../sampling/Timing.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+bool parse_timeline_every(const std::string& s, TimelineConfig& cfg) {
+  const bool cycles = !s.empty() && s.back() == 'c';
+  const std::string num = cycles ? s.substr(0, s.size() - 1) : s;
+  if (num.empty() || num.find_first_not_of("0123456789") != std::string::npos) return false;
+  try {
+    cfg.every = std::stoull(num);
+  } catch (const std::exception&) {
+    return false;
+  }
+  cfg.unit = cycles ? TimelineConfig::Unit::Cycles : TimelineConfig::Unit::Accesses;
+  return cfg.every >= 1;
+}
+
+IntervalSampler::IntervalSampler(const MesiInterconnect& bus, const TimelineConfig& cfg)
+  : bus_(bus), cfg_(cfg), t0_(std::chrono::steady_clock::now()) {
+  if (cfg_.every == 0) cfg_.every = 1;
+}
+
+IntervalSampler::~IntervalSampler() { close(); }
+
+uint64_t IntervalSampler::pe_cycles(const MESICache& c) {
+  const MESICache::CacheMetrics& m = c.stats();
+  uint64_t cyc = uint64_t(m.rw_accesses) * timing::kInstrCycles;
+  for (int k = 0; k < MESICache::kLatKinds; ++k) cyc += m.lat_cycles[k].sum();
+  return cyc;
+}
+
+uint64_t IntervalSampler::units(const MESICache& c) const {
+  return cfg_.unit == TimelineConfig::Unit::Cycles ? pe_cycles(c) : uint64_t(c.stats().rw_accesses);
+}
+
+uint64_t IntervalSampler::progress() const {
+  uint64_t p = 0;
+  for (const MESICache* c : bus_.caches())
+    if (c) p += units(*c);
+  return p;
+}
+
+/* open(path) -----------------------------------------------------------------
+ * El lote de los taps se fija aquí, con las L1$ ya conectadas: entre todos los
+ * PEs quedan a lo sumo K/8 unidades sin publicar.
+ * ------------------------------------------------------------------------- */
+bool IntervalSampler::open(const std::string& path) {
+  std::lock_guard<std::mutex> lk(mtx_);
+  if (f_) return true;
+  f_ = std::fopen(path.c_str(), "wb");
+  if (!f_) {
+    err_ = path + ": " + std::strerror(errno);
+    return false;
+  }
+  uint64_t pes = 0;
+  for (const MESICache* c : bus_.caches()) pes += (c != nullptr);
+  batch_ = std::max<uint64_t>(1, cfg_.every / (8 * std::max<uint64_t>(1, pes)));
+  buf_.reserve(cfg_.buffer_bytes + 4096);
+  t0_ = std::chrono::steady_clock::now();
+  published_.store(progress(), std::memory_order_relaxed);
+  sample_();
+  return true;
+}
+
+/* advance(units) -------------------------------------------------------------
+ * Una muestra por cada cruce de un múltiplo de K. Si un solo avance cruzó
+ * varios, sale una (con los valores actuales) y el resto se cuenta en skipped_.
+ * ------------------------------------------------------------------------- */
+bool IntervalSampler::advance(uint64_t units) {
+  const uint64_t p = published_.fetch_add(units, std::memory_order_relaxed) + units;
+  const uint64_t crossed = p / cfg_.every - (p - units) / cfg_.every;
+  if (!crossed) return false;
+  std::lock_guard<std::mutex> lk(mtx_);
+  if (!f_) return false;
+  skipped_ += crossed - 1;
+  sample_();
+  return true;
+}
+
+void IntervalSampler::sample_() {
+  const uint64_t us = uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(
+                                   std::chrono::steady_clock::now() - t0_).count());
+  uint64_t acc = 0, cyc = 0;
+  std::string pes;
+  for (const MESICache* c : bus_.caches()) {
+    if (!c) continue;
+    const MESICache::CacheMetrics& m = c->stats();
+    const uint64_t a = uint64_t(m.rw_accesses), y = pe_cycles(*c);
+    acc += a;
+    cyc += y;
+    pes += pes.empty() ? "{" : ",{";
+    pes += "\"pe\":" + std::to_string(c->id()) + ",\"accesses\":" + std::to_string(a) +
+           ",\"cycles\":" + std::to_string(y);
+    for (const auto& f : telemetry::cache_fields()) {
+      pes += ",\"";
+      pes += f.name;
+      pes += "\":" + std::to_string(f.get(m));
+    }
+    pes += "}";
+  }
+
+  const bool in_cycles = cfg_.unit == TimelineConfig::Unit::Cycles;
+  buf_ += "{\"sample\":" + std::to_string(samples_) + ",\"unit\":\"" +
+          (in_cycles ? "cycles" : "accesses") + "\",\"every\":" + std::to_string(cfg_.every) +
+          ",\"host_us\":" + std::to_string(us) +
+          ",\"accesses\":" + std::to_string(acc) + ",\"cycles\":" + std::to_string(cyc) + ",\"pes\":[" +
+          pes + "],\"bus\":{";
+  const auto& bs = bus_.stats();
+  bool first = true;
+  for (const auto& fields : {telemetry::bus_tx_fields(), telemetry::bus_other_fields()})
+    for (const auto& f : fields) {
+      buf_ += first ? "\"" : ",\"";
+      buf_ += f.name;
+      buf_ += "\":" + std::to_string(f.get(bs));
+      first = false;
+    }
+  buf_ += "}}\n";
+  ++samples_;
+  last_ = in_cycles ? cyc : acc;
+  if (buf_.size() >= cfg_.buffer_bytes) flush_();
+}
+
+void IntervalSampler::flush_() {
+  if (buf_.empty()) return;
+  if (f_ && std::fwrite(buf_.data(), 1, buf_.size(), f_) != buf_.size() && err_.empty())
+    err_ = std::string("escritura: ") + std::strerror(errno);
+  bytes_ += buf_.size();
+  ++flushes_;
+  buf_.clear();
+}
+
+void IntervalSampler::close() {
+  std::lock_guard<std::mutex> lk(mtx_);
+  if (!f_) return;
+  if (progress() != last_) sample_();   // totales del final (iguales a cache_stats.csv)
+  flush_();
+  std::fclose(f_);
+  f_ = nullptr;
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+class MESICache;
+class MesiInterconnect;
+
+/*
+ * IntervalSampler
+ * ===============
+ * Serie temporal de los contadores: cache_stats.csv solo trae los totales del
+ * final, así que el arranque en frío, el régimen y la reducción final quedan
+ * mezclados. Este muestreador escribe una instantánea de todos los contadores
+ * por PE y del bus (telemetry/CounterFields.hpp) cada K accesos o cada K
+ * ciclos, en JSON lines (un objeto por línea):
+ *
+ *   {"sample":3,"unit":"accesses","every":1000,"host_us":812,"accesses":3000,
+ *    "cycles":41230,"pes":[{"pe":0,"accesses":750,"cycles":10100,"loads":...},...],
+ *    "bus":{"BusRd":...,...,"data_bytes":...}}
+ *
+ *   unit     = "accesses" o "cycles": en qué se mide K (--timeline-every)
+ *   accesses = RW_Accesses de las L1$ (intentos: un miss cuenta dos veces)
+ *   cycles   = accesos * kInstrCycles + ciclos de las transacciones de la L1$
+ *              (suma de lat_cycles: memoria, Flush, NUMA/NoC/DRAM si están)
+ *
+ * Los contadores son acumulados; cada intervalo sale de la diferencia entre
+ * dos líneas (metrics.py grafica tasa de miss y tráfico del bus así).
+ *
+ * Disparo desde el camino de acceso: no hay hilo que sondee. Cada PE lleva un
+ * TimelineTap (MesiMemoryPort, TraceReplayer) que cuenta su avance localmente y
+ * lo publica con advance() cada batch() unidades (a lo sumo K/8 entre todos los
+ * PEs). El advance() que cruza un múltiplo de K toma la muestra en ese mismo
+ * hilo, bajo el mutex del muestreador; los contadores se leen con loads relaxed,
+ * como MetricsExporter, sin tomar el mutex del bus. Así hay una muestra por
+ * intervalo, a menos de K/8 del límite; solo un acceso que por sí solo salta
+ * varios límites (unidad ciclos con K chico) deja intervalos sin la suya, que
+ * se cuentan en skipped(). La primera muestra es la del arranque; close() agrega
+ * la del final si hubo avance desde la última.
+ *
+ * Buffer acotado: las líneas se juntan en memoria hasta 'buffer_bytes' y se
+ * escriben al archivo en bloque (desde el hilo que tomó la muestra); la memoria
+ * no crece con la duración de la corrida.
+ */
+struct TimelineConfig {
+  enum class Unit { Accesses, Cycles };
+  Unit     unit = Unit::Accesses;
+  uint64_t every = 1000;                 // K
+  size_t   buffer_bytes = size_t(64) << 10;
+};
+
+// "K" (accesos) o "Kc" (ciclos del modelo), K >= 1
+bool parse_timeline_every(const std::string& s, TimelineConfig& cfg);
+
+class IntervalSampler {
+public:
+  IntervalSampler(const MesiInterconnect& bus, const TimelineConfig& cfg);
+  ~IntervalSampler();
+
+  IntervalSampler(const IntervalSampler&) = delete;
+  IntervalSampler& operator=(const IntervalSampler&) = delete;
+
+  // Abre el archivo y escribe la muestra inicial
+  bool open(const std::string& path);
+  // Muestra final (si hubo avance desde la última), vuelca el buffer y cierra
+  void close();
+
+  // Publica 'units' de avance de un PE (desde cualquier hilo). Si el total
+  // cruza un múltiplo de K toma la muestra en el acto (true si lo hizo).
+  bool advance(uint64_t units);
+  // Cada cuántas unidades publica un TimelineTap
+  uint64_t batch() const { return batch_; }
+
+  bool is_open() const { return f_ != nullptr; }
+  const std::string& error() const { return err_; }
+  const TimelineConfig& config() const { return cfg_; }
+
+  uint64_t samples() const { return samples_; }
+  uint64_t skipped() const { return skipped_; }
+  uint64_t bytes_written() const { return bytes_; }
+  uint64_t flushes() const { return flushes_; }
+
+  // Ciclos del modelo de una L1$ (ver arriba), avance de una L1$ y total en la unidad elegida
+  static uint64_t pe_cycles(const MESICache& c);
+  uint64_t units(const MESICache& c) const;
+  uint64_t progress() const;
+
+private:
+  void sample_();
+  void flush_();
+
+  const MesiInterconnect& bus_;
+  TimelineConfig cfg_;
+  uint64_t batch_ = 1;
+  std::chrono::steady_clock::time_point t0_;
+  std::mutex mtx_;                       // muestras, buffer y archivo
+  std::FILE* f_ = nullptr;
+  std::string buf_;
+  std::atomic<uint64_t> published_{0};   // avance publicado por los taps
+  uint64_t last_ = 0;                    // avance en la última muestra
+  uint64_t samples_ = 0, skipped_ = 0, bytes_ = 0, flushes_ = 0;
+  std::string err_;
+};
+
+// Lado del PE: avance de su L1$ visto en el último acceso; publica de a batch()
+// unidades. Lo usa un solo hilo (el del PE).
+class TimelineTap {
+public:
+  void attach(IntervalSampler* s, const MESICache& c) {
+    s_ = s;
+    seen_ = s ? s->units(c) : 0;
+  }
+  explicit operator bool() const { return s_ != nullptr; }
+  void tick(const MESICache& c) {
+    const uint64_t u = s_->units(c);
+    if (u - seen_ < s_->batch()) return;
+    s_->advance(u - seen_);
+    seen_ = u;
+  }
+
+private:
+  IntervalSampler* s_ = nullptr;
+  uint64_t seen_ = 0;
+};
@@ -0,0 +1,193 @@
+#include "MetricsExporter.hpp"
+#include "CounterFields.hpp"
+#include "../MesiInterconnect.hpp"
+#include "../memory/cache/mesi/MESICache.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using telemetry::bus_other_fields;
+using telemetry::bus_tx_fields;
+using telemetry::cache_fields;
+
+MetricsExporter::MetricsExporter(const MesiInterconnect& bus)
+  : bus_(bus), t0_(std::chrono::steady_clock::now()) {}
+
+MetricsExporter::~MetricsExporter() { stop(); }
+
+std::string MetricsExporter::prometheus() const {
+  std::ostringstream os;
+  const auto& caches = bus_.caches();
+  for (const auto& f : cache_fields()) {
+    os << "# HELP mesi_cache_" << f.name << "_total " << f.help << "\n"
+       << "# TYPE mesi_cache_" << f.name << "_total counter\n";
+    for (const MESICache* c : caches)
+      if (c) os << "mesi_cache_" << f.name << "_total{pe=\"" << c->id() << "\"} " << f.get(c->stats()) << "\n";
+  }
+  const auto& bs = bus_.stats();
+  os << "# HELP mesi_bus_transactions_total Transacciones emitidas en el bus\n"
+     << "# TYPE mesi_bus_transactions_total counter\n";
+  for (const auto& f : bus_tx_fields())
+    os << "mesi_bus_transactions_total{type=\"" << f.name << "\"} " << f.get(bs) << "\n";
+  for (const auto& f : bus_other_fields())
+    os << "# TYPE mesi_bus_" << f.name << "_total counter\n"
+       << "mesi_bus_" << f.name << "_total " << f.get(bs) << "\n";
+  os << "# TYPE mesi_uptime_seconds gauge\n"
+     << "mesi_uptime_seconds "
+     << std::chrono::duration<double>(std::chrono::steady_clock::now() - t0_).count() << "\n";
+  return os.str();
+}
+
+std::string MetricsExporter::json() const {
+  std::ostringstream os;
+  os << "{\"uptime_s\":"
+     << std::chrono::duration<double>(std::chrono::steady_clock::now() - t0_).count()
+     << ",\"pes\":[";
+  bool first = true;
+  for (const MESICache* c : bus_.caches()) {
+    if (!c) continue;
+    os << (first ? "" : ",") << "{\"pe\":" << c->id();
+    first = false;
+    for (const auto& f : cache_fields()) os << ",\"" << f.name << "\":" << f.get(c->stats());
+    os << "}";
+  }
+  os << "],\"bus\":{";
+  const auto& bs = bus_.stats();
+  first = true;
+  for (const auto& f : bus_tx_fields())    { os << (first ? "" : ",") << "\"" << f.name << "\":" << f.get(bs); first = false; }
+  for (const auto& f : bus_other_fields()) { os << ",\"" << f.name << "\":" << f.get(bs); }
+  os << "}}\n";
+  return os.str();
+}
+
+#ifdef _WIN32
+
+bool MetricsExporter::start(const std::string&) {
+  err_ = "exportador no soportado en Windows";
+  return false;
+}
+void MetricsExporter::stop() {}
+void MetricsExporter::serve_() {}
+void MetricsExporter::handle_(int) {}
+
+#else
+
+bool MetricsExporter::start(const std::string& endpoint) {
+  if (running()) return true;
+  if (endpoint.rfind("unix:", 0) == 0) {
+    unix_path_ = endpoint.substr(5);
+    sockaddr_un sa{};
+    if (unix_path_.empty() || unix_path_.size() >= sizeof(sa.sun_path)) {
+      err_ = "ruta de socket Unix inválida";
+      return false;
+    }
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sa.sun_family = AF_UNIX;
+    std::strncpy(sa.sun_path, unix_path_.c_str(), sizeof(sa.sun_path) - 1);
+    ::unlink(unix_path_.c_str());
+    if (listen_fd_ < 0 || ::bind(listen_fd_, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) != 0) {
+      err_ = std::string("bind ") + unix_path_ + ": " + std::strerror(errno);
+      if (listen_fd_ >= 0) ::close(listen_fd_);
+      listen_fd_ = -1;
+      return false;
+    }
+  } else if (endpoint.rfind("tcp:", 0) == 0) {
+    const int port = std::atoi(endpoint.c_str() + 4);
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    if (listen_fd_ >= 0) ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);   // sólo localhost
+    sa.sin_port = htons(uint16_t(port));
+    if (listen_fd_ < 0 || ::bind(listen_fd_, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) != 0) {
+      err_ = std::string("bind 127.0.0.1:") + std::to_string(port) + ": " + std::strerror(errno);
+      if (listen_fd_ >= 0) ::close(listen_fd_);
+      listen_fd_ = -1;
+      return false;
+    }
+    socklen_t len = sizeof(sa);
+    ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&sa), &len);
+    port_ = ntohs(sa.sin_port);
+  } else {
+    err_ = "endpoint debe ser tcp:PUERTO o unix:RUTA";
+    return false;
+  }
+
+  if (::listen(listen_fd_, 8) != 0) {
+    err_ = std::string("listen: ") + std::strerror(errno);
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+    return false;
+  }
+  stop_.store(false);
+  thread_ = std::thread([this] { serve_(); });
+  return true;
+}
+
+void MetricsExporter::stop() {
+  if (!thread_.joinable()) return;
+  stop_.store(true);
+  thread_.join();
+  ::close(listen_fd_);
+  listen_fd_ = -1;
+  if (!unix_path_.empty()) ::unlink(unix_path_.c_str());
+}
+
+// accept() con poll de 100 ms para poder observar stop_
+void MetricsExporter::serve_() {
+  while (!stop_.load()) {
+    pollfd pfd{listen_fd_, POLLIN, 0};
+    if (::poll(&pfd, 1, 100) <= 0) continue;
+    const int fd = ::accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) continue;
+    handle_(fd);
+    ::close(fd);
+  }
+}
+
+void MetricsExporter::handle_(int fd) {
+  // Leer hasta el fin de cabeceras (o 4 KB / 1 s)
+  std::string req;
+  char buf[1024];
+  while (req.find("\r\n\r\n") == std::string::npos && req.find("\n\n") == std::string::npos &&
+         req.size() < 4096) {
+    pollfd pfd{fd, POLLIN, 0};
+    if (::poll(&pfd, 1, 1000) <= 0) break;
+    const ssize_t n = ::recv(fd, buf, sizeof buf, 0);
+    if (n <= 0) break;
+    req.append(buf, size_t(n));
+  }
+
+  std::string path = "/metrics";
+  if (req.rfind("GET ", 0) == 0) path = req.substr(4, req.find(' ', 4) - 4);
+
+  std::string body, ctype = "text/plain; version=0.0.4";
+  const char* status = "200 OK";
+  if (path == "/metrics" || path == "/") body = prometheus();
+  else if (path == "/json") { body = json(); ctype = "application/json"; }
+  else { status = "404 Not Found"; body = "usa /metrics o /json\n"; }
+
+  std::string resp = std::string("HTTP/1.0 ") + status + "\r\nContent-Type: " + ctype +
+                     "\r\nContent-Length: " + std::to_string(body.size()) +
+                     "\r\nConnection: close\r\n\r\n" + body;
+  size_t off = 0;
+  while (off < resp.size()) {
+    const ssize_t n = ::send(fd, resp.data() + off, resp.size() - off, MSG_NOSIGNAL);
+    if (n <= 0) break;
+    off += size_t(n);
+  }
+}
+
+#endif
@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+class MESICache;
+class MesiInterconnect;
+
+/*
+ * MetricsExporter
+ * ===============
+ * Hilo en segundo plano que sirve los contadores de la simulación MIENTRAS
+ * corre (para mesi_gui.py, Prometheus/Grafana o un simple curl):
+ *
+ *   GET /metrics  -> formato de texto de Prometheus (counters por PE y del bus)
+ *   GET /json     -> instantánea JSON con los mismos valores
+ *
+ * Escucha sólo en localhost: "tcp:9464" (127.0.0.1:9464; puerto 0 = efímero)
+ * o un socket de dominio Unix "unix:/tmp/mesi.sock". HTTP/1.0 mínimo: una
+ * petición por conexión.
+ *
+ * Las métricas se leen con loads relaxed de RelaxedCounter (ver
+ * utils/RelaxedCounter.hpp): el exportador nunca toma el mutex del bus ni
+ * bloquea a los PEs. Cada contador es exacto; la instantánea en conjunto no es
+ * atómica (dos contadores pueden corresponder a instantes ligeramente distintos).
+ *
+ * En Windows start() devuelve false (sólo sockets POSIX).
+ */
+class MetricsExporter {
+public:
+  explicit MetricsExporter(const MesiInterconnect& bus);
+  ~MetricsExporter();
+
+  MetricsExporter(const MetricsExporter&) = delete;
+  MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+  // Abre el socket y lanza el hilo. 'endpoint' = "tcp:PORT" | "unix:PATH".
+  bool start(const std::string& endpoint);
+  void stop();
+
+  bool running() const { return thread_.joinable(); }
+  const std::string& error() const { return err_; }
+  uint16_t port() const { return port_; }          // puerto TCP real (tras start)
+
+  // Renderizados (también usables sin socket, p.ej. en tests)
+  std::string prometheus() const;
+  std::string json() const;
+
+private:
+  void serve_();
+  void handle_(int fd);
+
+  const MesiInterconnect& bus_;
+  std::chrono::steady_clock::time_point t0_;
+  std::thread thread_;
+  std::atomic<bool> stop_{false};
+  int listen_fd_ = -1;
+  uint16_t port_ = 0;
+  std::string unix_path_;
+  std::string err_;
+};
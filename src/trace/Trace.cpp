@@ -0,0 +1,239 @@
+#include "Trace.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if MESI_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+/*
+ * Trace.cpp
+ * =========
+ * Escritura/lectura del formato de trazas descrito en Trace.hpp.
+ * - E/S con stdio y buffers grandes (la lectura es secuencial, por chunks).
+ * - Compresión opcional por chunk con zlib (deflate) si MESI_HAVE_ZLIB.
+ */
+
+namespace trace {
+
+bool deflate_available() {
+#if MESI_HAVE_ZLIB
+  return true;
+#else
+  return false;
+#endif
+}
+
+// Escribe un varint directamente al FILE*
+static void fput_varint(std::FILE* f, uint64_t v) {
+  uint8_t tmp[10];
+  std::fwrite(tmp, 1, put_varint(tmp, v), f);
+}
+
+// Lee un varint byte a byte (solo para las cabeceras de chunk)
+static bool fget_varint(std::FILE* f, uint64_t& v) {
+  v = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    int c = std::fgetc(f);
+    if (c == EOF) return false;
+    v |= uint64_t(c & 0x7F) << shift;
+    if (!(c & 0x80)) return true;
+  }
+  return false;
+}
+
+} // namespace trace
+
+// =====================================================================
+// TraceWriter
+// =====================================================================
+TraceWriter::TraceWriter(const std::string& path, int num_pes, bool compress)
+  : compress_(compress && trace::deflate_available()), pes_(num_pes) {
+  f_ = std::fopen(path.c_str(), "wb");
+  if (!f_) return;
+  std::setvbuf(f_, nullptr, _IOFBF, 1 << 20);
+
+  // addr_end (bytes 16..23) queda en 0 hasta close()
+  uint8_t hdr[trace::kHeaderBytes] = {};
+  std::memcpy(hdr, trace::kMagic, 8);
+  const uint16_t ver = trace::kVersion, np = uint16_t(num_pes);
+  const uint32_t flags = compress_ ? trace::kFlagDeflate : 0u;
+  hdr[8]  = uint8_t(ver);  hdr[9]  = uint8_t(ver >> 8);
+  hdr[10] = uint8_t(np);   hdr[11] = uint8_t(np >> 8);
+  for (int i = 0; i < 4; ++i) hdr[12 + i] = uint8_t(flags >> (8 * i));
+  std::fwrite(hdr, 1, sizeof(hdr), f_);
+
+  for (auto& p : pes_) p.buf.reserve(trace::kChunkBytes + 16);
+}
+
+TraceWriter::~TraceWriter() { close(); }
+
+void TraceWriter::record(int pe, TraceKind kind, uint64_t addr) {
+  PeBuf& b = pes_[pe];
+  // Cada chunk contiene registros completos: se vuelca antes de desbordar.
+  if (b.buf.size() + trace::kMaxRecordBytes > trace::kChunkBytes) flush_pe_(pe);
+
+  const int64_t  delta = int64_t(addr - b.prev);
+  const uint64_t tok   = (trace::zigzag(delta) << 2) | uint64_t(kind);
+  uint8_t tmp[trace::kMaxRecordBytes];
+  const size_t n = trace::put_varint(tmp, tok);
+  b.buf.insert(b.buf.end(), tmp, tmp + n);
+  b.prev = addr;
+  b.count++;
+  if (kind != TraceKind::Sync && addr + 8 > b.end) b.end = addr + 8;
+}
+
+void TraceWriter::barrier() {
+  for (int pe = 0; pe < (int)pes_.size(); ++pe)
+    record(pe, TraceKind::Sync, pes_[pe].prev);
+}
+
+uint64_t TraceWriter::records() const {
+  uint64_t n = 0;
+  for (const auto& p : pes_) n += p.count;
+  return n;
+}
+
+void TraceWriter::flush_pe_(int pe) {
+  PeBuf& b = pes_[pe];
+  if (b.buf.empty()) return;
+  write_chunk_(pe, b.buf.data(), b.buf.size());
+  b.buf.clear();
+}
+
+void TraceWriter::write_chunk_(int pe, const uint8_t* data, size_t n) {
+  std::lock_guard<std::mutex> lk(file_mtx_);
+  if (!f_) return;
+#if MESI_HAVE_ZLIB
+  if (compress_) {
+    uLongf zn = compressBound(uLong(n));
+    std::vector<uint8_t> z(zn);
+    if (compress2(z.data(), &zn, data, uLong(n), Z_BEST_SPEED) == Z_OK) {
+      trace::fput_varint(f_, uint64_t(pe));
+      trace::fput_varint(f_, n);
+      trace::fput_varint(f_, zn);
+      std::fwrite(z.data(), 1, zn, f_);
+      return;
+    }
+  }
+#endif
+  trace::fput_varint(f_, uint64_t(pe));
+  trace::fput_varint(f_, n);
+  trace::fput_varint(f_, n);
+  std::fwrite(data, 1, n, f_);
+}
+
+void TraceWriter::close() {
+  if (!f_) return;
+  for (int pe = 0; pe < (int)pes_.size(); ++pe) flush_pe_(pe);
+  std::lock_guard<std::mutex> lk(file_mtx_);
+  uint64_t end = 0;
+  for (const auto& p : pes_) end = std::max(end, p.end);
+  uint8_t tmp[8];
+  for (int i = 0; i < 8; ++i) tmp[i] = uint8_t(end >> (8 * i));
+  if (std::fseek(f_, 16, SEEK_SET) == 0) std::fwrite(tmp, 1, sizeof(tmp), f_);
+  std::fclose(f_);
+  f_ = nullptr;
+}
+
+// =====================================================================
+// TraceReader
+// =====================================================================
+TraceReader::TraceReader(const std::string& path) {
+  f_ = std::fopen(path.c_str(), "rb");
+  if (!f_) { err_ = "no se pudo abrir " + path; return; }
+  std::setvbuf(f_, nullptr, _IOFBF, 1 << 20);
+
+  uint8_t hdr[trace::kHeaderBytes];
+  if (std::fread(hdr, 1, 16, f_) != 16 ||
+      std::memcmp(hdr, trace::kMagic, 8) != 0) {
+    err_ = "cabecera de traza inválida";
+    std::fclose(f_); f_ = nullptr; return;
+  }
+  const uint16_t ver = uint16_t(hdr[8] | (hdr[9] << 8));
+  num_pes_ = hdr[10] | (hdr[11] << 8);
+  for (int i = 0; i < 4; ++i) flags_ |= uint32_t(hdr[12 + i]) << (8 * i);
+
+  if ((ver != 1 && ver != trace::kVersion) || num_pes_ <= 0) {
+    err_ = "versión de traza no soportada";
+    std::fclose(f_); f_ = nullptr; return;
+  }
+  if (num_pes_ > trace::kMaxPes) {
+    err_ = "la traza declara " + std::to_string(num_pes_) + " PEs (máximo " +
+           std::to_string(trace::kMaxPes) + ")";
+    std::fclose(f_); f_ = nullptr; return;
+  }
+  size_t hdr_bytes = 16;
+  if (ver >= 2) {
+    if (std::fread(hdr + 16, 1, 8, f_) != 8) {
+      err_ = "cabecera de traza inválida";
+      std::fclose(f_); f_ = nullptr; return;
+    }
+    for (int i = 0; i < 8; ++i) addr_end_ |= uint64_t(hdr[16 + i]) << (8 * i);
+    hdr_bytes = trace::kHeaderBytes;
+  }
+  if ((flags_ & trace::kFlagDeflate) && !trace::deflate_available()) {
+    err_ = "traza comprimida pero el binario no tiene zlib (MESI_HAVE_ZLIB)";
+    std::fclose(f_); f_ = nullptr; return;
+  }
+  bytes_read_ = hdr_bytes;
+  pes_.resize(num_pes_);
+}
+
+TraceReader::~TraceReader() {
+  if (f_) std::fclose(f_);
+}
+
+bool TraceReader::read_chunk_() {
+  if (eof_ || !f_) return false;
+  uint64_t pe = 0, raw = 0, stored = 0;
+  if (!trace::fget_varint(f_, pe) || !trace::fget_varint(f_, raw) ||
+      !trace::fget_varint(f_, stored)) {
+    eof_ = true; return false;
+  }
+  // Los tamaños se validan antes de reservar nada
+  if (pe >= (uint64_t)num_pes_) {
+    err_ = "chunk de un PE inexistente"; eof_ = true; return false;
+  }
+  if (raw > trace::kChunkBytes + trace::kMaxRecordBytes) {
+    err_ = "chunk más grande que el máximo del formato"; eof_ = true; return false;
+  }
+  bool stored_ok = stored == raw;
+#if MESI_HAVE_ZLIB
+  if (flags_ & trace::kFlagDeflate) stored_ok = stored <= compressBound(uLong(raw));
+#endif
+  if (!stored_ok) {
+    err_ = "tamaño almacenado de chunk inválido"; eof_ = true; return false;
+  }
+
+  std::vector<uint8_t> chunk(raw);
+  if (flags_ & trace::kFlagDeflate) {
+#if MESI_HAVE_ZLIB
+    zbuf_.resize(stored);
+    if (std::fread(zbuf_.data(), 1, stored, f_) != stored) { eof_ = true; return false; }
+    uLongf out = uLongf(raw);
+    if (uncompress(chunk.data(), &out, zbuf_.data(), uLong(stored)) != Z_OK || out != raw) {
+      err_ = "chunk comprimido corrupto"; eof_ = true; return false;
+    }
+#endif
+  } else if (std::fread(chunk.data(), 1, raw, f_) != raw) {
+    eof_ = true; return false;
+  }
+  bytes_read_ += stored;
+  pes_[pe].pending.push_back(std::move(chunk));
+  return true;
+}
+
+bool TraceReader::refill_(int pe) {
+  PeStream& s = pes_[pe];
+  while (s.pending.empty()) {
+    if (!read_chunk_()) return false;
+  }
+  // Descarta lo consumido y anexa el siguiente chunk del PE
+  s.buf.erase(s.buf.begin(), s.buf.begin() + s.pos);
+  s.pos = 0;
+  auto& next = s.pending.front();
+  s.buf.insert(s.buf.end(), next.begin(), next.end());
+  s.pending.erase(s.pending.begin());
+  return true;
+}
@@ -0,0 +1,170 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Trace.hpp
+ * =========
+ * Formato compacto de trazas de accesos a memoria por PE (para --mode=trace).
+ *
+ * Archivo:
+ *   Cabecera (24 B):  "MESITRC1" | u16 versión | u16 num_pes | u32 flags | u64 addr_end
+ *     - addr_end: fin (exclusivo) de la memoria que tocan los loads/stores, para
+ *       dimensionar SharedMemory antes de reproducir. La versión 1 (cabecera de
+ *       16 B, sin addr_end) se sigue leyendo; ahí addr_end() devuelve 0.
+ *   Secuencia de chunks:  varint pe | varint raw_len | varint stored_len | bytes
+ *     - Cada chunk pertenece a UN PE; los chunks de distintos PEs se intercalan
+ *       según se llenan los buffers del escritor (lectura en streaming).
+ *     - Si flags & kFlagDeflate, los bytes del chunk están comprimidos con zlib
+ *       (solo disponible si se compiló con MESI_HAVE_ZLIB).
+ *
+ * Registro (dentro del payload de un PE):
+ *   varint token = (zigzag(addr - prev_addr) << 2) | kind
+ *   kind: 0 = load, 1 = store, 2 = sync (barrera global; delta siempre 0)
+ *   prev_addr es por PE y empieza en 0. Accesos secuenciales de 8 B => 1 byte/registro.
+ */
+
+enum class TraceKind : uint8_t { Load = 0, Store = 1, Sync = 2 };
+
+struct TraceRecord {
+  TraceKind kind;
+  uint64_t  addr;
+};
+
+namespace trace {
+
+static constexpr char     kMagic[8]      = {'M','E','S','I','T','R','C','1'};
+static constexpr uint16_t kVersion       = 2;
+static constexpr size_t   kHeaderBytes   = 24;   // versión 1: 16
+static constexpr uint32_t kFlagDeflate   = 1u << 0;
+static constexpr size_t   kChunkBytes    = 64 * 1024;   // payload crudo por chunk
+static constexpr size_t   kMaxRecordBytes = 10;          // varint de 64 bits
+// Límites que el lector exige a la cabecera y a cada chunk (un archivo corrupto
+// no debe pedir memoria sin cota): un chunk crudo no pasa de kChunkBytes más un
+// registro, y una L1$ por PE
+static constexpr int      kMaxPes        = 1024;
+
+// ---- varint LEB128 + zigzag ----
+inline size_t put_varint(uint8_t* p, uint64_t v) {
+  size_t n = 0;
+  while (v >= 0x80) { p[n++] = uint8_t(v) | 0x80; v >>= 7; }
+  p[n++] = uint8_t(v);
+  return n;
+}
+
+// Devuelve bytes consumidos (0 si el buffer se acaba a mitad de varint).
+inline size_t get_varint(const uint8_t* p, const uint8_t* end, uint64_t& v) {
+  if (p < end && p[0] < 0x80) { v = p[0]; return 1; }   // camino rápido (delta pequeño)
+  v = 0;
+  for (size_t n = 0, shift = 0; p + n < end && shift < 64; ++n, shift += 7) {
+    v |= uint64_t(p[n] & 0x7F) << shift;
+    if (!(p[n] & 0x80)) return n + 1;
+  }
+  return 0;
+}
+
+inline uint64_t zigzag(int64_t d)  { return (uint64_t(d) << 1) ^ uint64_t(d >> 63); }
+inline int64_t  unzigzag(uint64_t z) { return int64_t(z >> 1) ^ -int64_t(z & 1); }
+
+bool deflate_available();
+
+} // namespace trace
+
+// ---------------- Escritor (thread-safe por PE) ----------------
+// Cada PE escribe solo en su propio buffer; el volcado de chunks al archivo
+// está serializado con un mutex (fuera del camino caliente).
+class TraceWriter {
+public:
+  TraceWriter(const std::string& path, int num_pes, bool compress = false);
+  ~TraceWriter();
+
+  bool ok() const { return f_ != nullptr; }
+
+  void record(int pe, TraceKind kind, uint64_t addr);
+  void load(int pe, uint64_t addr)  { record(pe, TraceKind::Load, addr); }
+  void store(int pe, uint64_t addr) { record(pe, TraceKind::Store, addr); }
+
+  // Inserta una barrera global (Sync) en TODOS los PEs (orden entre fases).
+  void barrier();
+
+  // Vuelca los buffers pendientes, escribe addr_end en la cabecera y cierra.
+  void close();
+
+  uint64_t records() const;
+
+private:
+  struct PeBuf {
+    std::vector<uint8_t> buf;
+    uint64_t prev = 0;
+    uint64_t count = 0;
+    uint64_t end = 0;   // max(addr + 8) de sus loads/stores
+  };
+
+  void flush_pe_(int pe);
+  void write_chunk_(int pe, const uint8_t* data, size_t n);
+
+  std::FILE* f_ = nullptr;
+  bool compress_ = false;
+  std::vector<PeBuf> pes_;
+  std::mutex file_mtx_;
+};
+
+// ---------------- Lector en streaming ----------------
+// Mantiene un buffer decodificable por PE y lee chunks del archivo bajo demanda.
+class TraceReader {
+public:
+  explicit TraceReader(const std::string& path);
+  ~TraceReader();
+
+  bool ok() const { return f_ != nullptr; }
+  int  num_pes() const { return num_pes_; }
+  bool compressed() const { return flags_ & trace::kFlagDeflate; }
+  // Fin (exclusivo) de las direcciones accedidas; 0 = desconocido (versión 1)
+  uint64_t addr_end() const { return addr_end_; }
+  // Motivo del fallo al abrir o de un chunk rechazado (la traza termina ahí)
+  const std::string& error() const { return err_; }
+
+  // Siguiente registro del PE 'pe'. false => fin de la traza de ese PE.
+  inline bool next(int pe, TraceRecord& out) {
+    PeStream& s = pes_[pe];
+    for (;;) {
+      const uint8_t* p   = s.buf.data() + s.pos;
+      const uint8_t* end = s.buf.data() + s.buf.size();
+      uint64_t tok;
+      if (size_t n = trace::get_varint(p, end, tok)) {
+        s.pos += n;
+        s.prev += uint64_t(trace::unzigzag(tok >> 2));
+        out.kind = TraceKind(tok & 3);
+        out.addr = s.prev;
+        return true;
+      }
+      if (!refill_(pe)) return false;
+    }
+  }
+
+  uint64_t bytes_read() const { return bytes_read_; }
+
+private:
+  struct PeStream {
+    std::vector<uint8_t> buf;
+    size_t   pos = 0;
+    uint64_t prev = 0;
+    std::vector<std::vector<uint8_t>> pending;   // chunks leídos para este PE aún no usados
+  };
+
+  bool refill_(int pe);
+  bool read_chunk_();   // lee 1 chunk del archivo y lo encola a su PE
+
+  std::FILE* f_ = nullptr;
+  int        num_pes_ = 0;
+  uint32_t   flags_ = 0;
+  uint64_t   addr_end_ = 0;
+  bool       eof_ = false;
+  uint64_t   bytes_read_ = 0;
+  std::string err_;
+  std::vector<PeStream> pes_;
+  std::vector<uint8_t>  zbuf_;
+};
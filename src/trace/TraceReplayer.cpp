@@ -0,0 +1,69 @@
+#include "TraceReplayer.hpp"
+#include "../memory/cache/mesi/MESICache.hpp"
+#include "../analysis/ReuseDistance.hpp"
+#include "../telemetry/IntervalSampler.hpp"
+#include <chrono>
+
+TraceReplayer::TraceReplayer(std::vector<MESICache*> caches, unsigned quantum)
+  : caches_(std::move(caches)), quantum_(quantum ? quantum : 1) {}
+
+/* run(reader)
+ * -----------
+ * Bucle round-robin sobre los PEs:
+ *  - Cada PE activo consume hasta 'quantum_' registros.
+ *  - Load/Store se reintentan hasta hit (mismo contrato que MesiMemoryPort).
+ *  - Sync deja al PE "en barrera"; cuando todos los PEs vivos están en barrera
+ *    se liberan juntos.
+ */
+TraceReplayStats TraceReplayer::run(TraceReader& reader) {
+  TraceReplayStats st;
+  const int P = reader.num_pes();
+  enum class S : uint8_t { Run, Barrier, Done };
+  std::vector<S> state(P, S::Run);
+  int done = 0;
+  std::vector<TimelineTap> tap(P);
+  if (tl_)
+    for (int pe = 0; pe < P; ++pe) tap[pe].attach(tl_, *caches_[pe]);
+
+  const auto t0 = std::chrono::steady_clock::now();
+  uint64_t store_val = 0;
+  TraceRecord r;
+
+  while (done < P) {
+    int at_barrier = 0;
+    for (int pe = 0; pe < P; ++pe) {
+      if (state[pe] != S::Run) { at_barrier += (state[pe] == S::Barrier); continue; }
+      MESICache& c = *caches_[pe];
+      ReuseDistanceProfiler* rd = pe < (int)rd_.size() ? rd_[pe] : nullptr;
+
+      for (unsigned q = 0; q < quantum_; ++q) {
+        if (!reader.next(pe, r)) { state[pe] = S::Done; ++done; break; }
+        if (rd && r.kind != TraceKind::Sync) rd->access(r.addr);
+        if (tap[pe]) tap[pe].tick(c);
+        if (r.kind == TraceKind::Load) {
+          uint64_t u;
+          while (!c.load(r.addr, &u)) {}
+          st.loads++;
+        } else if (r.kind == TraceKind::Store) {
+          ++store_val;
+          while (!c.store(r.addr, &store_val)) {}
+          st.stores++;
+        } else {
+          state[pe] = S::Barrier; ++at_barrier;
+          break;
+        }
+      }
+    }
+
+    // Todos los vivos llegaron a la barrera => liberar
+    if (at_barrier > 0 && at_barrier == P - done) {
+      for (auto& s : state) if (s == S::Barrier) s = S::Run;
+      st.barriers++;
+    }
+  }
+
+  st.accesses   = st.loads + st.stores;
+  st.seconds    = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  st.bytes_read = reader.bytes_read();
+  return st;
+}
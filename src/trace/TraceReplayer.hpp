@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Trace.hpp"
+
+class MESICache;
+class ReuseDistanceProfiler;
+class IntervalSampler;
+
+/*
+ * TraceReplayer
+ * =============
+ * Reproduce una traza (Trace.hpp) directamente sobre MESICache::load/store de
+ * cada PE, sin pasar por el intérprete PE::step.
+ *
+ * Orden entre PEs:
+ *  - Dentro de una fase, los PEs se intercalan en round-robin con un quantum
+ *    de Q accesos (determinista; Q=1 aproxima la máxima concurrencia).
+ *  - Un registro Sync es una barrera global: ningún PE continúa hasta que
+ *    todos los PEs que aún tienen traza alcanzan esa misma barrera.
+ *
+ * Se ejecuta en un solo hilo (no hay contención por el mutex del bus), lo que
+ * permite decenas de millones de accesos/seg en Release.
+ */
+struct TraceReplayStats {
+  uint64_t accesses = 0;
+  uint64_t loads = 0;
+  uint64_t stores = 0;
+  uint64_t barriers = 0;
+  double   seconds = 0.0;
+  uint64_t bytes_read = 0;
+};
+
+class TraceReplayer {
+public:
+  TraceReplayer(std::vector<MESICache*> caches, unsigned quantum = 1);
+
+  // Reproduce la traza completa. Requiere reader.num_pes() <= caches.size().
+  TraceReplayStats run(TraceReader& reader);
+
+  // (opcional) un perfil de reuse distance por PE, alimentado con cada load/store
+  void set_reuse_profilers(std::vector<ReuseDistanceProfiler*> rd) { rd_ = std::move(rd); }
+
+  // (opcional) serie temporal de contadores: cada acceso avanza el tap de su PE
+  void set_timeline(IntervalSampler* ts) { tl_ = ts; }
+
+private:
+  std::vector<MESICache*> caches_;
+  unsigned quantum_ = 1;
+  std::vector<ReuseDistanceProfiler*> rd_;
+  IntervalSampler* tl_ = nullptr;
+};
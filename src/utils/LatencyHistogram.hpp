@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include "RelaxedCounter.hpp"
+
+// ======================================================
+// LatencyHistogram: histograma log-lineal (estilo HDR) de latencias
+// ======================================================
+// Cubos exactos para v < 2^kSubBits; desde ahí cada potencia de 2 [2^e, 2^(e+1))
+// se parte en 2^kSubBits sub-cubos iguales, así el error relativo de un cubo
+// queda acotado (< 1/2^kSubBits = 6.25%) sea la latencia de 20 ciclos o de 20 ms.
+// Cubre todo uint64_t con kBuckets cubos fijos: record() no reserva memoria.
+//
+// Los cubos son RelaxedCounter multi-escritor (fetch_add relaxed): un Flush
+// inducido por snoop registra en la caché dueña desde el hilo del solicitante
+// mientras el dueño registra sus propias transacciones. merge() también es
+// lock-free (suma cubo a cubo); se usa con los PEs detenidos para el total.
+class LatencyHistogram {
+public:
+    static constexpr int kSubBits = 4;
+    static constexpr int kSub = 1 << kSubBits;
+    static constexpr int kBuckets = (64 - kSubBits + 1) * kSub;
+
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram& o) { *this = o; }
+    LatencyHistogram& operator=(const LatencyHistogram& o) {
+        for (int i = 0; i < kBuckets; ++i) b_[i] = o.b_[i];
+        count_ = o.count_;
+        sum_ = o.sum_;
+        max_.store(o.max(), std::memory_order_relaxed);
+        return *this;
+    }
+
+    static int bucket_of(uint64_t v) {
+        if (v < uint64_t(kSub)) return int(v);
+        const int e = 63 - std::countl_zero(v);
+        return (e - kSubBits + 1) * kSub + int((v >> (e - kSubBits)) & (kSub - 1));
+    }
+    // Rango [low, high] de valores que caen en el cubo b
+    static uint64_t bucket_low(int b) {
+        if (b < kSub) return uint64_t(b);
+        const int e = b / kSub + kSubBits - 1;
+        return (uint64_t(kSub) + uint64_t(b % kSub)) << (e - kSubBits);
+    }
+    static uint64_t bucket_high(int b) {
+        if (b < kSub) return uint64_t(b);
+        const int e = b / kSub + kSubBits - 1;
+        return bucket_low(b) + ((uint64_t(1) << (e - kSubBits)) - 1);
+    }
+
+    void record(uint64_t v) {
+        ++b_[bucket_of(v)];
+        ++count_;
+        sum_ += v;
+        uint64_t m = max_.load(std::memory_order_relaxed);
+        while (v > m && !max_.compare_exchange_weak(m, v, std::memory_order_relaxed)) {}
+    }
+
+    void merge(const LatencyHistogram& o) {
+        for (int i = 0; i < kBuckets; ++i)
+            if (const uint64_t n = o.b_[i]) b_[i] += n;
+        count_ += o.count_;
+        sum_ += o.sum_;
+        const uint64_t v = o.max();
+        uint64_t m = max_.load(std::memory_order_relaxed);
+        while (v > m && !max_.compare_exchange_weak(m, v, std::memory_order_relaxed)) {}
+    }
+
+    void reset() { *this = LatencyHistogram(); }
+
+    uint64_t count() const { return count_; }
+    uint64_t sum() const { return sum_; }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+    double mean() const { return count_ ? double(sum_) / double(count_) : 0.0; }
+    uint64_t bucket_count(int b) const { return b_[b]; }
+
+    // Cota superior del cubo que contiene al percentil q (0..1), acotada por el
+    // máximo observado; 0 sin muestras
+    uint64_t percentile(double q) const {
+        const uint64_t n = count_;
+        if (!n) return 0;
+        uint64_t target = uint64_t(std::ceil(q * double(n)));
+        if (target < 1) target = 1;
+        uint64_t acc = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            acc += b_[i];
+            if (acc >= target) {
+                const uint64_t hi = bucket_high(i);
+                return hi < max() ? hi : max();
+            }
+        }
+        return max();
+    }
+
+private:
+    RelaxedCounter<uint64_t, true> b_[kBuckets];
+    RelaxedCounter<uint64_t, true> count_, sum_;
+    std::atomic<uint64_t> max_{0};
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include <atomic>
+
+// ======================================================
+// RelaxedCounter: contador legible desde otro hilo sin data race
+// ======================================================
+// Las métricas de la caché se incrementan en el camino caliente y las lee el
+// exportador en vivo (telemetry/MetricsExporter) mientras la simulación corre.
+//
+// - Un solo escritor (por defecto): load + store relaxed => en x86 es un mov
+//   normal, sin prefijo lock; el lector ve un valor reciente, nunca uno roto.
+// - kMultiWriter=true: fetch_add relaxed, para contadores que pueden tocar dos
+//   hilos sin el bus retenido (p.ej. la matriz de transiciones MESI).
+//
+// Se convierte implícitamente a T, así el código que lee métricas (CSV,
+// dumpStats, tests) no cambia. La copia toma una instantánea del valor.
+template <class T, bool kMultiWriter = false>
+class RelaxedCounter {
+public:
+    RelaxedCounter(T v = T{}) : v_(v) {}
+    RelaxedCounter(const RelaxedCounter& o) : v_(o.load()) {}
+    RelaxedCounter& operator=(const RelaxedCounter& o) { v_.store(o.load(), std::memory_order_relaxed); return *this; }
+    RelaxedCounter& operator=(T v) { v_.store(v, std::memory_order_relaxed); return *this; }
+
+    T load() const { return v_.load(std::memory_order_relaxed); }
+    operator T() const { return load(); }
+
+    RelaxedCounter& operator+=(T d) {
+        if constexpr (kMultiWriter) v_.fetch_add(d, std::memory_order_relaxed);
+        else v_.store(v_.load(std::memory_order_relaxed) + d, std::memory_order_relaxed);
+        return *this;
+    }
+    RelaxedCounter& operator++() { return *this += T(1); }
+    T operator++(int) { T old = load(); *this += T(1); return old; }
+
+private:
+    std::atomic<T> v_;
+};
@@ -0,0 +1,297 @@
+#include "Stepper.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+static const char* bus_msg_name(BusMsg m) {
+  switch (m) {
+    case BusMsg::BusRd:   return "BusRd";
+    case BusMsg::BusRdX:  return "BusRdX";
+    case BusMsg::BusUpgr: return "BusUpgr";
+    case BusMsg::Data:    return "Data";
+    case BusMsg::Flush:   return "Flush";
+    case BusMsg::Inv:     return "Inv";
+    case BusMsg::BusWr:     return "BusWr";
+    case BusMsg::BusWrLine: return "BusWrLine";
+  }
+  return "?";
+}
+
+static char mesi_char(MESI s) {
+  switch (s) {
+    case MESI::M: return 'M';
+    case MESI::E: return 'E';
+    case MESI::S: return 'S';
+    case MESI::I: return 'I';
+  }
+  return '?';
+}
+
+static bool parse_mesi(char c, int& out) {
+  switch (c) {
+    case 'M': out = int(MESI::M); return true;
+    case 'E': out = int(MESI::E); return true;
+    case 'S': out = int(MESI::S); return true;
+    case 'I': out = int(MESI::I); return true;
+    case '*': out = -1;           return true;
+  }
+  return false;
+}
+
+static uint64_t line_of(uint64_t a) { return a & ~uint64_t(MESICache::kLineSize - 1); }
+
+static constexpr int kSlots = MESICache::kSets * MESICache::kWays;
+
+/* add_watch(spec)
+ * ---------------
+ * "clave=valor" separados por coma; ver la sintaxis en Stepper.hpp.
+ */
+bool Stepper::add_watch(const std::string& spec, std::string* err) {
+  auto fail = [&](const std::string& why) {
+    if (err) *err = "watch '" + spec + "': " + why;
+    return false;
+  };
+
+  Watch w;
+  w.spec = spec;
+  size_t pos = 0;
+  while (pos <= spec.size()) {
+    size_t end = spec.find(',', pos);
+    if (end == std::string::npos) end = spec.size();
+    const std::string item = spec.substr(pos, end - pos);
+    pos = end + 1;
+    if (item.empty()) continue;
+
+    const size_t eq = item.find('=');
+    if (eq == std::string::npos) return fail("falta '=' en '" + item + "'");
+    const std::string key = item.substr(0, eq), val = item.substr(eq + 1);
+
+    try {
+      if (key == "addr") {
+        const size_t dash = val.find('-');
+        w.lo = std::stoull(val.substr(0, dash), nullptr, 0);
+        w.hi = (dash == std::string::npos) ? w.lo : std::stoull(val.substr(dash + 1), nullptr, 0);
+        if (w.hi < w.lo) return fail("rango de direcciones invertido");
+      } else if (key == "ev") {
+        size_t p = 0;
+        while (p <= val.size()) {
+          size_t e = val.find('|', p);
+          if (e == std::string::npos) e = val.size();
+          const std::string name = val.substr(p, e - p);
+          p = e + 1;
+          bool found = false;
+          for (BusMsg m : {BusMsg::BusRd, BusMsg::BusRdX, BusMsg::BusUpgr, BusMsg::Flush, BusMsg::Inv,
+                           BusMsg::BusWr, BusMsg::BusWrLine})
+            if (name == bus_msg_name(m)) { w.ev_mask |= 1u << unsigned(m); found = true; }
+          if (!found) return fail("evento desconocido '" + name + "'");
+        }
+      } else if (key == "pe") {
+        w.pe = std::stoi(val);
+      } else if (key == "trans") {
+        if (val.size() != 3 || val[1] != '>' ||
+            !parse_mesi(val[0], w.from) || !parse_mesi(val[2], w.to))
+          return fail("transición debe ser X>Y con X,Y en M,E,S,I,*");
+        w.trans = true;
+      } else if (key == "every") {
+        w.every = std::stoull(val, nullptr, 0);
+        if (w.every == 0) return fail("every debe ser >= 1");
+      } else {
+        return fail("clave desconocida '" + key + "'");
+      }
+    } catch (const std::exception&) {
+      return fail("valor inválido en '" + item + "'");
+    }
+  }
+
+  need_trans_ = need_trans_ || w.trans;
+  watches_.push_back(w);
+  return true;
+}
+
+/* capture_(caches, t)
+ * -------------------
+ * Copia el estado de todas las vías. Los demás PEs siguen corriendo (stores hit
+ * en M/E sin bus), así que cada L1$ se copia con snapshotLines() (seqlocks de
+ * sus sets tomados). En BusUpgr el solicitante cambia S->M recién cuando emit()
+ * retorna, así que el snapshot lo anticipa (el bus ya lo concedió).
+ */
+Stepper::Snapshot Stepper::capture_(const std::vector<MESICache*>& caches,
+                                    const BusTransaction& t) {
+  Snapshot s(caches.size() * kSlots);
+  size_t src_slot = caches.size();   // posición de la L1$ del emisor (ids != posiciones)
+  for (size_t k = 0; k < caches.size(); ++k) {
+    if (!caches[k]) continue;
+    if (caches[k]->id() == t.src_pe) src_slot = k;
+    const MESICache::LineSnapshot snap = caches[k]->snapshotLines();
+    for (int set = 0; set < MESICache::kSets; ++set)
+      for (int way = 0; way < MESICache::kWays; ++way) {
+        const CacheLine& L = snap.line[set][way];
+        LineSnap& d = s[k * kSlots + set * MESICache::kWays + way];
+        d.pe    = caches[k]->id();
+        d.valid = L.valid && L.state != MESI::I;
+        d.dirty = L.dirty;
+        d.state = L.state;
+        d.line  = snap.base[set][way];
+        d.data  = L.data;
+      }
+  }
+  if (t.type == BusMsg::BusUpgr && src_slot < caches.size()) {
+    const MESICache* c = caches[src_slot];
+    const uint64_t line = line_of(t.addr);
+    for (int way = 0; way < MESICache::kWays; ++way) {
+      const int set = int(MESICache::setIndex(c->indexFunction(), t.addr, way));
+      LineSnap& d = s[src_slot * kSlots + set * MESICache::kWays + way];
+      if (d.valid && d.line == line) { d.state = MESI::M; d.dirty = true; }
+    }
+  }
+  return s;
+}
+
+/* for_each_change(before, after, fn)
+ * -----------------------------------
+ * Recorre las vías que cambiaron entre dos snapshots y llama
+ * fn(pe, set, way, addr_linea, from, to, old, now). Un reemplazo (otro tag en la
+ * misma vía) se reporta como dos cambios: víctima X->I y nueva línea I->Y.
+ * 'old'/'now' son null si la línea no estaba/no está presente. 'pe' es el id de
+ * la L1$ guardado en el snapshot, no la posición en el vector del bus.
+ */
+template<class Snap, class Fn>
+static void for_each_change(const std::vector<Snap>& before, const std::vector<Snap>& after, Fn fn) {
+  static const Snap kEmpty{};
+  for (size_t i = 0; i < after.size(); ++i) {
+    const Snap& o = (i < before.size()) ? before[i] : kEmpty;
+    const Snap& n = after[i];
+    const int pe  = n.pe >= 0 ? n.pe : o.pe;
+    const int set = int(i % kSlots) / MESICache::kWays;
+    const int way = int(i % kSlots) % MESICache::kWays;
+
+    if (o.valid && n.valid && o.line == n.line) {
+      if (o.state != n.state || o.dirty != n.dirty || o.data != n.data)
+        fn(pe, set, way, n.line, o.state, n.state, &o, &n);
+      continue;
+    }
+    if (o.valid)
+      fn(pe, set, way, o.line, o.state, MESI::I, &o, nullptr);
+    if (n.valid)
+      fn(pe, set, way, n.line, MESI::I, n.state, nullptr, &n);
+  }
+}
+
+bool Stepper::matches_(const Watch& w, const BusTransaction& t, const Snapshot& before,
+                       const Snapshot& after) const {
+  if (w.ev_mask && !(w.ev_mask & (1u << unsigned(t.type)))) return false;
+
+  auto in_range = [&](uint64_t line) {
+    return line <= w.hi && line + MESICache::kLineSize - 1 >= w.lo;
+  };
+
+  if (!w.trans) {
+    if (w.pe >= 0 && t.src_pe != w.pe) return false;
+    return in_range(line_of(t.addr));
+  }
+
+  bool hit = false;
+  for_each_change(before, after, [&](int pe, int, int, uint64_t addr, MESI from, MESI to,
+                                     const LineSnap*, const LineSnap*) {
+    if (hit || from == to) return;
+    if (w.pe >= 0 && pe != w.pe) return;
+    if (w.from >= 0 && int(from) != w.from) return;
+    if (w.to >= 0 && int(to) != w.to) return;
+    hit = in_range(addr);
+  });
+  return hit;
+}
+
+void Stepper::print_diff_(const BusTransaction& t, const std::vector<MESICache*>& caches,
+                          SharedMemory* shm) {
+  std::ostream& os = *out;
+  char buf[160];
+
+  std::snprintf(buf, sizeof buf, "\n========== EVENTO MESI #%llu: %s PE%d @0x%llx (",
+                (unsigned long long)events_, bus_msg_name(t.type), t.src_pe,
+                (unsigned long long)t.addr);
+  os << buf << last_reason_ << ") ==========\n";
+
+  Snapshot now = capture_(caches, t);
+  int changes = 0;
+  for_each_change(shown_, now, [&](int pe, int set, int way, uint64_t addr, MESI from, MESI to,
+                                   const LineSnap* o, const LineSnap* n) {
+    ++changes;
+    std::snprintf(buf, sizeof buf, "  PE%d set%d way%d 0x%03llx: %c -> %c%s\n", pe, set, way,
+                  (unsigned long long)addr, mesi_char(from), mesi_char(to),
+                  (n && n->dirty) ? " (dirty)" : "");
+    os << buf;
+    if (!o || !n) return;
+    for (int w = 0; w < MESICache::kLineSize; w += 8) {
+      uint64_t a, b;
+      std::memcpy(&a, o->data.data() + w, 8);
+      std::memcpy(&b, n->data.data() + w, 8);
+      if (a == b) continue;
+      std::snprintf(buf, sizeof buf, "      +%02d: 0x%016llx -> 0x%016llx\n", w,
+                    (unsigned long long)a, (unsigned long long)b);
+      os << buf;
+    }
+  });
+  if (!changes) os << "  (sin cambios en las L1$ desde la parada anterior)\n";
+  shown_ = std::move(now);
+
+  if (shm) {
+    uint64_t r = 0, w = 0;
+    shm->get_stats(r, w);
+    std::snprintf(buf, sizeof buf, "  DRAM: +%llu lecturas, +%llu escrituras (total %llu/%llu)\n",
+                  (unsigned long long)(r - shm_reads_), (unsigned long long)(w - shm_writes_),
+                  (unsigned long long)r, (unsigned long long)w);
+    os << buf;
+    shm_reads_ = r; shm_writes_ = w;
+  }
+}
+
+/* pause(t, caches, shm)
+ * ---------------------
+ * Evalúa los watchpoints para la transacción recién completada; si alguno dispara
+ * (o no hay ninguno) imprime el diff y, en modo interactivo, espera una orden.
+ */
+void Stepper::pause(const BusTransaction& t,
+                    const std::vector<MESICache*>& caches,
+                    SharedMemory* shm)
+{
+  if (!enabled) return;
+  std::lock_guard<std::mutex> lk(mx);
+  ++events_;
+
+  Snapshot now;
+  if (need_trans_) now = capture_(caches, t);
+
+  std::string reason;
+  if (watches_.empty()) reason = "paso";
+  for (auto& w : watches_) {
+    if (!matches_(w, t, seen_, now)) continue;
+    if (++w.hits % w.every == 0 && reason.empty()) reason = "watch " + w.spec;
+  }
+  if (reason.empty() && step_once_) reason = "paso";
+  if (need_trans_) seen_ = std::move(now);
+  if (reason.empty()) return;
+
+  step_once_ = false;
+  ++stops_;
+  last_reason_ = reason;
+  print_diff_(t, caches, shm);
+
+  if (!interactive) return;
+  for (;;) {
+    *out << "[ENTER/c] continuar  [s] siguiente evento  [f] estado completo  [q] sin pausas > "
+         << std::flush;
+    std::string cmd;
+    if (!std::getline(*in, cmd)) return;
+    if (cmd == "s") { step_once_ = true; return; }
+    if (cmd == "q") { enabled = false; return; }
+    if (cmd == "f") {
+      for (auto* c : caches)
+        if (c) c->dumpCacheState(*out);
+      if (shm) shm->dump_stats(*out);
+      continue;
+    }
+    return;
+  }
+}
@@ -1,5 +1,8 @@
 #pragma once
+#include <array>
+#include <cstdint>
 #include <iostream>
+#include <string>
 #include <vector>
 #include <mutex>
 #include "../../src/memory/SharedMemory.h"
@@ -8,23 +11,79 @@
 // ======================================================
 // Stepper: herramienta de depuración interactiva del bus MESI
 // ======================================================
+//
+// El bus llama pause(t, ...) al terminar cada transacción (BusRd/BusRdX/BusUpgr/
+// Inv/Flush), con el bus retenido y la respuesta ya entregada.
+//
+// Sin watchpoints se detiene en cada evento (comportamiento clásico). Con
+// watchpoints la simulación corre sin pausas hasta que alguno se cumple.
+// Sintaxis de add_watch (condiciones separadas por coma, todas deben cumplirse):
+//
+//   addr=0x100          línea que contiene la dirección
+//   addr=0x100-0x1ff    rango [lo, hi] (inclusive); basta que la línea lo toque
+//   ev=BusRdX|Inv       tipos de transacción (BusRd, BusRdX, BusUpgr, Inv, Flush)
+//   pe=2                PE emisor; con trans=, PE cuya L1$ hizo la transición
+//   trans=S>M           transición MESI de alguna línea (* = comodín: "*>I")
+//   every=100           dispara en cada 100-ésima coincidencia (conteo de eventos)
+//
+// Las transiciones se detectan comparando el estado de las L1$ antes y después de
+// cada transacción; las silenciosas (E->M en un store hit) se ven en la siguiente.
+//
+// Cada parada imprime solo las líneas que cambiaron desde la parada anterior (la
+// primera muestra todas las válidas) y el delta de lecturas/escrituras de DRAM.
+// En el prompt: ENTER/c continúa hasta el próximo watchpoint, s avanza un evento,
+// f imprime el estado completo y q desactiva el stepper hasta el final.
 struct Stepper {
     bool enabled = true;
+    bool interactive = true;          // false: imprime y sigue (pruebas/registro)
+    std::ostream* out = &std::cout;
+    std::istream* in  = &std::cin;
     std::mutex mx;
 
-    void pause(const char* tag,
+    // Agrega un watchpoint; false (y *err) si la especificación es inválida.
+    bool add_watch(const std::string& spec, std::string* err = nullptr);
+    size_t watch_count() const { return watches_.size(); }
+
+    void pause(const BusTransaction& t,
                const std::vector<MESICache*>& caches,
-               SharedMemory* shm)
-    {
-        if (!enabled) return;
-        std::lock_guard<std::mutex> lk(mx);
+               SharedMemory* shm);
+
+    uint64_t events() const { return events_; }            // transacciones vistas
+    uint64_t stops()  const { return stops_; }             // paradas impresas
+    const std::string& last_reason() const { return last_reason_; }
+
+private:
+    struct Watch {
+        std::string spec;
+        uint64_t lo = 0, hi = UINT64_MAX;
+        uint32_t ev_mask = 0;           // bit = BusMsg; 0 => cualquiera
+        int      pe = -1;
+        bool     trans = false;
+        int      from = -1, to = -1;    // MESI; -1 => comodín
+        uint64_t every = 1;
+        uint64_t hits = 0;
+    };
+    struct LineSnap {
+        int  pe = -1;        // MESICache::id() de la L1$ (no su posición en 'caches')
+        bool valid = false, dirty = false;
+        MESI state = MESI::I;
+        uint64_t line = 0;   // dirección base (MESICache::lineBase)
+        std::array<uint8_t, 32> data{};
+    };
+    using Snapshot = std::vector<LineSnap>;   // [slot de caches][set][way] aplanado
 
-        std::cout << "\n========== EVENTO MESI: " << tag << " ==========\n";
-        for (auto* c : caches)
-            if (c) c->dumpCacheState(std::cout);
-        if (shm) shm->dump_stats(std::cout);
+    static Snapshot capture_(const std::vector<MESICache*>& caches, const BusTransaction& t);
+    bool matches_(const Watch& w, const BusTransaction& t, const Snapshot& before,
+                  const Snapshot& after) const;
+    void print_diff_(const BusTransaction& t, const std::vector<MESICache*>& caches,
+                     SharedMemory* shm);
 
-        std::cout << "Presione ENTER para continuar...\n";
-        std::cin.get();
-    }
+    std::vector<Watch> watches_;
+    bool     need_trans_ = false;   // algún watch usa trans= (exige snapshot por evento)
+    bool     step_once_  = false;   // 's' en el prompt
+    Snapshot seen_;                 // estado tras el evento anterior
+    Snapshot shown_;                // estado en la última parada
+    uint64_t shm_reads_ = 0, shm_writes_ = 0;
+    uint64_t events_ = 0, stops_ = 0;
+    std::string last_reason_;
 };
@@ -0,0 +1,262 @@
+#include "vm/Mmu.hpp"
+
+#include <cstdio>
+
+#include "MesiInterconnect.hpp"
+#include "memory/SharedMemory.h"
+#include "memory/cache/mesi/MESICache.hpp"
+#include "sampling/Timing.hpp"
+
+namespace {
+inline uint64_t pt_index(uint64_t va, int level) { return (va >> (Tlb::kPageShift + 9 * level)) & 511; }
+inline uint64_t align_up(uint64_t v, uint64_t a) { return (v + a - 1) / a * a; }
+}  // namespace
+
+// ===================================================================
+// AddressSpace
+// ===================================================================
+AddressSpace::AddressSpace(SharedMemory& shm, uint64_t phys_base)
+    : shm_(shm), next_(phys_base), end_(shm.size()) {
+  alloc_(kPageBytes, kPageBytes, root_);
+}
+
+uint64_t AddressSpace::phys_bytes_for(uint64_t virt_bytes, bool huge) {
+  static constexpr uint64_t kSlackPages = 16;   // fallos a demanda fuera del rango mapeado
+  if (huge) return (align_up(virt_bytes, kHugeBytes) / kHugeBytes + 1) * kHugeBytes + kSlackPages * kPageBytes;
+  const uint64_t pages = align_up(virt_bytes, kPageBytes) / kPageBytes;
+  return (pages + pages / 512 + 4 + kSlackPages) * kPageBytes;
+}
+
+bool AddressSpace::alloc_(uint64_t bytes, uint64_t align, uint64_t& pa) {
+  const uint64_t p = align_up(next_, align);
+  if (p + bytes > end_) return false;
+  pa = p;
+  next_ = p + bytes;
+  return true;
+}
+
+/* map_page_(va, huge, rd, wr, err) -----------------------------------------
+ * Baja por la tabla creando los niveles que falten (páginas nuevas, en cero)
+ * y escribe la hoja. Si la página ya estaba mapeada (otro PE falló antes) no
+ * hace nada.
+ * ------------------------------------------------------------------------- */
+bool AddressSpace::map_page_(uint64_t va, bool huge, const Read8& rd, const Write8& wr, std::string* err) {
+  const int leaf_level = huge ? 1 : 0;
+  uint64_t table = root_;
+  for (int level = 3; level > leaf_level; --level) {
+    const uint64_t pte_pa = table + pt_index(va, level) * 8;
+    uint64_t pte = rd(pte_pa);
+    if (pte & kHuge) return true;   // ya cubierta por una página de 2 MiB
+    if (!(pte & kPresent)) {
+      uint64_t t = 0;
+      if (!alloc_(kPageBytes, kPageBytes, t)) {
+        if (err) *err = "sin memoria física para tablas de páginas";
+        return false;
+      }
+      ++tables_;
+      pte = t | kPresent;
+      wr(pte_pa, pte);
+    }
+    table = pte & kAddrMask;
+  }
+  const uint64_t leaf = table + pt_index(va, leaf_level) * 8;
+  const uint64_t old = rd(leaf);
+  if (old & kPresent) {
+    if (huge && !(old & kHuge)) {
+      if (err) *err = "la región de 2 MiB ya tiene páginas de 4 KiB";
+      return false;
+    }
+    return true;
+  }
+  const uint64_t bytes = huge ? kHugeBytes : kPageBytes;
+  uint64_t frame = 0;
+  if (!alloc_(bytes, bytes, frame)) {
+    if (err) *err = "sin memoria física para marcos";
+    return false;
+  }
+  wr(leaf, frame | kPresent | (huge ? kHuge : 0));
+  if (huge) huge_[va >> Tlb::kHugeShift] = frame;
+  else      small_[va >> Tlb::kPageShift] = frame;
+  return true;
+}
+
+bool AddressSpace::map(uint64_t va, uint64_t len, bool huge, std::string* err) {
+  std::lock_guard<std::mutex> lk(mtx_);
+  const uint64_t step = huge ? kHugeBytes : kPageBytes;
+  const Read8 rd = [this](uint64_t pa) {
+    uint64_t v = 0;
+    shm_.read_block(pa, &v, 8);
+    return v;
+  };
+  const Write8 wr = [this](uint64_t pa, uint64_t v) { shm_.write_block(pa, &v, 8); };
+  for (uint64_t p = va & ~(step - 1); p < va + len; p += step)
+    if (!map_page_(p, huge, rd, wr, err)) return false;
+  return true;
+}
+
+bool AddressSpace::leaf_(uint64_t va, const Read8& rd, uint64_t& pte_pa, bool& huge) const {
+  uint64_t table = root_;
+  for (int level = 3; level >= 0; --level) {
+    pte_pa = table + pt_index(va, level) * 8;
+    const uint64_t pte = rd(pte_pa);
+    if (!(pte & kPresent)) return false;
+    huge = level == 1 && (pte & kHuge);
+    if (level == 0 || huge) return true;
+    table = pte & kAddrMask;
+  }
+  return false;
+}
+
+bool AddressSpace::translate(uint64_t va, uint64_t& pa) const {
+  std::lock_guard<std::mutex> lk(mtx_);
+  auto it = small_.find(va >> Tlb::kPageShift);
+  if (it != small_.end()) { pa = it->second | (va & (kPageBytes - 1)); return true; }
+  it = huge_.find(va >> Tlb::kHugeShift);
+  if (it != huge_.end()) { pa = it->second | (va & (kHugeBytes - 1)); return true; }
+  return false;
+}
+
+bool AddressSpace::split(uint64_t va, size_t n, const std::function<void(uint64_t, size_t, size_t)>& fn) const {
+  for (size_t done = 0; done < n;) {
+    const uint64_t v = va + done;
+    uint64_t pa = 0;
+    if (!translate(v, pa)) return false;
+    bool huge = false;
+    {
+      std::lock_guard<std::mutex> lk(mtx_);
+      huge = !small_.count(v >> Tlb::kPageShift);
+    }
+    const uint64_t page = huge ? kHugeBytes : kPageBytes;
+    const size_t len = size_t(std::min<uint64_t>(n - done, page - (v & (page - 1))));
+    fn(pa, done, len);
+    done += len;
+  }
+  return true;
+}
+
+uint64_t AddressSpace::pages() const {
+  std::lock_guard<std::mutex> lk(mtx_);
+  return small_.size() + huge_.size();
+}
+
+uint64_t AddressSpace::table_pages() const {
+  std::lock_guard<std::mutex> lk(mtx_);
+  return tables_;
+}
+
+// ===================================================================
+// Mmu
+// ===================================================================
+Mmu::Mmu(int pe, AddressSpace& as, MESICache& cache, MesiInterconnect& bus, const TlbConfig& cfg)
+    : pe_(pe), as_(as), cache_(cache), bus_(bus), tlb_(cfg) {
+  bus_.add_mmu(this);
+}
+
+/* read_pte_(pa) -------------------------------------------------------------
+ * Un nivel del recorrido: load de 8 B por la L1$. Si falla, los ciclos son los
+ * que la L1$ registró para su BusRd.
+ * ------------------------------------------------------------------------- */
+uint64_t Mmu::read_pte_(uint64_t pa) {
+  ++stats_.walk_loads;
+  const LatencyHistogram& h = cache_.stats().lat_cycles[MESICache::LatBusRd];
+  const uint64_t before = h.sum();
+  uint64_t v = 0;
+  if (!cache_.load(pa, &v)) {
+    ++stats_.walk_l1_misses;
+    while (!cache_.load(pa, &v)) {}
+  }
+  stats_.walk_cycles += timing::kInstrCycles + (h.sum() - before);
+  return v;
+}
+
+bool Mmu::walk_(uint64_t va, uint64_t& page_pa, bool& huge) {
+  uint64_t table = as_.root();
+  for (int level = 3; level >= 0; --level) {
+    const uint64_t pte = read_pte_(table + pt_index(va, level) * 8);
+    if (!(pte & AddressSpace::kPresent)) return false;
+    huge = level == 1 && (pte & AddressSpace::kHuge);
+    if (huge) { page_pa = pte & AddressSpace::kAddrMask & ~(AddressSpace::kHugeBytes - 1); return true; }
+    if (level == 0) { page_pa = pte & AddressSpace::kAddrMask; return true; }
+    table = pte & AddressSpace::kAddrMask;
+  }
+  return false;
+}
+
+bool Mmu::translate(uint64_t va, uint64_t& pa, std::string* err) {
+  ++stats_.accesses;
+  if (tlb_.lookup(va, pa)) return true;
+
+  ++stats_.misses;
+  const uint64_t gen = shoot_gen_.load(std::memory_order_acquire);
+  uint64_t page = 0;
+  bool huge = false;
+  while (!walk_(va, page, huge)) {
+    // Fallo de página: mapeo a demanda escribiendo las PTEs por la L1$
+    std::lock_guard<std::mutex> lk(as_.mtx_);
+    const AddressSpace::Read8 rd = [this](uint64_t p) {
+      uint64_t v = 0;
+      while (!cache_.load(p, &v)) {}
+      return v;
+    };
+    const AddressSpace::Write8 wr = [this](uint64_t p, uint64_t v) { while (!cache_.store(p, &v)) {} };
+    std::string why;
+    if (!as_.map_page_(va, false, rd, wr, &why)) {
+      if (err) {
+        char head[64];
+        std::snprintf(head, sizeof head, "fallo de página en 0x%llx: ", (unsigned long long)va);
+        *err = head + why;
+      }
+      return false;
+    }
+    ++stats_.faults;
+  }
+  if (huge) ++stats_.huge_misses;
+  // Si hubo un shootdown durante el recorrido, la traducción puede ser vieja.
+  // Se instala primero y se revisa después: un shootdown que llega entre la
+  // revisión y la inserción ya no la borraría (las fences ordenan la inserción
+  // contra el incremento de shoot_gen_ de invalidate()).
+  tlb_.insert(va, page, huge);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (shoot_gen_.load(std::memory_order_relaxed) != gen) tlb_.invalidate(va, huge);
+  const uint64_t mask = huge ? AddressSpace::kHugeBytes - 1 : AddressSpace::kPageBytes - 1;
+  pa = page | (va & mask);
+  return true;
+}
+
+/* change_(va, new_pa, present) ---------------------------------------------
+ * Reescribe la hoja de 'va' por la L1$ (coherente con las copias de la PTE en
+ * otras L1$) y después pide el shootdown de la página a todas las TLB.
+ * ------------------------------------------------------------------------- */
+bool Mmu::change_(uint64_t va, uint64_t new_pa, bool present) {
+  bool huge = false;
+  {
+    std::lock_guard<std::mutex> lk(as_.mtx_);
+    const AddressSpace::Read8 rd = [this](uint64_t p) {
+      uint64_t v = 0;
+      while (!cache_.load(p, &v)) {}
+      return v;
+    };
+    uint64_t pte_pa = 0;
+    if (!as_.leaf_(va, rd, pte_pa, huge)) return false;
+    const uint64_t page = huge ? AddressSpace::kHugeBytes : AddressSpace::kPageBytes;
+    if (present && (new_pa & (page - 1))) return false;
+    const uint64_t pte = present ? new_pa | AddressSpace::kPresent | (huge ? AddressSpace::kHuge : 0) : 0;
+    while (!cache_.store(pte_pa, &pte)) {}
+    auto& m = huge ? as_.huge_ : as_.small_;
+    const uint64_t vpn = va >> (huge ? Tlb::kHugeShift : Tlb::kPageShift);
+    if (present) m[vpn] = new_pa;
+    else         m.erase(vpn);
+  }
+  bus_.tlb_shootdown(pe_, va, huge);
+  ++stats_.shootdowns_sent;
+  return true;
+}
+
+bool Mmu::remap(uint64_t va, uint64_t new_pa) { return change_(va, new_pa, true); }
+bool Mmu::unmap(uint64_t va) { return change_(va, 0, false); }
+
+void Mmu::invalidate(uint64_t va, bool huge) {
+  shoot_gen_.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (tlb_.invalidate(va, huge)) ++stats_.shootdowns_recv;
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "../utils/RelaxedCounter.hpp"
+#include "vm/Tlb.hpp"
+
+class SharedMemory;
+class MESICache;
+class MesiInterconnect;
+
+/*
+ * Mmu.hpp
+ * =======
+ * Memoria virtual: un espacio de direcciones (AddressSpace) compartido por
+ * los PEs y una MMU por PE (Mmu) con su TLB. MesiMemoryPort::set_mmu hace que
+ * cada acceso del PE use una dirección virtual; la L1$, el bus y SharedMemory
+ * siguen trabajando con direcciones físicas.
+ *
+ * Tabla de páginas (en SharedMemory, estilo x86-64): radix de 4 niveles de
+ * 512 PTEs de 8 B (una página de 4 KiB por tabla), VA de 48 bits. Nivel 3 =
+ * raíz (VA[47:39]), ..., nivel 0 = hojas de 4 KiB (VA[20:12]).
+ *   PTE: bit 0 = presente, bit 7 = página grande (hoja en el nivel 1: 2 MiB),
+ *        bits 12..51 = dirección física de la tabla siguiente o de la página.
+ * El recorrido (page walk) lee cada PTE con MESICache::load, como un load
+ * normal del PE: compite por la L1$ con los datos, puede fallar y cruzar el
+ * bus, y sus ciclos salen del mismo modelo (hit = kInstrCycles, miss = la
+ * latencia que registró la L1$ para su BusRd).
+ *
+ * Fallos de página: una VA sin mapear se mapea a demanda (página de 4 KiB en
+ * cero). Las PTEs nuevas se escriben por la L1$ del PE que falló, así quedan
+ * coherentes con las copias de otras L1$. Si no queda memoria física para la
+ * página o sus tablas, translate() falla y MesiMemoryPort detiene al PE con
+ * el error (IMemoryPort::fault).
+ *
+ * TLB shootdown: Mmu::remap/unmap escriben la PTE por la L1$ y luego piden al
+ * bus (MesiInterconnect::tlb_shootdown) que invalide la página en todas las
+ * TLB conectadas. Un recorrido que estaba en curso durante el shootdown usa
+ * su resultado para ese acceso pero no lo deja en la TLB (lo instala y, si
+ * vio un shootdown, lo vuelve a borrar).
+ */
+class AddressSpace {
+public:
+  static constexpr uint64_t kPageBytes = uint64_t(1) << Tlb::kPageShift;   // 4 KiB
+  static constexpr uint64_t kHugeBytes = uint64_t(1) << Tlb::kHugeShift;   // 2 MiB
+  static constexpr uint64_t kPresent = 1, kHuge = 1u << 7;
+  static constexpr uint64_t kAddrMask = 0x000FFFFFFFFFF000ull;
+
+  // Las tablas y los marcos se toman de [phys_base, shm.size()) en orden.
+  explicit AddressSpace(SharedMemory& shm, uint64_t phys_base = 0);
+
+  // Bytes de memoria física para mapear 'virt_bytes' (marcos, tablas y alineación)
+  static uint64_t phys_bytes_for(uint64_t virt_bytes, bool huge);
+
+  // Host, antes de arrancar los PEs (escribe las tablas directo en SharedMemory):
+  // mapea [va, va+len) con páginas de 4 KiB o de 2 MiB.
+  bool map(uint64_t va, uint64_t len, bool huge, std::string* err = nullptr);
+
+  // Traducción del host (copia de la tabla): inicialización y lecturas DMA
+  bool translate(uint64_t va, uint64_t& pa) const;
+  // Recorre [va, va+n) por tramos físicamente contiguos: fn(pa, desplazamiento, largo)
+  bool split(uint64_t va, size_t n, const std::function<void(uint64_t, size_t, size_t)>& fn) const;
+
+  uint64_t root() const { return root_; }
+  uint64_t pages() const;        // páginas mapeadas (de cualquier tamaño)
+  uint64_t table_pages() const;  // páginas de tablas
+
+  // Acceso a PTEs de 8 B (host: SharedMemory; PE: su L1$)
+  using Read8  = std::function<uint64_t(uint64_t)>;
+  using Write8 = std::function<void(uint64_t, uint64_t)>;
+
+private:
+  friend class Mmu;
+
+  // Con mtx_ tomado. Crea las tablas que falten y escribe la hoja.
+  bool map_page_(uint64_t va, bool huge, const Read8& rd, const Write8& wr, std::string* err);
+  bool alloc_(uint64_t bytes, uint64_t align, uint64_t& pa);
+  bool leaf_(uint64_t va, const Read8& rd, uint64_t& pte_pa, bool& huge) const;
+
+  SharedMemory& shm_;
+  uint64_t root_ = 0, next_ = 0, end_ = 0;
+  uint64_t tables_ = 1;
+  std::unordered_map<uint64_t, uint64_t> small_, huge_;   // vpn -> base física
+  mutable std::mutex mtx_;
+};
+
+class Mmu {
+public:
+  struct Stats {
+    RelaxedCounter<uint64_t> accesses, misses, huge_misses;   // traducciones y fallos de TLB
+    RelaxedCounter<uint64_t> walk_loads, walk_l1_misses;      // PTEs leídas y cuántas fallaron en la L1$
+    RelaxedCounter<uint64_t> walk_cycles;
+    RelaxedCounter<uint64_t> faults;                          // páginas mapeadas a demanda
+    RelaxedCounter<uint64_t> shootdowns_sent;
+    RelaxedCounter<uint64_t, true> shootdowns_recv;           // invalidaciones que acertaron en esta TLB
+    double miss_rate() const { return accesses ? double(misses) / double(accesses) : 0.0; }
+  };
+
+  // Se registra en el bus para recibir shootdowns
+  Mmu(int pe, AddressSpace& as, MESICache& cache, MesiInterconnect& bus, const TlbConfig& cfg = {});
+
+  // Dirección física de 'va' en 'pa' (mapea a demanda si hace falta). false si
+  // el fallo de página no se pudo resolver (motivo en *err). Solo el hilo del PE.
+  bool translate(uint64_t va, uint64_t& pa, std::string* err = nullptr);
+
+  // Desde el hilo del PE: nuevo marco para la página de 'va' (new_pa alineada al
+  // tamaño de la página) o quitar el mapeo; ambos con shootdown. false si 'va'
+  // no estaba mapeada.
+  bool remap(uint64_t va, uint64_t new_pa);
+  bool unmap(uint64_t va);
+
+  // Shootdown recibido (lo llama el bus con el bus retenido)
+  void invalidate(uint64_t va, bool huge);
+
+  int pe() const { return pe_; }
+  const Stats& stats() const { return stats_; }
+  Tlb& tlb() { return tlb_; }
+
+private:
+  bool walk_(uint64_t va, uint64_t& page_pa, bool& huge);
+  uint64_t read_pte_(uint64_t pa);
+  bool change_(uint64_t va, uint64_t new_pa, bool present);
+
+  int pe_;
+  AddressSpace& as_;
+  MESICache& cache_;
+  MesiInterconnect& bus_;
+  Tlb tlb_;
+  Stats stats_;
+  std::atomic<uint64_t> shoot_gen_{0};
+};
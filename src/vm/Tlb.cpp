@@ -0,0 +1,99 @@
+#include "vm/Tlb.hpp"
+
+bool parse_tlb_geom(const std::string& s, int& entries, int& ways) {
+  const size_t c = s.find(':');
+  try {
+    entries = std::stoi(s.substr(0, c));
+    ways = c == std::string::npos ? (entries <= 8 ? entries : 4) : std::stoi(s.substr(c + 1));
+  } catch (const std::exception&) {
+    return false;
+  }
+  return entries >= 1 && ways >= 1 && entries % ways == 0;
+}
+
+bool Tlb::validate(const TlbConfig& c, std::string* err) {
+  auto fail = [&](const char* m) {
+    if (err) *err = m;
+    return false;
+  };
+  if (c.entries < 1 || c.ways < 1 || c.entries % c.ways != 0)
+    return fail("TLB de 4 KiB: entries >= 1 y múltiplo de ways");
+  if (c.huge_entries < 1 || c.huge_ways < 1 || c.huge_entries % c.huge_ways != 0)
+    return fail("TLB de 2 MiB: entries >= 1 y múltiplo de ways");
+  if (c.entries > 65536 || c.huge_entries > 65536) return fail("TLB: a lo sumo 65536 entradas");
+  return true;
+}
+
+Tlb::Tlb(const TlbConfig& c) : cfg_(c) {
+  small_.sets = c.entries / c.ways;
+  small_.ways = c.ways;
+  small_.shift = kPageShift;
+  small_.e = std::make_unique<Entry[]>(size_t(c.entries));
+  huge_.sets = c.huge_entries / c.huge_ways;
+  huge_.ways = c.huge_ways;
+  huge_.shift = kHugeShift;
+  huge_.e = std::make_unique<Entry[]>(size_t(c.huge_entries));
+}
+
+bool Tlb::find_(Array& a, uint64_t va, uint64_t& pa, uint64_t clock) {
+  const uint64_t vpn = va >> a.shift;
+  Entry* s = a.set(vpn);
+  for (int w = 0; w < a.ways; ++w)
+    if (s[w].key.load(std::memory_order_acquire) == vpn + 1) {
+      s[w].stamp = clock;
+      pa = s[w].pa | (va & ((uint64_t(1) << a.shift) - 1));
+      return true;
+    }
+  return false;
+}
+
+bool Tlb::lookup(uint64_t va, uint64_t& pa, bool* huge) {
+  ++clock_;
+  if (find_(small_, va, pa, clock_)) {
+    if (huge) *huge = false;
+    return true;
+  }
+  if (find_(huge_, va, pa, clock_)) {
+    if (huge) *huge = true;
+    return true;
+  }
+  return false;
+}
+
+/* insert(va, page_pa, huge) ------------------------------------------------
+ * Vía vacía si hay; si no, la de sello más viejo. La traducción se escribe
+ * antes de publicar la clave (release), así un lookup nunca la ve a medias.
+ * ------------------------------------------------------------------------- */
+void Tlb::insert(uint64_t va, uint64_t page_pa, bool huge) {
+  Array& a = huge ? huge_ : small_;
+  const uint64_t vpn = va >> a.shift;
+  Entry* s = a.set(vpn);
+  int victim = 0;
+  for (int w = 0; w < a.ways; ++w) {
+    const uint64_t k = s[w].key.load(std::memory_order_relaxed);
+    if (k == vpn + 1 || k == 0) { victim = w; break; }
+    if (s[w].stamp < s[victim].stamp) victim = w;
+  }
+  Entry& e = s[victim];
+  e.key.store(0, std::memory_order_relaxed);
+  e.pa = page_pa;
+  e.stamp = ++clock_;
+  e.key.store(vpn + 1, std::memory_order_release);
+}
+
+bool Tlb::invalidate(uint64_t va, bool huge) {
+  Array& a = huge ? huge_ : small_;
+  const uint64_t vpn = va >> a.shift;
+  Entry* s = a.set(vpn);
+  bool hit = false;
+  for (int w = 0; w < a.ways; ++w) {
+    uint64_t k = vpn + 1;
+    hit |= s[w].key.compare_exchange_strong(k, 0, std::memory_order_relaxed);
+  }
+  return hit;
+}
+
+void Tlb::invalidate_all() {
+  for (Array* a : {&small_, &huge_})
+    for (int i = 0; i < a->sets * a->ways; ++i) a->e[size_t(i)].key.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/*
+ * Tlb.hpp
+ * =======
+ * TLB de un PE (ver vm/Mmu.hpp): dos arreglos asociativos por conjuntos, uno
+ * para páginas de 4 KiB y otro para páginas grandes de 2 MiB (como las DTLB
+ * separadas por tamaño). Reemplazo LRU por set.
+ *
+ * Hilos: lookup/insert los llama solo el hilo del PE dueño; invalidate (TLB
+ * shootdown) puede llegar desde otro hilo con el bus retenido. La clave de cada
+ * entrada es atómica y el shootdown solo la borra, así que el dueño nunca lee
+ * una entrada a medio escribir; la traducción y el sello LRU son del dueño.
+ */
+struct TlbConfig {
+  int entries = 64, ways = 4;             // páginas de 4 KiB
+  int huge_entries = 32, huge_ways = 4;   // páginas de 2 MiB
+};
+
+// "E[:W]" -> entries y ways (W por defecto: totalmente asociativa si E <= 8, si no 4)
+bool parse_tlb_geom(const std::string& s, int& entries, int& ways);
+
+class Tlb {
+public:
+  static constexpr int kPageShift = 12, kHugeShift = 21;
+
+  explicit Tlb(const TlbConfig& c);
+
+  // entries >= 1, ways >= 1 y entries múltiplo de ways (en ambos arreglos)
+  static bool validate(const TlbConfig& c, std::string* err);
+
+  // Dirección física de 'va' si alguna entrada la cubre; '*huge' indica cuál acertó
+  bool lookup(uint64_t va, uint64_t& pa, bool* huge = nullptr);
+  // Instala la traducción de la página de 'va' (page_pa: base física de la página)
+  void insert(uint64_t va, uint64_t page_pa, bool huge);
+
+  // Shootdown: borra la entrada de la página de 'va' (del tamaño indicado). Desde cualquier hilo.
+  bool invalidate(uint64_t va, bool huge);
+  void invalidate_all();
+
+  const TlbConfig& config() const { return cfg_; }
+
+private:
+  struct Entry {
+    std::atomic<uint64_t> key{0};   // vpn + 1 (0 = vacía)
+    uint64_t pa = 0;
+    uint64_t stamp = 0;             // LRU (solo el dueño)
+  };
+  struct Array {
+    int sets = 1, ways = 1, shift = kPageShift;
+    std::unique_ptr<Entry[]> e;
+    Entry* set(uint64_t vpn) { return &e[size_t(vpn % uint64_t(sets)) * size_t(ways)]; }
+  };
+
+  static bool find_(Array& a, uint64_t va, uint64_t& pa, uint64_t clock);
+
+  TlbConfig cfg_;
+  Array small_, huge_;
+  uint64_t clock_ = 0;
+};
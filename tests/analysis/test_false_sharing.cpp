@@ -0,0 +1,68 @@
+#include <cassert>
+#include <cstdio>
+
+#include "MesiInterconnect.hpp"
+#include "analysis/FalseSharingDetector.hpp"
+#include "dma/DmaAgent.hpp"
+#include "memory/SharedMemory.h"
+#include "memory/cache/mesi/MESICache.hpp"
+
+int main() {
+  SharedMemory shm;
+  MesiInterconnect bus(0);
+  bus.set_shared_memory(&shm);
+  MESICache c0(0, bus), c1(1, bus);
+  bus.connect(&c0); bus.connect(&c1);
+
+  FalseSharingDetector fsd(2);
+  bus.set_false_sharing_detector(&fsd);
+  DmaAgent dma(bus);
+
+  auto st = [](MESICache& c, uint64_t a, uint64_t v) { while (!c.store(a, &v)) {} };
+  auto ld = [](MESICache& c, uint64_t a) { uint64_t v = 0; while (!c.load(a, &v)) {} return v; };
+
+  // --- 1) cada PE escribe su propia palabra de la línea 0x100: ping-pong falso ---
+  for (int i = 0; i < 5; ++i) {
+    st(c0, 0x100, i);       // palabra 0
+    st(c1, 0x108, i);       // palabra 1
+  }
+  // --- 2) contador compartido en 0x200 (misma palabra): comunicación real ---
+  for (int i = 0; i < 3; ++i) {
+    st(c0, 0x200, ld(c0, 0x200) + 1);
+    st(c1, 0x200, ld(c1, 0x200) + 1);
+  }
+  assert(ld(c0, 0x200) == 6);
+
+  const auto rows = fsd.ranked();
+  assert(rows.size() >= 2);
+  assert(rows[0].line == 0x100);
+  assert(rows[0].true_inv == 0 && rows[0].false_inv == 9);  // 10 escrituras alternadas
+  assert(rows[0].pe_mask == 0x3);
+  assert(rows[0].words[0] == 0x1 && rows[0].words[1] == 0x2);
+
+  bool found = false;
+  for (const auto& r : rows)
+    if (r.line == 0x200) { found = true; assert(r.false_inv == 0 && r.true_inv > 0); }
+  assert(found);
+  assert(fsd.total_false() == 9);
+
+  // --- 3) BusWrLine cubre la línea entera (true); el DMA de 8 B sólo la palabra 0 ---
+  ld(c1, 0x308);
+  for (int w = 0; w < 4; ++w) {   // store no temporal de toda la línea => BusWrLine
+    const uint64_t v = w;
+    c0.storeNonTemporal(0x300 + 8 * w, &v);
+  }
+  ld(c1, 0x418);
+  const double d = 1.0;
+  assert(dma.write(0x400, &d, sizeof d));   // DMA: Inv con la máscara de la palabra 0
+  int lines = 0;
+  for (const auto& r : fsd.ranked()) {
+    if (r.line == 0x300) { ++lines; assert(r.false_inv == 0 && r.true_inv == 1); }
+    if (r.line == 0x400) { ++lines; assert(r.false_inv == 1 && r.true_inv == 0); }
+  }
+  assert(lines == 2);
+  assert(fsd.total_false() == 10);
+
+  std::puts("OK false sharing detector");
+  return 0;
+}
@@ -0,0 +1,45 @@
+#include <cassert>
+#include <cstdio>
+
+#include "MesiInterconnect.hpp"
+#include "memory/SharedMemory.h"
+#include "memory/cache/mesi/MESICache.hpp"
+
+static void ld(MESICache& c, uint64_t a) { uint64_t v = 0; while (!c.load(a, &v)) {} }
+
+int main() {
+  SharedMemory shm(8192);
+  MesiInterconnect bus(0);
+  bus.set_shared_memory(&shm);
+  MESICache c0(0, bus), c1(1, bus);
+  bus.connect(&c0); bus.connect(&c1);
+
+  // --- 1) 3 líneas del set 0 en ronda: 3 compulsory y luego sólo conflict ---
+  for (int r = 0; r < 4; ++r)
+    for (uint64_t a : {0x000, 0x100, 0x200}) ld(c0, a);
+  auto s = c0.stats();
+  assert(s.miss_compulsory == 3);
+  assert(s.miss_conflict == 9);
+  assert(s.miss_capacity == 0 && s.miss_coherence == 0);
+
+  // --- 2) barrido de 24 líneas (> 16 de capacidad) dos veces: capacity ---
+  for (int r = 0; r < 2; ++r)
+    for (uint64_t i = 0; i < 24; ++i) ld(c0, 0x1000 + i * 32);
+  s = c0.stats();
+  assert(s.miss_compulsory == 3 + 24);
+  assert(s.miss_capacity == 24);
+
+  // --- 3) otro PE escribe una línea que tenemos: el siguiente miss es coherence ---
+  ld(c0, 0x1000 + 23 * 32);                 // hit (MRU)
+  uint64_t v = 7;
+  while (!c1.store(0x1000 + 23 * 32, &v)) {}
+  ld(c0, 0x1000 + 23 * 32);
+  s = c0.stats();
+  assert(s.miss_coherence == 1);
+
+  // Las cuatro clases suman el total de misses
+  assert(s.miss_compulsory + s.miss_capacity + s.miss_conflict + s.miss_coherence == s.cache_misses);
+
+  std::puts("OK miss classifier (compulsory/capacity/conflict/coherence)");
+  return 0;
+}
@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <list>
+#include <vector>
+
+#include "analysis/ReuseDistance.hpp"
+
+// Simulación directa de una FA-LRU de C líneas (referencia)
+static double lru_miss_ratio(const std::vector<uint64_t>& lines, size_t C) {
+  std::list<uint64_t> lru;
+  uint64_t miss = 0;
+  for (uint64_t l : lines) {
+    auto it = std::find(lru.begin(), lru.end(), l);
+    if (it == lru.end()) { ++miss; if (lru.size() == C) lru.pop_back(); }
+    else lru.erase(it);
+    lru.push_front(l);
+  }
+  return double(miss) / double(lines.size());
+}
+
+int main() {
+  // --- 1) ciclo sobre K líneas: LRU falla siempre si C < K, sólo frías si C >= K ---
+  {
+    const int K = 10, R = 50;
+    ReuseDistanceProfiler rd;
+    for (int r = 0; r < R; ++r)
+      for (int k = 0; k < K; ++k) rd.access(uint64_t(k) * 32 + 8);
+    assert(rd.cold() == K);
+    assert(rd.miss_ratio(K - 1) == 1.0);
+    assert(std::abs(rd.miss_ratio(K) - double(K) / (K * R)) < 1e-12);
+  }
+
+  // --- 2) traza pseudo-aleatoria (con compactación del árbol): igual a la LRU directa ---
+  std::vector<uint64_t> lines;
+  uint64_t x = 42;
+  for (int i = 0; i < 20000; ++i) {
+    x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    // 80% de los accesos a 64 líneas "calientes", 20% a 2048
+    const uint64_t r = x >> 33;
+    lines.push_back((r % 5) ? (r >> 3) % 64 : 64 + (r >> 3) % 2048);
+  }
+  ReuseDistanceProfiler exact;
+  for (uint64_t l : lines) exact.access(l * 32);
+  for (size_t C : {1, 8, 16, 64, 128, 512})
+    assert(std::abs(exact.miss_ratio(C) - lru_miss_ratio(lines, C)) < 1e-12);
+
+  // --- 3) muestreo SHARDS: la MRC aproximada queda cerca de la exacta ---
+  ReuseDistanceProfiler sampled(0.1);
+  for (uint64_t l : lines) sampled.access(l * 32);
+  assert(sampled.accesses() == lines.size());
+  assert(sampled.sampled() < lines.size() / 4);
+  for (size_t C : {16, 64, 128, 512})
+    assert(std::abs(sampled.miss_ratio(C) - exact.miss_ratio(C)) < 0.08);
+
+  // --- 4) merge: el agregado de dos perfiles iguales tiene la misma MRC ---
+  ReuseDistanceProfiler all;
+  all.merge(exact); all.merge(exact);
+  assert(all.accesses() == 2 * lines.size());
+  assert(std::abs(all.miss_ratio(64) - exact.miss_ratio(64)) < 1e-12);
+
+  std::puts("OK reuse distance profiler (exact LRU, SHARDS, merge)");
+  return 0;
+}
@@ -0,0 +1,72 @@
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "MesiInterconnect.hpp"
+#include "memory/SharedMemory.h"
+#include "memory/cache/mesi/MESICache.hpp"
+
+int main() {
+  SharedMemory shm;
+  MesiInterconnect bus(0);
+  bus.set_shared_memory(&shm);
+
+  MESICache c0(0, bus), c1(1, bus), c2(2, bus), c3(3, bus);
+  MESICache* cs[4] = {&c0, &c1, &c2, &c3};
+  for (auto* c : cs) bus.connect(c);
+
+  const uint64_t ctr = 0x400;   // contador compartido (fetch-add)
+  const uint64_t cas = 0x500;   // contador compartido (bucle CAS)
+  const int kIters = 2000;
+
+  // --- 1) fetch-add y CAS concurrentes desde 4 hilos: no se pierde ningún incremento ---
+  std::vector<std::thread> th;
+  for (int p = 0; p < 4; ++p) {
+    th.emplace_back([&, p] {
+      MESICache& c = *cs[p];
+      for (int i = 0; i < kIters; ++i) {
+        c.atomicRMW(ctr, MESICache::AtomicOp::FetchAdd, 1);
+        for (;;) {
+          uint64_t seen = c.atomicRMW(cas, MESICache::AtomicOp::FetchAdd, 0); // lectura atómica
+          bool ok = false;
+          c.atomicRMW(cas, MESICache::AtomicOp::CAS, seen + 1, seen, &ok);
+          if (ok) break;
+        }
+      }
+    });
+  }
+  for (auto& t : th) t.join();
+
+  uint64_t v = 0;
+  while (!c0.load(ctr, &v)) {}
+  assert(v == uint64_t(4 * kIters));
+  while (!c0.load(cas, &v)) {}
+  assert(v == uint64_t(4 * kIters));
+
+  // --- 2) LL/SC: sin interferencia tiene éxito ---
+  const uint64_t x = 0x600;
+  uint64_t old = c1.loadLinked(x);
+  assert(c1.storeConditional(x, old + 5));
+
+  // --- 3) LL/SC: un store ajeno (BusRdX/BusUpgr) rompe la reserva ---
+  old = c1.loadLinked(x);
+  uint64_t w = 42;
+  while (!c2.store(x, &w)) {}
+  assert(!c1.storeConditional(x, old + 1));
+  assert(c1.stats().sc_failures == 1);
+  assert(c1.stats().resv_lost >= 1);
+
+  // --- 4) el valor final es el del store de c2 ---
+  while (!c0.load(x, &v)) {}
+  assert(v == 42);
+
+  // Los atómicos que tuvieron que mover la línea cuentan tráfico de propiedad
+  int bus_ops = 0;
+  for (auto* c : cs) bus_ops += c->stats().atomic_bus_ops;
+  assert(bus_ops > 0);
+
+  std::puts("OK MESI atomics (fetch-add, CAS, LL/SC)");
+  return 0;
+}
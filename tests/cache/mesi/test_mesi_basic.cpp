@@ -4,12 +4,24 @@
 #include <array>
 #include <cstring>
 
-#include "../src/memory/cache/mesi/MesiInterconnect.hpp"
-#include "../src/memory/cache/mesi/MESICache.hpp"
+#include "MesiInterconnect.hpp"
+#include "memory/SharedMemory.h"
+#include "memory/cache/mesi/MESICache.hpp"
+
+// Escribe bytes directamente en SharedMemory (sin pasar por la caché)
+static void shm_write(SharedMemory& shm, uint64_t addr, const uint8_t* p, uint32_t n) {
+  auto req = std::make_shared<Message>(MessageType::WRITE_MEM, -1, -1);
+  req->payload.write_mem.address = static_cast<uint32_t>(addr);
+  req->payload.write_mem.size    = n;
+  req->data_write.assign(p, p + n);
+  shm.handle_message(req, [](MessageP){});
+}
 
 int main() {
   // --- Bus + DRAM ---
-  MesiInterconnect bus(/*dram_bytes=*/ 1<<20); // 1 MiB
+  SharedMemory shm;
+  MesiInterconnect bus(0);
+  bus.set_shared_memory(&shm);
 
   // --- Caches conectadas al bus (SIN adapter) ---
   MESICache c0(0, bus);
@@ -20,9 +32,10 @@ int main() {
   // --- Inicializa una línea en DRAM ---
   uint64_t addr = 0x100; // alguna dirección
   uint64_t base = addr & ~((uint64_t)MESICache::kLineSize - 1);
-  auto& mem = bus.dram();
+  uint8_t init[MESICache::kLineSize];
   for (int i = 0; i < (int)MESICache::kLineSize; ++i)
-    mem[base + i] = static_cast<uint8_t>(i);
+    init[i] = static_cast<uint8_t>(i);
+  shm_write(shm, base, init, MESICache::kLineSize);
 
   // 1) LOAD en c0 => miss -> BusRd -> Data -> reintenta
   uint64_t out=0;
@@ -4,13 +4,33 @@
 #include <array>
 #include <cstring>
 
-#include "../src/memory/cache/mesi/MesiInterconnect.hpp"
-#include "../src/memory/cache/mesi/MESICache.hpp"
+#include "MesiInterconnect.hpp"
+#include "memory/SharedMemory.h"
+#include "memory/cache/mesi/MESICache.hpp"
+
+// Acceso directo a SharedMemory (sin pasar por la caché)
+static void shm_write(SharedMemory& shm, uint64_t addr, const uint8_t* p, uint32_t n) {
+  auto req = std::make_shared<Message>(MessageType::WRITE_MEM, -1, -1);
+  req->payload.write_mem.address = static_cast<uint32_t>(addr);
+  req->payload.write_mem.size    = n;
+  req->data_write.assign(p, p + n);
+  shm.handle_message(req, [](MessageP){});
+}
+
+static void shm_read(SharedMemory& shm, uint64_t addr, uint8_t* p, uint32_t n) {
+  auto req = std::make_shared<Message>(MessageType::READ_MEM, -1, -1);
+  req->payload.read_mem.address = static_cast<uint32_t>(addr);
+  req->payload.read_mem.size    = n;
+  shm.handle_message(req, [&](MessageP resp){
+    if (resp && resp->payload.read_resp.status) std::memcpy(p, resp->read_resp_data.data(), n);
+  });
+}
 
 int main() {
   // --- Bus + DRAM ---
-  MesiInterconnect bus(/*dram_bytes=*/ 1<<20); // 1 MiB
-  auto& dram = bus.dram();
+  SharedMemory shm;
+  MesiInterconnect bus(0);
+  bus.set_shared_memory(&shm);
 
   // --- Dos L1$ conectadas al bus (SIN adapter) ---
   MESICache c0(0, bus);
@@ -21,8 +41,9 @@ int main() {
   // --- Inicializa una línea en DRAM ---
   const uint64_t addr = 0x200;
   const uint64_t line_base = addr & ~((uint64_t)MESICache::kLineSize - 1);
-  for (int i = 0; i < (int)MESICache::kLineSize; ++i)
-    dram[line_base + i] = (uint8_t)0x11;
+  uint8_t init[MESICache::kLineSize];
+  std::memset(init, 0x11, sizeof(init));
+  shm_write(shm, line_base, init, MESICache::kLineSize);
 
   // --- 1) c0 STORE -> M (primer intento miss->BusRdX, segundo intento hit) ---
   uint64_t v = 0xDEADBEEFCAFEBABEULL;
@@ -41,7 +62,7 @@ int main() {
   // --- Verifica que DRAM tenga el valor escrito por c0 (write-back del Flush) ---
   uint64_t memval = 0;
   const uint32_t off = addr & (MESICache::kLineSize - 1); // offset dentro de la línea
-  std::memcpy(&memval, dram.data() + line_base + off, 8);
+  shm_read(shm, line_base + off, reinterpret_cast<uint8_t*>(&memval), 8);
   assert(memval == v);
 
   std::puts("OK M->S downgrade with Flush");
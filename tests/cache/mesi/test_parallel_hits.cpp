@@ -0,0 +1,140 @@
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "MesiInterconnect.hpp"
+#include "memory/SharedMemory.h"
+#include "memory/cache/mesi/MESICache.hpp"
+
+// Hits del dueño en paralelo con snoops de otros hilos (correr también con
+// -DMESI_SANITIZE=thread: no debe haber carreras).
+int main() {
+  // --- 1) Mismo set: c0 escribe/lee A en M mientras c1 invalida C (otra vía del set 0) ---
+  {
+    SharedMemory shm;
+    MesiInterconnect bus(0);
+    bus.set_shared_memory(&shm);
+    MESICache c0(0, bus), c1(1, bus);
+    bus.connect(&c0);
+    bus.connect(&c1);
+
+    const uint64_t A = 0x000, C = 0x100, B = 0x080;   // A y C en el set 0, B en el 4
+    const int kIters = 20000;
+    uint64_t v = 0, u = 0;
+    while (!c0.store(A, &v)) {}
+    while (!c0.load(C, &u)) {}
+
+    // 'started': el primer store de c1 ya invalidó la copia de C de c0; sin esa
+    // espera el bucle del dueño puede terminar antes de que el hilo corra.
+    std::atomic<bool> done{false}, started{false};
+    std::thread writer([&] {
+      for (uint64_t j = 1; !done.load(std::memory_order_relaxed); ++j) {
+        while (!c1.store(C, &j)) {}   // BusRdX/BusUpgr: snoop en el set 0 de c0
+        while (!c1.store(B, &j)) {}
+        started.store(true, std::memory_order_release);
+      }
+    });
+    while (!started.load(std::memory_order_acquire)) std::this_thread::yield();
+
+    uint64_t last_c = 0;
+    for (uint64_t i = 1; i <= kIters; ++i) {
+      assert(c0.store(A, &i));          // siempre hit: nadie más toca A
+      uint64_t a = 0;
+      assert(c0.load(A, &a) && a == i);
+      if (i % 64 == 0) {                // C cambia de dueño: valores crecientes (coherencia)
+        uint64_t c = 0;
+        while (!c0.load(C, &c)) {}
+        assert(c >= last_c);
+        last_c = c;
+      }
+    }
+    done = true;
+    writer.join();
+
+    const auto& st = c0.stats();
+    assert(st.loads >= kIters && st.invalidations > 0);   // Counter es int, como kIters
+    uint64_t a = 0;
+    assert(c0.load(A, &a) && a == uint64_t(kIters));
+  }
+
+  // --- 2) Varios PEs con hits en sus propias líneas y un tercero que genera snoops ---
+  {
+    SharedMemory shm;
+    MesiInterconnect bus(0);
+    bus.set_shared_memory(&shm);
+    const int P = 4;
+    std::vector<std::unique_ptr<MESICache>> c;
+    for (int k = 0; k <= P; ++k) {
+      c.push_back(std::make_unique<MESICache>(k, bus));
+      bus.connect(c.back().get());
+    }
+    // Cada PE: una línea propia en el set k (en M) y una compartida en el set 7
+    const uint64_t shared = 7 * 32;
+    uint64_t u = 0;
+    for (int k = 0; k < P; ++k) {
+      uint64_t v = uint64_t(k) << 32;
+      while (!c[k]->store(uint64_t(k) * 32, &v)) {}
+      while (!c[k]->load(shared, &u)) {}
+    }
+
+    std::atomic<bool> done{false};
+    std::thread snooper([&] {
+      // Tres líneas del set 7 en ronda: siempre falla, cada BusRd hace snoop en todos
+      for (uint64_t i = 0; !done.load(std::memory_order_relaxed); ++i)
+        while (!c[P]->load(shared + (i % 3) * 256, &u)) {}
+    });
+
+    std::vector<std::thread> th;
+    std::atomic<int> bad{0};
+    for (int k = 0; k < P; ++k)
+      th.emplace_back([&, k] {
+        const uint64_t addr = uint64_t(k) * 32;
+        for (uint64_t i = 0; i < 20000; ++i) {
+          uint64_t v = (uint64_t(k) << 32) | i, r = 0;
+          bad += !c[k]->store(addr, &v);
+          bad += !c[k]->load(addr, &r) || r != v;
+        }
+      });
+    for (auto& t : th) t.join();
+    done = true;
+    snooper.join();
+    assert(bad == 0);
+  }
+
+  // --- 3) Store no temporal sobre una línea presente mientras otro PE la escribe ---
+  // El NT store con hit va por store(); si un BusRdX ajeno invalida la línea
+  // entre medio, store() retorna false y hay que reintentar (no perder el valor).
+  {
+    SharedMemory shm;
+    MesiInterconnect bus(0);
+    bus.set_shared_memory(&shm);
+    MESICache c0(0, bus), c1(1, bus);
+    bus.connect(&c0);
+    bus.connect(&c1);
+
+    const uint64_t X = 0x400;   // c0 escribe la palabra 0, c1 la 1
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+      for (uint64_t j = 1; !done.load(std::memory_order_relaxed); ++j)
+        while (!c1.store(X + 8, &j)) {}
+    });
+
+    for (uint64_t i = 1; i <= 20000; ++i) {
+      uint64_t u = 0;
+      while (!c0.load(X, &u)) {}        // la trae: el NT store verá hit
+      assert(c0.storeNonTemporal(X, &i));
+      c0.fence();
+      while (!c0.load(X, &u)) {}
+      assert(u == i);
+    }
+    done = true;
+    writer.join();
+  }
+
+  std::puts("OK parallel hits");
+  return 0;
+}
@@ -0,0 +1,88 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+
+#include "MesiInterconnect.hpp"
+#include "memory/SharedMemory.h"
+#include "memory/cache/mesi/MESICache.hpp"
+
+// tag_match<N> contra la comparación escalar, con tags repetidos y ~0
+template <int N>
+static void check_match(std::mt19937_64& rng) {
+  alignas(64) uint64_t tags[N];
+  for (int it = 0; it < 2000; ++it) {
+    for (int w = 0; w < N; ++w) tags[w] = (rng() % 4 == 0) ? ~uint64_t(0) : rng() % 5;
+    const uint64_t t = (it % 7 == 0) ? ~uint64_t(0) : rng() % 5;
+    uint32_t ref = 0;
+    for (int w = 0; w < N; ++w) ref |= uint32_t(tags[w] == t) << w;
+    assert(tag_match<N>(tags, t) == ref);
+  }
+  // Solo difiere la mitad alta de 64 bits: no debe confundirse con un match
+  for (int w = 0; w < N; ++w) tags[w] = (uint64_t(w + 1) << 32) | 7;
+  assert(tag_match<N>(tags, 7) == 0);
+  assert(tag_match<N>(tags, (uint64_t(N) << 32) | 7) == (1u << (N - 1)));
+}
+
+int main() {
+  std::mt19937_64 rng(39);
+  check_match<1>(rng);
+  check_match<2>(rng);
+  check_match<3>(rng);
+  check_match<4>(rng);
+  check_match<8>(rng);
+  check_match<16>(rng);
+
+  SharedMemory shm;
+  MesiInterconnect bus(0);
+  bus.set_shared_memory(&shm);
+
+  // Cada L1$ empieza en su propia línea de 64 B del host (también en el heap)
+  static_assert(alignof(MESICache) >= 64);
+  auto c0 = std::make_unique<MESICache>(0, bus);
+  auto c1 = std::make_unique<MESICache>(1, bus);
+  assert(reinterpret_cast<uintptr_t>(c0.get()) % 64 == 0);
+  assert(reinterpret_cast<uintptr_t>(c1.get()) % 64 == 0);
+  bus.connect(c0.get());
+  bus.connect(c1.get());
+
+  // Vacía: ninguna vía válida
+  for (int s = 0; s < MESICache::kSets; ++s)
+    for (int w = 0; w < MESICache::kWays; ++w) assert(!c0->lineAt(s, w).valid);
+
+  // c0 escribe: línea en M, la vista refleja tag/dirty/datos
+  const uint64_t a = 0x240, stride = uint64_t(MESICache::kSets) * MESICache::kLineSize;
+  const uint32_t set = (a >> 5) & 7;
+  uint64_t v = 0x1122334455667788ULL, out = 0;
+  while (!c0->store(a, &v)) {}
+  assert(c0->hasLine(a) && !c0->hasLine(a + stride));
+  {
+    const CacheLine L = c0->lineAt(set, 0);
+    assert(L.valid && L.dirty && L.state == MESI::M && L.tag == (a >> 8));
+    assert(MESICache::lineAddress(L.tag, set) == (a & ~uint64_t(31)));
+    assert(L.data[a & 31] == 0x88);
+  }
+
+  // c1 escribe la misma línea: c0 queda en I (válida, mismo tag) y ya no hace hit
+  uint64_t w1 = 42;
+  while (!c1->store(a, &w1)) {}
+  assert(!c0->hasLine(a) && !c0->lookupLine(a).hit);
+  {
+    const CacheLine L = c0->lineAt(set, 0);
+    assert(L.valid && !L.dirty && L.state == MESI::I && L.tag == (a >> 8));
+  }
+
+  // La vía en I es la primera en reutilizarse; luego se desaloja por LRU
+  while (!c0->load(a + stride, &out)) {}
+  assert(c0->lineAt(set, 0).tag == ((a + stride) >> 8));
+  while (!c0->load(a + 2 * stride, &out)) {}
+  assert(c0->lineAt(set, 1).tag == ((a + 2 * stride) >> 8));
+  while (!c0->load(a, &out)) {}     // desaloja la LRU (vía 0)
+  assert(out == 42);
+  assert(c0->lookupLine(a).hit && c0->lookupLine(a).way == 0);
+  assert(!c0->hasLine(a + stride) && c0->hasLine(a + 2 * stride));
+
+  std::puts("OK tag store: tag_match SIMD, alineación y vistas por vía");
+  return 0;
+}
@@ -0,0 +1,132 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+
+#include "MesiInterconnect.hpp"
+#include "memory/SharedMemory.h"
+#include "memory/cache/mesi/MESICache.hpp"
+
+// Línea de 'addr' en la L1$ (inválida si no está)
+static CacheLine line_of(const MESICache& c, uint64_t addr) {
+  const uint64_t base = addr & ~uint64_t(MESICache::kLineSize - 1);
+  for (int s = 0; s < MESICache::kSets; ++s)
+    for (int w = 0; w < MESICache::kWays; ++w) {
+      const CacheLine L = c.lineAt(s, w);
+      if (L.valid && c.lineBase(s, w) == base) return L;
+    }
+  return CacheLine{};
+}
+
+// Estado MESI de la línea de 'addr' en la L1$ (I si no está)
+static MESI state_of(const MESICache& c, uint64_t addr) { return line_of(c, addr).state; }
+
+static uint64_t mem64(const SharedMemory& shm, uint64_t addr) {
+  uint64_t v = 0;
+  shm.read_block(addr, &v, 8);
+  return v;
+}
+
+int main() {
+  // --- parse / nombres ---
+  WritePolicy p = WritePolicy::WriteBack;
+  for (const char* n : {"wb", "wb-na", "wt", "wt-na"}) {
+    assert(write_policy::parse(n, p));
+    assert(std::string(write_policy::name(p)) == n);
+  }
+  assert(!write_policy::parse("wx", p));
+
+  SharedMemory shm;
+  MesiInterconnect bus(0);
+  bus.set_shared_memory(&shm);
+  MESICache c0(0, bus), c1(1, bus);
+  bus.connect(&c0);
+  bus.connect(&c1);
+  const auto& bs = bus.stats();
+  uint64_t v = 0, out = 0;
+
+  // --- 1) write-through: el miss trae la línea con BusRd, el hit escribe a través ---
+  c0.setWritePolicy(WritePolicy::WriteThrough);
+  v = 11;
+  assert(!c0.store(0x000, &v));
+  assert(bs.busRd == 1 && bs.busRdX == 0);
+  while (!c1.load(0x000, &out)) {}              // c1 comparte la línea
+  assert(c0.store(0x000, &v));
+  assert(bs.busWr == 1 && mem64(shm, 0x000) == 11);
+  assert(state_of(c0, 0x000) != MESI::M && state_of(c1, 0x000) == MESI::I);
+  assert(!line_of(c0, 0x000).dirty);              // la copia sigue limpia
+  assert(c0.stats().bus_writes == 1);
+
+  // --- 2) write-around (wt-na / wb-na): el miss no instala la línea ---
+  for (WritePolicy wp : {WritePolicy::WriteThroughNoAlloc, WritePolicy::WriteBackNoAlloc}) {
+    c0.setWritePolicy(wp);
+    const uint64_t a = wp == WritePolicy::WriteBackNoAlloc ? 0x108 : 0x100;
+    v = a;
+    assert(c0.store(a, &v));
+    assert(state_of(c0, a) == MESI::I && mem64(shm, a) == a);
+  }
+  assert(c0.stats().write_arounds == 2 && bs.busWr == 3);
+
+  // Regiones: la última que contiene la dirección gana sobre la política de la L1$
+  c0.setWritePolicy(WritePolicy::WriteBack);
+  c0.addWriteRegion(0x400, 0x100, WritePolicy::WriteThroughNoAlloc);
+  c0.addWriteRegion(0x480, 0x20, WritePolicy::WriteBack);
+  assert(c0.writePolicyFor(0x3f8) == WritePolicy::WriteBack);
+  assert(c0.writePolicyFor(0x400) == WritePolicy::WriteThroughNoAlloc);
+  assert(c0.writePolicyFor(0x498) == WritePolicy::WriteBack);
+  assert(c0.writePolicyFor(0x4a0) == WritePolicy::WriteThroughNoAlloc);
+
+  // --- 3) stores no temporales: línea completa -> BusWrLine, sin RFO ---
+  const uint64_t rdx0 = bs.busRdX, rd0 = bs.busRd;
+  for (uint64_t i = 0; i < 4; ++i) {
+    v = 100 + i;
+    assert(c1.storeNonTemporal(0x200 + 8 * i, &v));
+  }
+  assert(bs.busWrLine == 1 && bs.busRdX == rdx0 && bs.busRd == rd0);
+  assert(state_of(c1, 0x200) == MESI::I);
+  for (uint64_t i = 0; i < 4; ++i) assert(mem64(shm, 0x200 + 8 * i) == 100 + i);
+  assert(c1.stats().nt_stores == 4 && c1.stats().nt_lines == 1);
+
+  // Línea incompleta: queda en el buffer hasta fence() y sale como BusWr por palabra
+  const uint64_t wr0 = bs.busWr;
+  v = 7;
+  c1.storeNonTemporal(0x300, &v);
+  c1.storeNonTemporal(0x310, &v);
+  assert(bs.busWr == wr0 && mem64(shm, 0x300) == 0);
+  c1.fence();
+  assert(bs.busWr == wr0 + 2 && mem64(shm, 0x300) == 7 && mem64(shm, 0x310) == 7);
+  assert(mem64(shm, 0x308) == 0 && c1.stats().nt_partial == 1);
+
+  // Un acceso propio a la línea vacía su buffer antes (lee su propio dato)
+  v = 9;
+  c1.storeNonTemporal(0x338, &v);
+  while (!c1.load(0x338, &out)) {}
+  assert(out == 9);
+
+  // --- 4) BusWrLine invalida una copia en M sin Flush (la línea entera se pisa) ---
+  v = 55;
+  while (!c0.store(0x600, &v)) {}
+  assert(state_of(c0, 0x600) == MESI::M);
+  const uint64_t fl0 = bs.flush;
+  for (uint64_t i = 0; i < 4; ++i) {
+    v = 200 + i;
+    c1.storeNonTemporal(0x600 + 8 * i, &v);
+  }
+  assert(bs.flush == fl0 && state_of(c0, 0x600) == MESI::I);
+  while (!c0.load(0x600, &out)) {}
+  assert(out == 200);
+
+  // BusWr parcial sobre una copia en M: primero el Flush, así no se pierde el resto
+  v = 66;
+  while (!c0.store(0x700, &v)) {}
+  v = 77;
+  c1.storeNonTemporal(0x708, &v);
+  c1.fence();
+  assert(bs.flush == fl0 + 1 && state_of(c0, 0x700) == MESI::I);
+  assert(mem64(shm, 0x700) == 66 && mem64(shm, 0x708) == 77);
+
+  // Bytes de datos: cada BusWr lleva 8 B y cada BusWrLine una línea
+  assert(bs.data_bytes >= 8 * bs.busWr + MESICache::kLineSize * bs.busWrLine);
+
+  std::puts("OK write policies");
+  return 0;
+}
@@ -0,0 +1,194 @@
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "MesiInterconnect.hpp"
+#include "MesiMemoryPort.hpp"
+#include "memory/SharedMemory.h"
+#include "memory/cache/mesi/MESICache.hpp"
+#include "checkpoint/Checkpoint.hpp"
+
+// Cada PE: 20 x { old = fetch_add([0], 1); [base] = old; base += 64 }
+static Program make_program(uint64_t base) {
+  return {
+    {Op::LI, 1, 0, 0, int64_t(base)},
+    {Op::LI, 2, 0, 0, 0},
+    {Op::LI, 3, 0, 0, 1},
+    {Op::LI, 7, 0, 0, 20},
+    {Op::FETCH_ADD, 4, 2, 3, 0},
+    {Op::STORE, 4, 1, 0, 0},
+    {Op::LEA, 1, 1, 3, 6},
+    {Op::DEC, 7, 0, 0, 0},
+    {Op::JNZ, 7, 0, 0, -4},
+    {Op::HALT, 0, 0, 0, 0},
+  };
+}
+
+struct System {
+  SharedMemory shm;
+  MesiInterconnect bus{0};
+  MESICache c0{0, bus}, c1{1, bus};
+  MesiMemoryPort mp0{c0, bus}, mp1{c1, bus};
+  PE pe0{0, &mp0}, pe1{1, &mp1};
+
+  System() {
+    bus.set_shared_memory(&shm);
+    bus.connect(&c0); bus.connect(&c1);
+    pe0.load_program(make_program(0x100));
+    pe1.load_program(make_program(0x800));
+  }
+  // Intercalado determinista en un solo hilo
+  void run(int rounds) {
+    for (int i = 0; i < rounds; ++i) { pe0.run(5); pe1.run(5); }
+  }
+  bool save(const std::string& path) const {
+    return save_checkpoint(path, shm, bus, {&pe0, &pe1});
+  }
+};
+
+// Mismo estado arquitectónico y mismas métricas (salvo atomic_bus_ns, que es tiempo de host)
+static bool same_state(System& x, System& y) {
+  if (x.pe0.regs() != y.pe0.regs() || x.pe1.regs() != y.pe1.regs()) return false;
+  MESICache* cx[2] = {&x.c0, &x.c1};
+  MESICache* cy[2] = {&y.c0, &y.c1};
+  for (int k = 0; k < 2; ++k) {
+    for (int s = 0; s < MESICache::kSets; ++s)
+      for (int w = 0; w < MESICache::kWays; ++w) {
+        const CacheLine& a = cx[k]->lineAt(s, w);
+        const CacheLine& b = cy[k]->lineAt(s, w);
+        if (a.valid != b.valid || a.state != b.state || a.tag != b.tag ||
+            a.dirty != b.dirty || a.data != b.data) return false;
+      }
+    const auto& ma = cx[k]->stats();
+    const auto& mb = cy[k]->stats();
+    if (ma.loads != mb.loads || ma.stores != mb.stores || ma.cache_misses != mb.cache_misses ||
+        ma.atomics != mb.atomics || ma.invalidations != mb.invalidations ||
+        ma.miss_coherence != mb.miss_coherence || ma.mesi_trans[2][3] != mb.mesi_trans[2][3])
+      return false;
+  }
+  if (x.bus.stats().busRdX != y.bus.stats().busRdX) return false;
+  // Contenido de memoria visto coherentemente (ambos sistemas hacen los mismos accesos)
+  for (uint64_t a = 0; a < x.shm.size(); a += 8) {
+    uint64_t u = 0, v = 0;
+    while (!x.c1.load(a, &u)) {}
+    while (!y.c1.load(a, &v)) {}
+    if (u != v) return false;
+  }
+  return true;
+}
+
+static std::vector<char> slurp(const std::string& path) {
+  std::ifstream f(path, std::ios::binary);
+  return std::vector<char>(std::istreambuf_iterator<char>(f), {});
+}
+
+// Copia de 'bytes' con 'n' bytes de 'v' escritos en 'at'; true si la restauración
+// falla con un error que contiene 'why'
+static bool rejects(std::vector<char> bytes, size_t at, const void* v, size_t n, const char* why) {
+  std::memcpy(bytes.data() + at, v, n);
+  std::ofstream("ckp_bad.ckp", std::ios::binary).write(bytes.data(), std::streamsize(bytes.size()));
+  System c;
+  std::string err;
+  return !load_checkpoint("ckp_bad.ckp", c.shm, c.bus, {&c.pe0, &c.pe1}, &err) &&
+         err.find(why) != std::string::npos;
+}
+
+static size_t find_tag(const std::vector<char>& bytes, const char* tag) {
+  const std::string s(bytes.begin(), bytes.end());
+  const size_t p = s.find(std::string(tag, 4));
+  assert(p != std::string::npos);
+  return p + 4;
+}
+
+int main() {
+  // --- 1) guardar a mitad de camino y terminar ---
+  System a;
+  a.c1.setWritePolicy(WritePolicy::WriteThrough);
+  a.c1.addWriteRegion(0x800, 0x400, WritePolicy::WriteBackNoAlloc);
+  a.run(8);
+  assert(a.save("ckp_mid.ckp"));
+  a.run(40);
+  assert(a.save("ckp_a_end.ckp"));
+
+  // --- 2) restaurar en un sistema nuevo y terminar: mismo estado final ---
+  System b;
+  std::string err;
+  assert(load_checkpoint("ckp_mid.ckp", b.shm, b.bus, {&b.pe0, &b.pe1}, &err));
+  assert(b.c0.stats().rw_accesses > 0);          // métricas del tramo ya ejecutado
+  assert(b.c1.writePolicy() == WritePolicy::WriteThrough);   // política y regiones de la L1$
+  assert(b.c1.writePolicyFor(0x900) == WritePolicy::WriteBackNoAlloc);
+  assert(b.c1.writePolicyFor(0x100) == WritePolicy::WriteThrough);
+  assert(b.c0.writePolicy() == WritePolicy::WriteBack);
+  b.run(40);
+  assert(b.save("ckp_b_end.ckp"));
+  assert(slurp("ckp_a_end.ckp").size() == slurp("ckp_b_end.ckp").size());
+
+  // ...y recargar ambos finales reproduce el mismo sistema
+  System ra, rb;
+  assert(load_checkpoint("ckp_a_end.ckp", ra.shm, ra.bus, {&ra.pe0, &ra.pe1}, &err));
+  assert(load_checkpoint("ckp_b_end.ckp", rb.shm, rb.bus, {&rb.pe0, &rb.pe1}, &err));
+  assert(same_state(a, b));
+  assert(same_state(ra, rb));
+
+  uint64_t v = 0;
+  while (!b.c0.load(0, &v)) {}
+  assert(v == 40);
+
+  // --- 3) forma distinta o archivo dañado: error, no estado a medias ---
+  {
+    SharedMemory shm;
+    MesiInterconnect bus(0);
+    bus.set_shared_memory(&shm);
+    MESICache c0(0, bus), c1(1, bus), c2(2, bus);
+    bus.connect(&c0); bus.connect(&c1); bus.connect(&c2);
+    assert(!load_checkpoint("ckp_mid.ckp", shm, bus, {}, &err));
+    assert(err.find("L1$") != std::string::npos);
+  }
+  {
+    std::vector<char> bytes = slurp("ckp_mid.ckp");
+    std::ofstream("ckp_trunc.ckp", std::ios::binary).write(bytes.data(), bytes.size() / 2);
+    System c;
+    assert(!load_checkpoint("ckp_trunc.ckp", c.shm, c.bus, {&c.pe0, &c.pe1}, &err));
+    assert(err.find("truncado") != std::string::npos);
+    assert(!load_checkpoint("no_existe.ckp", c.shm, c.bus, {&c.pe0, &c.pe1}, &err));
+  }
+  {
+    // Valores fuera de rango: se rechazan al cargar, no al ejecutar
+    const std::vector<char> bytes = slurp("ckp_mid.ckp");
+    // L1$ de PE0 (sin regiones de escritura): id, índice, política, 0 regiones, vía 0 del set 0
+    const size_t l1 = find_tag(bytes, "L1$ ") + sizeof(int32_t) + sizeof(IndexFn) + sizeof(WritePolicy) +
+                      sizeof(uint32_t);
+    const uint8_t bad_state = 7;
+    assert(rejects(bytes, l1 + 2, &bad_state, 1, "estado MESI"));
+    const uint8_t bad_policy = 9;
+    assert(rejects(bytes, l1 - sizeof(uint32_t) - 1, &bad_policy, 1, "política"));
+    const size_t pe = find_tag(bytes, "PE  ") + sizeof(int32_t);                       // tamaño del programa
+    const uint64_t huge_n = ~uint64_t(0) / 2;
+    assert(rejects(bytes, pe, &huge_n, 8, "programa"));
+    const uint8_t bad_op = 200, bad_reg = 8;
+    assert(rejects(bytes, pe + 8, &bad_op, 1, "opcode"));
+    assert(rejects(bytes, pe + 8 + 1, &bad_reg, 1, "registro"));
+    assert(rejects(bytes, pe + 8 + 2, &bad_reg, 1, "registro"));
+
+    // Sombra del clasificador de PE0: tras vías+LRU, sellos, reloj, reserva LL,
+    // contadores (26 escalares + 2 por set + ns) y la matriz MESI
+    const size_t way_bytes = 2 + sizeof(MESI) + sizeof(uint64_t) + MESICache::kLineSize;
+    const size_t cls = l1 + MESICache::kSets * (MESICache::kWays * way_bytes + 1) +
+                       MESICache::kSets * MESICache::kWays * 8 + 8 + 8 + 1 +
+                       26 * 4 + MESICache::kSets * 2 * 4 + 8 + 16 * 4;
+    int32_t shadow_n = 0;
+    std::memcpy(&shadow_n, bytes.data() + cls + 4, 4);
+    assert(shadow_n >= 0 && shadow_n <= MESICache::kSets * MESICache::kWays);
+    const size_t seen = cls + 8 + size_t(shadow_n) * 16;  // tamaño del conjunto 'seen'
+    assert(rejects(bytes, seen, &huge_n, 8, "MissClassifier"));
+  }
+
+  for (const char* f : {"ckp_mid.ckp", "ckp_a_end.ckp", "ckp_b_end.ckp", "ckp_trunc.ckp", "ckp_bad.ckp"})
+    std::remove(f);
+  std::puts("OK checkpoint save/restore");
+  return 0;
+}
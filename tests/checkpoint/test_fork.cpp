@@ -0,0 +1,125 @@
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "checkpoint/Fork.hpp"
+
+static void shm_write(SharedMemory& m, uint32_t addr, uint64_t v) {
+  auto req = std::make_shared<Message>(MessageType::WRITE_MEM, -1, -1);
+  req->payload.write_mem.address = addr;
+  req->payload.write_mem.size = 8;
+  req->data_write.assign(reinterpret_cast<uint8_t*>(&v), reinterpret_cast<uint8_t*>(&v) + 8);
+  m.handle_message(req, [](MessageP) {});
+}
+
+static uint64_t shm_read(SharedMemory& m, uint32_t addr) {
+  auto req = std::make_shared<Message>(MessageType::READ_MEM, -1, -1);
+  req->payload.read_mem.address = addr;
+  req->payload.read_mem.size = 8;
+  uint64_t v = 0;
+  m.handle_message(req, [&](MessageP r) { std::memcpy(&v, r->read_resp_data.data(), 8); });
+  return v;
+}
+
+// Cada PE: 20 x { old = fetch_add([0], 1); [base] = old; base += 64 }
+static Program make_program(uint64_t base) {
+  return {
+    {Op::LI, 1, 0, 0, int64_t(base)},
+    {Op::LI, 2, 0, 0, 0},
+    {Op::LI, 3, 0, 0, 1},
+    {Op::LI, 7, 0, 0, 20},
+    {Op::FETCH_ADD, 4, 2, 3, 0},
+    {Op::STORE, 4, 1, 0, 0},
+    {Op::LEA, 1, 1, 3, 6},
+    {Op::DEC, 7, 0, 0, 0},
+    {Op::JNZ, 7, 0, 0, -4},
+    {Op::HALT, 0, 0, 0, 0},
+  };
+}
+
+int main() {
+  // --- 1) copy-on-write de SharedMemory ---
+  {
+    SharedMemory a;
+    assert(a.page_count() == SharedMemory::kDefaultBytes / SharedMemory::kPageBytes);
+    shm_write(a, 0x10, 111);
+    auto b = a.fork();
+    assert(a.shared_pages() == a.page_count() && b->shared_pages() == b->page_count());
+    assert(shm_read(*b, 0x10) == 111);
+
+    shm_write(*b, 0x18, 222);                       // b copia solo la página 0
+    assert(shm_read(a, 0x18) == 0 && shm_read(*b, 0x18) == 222);
+    assert(b->shared_pages() == b->page_count() - 1);
+    shm_write(a, 0x300, 333);                       // a copia la página 3
+    assert(shm_read(*b, 0x300) == 0);
+    assert(a.shared_pages() == a.page_count() - 2);
+    b.reset();                                      // al soltar b, a vuelve a ser dueña única
+    assert(a.shared_pages() == 0);
+  }
+  {
+    // Un fork lee una página y se suelta en otro hilo; después la original la
+    // escribe en el lugar. El aviso es relajado: lo único que ordena la lectura
+    // del fork antes de esa escritura es el contador de la página (con
+    // -DMESI_SANITIZE=thread, TSAN lo comprueba)
+    SharedMemory a;
+    for (int i = 0; i < 50; ++i) {
+      auto b = a.fork();
+      std::atomic<bool> done{false};
+      std::thread t([&b, &done] {
+        const uint64_t seen = shm_read(*b, 0x20);
+        assert(seen < 50);
+        (void)seen;
+        b.reset();
+        done.store(true, std::memory_order_relaxed);
+      });
+      while (!done.load(std::memory_order_relaxed)) std::this_thread::yield();
+      shm_write(a, 0x20, uint64_t(i));
+      assert(a.shared_pages() == 0);
+      t.join();
+    }
+  }
+
+  // --- 2) fork de un sistema caliente: variantes en paralelo con la original ---
+  SharedMemory shm;
+  MesiInterconnect bus(0);
+  bus.set_shared_memory(&shm);
+  MESICache c0(0, bus), c1(1, bus);
+  bus.connect(&c0); bus.connect(&c1);
+  MesiMemoryPort mp0(c0, bus), mp1(c1, bus);
+  PE pe0(0, &mp0), pe1(1, &mp1);
+  pe0.load_program(make_program(0x100));
+  pe1.load_program(make_program(0x800));
+  for (int i = 0; i < 8; ++i) { pe0.run(5); pe1.run(5); }   // punto caliente
+
+  const int warm_misses = c0.stats().cache_misses;
+  std::vector<std::unique_ptr<SimFork>> forks;
+  for (int k = 0; k < 8; ++k) {
+    forks.push_back(fork_simulation(shm, bus, {&pe0, &pe1}));
+    assert(forks.back() && forks.back()->pes.size() == 2);
+    assert(forks.back()->caches[0]->stats().cache_misses == warm_misses);
+  }
+
+  std::vector<std::thread> th;
+  for (auto& f : forks) th.emplace_back([&f] { f->run(); });
+  std::thread orig([&] {
+    std::thread t0([&] { pe0.run(); }), t1([&] { pe1.run(); });
+    t0.join(); t1.join();
+  });
+  for (auto& t : th) t.join();
+  orig.join();
+
+  uint64_t v = 0;
+  while (!c0.load(0, &v)) {}
+  assert(v == 40);
+  for (auto& f : forks) {
+    assert(f->ports[1]->load64(0) == 40);                        // 40 fetch_add en total
+    assert(f->pm[0].atomics + f->pm[1].atomics < 40);             // solo los del tramo nuevo
+    assert(f->shm->shared_pages() > 0);                          // páginas no escritas siguen compartidas
+  }
+
+  std::puts("OK copy-on-write fork");
+  return 0;
+}
@@ -0,0 +1,97 @@
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "MesiInterconnect.hpp"
+#include "dma/DmaAgent.hpp"
+#include "memory/SharedMemory.h"
+#include "memory/cache/mesi/MESICache.hpp"
+
+static uint64_t load(MESICache& c, uint64_t addr) {
+  uint64_t v = 0;
+  while (!c.load(addr, &v)) {}
+  return v;
+}
+static void store(MESICache& c, uint64_t addr, uint64_t v) {
+  while (!c.store(addr, &v)) {}
+}
+static MESI state_of(const MESICache& c, uint64_t addr) {
+  const uint32_t set = uint32_t(addr >> MESICache::kOffsetBits) & (MESICache::kSets - 1);
+  const uint64_t tag = addr >> (MESICache::kOffsetBits + MESICache::kIndexBits);
+  for (int w = 0; w < MESICache::kWays; ++w) {
+    const CacheLine& L = c.lineAt(set, w);
+    if (L.valid && L.tag == tag) return L.state;
+  }
+  return MESI::I;
+}
+
+int main() {
+  // --- 1) bloques en SharedMemory: cruzan páginas, rango inválido no toca nada ---
+  {
+    SharedMemory shm;
+    std::vector<double> in(100), out(100, -1.0);
+    for (size_t i = 0; i < in.size(); ++i) in[i] = 0.25 * double(i);
+    const uint64_t addr = SharedMemory::kPageBytes - 24;      // empieza a mitad de página
+    assert(shm.write_doubles(addr, in.data(), in.size()));
+    assert(shm.read_doubles(addr, out.data(), out.size()));
+    assert(out == in);
+    assert(shm.load64(addr + 8) == [&] { uint64_t u; std::memcpy(&u, &in[1], 8); return u; }());
+
+    uint64_t r = 0, w = 0;
+    shm.get_stats(r, w);
+    assert(r == 0 && w == 0);                                 // acceso del host: sin contadores
+
+    const double big[2] = {1.0, 2.0};
+    assert(!shm.write_doubles(shm.size() - 8, big, 2));
+    assert(!shm.read_block(shm.size() + 8, out.data(), 0));
+    assert(shm.load64(shm.size() - 8) == 0);
+  }
+
+  SharedMemory shm;
+  MesiInterconnect bus(0);
+  bus.set_shared_memory(&shm);
+  MESICache c0(0, bus), c1(1, bus);
+  bus.connect(&c0); bus.connect(&c1);
+  DmaAgent dma(bus);
+
+  // --- 2) lectura DMA: ve el dato en M de una L1$ (la memoria aún no lo tiene) ---
+  store(c0, 0x100, 7);
+  assert(shm.load64(0x100) == 0);
+  uint64_t v = 0;
+  assert(dma.read(0x100, &v, 8) && v == 7);
+  assert(state_of(c0, 0x100) == MESI::S);
+  assert(dma.stats().lines_snooped == 1);
+  assert(dma.read(0x500, &v, 8) && v == 0);                   // línea sin copias: sin snoop
+  assert(dma.stats().lines_snooped == 1 && dma.stats().reads == 2);
+
+  // --- 3) escritura DMA: invalida copias; una escritura parcial conserva el resto de la línea ---
+  assert(load(c1, 0x200) == 0 && state_of(c1, 0x200) == MESI::E);
+  const uint64_t x = 99;
+  assert(dma.write(0x208, &x, 8));
+  assert(state_of(c1, 0x200) == MESI::I);
+  assert(load(c1, 0x208) == 99);
+
+  store(c0, 0x300, 5);
+  const uint64_t y = 6;
+  assert(dma.write(0x308, &y, 8));
+  assert(state_of(c0, 0x300) == MESI::I);
+  assert(load(c1, 0x300) == 5 && load(c1, 0x308) == 6);
+
+  // --- 4) el Flush provocado por una lectura DMA no tapa una escritura DMA posterior ---
+  store(c0, 0x400, 1);
+  assert(dma.read(0x400, &v, 8) && v == 1);
+  const uint64_t z = 2;
+  assert(dma.write(0x400, &z, 8));
+  assert(load(c1, 0x400) == 2);
+
+  // --- 5) bloque grande con varias líneas en M ---
+  for (uint64_t a = 0x600; a < 0x700; a += 32) store(c0, a, a);
+  std::vector<uint64_t> blk(32);
+  assert(dma.read(0x600, blk.data(), blk.size() * 8));
+  for (uint64_t a = 0x600; a < 0x700; a += 32) assert(blk[(a - 0x600) / 8] == a);
+  assert(!dma.read(shm.size() - 8, blk.data(), 16));
+
+  std::puts("OK bulk SharedMemory + DMA coherente");
+  return 0;
+}
@@ -0,0 +1,127 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "memory/SharedMemory.h"
+#include "memory/dram/DramController.hpp"
+
+// n lecturas: secuenciales (línea tras línea) o al azar en 64 MB
+static DramController run(DramConfig c, bool random, int n = 4096) {
+  DramController d(c);
+  std::mt19937_64 rng(3);
+  for (int i = 0; i < n; ++i)
+    d.access(random ? (rng() % (uint64_t(1) << 26)) & ~uint64_t(31) : uint64_t(i) * 32, false);
+  d.drain();
+  return d;
+}
+
+int main() {
+  // --- 1) configuración y mapeo de direcciones ---
+  {
+    DramConfig c;
+    DramSched s;
+    DramPage p;
+    assert(parse_dram_sched("fcfs", s) && s == DramSched::FCFS && !parse_dram_sched("lru", s));
+    assert(parse_dram_page("closed", p) && p == DramPage::Closed && !parse_dram_page("x", p));
+    std::string err;
+    c.map = "RoRaBaChCx";
+    assert(!DramController::validate(c, &err) && !err.empty());
+    c.map = "CoRoRaBaCh";
+    assert(!DramController::validate(c, &err));
+    c = DramConfig{};
+    c.banks = 6;
+    assert(!DramController::validate(c, &err));
+
+    const DramController d(DramConfig{});   // RoRaBaCoCh: 2 canales, 8 bancos, filas de 64 líneas
+    assert(d.decode(32).channel == 1 && d.decode(32).column == 0);
+    assert(d.decode(64).channel == 0 && d.decode(64).column == 1);
+    assert(d.decode(4096).bank == 1 && d.decode(32768).row == 1 && d.decode(32768).bank == 0);
+    c = DramConfig{};
+    c.map = "RoCoRaBaCh";
+    const DramController e(c);
+    assert(e.decode(32).channel == 1 && e.decode(64).bank == 1 && e.decode(16 * 32).column == 1);
+  }
+
+  // --- 2) latencia de un acceso a un banco cerrado y acierto de fila ---
+  {
+    DramController d(DramConfig{});
+    d.access(0, false);
+    d.drain();
+    // tRCD 42 + tCL 42 + tBURST 6 + tCtrl 20
+    assert(d.stats().max_latency == 110 && d.stats().row_empty == 1);
+    d.access(64, true);
+    d.drain();
+    assert(d.stats().row_hits == 1 && d.stats().writes == 1 && d.stats().reads == 1);
+    assert(d.bank_stats(0, 0, 0).requests() == 2);
+  }
+
+  // --- 3) flujo secuencial vs. accesos al azar ---
+  {
+    const DramController seq = run(DramConfig{}, false);
+    const DramController rnd = run(DramConfig{}, true);
+    assert(seq.stats().row_hit_rate() > 0.9 && rnd.stats().row_hit_rate() < 0.1);
+    assert(seq.bytes_per_cycle() > 2.0 * rnd.bytes_per_cycle());
+    assert(seq.stats().avg_latency() < rnd.stats().avg_latency());
+    assert(rnd.stats().stall_cycles > 0);
+  }
+
+  // --- 4) FR-FCFS reordena para acertar en la fila abierta ---
+  {
+    auto two_rows = [](DramSched s) {
+      DramConfig c;
+      c.sched = s;
+      DramController d(c);
+      for (int i = 0; i < 512; ++i)   // filas 0 y 1 del banco 0 (canal 0), alternadas
+        d.access(uint64_t(i % 2) * 32768 + uint64_t(i / 2 % 64) * 64, false);
+      d.drain();
+      return d;
+    };
+    const DramController fcfs = two_rows(DramSched::FCFS);
+    const DramController fr = two_rows(DramSched::FRFCFS);
+    assert(fcfs.stats().row_hits == 0);
+    assert(fr.stats().row_hits > fr.stats().requests() / 2);
+    assert(fr.elapsed() < fcfs.elapsed());
+  }
+
+  // --- 5) página cerrada y refresco ---
+  {
+    DramConfig c;
+    c.page = DramPage::Closed;
+    const DramController d = run(c, false);
+    assert(d.stats().row_hits == 0 && d.stats().row_conflicts == 0 && d.stats().row_empty == 4096);
+    c = DramConfig{};
+    c.tREFI = 1000;
+    c.tRFC = 100;
+    const DramController r = run(c, false);
+    const DramController n = run(DramConfig{}, false);
+    assert(r.stats().refreshes > 0 && r.elapsed() > n.elapsed());
+  }
+
+  // --- 6) SharedMemory: solo los accesos de línea por mensaje pasan por la DRAM ---
+  {
+    SharedMemory shm;
+    DramController d(DramConfig{});
+    shm.set_dram(&d);
+    auto rd = std::make_shared<Message>(MessageType::READ_MEM, -1, -1);
+    rd->payload.read_mem.address = 64;
+    rd->payload.read_mem.size = 32;
+    shm.handle_message(rd, [](MessageP) {});
+    auto wr = std::make_shared<Message>(MessageType::WRITE_MEM, -1, -1);
+    wr->payload.write_mem.address = 128;
+    wr->payload.write_mem.size = 32;
+    wr->data_write.assign(32, 7);
+    shm.handle_message(wr, [](MessageP) {});
+    uint64_t v = 0;
+    shm.read_block(0, &v, 8);
+    shm.store64(0, 1);
+    d.drain();
+    assert(d.stats().reads == 1 && d.stats().writes == 1 && d.stats().row_hits == 1);
+    assert(shm.load64(128) == 0x0707070707070707ull);
+  }
+
+  std::puts("OK dram: mapeo, latencia por estado de fila, secuencial vs azar, FR-FCFS, página cerrada, refresco");
+  return 0;
+}
@@ -0,0 +1,133 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "MesiInterconnect.hpp"
+#include "memory/SharedMemory.h"
+#include "memory/cache/mesi/MESICache.hpp"
+#include "noc/NocModel.hpp"
+
+static NocConfig cfg(NocTopology topo, int tiles, int cols = 0, bool dateline = true) {
+  NocConfig c;
+  c.topo = topo; c.tiles = tiles; c.cols = cols; c.dateline = dateline;
+  return c;
+}
+
+// Una transacción de cada PE sobre cada una de las 'tiles' líneas (home = tile)
+static void all_to_all(NocModel& n, BusMsg type) {
+  for (int pe = 0; pe < n.tiles(); ++pe)
+    for (int h = 0; h < n.tiles(); ++h) {
+      n.begin(pe);
+      n.end(type, uint64_t(h) * 32, true);
+    }
+}
+
+int main() {
+  // --- 1) configuración y topología ---
+  {
+    NocConfig c;
+    assert(parse_noc_topology("ring", c) && c.topo == NocTopology::Ring);
+    assert(parse_noc_topology("mesh:4", c) && c.topo == NocTopology::Mesh && c.cols == 4);
+    assert(!parse_noc_topology("ring:2", c) && !parse_noc_topology("torus", c));
+    std::string err;
+    assert(!NocModel::validate(cfg(NocTopology::Mesh, 6, 4), &err) && !err.empty());
+    assert(NocModel(cfg(NocTopology::Mesh, 16)).cols() == 4);
+    assert(NocModel(cfg(NocTopology::Mesh, 6)).cols() == 3);
+    const NocModel m32(cfg(NocTopology::Mesh, 32));
+    assert(m32.cols() == 8 && m32.rows() == 4 && m32.vcs() == 3);
+    assert(NocModel(cfg(NocTopology::Ring, 8)).vcs() == 6);
+  }
+
+  // --- 2) rutas: XY en la malla, camino más corto en el anillo ---
+  {
+    NocModel m(cfg(NocTopology::Mesh, 16));
+    const auto r = m.route(0, 15);
+    assert(r.size() == 6);
+    for (int i = 0; i < 3; ++i) assert(m.links()[size_t(r[size_t(i)])].dir == 'E');
+    for (int i = 3; i < 6; ++i) assert(m.links()[size_t(r[size_t(i)])].dir == 'S');
+    assert(m.links()[size_t(r.back())].to == 15 && m.route(5, 5).empty());
+
+    NocModel g(cfg(NocTopology::Ring, 8));
+    assert(g.route(0, 3).size() == 3 && g.links()[size_t(g.route(0, 3)[0])].dir == '+');
+    assert(g.route(0, 6).size() == 2 && g.links()[size_t(g.route(0, 6)[0])].dir == '-');
+    assert(g.route(0, 4).size() == 4 && g.links()[size_t(g.route(0, 4)[0])].dir == '+');
+  }
+
+  // --- 3) latencia sin contención en una malla 2x2 (salto 3, datos = 3 flits) ---
+  {
+    NocModel m(cfg(NocTopology::Mesh, 4));
+    m.begin(0);
+    m.end(BusMsg::BusRd, 0, true);          // home local: solo la memoria
+    assert(m.pe_stats(0).latency == 100);
+    m.begin(0);
+    m.end(BusMsg::BusRd, 3 * 32, true);     // home en la esquina opuesta (2 saltos)
+    // pedido 6 + memoria 100 + datos 2 saltos * 3 + 2 flits de cola
+    assert(m.pe_stats(0).max_latency == 114 && m.pe_stats(0).clock == 214);
+    m.begin(1);
+    m.end(BusMsg::BusUpgr, 0, false);       // sin datos: último ack (1 -> 0 -> 3 -> 1 o 0 -> 2 -> 1)
+    assert(m.pe_stats(1).latency == 3 + 6 + 3);
+    assert(m.totals().class_packets[NocModel::Req] == 3 &&
+           m.totals().class_packets[NocModel::Fwd] == 9);
+  }
+
+  // --- 4) canales virtuales: sin línea de fecha el anillo tiene un ciclo ---
+  {
+    NocModel ring(cfg(NocTopology::Ring, 8));
+    all_to_all(ring, BusMsg::BusRdX);
+    assert(ring.deadlock_free());
+    NocModel bad(cfg(NocTopology::Ring, 8, 0, /*dateline*/false));
+    all_to_all(bad, BusMsg::BusRdX);
+    assert(!bad.deadlock_free());
+    NocModel mesh(cfg(NocTopology::Mesh, 16));
+    all_to_all(mesh, BusMsg::BusRdX);
+    assert(mesh.deadlock_free());
+    // cada clase viaja en su VC
+    for (const auto& l : mesh.links()) assert(l.flits == l.vc_flits[0] + l.vc_flits[1] + l.vc_flits[2]);
+  }
+
+  // --- 5) contención: 16 PEs contra el mismo home esperan por los enlaces ---
+  {
+    NocModel m(cfg(NocTopology::Mesh, 16));
+    for (int i = 0; i < 8; ++i)
+      for (int pe = 0; pe < 16; ++pe) { m.begin(pe); m.end(BusMsg::BusRdX, 5 * 32, true); }
+    uint64_t wait = 0;
+    for (const auto& l : m.links()) wait += l.wait_cycles;
+    assert(wait > 0 && m.totals().max_packet_latency > 6 * 3 + 2);
+  }
+
+  // --- 6) bus con modelo de red: una transacción de red por transacción del bus ---
+  {
+    SharedMemory shm;
+    MesiInterconnect bus(0);
+    bus.set_shared_memory(&shm);
+    NocModel noc(cfg(NocTopology::Ring, 4));
+    bus.set_noc(&noc);
+    std::vector<std::unique_ptr<MESICache>> c;
+    for (int k = 0; k < 4; ++k) {
+      c.push_back(std::make_unique<MESICache>(k, bus));
+      bus.connect(c.back().get());
+    }
+    std::mt19937_64 rng(7);
+    std::vector<uint64_t> model(4096 / 8, 0);
+    for (int i = 0; i < 5000; ++i) {
+      MESICache& cc = *c[rng() % 4];
+      const uint64_t slot = rng() % model.size();
+      uint64_t v = rng();
+      if (rng() % 2) { while (!cc.store(slot * 8, &v)) {} model[slot] = v; }
+      else { while (!cc.load(slot * 8, &v)) {} assert(v == model[slot]); }
+    }
+    const auto& s = bus.stats();
+    uint64_t txns = 0;
+    for (int k = 0; k < 4; ++k) txns += noc.pe_stats(k).transactions;
+    assert(txns == s.busRd + s.busRdX + s.busUpgr + s.inv);
+    assert(noc.totals().class_packets[NocModel::Req] == txns);
+    assert(noc.elapsed() > 0 && noc.deadlock_free());
+  }
+
+  std::puts("OK noc: anillo/malla, rutas XY, latencia, VCs sin ciclos, contención, bus con red");
+  return 0;
+}
@@ -0,0 +1,141 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "MesiInterconnect.hpp"
+#include "dma/DmaAgent.hpp"
+#include "memory/SharedMemory.h"
+#include "memory/cache/mesi/MESICache.hpp"
+#include "numa/NumaDirectory.hpp"
+
+// 2 nodos x 2 L1$: PEs 0,1 en el bus del nodo 0 y PEs 2,3 en el del nodo 1
+struct Numa {
+  SharedMemory shm{4096};
+  NumaDirectory dir{shm};
+  MesiInterconnect bus0{0}, bus1{0};
+  std::vector<std::unique_ptr<MESICache>> c;
+
+  Numa() {
+    assert(shm.set_numa_nodes(2, 256));
+    for (MesiInterconnect* b : {&bus0, &bus1}) b->set_shared_memory(&shm);
+    dir.attach(0, &bus0);
+    dir.attach(1, &bus1);
+    for (int k = 0; k < 4; ++k) {
+      MesiInterconnect& b = k < 2 ? bus0 : bus1;
+      c.push_back(std::make_unique<MESICache>(k, b));
+      b.connect(c.back().get());
+    }
+  }
+  MESI state(int k, uint64_t a) const {
+    const auto L = c[k]->lookupLine(a);
+    return L.hit ? c[k]->lineAt(int((a >> 5) & 7), L.way).state : MESI::I;
+  }
+};
+
+static uint64_t ld(MESICache& c, uint64_t a) { uint64_t v = 0; while (!c.load(a, &v)) {} return v; }
+static void st(MESICache& c, uint64_t a, uint64_t v) { while (!c.store(a, &v)) {} }
+
+int main() {
+  // --- 1) particiones de SharedMemory: intercalado por páginas y bind ---
+  {
+    SharedMemory m(4096);
+    assert(m.numa_nodes() == 1 && m.home_node(1000) == 0);
+    assert(!m.set_numa_nodes(2, 100) && !m.set_numa_nodes(0));
+    assert(m.set_numa_nodes(2, 512));
+    assert(m.home_node(0) == 0 && m.home_node(511) == 0 && m.home_node(512) == 1 && m.home_node(1024) == 0);
+    assert(m.bind(100, 300, 1));                    // páginas 0 y 1
+    assert(m.home_node(0) == 1 && m.home_node(300) == 1 && m.home_node(600) == 1);
+    assert(!m.bind(0, 8, 2) && !m.bind(4090, 16, 0));
+    auto f = m.fork();
+    assert(f->numa_nodes() == 2 && f->home_node(0) == 1);
+  }
+
+  // --- 2) protocolo entre clusters y contabilidad local/remota ---
+  {
+    Numa s;
+    const uint64_t a = 0x000;     // home nodo 0
+    assert(ld(*s.c[0], a) == 0 && s.state(0, a) == MESI::E);
+    assert(s.dir.stats(0).local_mem == 1 && s.dir.stats(0).remote_mem == 0);
+
+    assert(ld(*s.c[2], a) == 0);  // el nodo 1 la lee: remota, ambas en S
+    assert(s.state(0, a) == MESI::S && s.state(2, a) == MESI::S);
+    assert(s.dir.stats(1).remote_mem == 1 && s.dir.stats(1).remote_cycles > 0);
+
+    st(*s.c[2], a, 7);            // BusUpgr: invalida el cluster 0
+    assert(s.state(2, a) == MESI::M && s.state(0, a) == MESI::I);
+    assert(s.dir.stats(1).invals_sent == 1);
+
+    assert(ld(*s.c[1], a) == 7);  // el nodo 0 trae el dato sucio del nodo 1
+    assert(s.dir.stats(0).remote_c2c == 1);
+    assert(s.state(2, a) == MESI::S && s.state(1, a) == MESI::S);
+
+    assert(ld(*s.c[0], a) == 7);  // copia en los dos clusters: de memoria, en S
+    assert(s.state(0, a) == MESI::S);
+
+    assert(ld(*s.c[1], 0x100) == 0);   // home nodo 1: lectura remota del nodo 0
+    assert(s.dir.stats(0).remote_mem == 1);
+
+    // DMA por el bus del nodo 0 ve un dato en M del nodo 1
+    st(*s.c[3], 0x140, 99);
+    DmaAgent dma(s.bus0);
+    uint64_t v = 0;
+    assert(dma.read(0x140, &v, 8) && v == 99);
+    assert(s.state(3, 0x140) == MESI::S);
+    v = 5;
+    assert(dma.write(0x140, &v, 8) && s.state(3, 0x140) == MESI::I);
+    assert(ld(*s.c[3], 0x140) == 5);
+  }
+
+  // --- 3) 4 L1$ en 2 clusters contra un modelo (loads, stores y fetch-add) ---
+  {
+    Numa s;
+    std::mt19937_64 rng(42);
+    std::vector<uint64_t> model(4096 / 8, 0);
+    for (int i = 0; i < 20000; ++i) {
+      MESICache& c = *s.c[rng() % 4];
+      const uint64_t slot = rng() % model.size();
+      const int op = int(rng() % 4);
+      if (op == 0) {
+        const uint64_t v = rng();
+        st(c, slot * 8, v);
+        model[slot] = v;
+      } else if (op == 1) {
+        assert(c.atomicRMW(slot * 8, MESICache::AtomicOp::FetchAdd, 3) == model[slot]);
+        model[slot] += 3;
+      } else {
+        assert(ld(c, slot * 8) == model[slot]);
+      }
+    }
+    for (int n = 0; n < 2; ++n) {
+      const auto st = s.dir.stats(n);
+      assert(st.local_mem > 0 && st.remote_mem > 0 && st.local_cycles > 0 && st.remote_cycles > 0);
+    }
+  }
+
+  // --- 4) concurrencia: fetch-add desde los 4 PEs sobre líneas de ambos home ---
+  {
+    Numa s;
+    std::vector<std::thread> ts;
+    for (int k = 0; k < 4; ++k)
+      ts.emplace_back([&, k] {
+        for (int i = 0; i < 500; ++i) {
+          s.c[k]->atomicRMW(0x40, MESICache::AtomicOp::FetchAdd, 1);    // home 0
+          s.c[k]->atomicRMW(0x140, MESICache::AtomicOp::FetchAdd, 2);   // home 1
+          st(*s.c[k], 0x200 + 32 * k, uint64_t(i));
+        }
+      });
+    for (auto& t : ts) t.join();
+    DmaAgent dma(s.bus1);
+    uint64_t v[2] = {};
+    assert(dma.read(0x40, &v[0], 8) && dma.read(0x140, &v[1], 8));
+    assert(v[0] == 2000 && v[1] == 4000);
+    for (int k = 0; k < 4; ++k) assert(ld(*s.c[(k + 2) % 4], 0x200 + 32 * k) == 499);
+  }
+
+  std::puts("OK numa: particiones por nodo, directorio entre clusters, latencia local/remota");
+  return 0;
+}
@@ -0,0 +1,156 @@
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MesiInterconnect.hpp"
+#include "MesiMemoryPort.hpp"
+#include "memory/SharedMemory.h"
+#include "memory/cache/mesi/MESICache.hpp"
+#include "sampling/Sampler.hpp"
+
+static constexpr int P = 4;
+
+// Sistema de 4 PEs; cada PE recibe su programa de make(k)
+struct System {
+  SharedMemory shm;
+  MesiInterconnect bus{0};
+  std::vector<std::unique_ptr<MESICache>> caches;
+  std::vector<std::unique_ptr<MesiMemoryPort>> ports;
+  std::vector<std::unique_ptr<PE>> pes;
+
+  template <class Make>
+  System(size_t bytes, Make make) : shm(bytes) {
+    bus.set_shared_memory(&shm);
+    for (int k = 0; k < P; ++k) {
+      caches.push_back(std::make_unique<MESICache>(k, bus));
+      bus.connect(caches.back().get());
+      ports.push_back(std::make_unique<MesiMemoryPort>(*caches.back(), bus));
+      pes.push_back(std::make_unique<PE>(k, ports.back().get()));
+      pes.back()->load_program(make(k));
+    }
+  }
+
+  SamplingReport run(const SamplingConfig& cfg) {
+    std::vector<PE*> pv;
+    std::vector<IMemoryPort*> mv;
+    for (int k = 0; k < P; ++k) { pv.push_back(pes[k].get()); mv.push_back(ports[k].get()); }
+    SampledRunner r(shm, bus, pv, mv);
+    SamplingReport rep;
+    std::string err;
+    const bool ok = r.run(cfg, rep, &err);
+    assert(ok && err.empty());
+    return rep;
+  }
+};
+
+static double as_double(uint64_t u) { double d; std::memcpy(&d, &u, 8); return d; }
+
+// Producto punto de 'len' elementos desde A/B; [out] = acumulado (como --mode=dot)
+static Program dot(uint64_t a, uint64_t b, uint64_t out, uint64_t len) {
+  return {
+    {Op::LI, 1, 0, 0, int64_t(a)}, {Op::LI, 2, 0, 0, int64_t(b)},
+    {Op::LI, 5, 0, 0, int64_t(out)}, {Op::LI, 7, 0, 0, int64_t(len)},
+    {Op::LI, 0, 0, 0, 0}, {Op::LI, 3, 0, 0, 0},
+    {Op::LEA, 4, 1, 0, 3}, {Op::LEA, 6, 2, 0, 3},
+    {Op::LOAD, 4, 4, 0, 0}, {Op::LOAD, 6, 6, 0, 0},
+    {Op::FMUL, 4, 4, 6, 0}, {Op::FADD, 3, 3, 4, 0},
+    {Op::INC, 0, 0, 0, 0}, {Op::DEC, 7, 0, 0, 0}, {Op::JNZ, 7, 0, 0, -8},
+    {Op::STORE, 3, 5, 0, 0},
+    {Op::HALT, 0, 0, 0, 0},
+  };
+}
+
+// 'reps' pasadas leyendo 8 líneas propias desde 'base' (caben en la L1$)
+static Program reuse(uint64_t base, uint64_t reps) {
+  return {
+    {Op::LI, 1, 0, 0, int64_t(base)}, {Op::LI, 7, 0, 0, int64_t(reps)},
+    {Op::LI, 0, 0, 0, 0}, {Op::LI, 2, 0, 0, 8},
+    {Op::LEA, 4, 1, 0, 5}, {Op::LOAD, 4, 4, 0, 0},
+    {Op::INC, 0, 0, 0, 0}, {Op::DEC, 2, 0, 0, 0}, {Op::JNZ, 2, 0, 0, -4},
+    {Op::DEC, 7, 0, 0, 0}, {Op::JNZ, 7, 0, 0, -8},
+    {Op::HALT, 0, 0, 0, 0},
+  };
+}
+
+int main() {
+  // --- 1) dot grande: muestreado vs detallado completo (misma métrica) ---
+  const uint64_t N = 16000, len = N / P;
+  const uint64_t A = 0, B = N * 8, OUT = 2 * N * 8;
+  const size_t bytes = OUT + P * 32;
+  auto make_dot = [&](int k) { return dot(A + k * len * 8, B + k * len * 8, OUT + k * 32, len); };
+  auto init = [&](System& s) {
+    for (uint64_t i = 0; i < N; ++i) {
+      double a = double(i + 1), b = 0.5 * double(i + 1);
+      uint64_t u; std::memcpy(&u, &a, 8); s.shm.store64(A + i * 8, u);
+      std::memcpy(&u, &b, 8);             s.shm.store64(B + i * 8, u);
+    }
+  };
+  const double expected = 0.5 * (double(N) * (N + 1) * (2.0 * N + 1) / 6.0);
+  auto result = [&](System& s) {
+    double sum = 0.0;
+    for (int k = 0; k < P; ++k) sum += as_double(s.shm.load64(OUT + k * 32));
+    return sum;
+  };
+
+  System full(bytes, make_dot), sampled(bytes, make_dot);
+  init(full); init(sampled);
+
+  SamplingConfig ref;
+  ref.period = ref.window = 1000; ref.warmup = 0;
+  const SamplingReport f = full.run(ref);
+
+  SamplingConfig cfg;
+  cfg.period = 6000; cfg.window = 600; cfg.warmup = 200;
+  const SamplingReport s = sampled.run(cfg);
+
+  // Los resultados quedan en memoria (L1$ vaciadas) y son exactos en ambos modos
+  assert(std::abs(result(full) - expected) < 1e-9 * expected);
+  assert(std::abs(result(sampled) - expected) < 1e-9 * expected);
+  for (const auto& c : sampled.caches)
+    for (int set = 0; set < MESICache::kSets; ++set)
+      for (int w = 0; w < MESICache::kWays; ++w) assert(!c->lineAt(set, w).valid);
+
+  assert(f.instructions == s.instructions);
+  assert(f.detailed_instructions == f.instructions);
+  assert(s.detailed_instructions * 5 < s.instructions);
+  assert(s.windows >= 5);
+  assert(std::abs(s.miss_rate.mean - f.miss_rate.mean) < 0.01);
+  assert(std::abs(s.cpi.mean - f.cpi.mean) < 0.05 * f.cpi.mean);
+  assert(std::abs(s.cycles.mean - f.cycles.mean) <= s.cycles.half + 0.05 * f.cycles.mean);
+
+  // --- 2) calentamiento funcional: sin él cada ventana arranca con la L1$ fría ---
+  auto make_reuse = [](int k) { return reuse(uint64_t(k) * 256, 400); };
+  SamplingConfig w;
+  w.period = 2000; w.window = 200; w.warmup = 0;
+  System warm(4096, make_reuse), cold(4096, make_reuse);
+  const SamplingReport rw = warm.run(w);
+  w.functional_warming = false;
+  const SamplingReport rc = cold.run(w);
+  assert(rw.miss_rate.mean < 0.01);
+  assert(rc.miss_rate.mean > 0.05);
+  assert(rw.cpi.mean < rc.cpi.mean);
+
+  // --- 3) configuraciones y programas no admitidos ---
+  {
+    System s3(4096, [](int) { return Program{{Op::WAIT, 0, 1, 0, 0}, {Op::HALT, 0, 0, 0, 0}}; });
+    std::vector<PE*> pv;
+    std::vector<IMemoryPort*> mv;
+    for (int k = 0; k < P; ++k) { pv.push_back(s3.pes[k].get()); mv.push_back(s3.ports[k].get()); }
+    SampledRunner r(s3.shm, s3.bus, pv, mv);
+    SamplingReport rep;
+    std::string err;
+    assert(!r.run(SamplingConfig{}, rep, &err) && err.find("WAIT") != std::string::npos);
+    SamplingConfig bad;
+    bad.period = 100; bad.window = 80; bad.warmup = 40;
+    assert(!r.run(bad, rep, &err));
+  }
+
+  std::printf("OK sampling: miss %.4f vs %.4f, CPI %.3f±%.3f vs %.3f, %llu ventanas\n",
+              s.miss_rate.mean, f.miss_rate.mean, s.cpi.mean, s.cpi.half, f.cpi.mean,
+              (unsigned long long)s.windows);
+  return 0;
+}
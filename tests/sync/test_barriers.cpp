@@ -0,0 +1,72 @@
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "MesiInterconnect.hpp"
+#include "MesiMemoryPort.hpp"
+#include "memory/SharedMemory.h"
+#include "memory/cache/mesi/MESICache.hpp"
+#include "sync/Barriers.hpp"
+
+// Cada PE, en cada episodio e, escribe e en su línea y tras la barrera comprueba
+// que las líneas de TODOS los PEs ya valen e (si no, marca error en su línea de error).
+static void run_kind(BarrierKind kind) {
+  const int P = 4, kEpisodes = 6;
+  const uint64_t LINE = 32;
+  const uint64_t baseV = 0, baseErr = P * LINE, baseBar = 2 * P * LINE;
+
+  SharedMemory shm(baseBar + barrier_region_bytes(kind, P) + 1024);
+  MesiInterconnect bus(0);
+  bus.set_shared_memory(&shm);
+  MESICache c0(0, bus), c1(1, bus), c2(2, bus), c3(3, bus);
+  MESICache* cs[P] = {&c0, &c1, &c2, &c3};
+  for (auto* c : cs) bus.connect(c);
+
+  std::vector<std::unique_ptr<MesiMemoryPort>> mps;
+  std::vector<std::unique_ptr<PE>> pes;
+  for (int k = 0; k < P; ++k) {
+    Program p;
+    for (int e = 1; e <= kEpisodes; ++e) {
+      p.push_back({Op::LI, 1, 0, 0, e});
+      p.push_back({Op::LI, 2, 0, 0, (int64_t)(baseV + k * LINE)});
+      p.push_back({Op::STORE, 1, 2, 0, 0});
+      emit_barrier(p, kind, baseBar, k, P, 2 * e - 1);
+      for (int j = 0; j < P; ++j) {
+        p.push_back({Op::LI, 2, 0, 0, (int64_t)(baseV + j * LINE)});
+        p.push_back({Op::LOAD, 3, 2, 0, 0});
+        p.push_back({Op::SUB, 3, 3, 1, 0});
+        p.push_back({Op::JNZ, 3, 0, 0, 2});                 // distinto de e => error
+        p.push_back({Op::JNZ, 1, 0, 0, 3});                 // (R1 = e != 0) siguiente j
+        p.push_back({Op::LI, 2, 0, 0, (int64_t)(baseErr + k * LINE)});
+        p.push_back({Op::STORE, 1, 2, 0, 0});
+      }
+      // Sin segunda barrera, un PE rápido podría pisar su línea con e+1 antes de
+      // que otro la lea: se separan los episodios con una barrera extra.
+      emit_barrier(p, kind, baseBar, k, P, 2 * e);
+    }
+    p.push_back({Op::HALT, 0, 0, 0, 0});
+    mps.push_back(std::make_unique<MesiMemoryPort>(*cs[k], bus));
+    pes.push_back(std::make_unique<PE>(k, mps.back().get()));
+    pes.back()->load_program(p);
+  }
+
+  std::vector<std::thread> th;
+  for (auto& pe : pes) th.emplace_back([&pe] { pe->run(0); });
+  for (auto& t : th) t.join();
+
+  for (int k = 0; k < P; ++k) {
+    assert(mps[0]->load64(baseErr + k * LINE) == 0);
+    assert(mps[0]->load64(baseV + k * LINE) == uint64_t(kEpisodes));
+  }
+  std::printf("  %s ok\n", barrier_kind_name(kind));
+}
+
+int main() {
+  for (BarrierKind k : {BarrierKind::Central, BarrierKind::Tree, BarrierKind::Dissem, BarrierKind::Hw})
+    run_kind(k);
+  std::puts("OK barriers (central, tree, dissem, hw)");
+  return 0;
+}
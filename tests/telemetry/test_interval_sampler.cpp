@@ -0,0 +1,167 @@
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MesiInterconnect.hpp"
+#include "memory/SharedMemory.h"
+#include "memory/cache/mesi/MESICache.hpp"
+#include "sampling/Timing.hpp"
+#include "telemetry/IntervalSampler.hpp"
+
+static const char* kPath = "test_timeline.jsonl";
+
+static std::vector<std::string> read_lines(const char* path) {
+  std::ifstream in(path);
+  std::vector<std::string> out;
+  for (std::string l; std::getline(in, l);) out.push_back(l);
+  return out;
+}
+
+// Valor entero de "key": en una línea JSON (el primero que aparezca)
+static uint64_t field(const std::string& line, const std::string& key) {
+  const size_t p = line.find("\"" + key + "\":");
+  assert(p != std::string::npos);
+  return std::stoull(line.substr(p + key.size() + 3));
+}
+
+static void load(MESICache& c, uint64_t addr) {
+  uint64_t v = 0;
+  while (!c.load(addr, &v)) {}
+}
+
+int main() {
+  // --- Parseo de --timeline-every ---
+  {
+    TimelineConfig c;
+    assert(parse_timeline_every("1000", c) && c.every == 1000 && c.unit == TimelineConfig::Unit::Accesses);
+    assert(parse_timeline_every("500c", c) && c.every == 500 && c.unit == TimelineConfig::Unit::Cycles);
+    assert(!parse_timeline_every("", c) && !parse_timeline_every("c", c));
+    assert(!parse_timeline_every("0", c) && !parse_timeline_every("12x", c) && !parse_timeline_every("-4", c));
+  }
+
+  SharedMemory shm;
+  MesiInterconnect bus(0);
+  bus.set_shared_memory(&shm);
+  MESICache c0(0, bus), c1(1, bus);
+  bus.connect(&c0);
+  bus.connect(&c1);
+
+  // --- Muestras por cruce de límites, disparadas por el tap del PE ---
+  {
+    TimelineConfig cfg;
+    cfg.every = 4;
+    cfg.buffer_bytes = 256;   // menos que una línea: cada muestra va al archivo
+    IntervalSampler s(bus, cfg);
+    assert(s.open(kPath) && s.samples() == 1 && s.batch() == 1);   // muestra inicial
+    TimelineTap t0, t1;
+    t0.attach(&s, c0);
+    t1.attach(&s, c1);
+    t0.tick(c0);
+    assert(s.samples() == 1);
+
+    load(c0, 0x00);
+    load(c0, 0x40);                               // 2 misses = 4 intentos
+    t0.tick(c0);
+    assert(s.progress() == 4 && s.samples() == 2 && s.skipped() == 0);
+    t0.tick(c0);
+    assert(s.samples() == 2);
+    for (int i = 0; i < 12; ++i) {                // hits: una muestra en cada límite
+      load(c0, 0x00);
+      t0.tick(c0);
+    }
+    assert(s.samples() == 5 && s.skipped() == 0);
+    load(c1, 0x40);                               // otro PE, línea compartida
+    t1.tick(c1);                                  // 16 -> 18: no cruza
+    assert(s.samples() == 5);
+    s.close();
+    assert(s.samples() == 6 && s.flushes() == 6 && s.error().empty());
+    s.close();                                    // idempotente
+    assert(s.samples() == 6);
+
+    const auto lines = read_lines(kPath);
+    assert(lines.size() == 6);
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < lines.size(); ++i) {
+      assert(field(lines[i], "sample") == i && field(lines[i], "every") == 4);
+      assert(lines[i].find("\"unit\":\"accesses\"") != std::string::npos);
+      bytes += lines[i].size() + 1;
+    }
+    assert(bytes == s.bytes_written());
+    const uint64_t want[] = {0, 4, 8, 12, 16, 18};
+    for (size_t i = 0; i < lines.size(); ++i) assert(field(lines[i], "accesses") == want[i]);
+
+    // Última línea = totales: por PE y del bus
+    const std::string& last = lines.back();
+    const std::string pe0 = "{\"pe\":0,\"accesses\":16,\"cycles\":" +
+                            std::to_string(IntervalSampler::pe_cycles(c0)) + ",\"loads\":16,";
+    assert(last.find(pe0) != std::string::npos);
+    assert(last.find("\"pe\":1,\"accesses\":2,") != std::string::npos);
+    assert(last.find("\"bus\":{\"BusRd\":3,") != std::string::npos);
+    assert(last.find("\"misses\":2,") != std::string::npos);
+    assert(field(last, "cycles") == IntervalSampler::pe_cycles(c0) + IntervalSampler::pe_cycles(c1));
+    assert(IntervalSampler::pe_cycles(c0) >= 16 * timing::kInstrCycles + 2 * timing::kMemLineCycles);
+  }
+
+  // --- Sin avance desde la última muestra: close() no la repite ---
+  {
+    IntervalSampler s(bus, TimelineConfig{});
+    assert(s.open(kPath));
+    s.close();
+    assert(s.samples() == 1 && read_lines(kPath).size() == 1);
+  }
+
+  // --- Unidad ciclos y buffer grande: una sola escritura al final ---
+  {
+    TimelineConfig cfg;
+    assert(parse_timeline_every("10c", cfg));
+    IntervalSampler s(bus, cfg);
+    assert(s.progress() == IntervalSampler::pe_cycles(c0) + IntervalSampler::pe_cycles(c1));
+    assert(s.open(kPath));
+    TimelineTap t;
+    t.attach(&s, c1);
+    load(c1, 0x80);                               // miss: más de 100 ciclos (>= 10 límites)
+    t.tick(c1);
+    assert(s.samples() == 2 && s.skipped() >= 9 && s.flushes() == 0);   // una muestra para todos
+    s.close();
+    const auto lines = read_lines(kPath);
+    assert(s.samples() == 2 && s.flushes() == 1 && lines.size() == 2);
+    assert(lines[0].find("\"unit\":\"cycles\",\"every\":10,") != std::string::npos);
+  }
+
+  // --- Dos PEs en paralelo: una muestra por múltiplo de K, cada una pasado su límite ---
+  {
+    TimelineConfig cfg;
+    cfg.every = 64;
+    IntervalSampler s(bus, cfg);
+    const uint64_t p0 = s.progress();
+    assert(s.open(kPath) && s.batch() == 4);
+    auto run = [&](MESICache& c, uint64_t base) {
+      TimelineTap t;
+      t.attach(&s, c);
+      for (int i = 0; i < 20000; ++i) {
+        load(c, base + uint64_t(i % 64) * MESICache::kLineSize);
+        t.tick(c);
+      }
+    };
+    std::thread pe0([&] { run(c0, 0x000); }), pe1([&] { run(c1, 0x800); });
+    pe0.join();
+    pe1.join();
+    const uint64_t end = s.progress();
+    s.close();
+    assert(s.skipped() == 0);
+    const auto lines = read_lines(kPath);
+    assert(lines.size() == s.samples());
+    const uint64_t crossed = lines.size() - 2;    // sin la inicial ni la final
+    assert(crossed >= (end - 2 * 4) / 64 - p0 / 64 && crossed <= end / 64 - p0 / 64);
+    for (uint64_t j = 1; j <= crossed; ++j)
+      assert(field(lines[j], "accesses") >= (p0 / 64 + j) * 64);
+    assert(field(lines.back(), "accesses") == end);
+  }
+
+  std::remove(kPath);
+  std::puts("OK interval_sampler");
+  return 0;
+}
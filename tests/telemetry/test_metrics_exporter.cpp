@@ -0,0 +1,97 @@
+#include <cassert>
+#include <cstdio>
+#include <string>
+
+#include "MesiInterconnect.hpp"
+#include "memory/SharedMemory.h"
+#include "memory/cache/mesi/MESICache.hpp"
+#include "telemetry/MetricsExporter.hpp"
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// GET 'path' por TCP (port > 0) o socket Unix; devuelve la respuesta completa
+static std::string http_get(uint16_t port, const std::string& unix_path, const std::string& path) {
+  int fd;
+  if (port) {
+    fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    sa.sin_port = htons(port);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&sa), sizeof sa) != 0) return {};
+  } else {
+    fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un sa{};
+    sa.sun_family = AF_UNIX;
+    std::snprintf(sa.sun_path, sizeof sa.sun_path, "%s", unix_path.c_str());
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&sa), sizeof sa) != 0) return {};
+  }
+  const std::string req = "GET " + path + " HTTP/1.0\r\n\r\n";
+  ::send(fd, req.data(), req.size(), 0);
+  std::string resp;
+  char buf[4096];
+  ssize_t n;
+  while ((n = ::recv(fd, buf, sizeof buf, 0)) > 0) resp.append(buf, size_t(n));
+  ::close(fd);
+  return resp;
+}
+#endif
+
+int main() {
+  SharedMemory shm;
+  MesiInterconnect bus(0);
+  bus.set_shared_memory(&shm);
+  MESICache c0(0, bus), c1(1, bus);
+  bus.connect(&c0); bus.connect(&c1);
+
+  uint64_t v = 0;
+  for (int i = 0; i < 3; ++i) while (!c0.load(0x40 * i, &v)) {}
+  v = 5;
+  while (!c1.store(0x40, &v)) {}
+
+  MetricsExporter ex(bus);
+
+  // Renderizado directo
+  const std::string prom = ex.prometheus();
+  assert(prom.find("mesi_cache_loads_total{pe=\"0\"} 6") != std::string::npos);   // 3 misses + 3 reintentos
+  assert(prom.find("mesi_cache_invalidations_total{pe=\"0\"} 1") != std::string::npos);
+  assert(prom.find("mesi_bus_transactions_total{type=\"BusRd\"} 3") != std::string::npos);
+  assert(prom.find("mesi_bus_transactions_total{type=\"BusRdX\"} 1") != std::string::npos);
+  const std::string js = ex.json();
+  assert(js.find("\"pe\":1,\"loads\":0,\"stores\":2") != std::string::npos);
+
+#ifndef _WIN32
+  // TCP en puerto efímero
+  assert(ex.start("tcp:0"));
+  assert(ex.port() != 0);
+  std::string r = http_get(ex.port(), "", "/metrics");
+  assert(r.rfind("HTTP/1.0 200", 0) == 0);
+  assert(r.find("mesi_cache_misses_total{pe=\"1\"} 1") != std::string::npos);
+  r = http_get(ex.port(), "", "/json");
+  assert(r.find("application/json") != std::string::npos && r.find("\"bus\":{") != std::string::npos);
+  assert(http_get(ex.port(), "", "/nope").rfind("HTTP/1.0 404", 0) == 0);
+
+  // Los valores son en vivo: un acceso nuevo se ve en la siguiente lectura
+  while (!c1.load(0x80, &v)) {}
+  r = http_get(ex.port(), "", "/metrics");
+  assert(r.find("mesi_cache_loads_total{pe=\"1\"} 2") != std::string::npos);
+  ex.stop();
+
+  // Socket de dominio Unix
+  const std::string sock = "test_metrics_exporter.sock";
+  MetricsExporter ux(bus);
+  assert(ux.start("unix:" + sock));
+  r = http_get(0, sock, "/json");
+  assert(r.find("\"pes\":[") != std::string::npos);
+  ux.stop();
+  assert(::access(sock.c_str(), F_OK) != 0);   // stop() borra el socket
+#endif
+
+  std::puts("OK metrics exporter (prometheus, json, tcp, unix)");
+  return 0;
+}
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <string>
+
+#include "MesiInterconnect.hpp"
+#include "memory/SharedMemory.h"
+#include "memory/cache/mesi/MESICache.hpp"
+#include "trace/Trace.hpp"
+#include "trace/TraceReplayer.hpp"
+
+// Escribe una traza de 3 PEs, la relee (con y sin compresión) y la reproduce.
+static void roundtrip(bool compress) {
+  const std::string path = compress ? "test_trace_z.trc" : "test_trace.trc";
+  std::vector<std::vector<TraceRecord>> expect(3);
+  uint64_t addr_end = 0;
+
+  {
+    TraceWriter w(path, 3, compress);
+    assert(w.ok());
+    uint64_t x = 12345;
+    for (int i = 0; i < 50000; ++i) {
+      const int pe = i % 3;
+      x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+      // Mezcla de accesos secuenciales (delta pequeño) y saltos (delta grande/negativo)
+      const uint64_t addr = (i % 7) ? (uint64_t(i) * 8) % 4096 : (x >> 20) % 4096 & ~7ull;
+      const TraceKind k = (x & 1) ? TraceKind::Store : TraceKind::Load;
+      w.record(pe, k, addr);
+      expect[pe].push_back({k, addr});
+      addr_end = std::max(addr_end, addr + 8);
+      if (i == 30000) {
+        w.barrier();
+        for (int p = 0; p < 3; ++p) expect[p].push_back({TraceKind::Sync, expect[p].back().addr});
+      }
+    }
+    w.close();
+  }
+
+  {
+    TraceReader r(path);
+    assert(r.ok());
+    assert(r.num_pes() == 3);
+    assert(r.addr_end() == addr_end);
+    for (int pe = 0; pe < 3; ++pe) {
+      TraceRecord rec;
+      for (const auto& e : expect[pe]) {
+        assert(r.next(pe, rec));
+        assert(rec.kind == e.kind && rec.addr == e.addr);
+      }
+      assert(!r.next(pe, rec));
+    }
+  }
+
+  // Reproducción sobre 3 L1$: cuenta exacta de loads/stores y una barrera
+  SharedMemory shm;
+  MesiInterconnect bus(0);
+  bus.set_shared_memory(&shm);
+  MESICache c0(0, bus), c1(1, bus), c2(2, bus);
+  bus.connect(&c0); bus.connect(&c1); bus.connect(&c2);
+
+  TraceReader r(path);
+  TraceReplayer rep({&c0, &c1, &c2}, 4);
+  auto st = rep.run(r);
+  assert(st.accesses == 50000);
+  assert(st.barriers == 1);
+  uint64_t loads = 0;
+  for (const auto& v : expect) for (const auto& e : v) loads += (e.kind == TraceKind::Load);
+  assert(st.loads == loads);
+  std::remove(path.c_str());
+}
+
+// Cabecera v2 a mano; devuelve el archivo abierto para agregar chunks
+static std::FILE* write_header(const char* path, uint16_t pes) {
+  std::FILE* f = std::fopen(path, "wb");
+  uint8_t hdr[trace::kHeaderBytes] = {};
+  std::memcpy(hdr, trace::kMagic, 8);
+  hdr[8] = uint8_t(trace::kVersion);
+  hdr[10] = uint8_t(pes); hdr[11] = uint8_t(pes >> 8);
+  std::fwrite(hdr, 1, sizeof hdr, f);
+  return f;
+}
+
+// Un archivo corrupto se rechaza sin reservar lo que declara
+static void corrupt() {
+  const char* path = "test_trace_bad.trc";
+  std::fclose(write_header(path, 65535));
+  {
+    TraceReader r(path);
+    assert(!r.ok() && !r.error().empty());
+  }
+
+  // Chunk que dice tener 1 TiB (sin compresión: almacenado == crudo)
+  std::FILE* f = write_header(path, 1);
+  uint8_t tmp[3 * trace::kMaxRecordBytes];
+  size_t n = trace::put_varint(tmp, 0);
+  n += trace::put_varint(tmp + n, 1ull << 40);
+  n += trace::put_varint(tmp + n, 1ull << 40);
+  std::fwrite(tmp, 1, n, f);
+  std::fclose(f);
+  {
+    TraceReader r(path);
+    assert(r.ok());
+    TraceRecord rec;
+    assert(!r.next(0, rec));
+    assert(!r.error().empty());
+  }
+
+  // Tamaño almacenado distinto del crudo en una traza sin compresión
+  f = write_header(path, 1);
+  n = trace::put_varint(tmp, 0);
+  n += trace::put_varint(tmp + n, 16);
+  n += trace::put_varint(tmp + n, 1ull << 40);
+  std::fwrite(tmp, 1, n, f);
+  std::fclose(f);
+  {
+    TraceReader r(path);
+    TraceRecord rec;
+    assert(!r.next(0, rec));
+    assert(!r.error().empty());
+  }
+  std::remove(path);
+}
+
+int main() {
+  corrupt();
+  roundtrip(false);
+  if (trace::deflate_available()) roundtrip(true);
+  std::puts("OK trace roundtrip + replay");
+  return 0;
+}
@@ -0,0 +1,91 @@
+#include <cassert>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "MesiInterconnect.hpp"
+#include "memory/SharedMemory.h"
+#include "memory/cache/mesi/MESICache.hpp"
+#include "sampling/Timing.hpp"
+#include "utils/LatencyHistogram.hpp"
+
+using H = LatencyHistogram;
+
+int main() {
+  // --- Cubos: exactos abajo, contiguos y con error relativo acotado arriba ---
+  for (uint64_t v = 0; v < 16; ++v) assert(H::bucket_low(H::bucket_of(v)) == v);
+  for (int b = 0; b + 1 < H::kBuckets; ++b) {
+    assert(H::bucket_high(b) + 1 == H::bucket_low(b + 1));
+    assert(H::bucket_of(H::bucket_low(b)) == b && H::bucket_of(H::bucket_high(b)) == b);
+    const uint64_t lo = H::bucket_low(b), hi = H::bucket_high(b);
+    assert(lo < 16 || double(hi - lo + 1) / double(lo) <= 1.0 / 16);
+  }
+  assert(H::bucket_of(~uint64_t(0)) == H::kBuckets - 1);
+  assert(H::bucket_high(H::kBuckets - 1) == ~uint64_t(0));
+
+  // --- Percentiles: 1..1000 uniformes ---
+  H h;
+  assert(h.percentile(0.5) == 0 && h.count() == 0);
+  for (uint64_t v = 1; v <= 1000; ++v) h.record(v);
+  assert(h.count() == 1000 && h.max() == 1000 && h.mean() == 500.5);
+  for (double q : {0.5, 0.99, 0.999}) {
+    const double exact = q * 1000, p = double(h.percentile(q));
+    assert(p >= exact && p <= exact * (1 + 1.0 / 16));
+  }
+  assert(h.percentile(1.0) == 1000);
+
+  // --- merge: igual a registrar todo en uno; copia = instantánea ---
+  H a, b, all;
+  for (uint64_t v = 0; v < 5000; ++v) {
+    (v % 3 ? a : b).record(v * 37);
+    all.record(v * 37);
+  }
+  H m = a;
+  m.merge(b);
+  assert(m.count() == all.count() && m.sum() == all.sum() && m.max() == all.max());
+  for (int i = 0; i < H::kBuckets; ++i) assert(m.bucket_count(i) == all.bucket_count(i));
+  assert(a.count() + b.count() == 5000);
+
+  // --- Varios escritores sobre el mismo histograma (Flush por snoop) ---
+  H shared;
+  std::vector<std::thread> th;
+  for (int t = 0; t < 4; ++t)
+    th.emplace_back([&shared, t] { for (int i = 0; i < 20000; ++i) shared.record(uint64_t(t * 100 + i % 7)); });
+  for (auto& t : th) t.join();
+  assert(shared.count() == 80000 && shared.max() == 306);
+
+  // --- Integración: latencia en ciclos según el origen de los datos ---
+  SharedMemory shm;
+  MesiInterconnect bus(0);
+  bus.set_shared_memory(&shm);
+  MESICache c0(0, bus), c1(1, bus);
+  bus.connect(&c0);
+  bus.connect(&c1);
+  const uint64_t addr = 0x100;
+  uint64_t out = 0, val = 7;
+
+  while (!c0.load(addr, &out)) {}    // BusRd desde memoria
+  while (!c1.load(addr, &out)) {}    // BusRd desde memoria (quedan en S)
+  while (!c0.store(addr, &val)) {}   // BusUpgr
+  c1.load(addr, &out);               // c1 invalidada: BusRd, c0 hace Flush y reenvía
+  while (!c1.load(addr, &out)) {}
+  assert(out == 7);
+
+  const auto& s0 = c0.stats();
+  const auto& s1 = c1.stats();
+  assert(s0.lat_cycles[MESICache::LatBusRd].count() == 1);
+  assert(s0.lat_cycles[MESICache::LatBusRd].max() == timing::kMemLineCycles);
+  assert(s0.lat_cycles[MESICache::LatBusUpgr].count() == 1);
+  assert(s0.lat_cycles[MESICache::LatBusUpgr].max() == timing::kBusUpgrCycles);
+  // El Flush lo registra c0 aunque corra en el snoop del BusRd de c1
+  assert(s0.lat_cycles[MESICache::LatFlush].count() == 1);
+  assert(s0.lat_cycles[MESICache::LatFlush].max() == timing::kWriteBackCycles);
+  const H& rd1 = s1.lat_cycles[MESICache::LatBusRd];
+  assert(rd1.count() == 2 && rd1.max() == timing::kMemLineCycles);
+  assert(rd1.bucket_count(H::bucket_of(timing::kCacheToCacheCycles)) == 1);
+  // Tiempo del host registrado para cada transacción
+  assert(s1.lat_ns[MESICache::LatBusRd].count() == 2 && s1.lat_ns[MESICache::LatBusRd].max() > 0);
+
+  std::puts("OK latency histogram");
+  return 0;
+}
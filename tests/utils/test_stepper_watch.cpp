@@ -0,0 +1,112 @@
+#include <cassert>
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#include "MesiInterconnect.hpp"
+#include "memory/SharedMemory.h"
+#include "memory/cache/mesi/MESICache.hpp"
+#include "utils/Stepper.hpp"
+
+static bool has(const std::string& s, const char* needle) { return s.find(needle) != std::string::npos; }
+
+int main() {
+  // --- 1) especificaciones inválidas ---
+  {
+    Stepper s;
+    std::string err;
+    assert(!s.add_watch("foo=1", &err) && has(err, "foo"));
+    assert(!s.add_watch("trans=SM", &err));
+    assert(!s.add_watch("ev=BusRd|Bogus", &err));
+    assert(!s.add_watch("every=0", &err));
+    assert(!s.add_watch("addr=0x200-0x100", &err));
+    assert(s.watch_count() == 0);
+  }
+
+  SharedMemory shm;
+  MesiInterconnect bus(0);
+  bus.set_shared_memory(&shm);
+  MESICache c0(0, bus), c1(1, bus);
+  bus.connect(&c0); bus.connect(&c1);
+
+  std::ostringstream log;
+  Stepper step;
+  step.interactive = false;
+  step.out = &log;
+  assert(step.add_watch("trans=S>M,pe=0,addr=0x100"));
+  assert(step.add_watch("ev=BusRd,every=2"));
+  bus.set_stepper(&step);
+
+  uint64_t v = 0, w = 7;
+  // --- 2) corre sin parar hasta el 2º BusRd ---
+  while (!c0.load(0x100, &v)) {}
+  assert(step.events() == 1 && step.stops() == 0);
+  while (!c1.load(0x100, &v)) {}
+  assert(step.stops() == 1);
+  assert(has(step.last_reason(), "every=2"));
+
+  // --- 3) watchpoint de transición: S->M en PE0 (BusUpgr) ---
+  size_t mark = log.str().size();
+  while (!c0.store(0x100, &w)) {}
+  assert(step.stops() == 2);
+  assert(has(step.last_reason(), "trans=S>M"));
+  std::string diff = log.str().substr(mark);
+  assert(has(diff, "PE0") && has(diff, "0x100: S -> M (dirty)"));
+  assert(has(diff, "PE1") && has(diff, "0x100: S -> I"));
+
+  // --- 4) el diff solo muestra lo que cambió desde la parada anterior ---
+  while (!c1.load(0x200, &v)) {}
+  assert(step.stops() == 2);
+  mark = log.str().size();
+  while (!c1.load(0x300, &v)) {}
+  assert(step.stops() == 3);
+  diff = log.str().substr(mark);
+  assert(has(diff, "0x200: I -> E") && has(diff, "0x300: I -> E"));
+  assert(!has(diff, "S -> I"));                 // ya reportado en la parada anterior
+  // el store de PE0 se escribió después de la parada del BusUpgr: aparece ahora
+  assert(has(diff, "0x100: M -> M") && has(diff, "+00: 0x0000000000000000 -> 0x0000000000000007"));
+  assert(has(diff, "DRAM: +2 lecturas"));
+
+  // --- 5) sin watchpoints se detiene en cada evento; deshabilitado no cuenta ---
+  std::ostringstream log2;
+  Stepper every;
+  every.interactive = false;
+  every.out = &log2;
+  bus.set_stepper(&every);
+  while (!c0.load(0x400, &v)) {}
+  while (!c1.store(0x400, &w)) {}
+  assert(every.events() == 2 && every.stops() == 2);
+  every.enabled = false;
+  while (!c0.load(0x500, &v)) {}
+  assert(every.events() == 2);
+  bus.set_stepper(nullptr);
+
+  // --- 6) L1$ con ids que no empiezan en 0 (PEs de un cluster): etiquetas y
+  // anticipo del BusUpgr por id(), no por posición en el bus ---
+  {
+    SharedMemory shm2;
+    MesiInterconnect bus2(0);
+    bus2.set_shared_memory(&shm2);
+    MESICache c4(4, bus2), c5(5, bus2);
+    bus2.connect(&c4); bus2.connect(&c5);
+    std::ostringstream log3;
+    Stepper s;
+    s.interactive = false;
+    s.out = &log3;
+    assert(s.add_watch("trans=S>M,pe=5"));
+    bus2.set_stepper(&s);
+    while (!c4.load(0x100, &v)) {}
+    while (!c5.load(0x100, &v)) {}
+    assert(s.stops() == 0);
+    while (!c5.store(0x100, &w)) {}
+    assert(s.stops() == 1);
+    // primera parada: se listan las vías válidas (la de PE4 ya quedó en I)
+    const std::string d = log3.str();
+    assert(has(d, "BusUpgr PE5") && has(d, "PE5 set0 way0 0x100: I -> M (dirty)"));
+    assert(!has(d, "PE0") && !has(d, "PE1"));
+    bus2.set_stepper(nullptr);
+  }
+
+  std::puts("OK stepper watchpoints + diff dumps");
+  return 0;
+}
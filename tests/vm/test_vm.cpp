@@ -0,0 +1,184 @@
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "MesiInterconnect.hpp"
+#include "MesiMemoryPort.hpp"
+#include "memory/SharedMemory.h"
+#include "memory/cache/mesi/MESICache.hpp"
+#include "sampling/Timing.hpp"
+#include "vm/Mmu.hpp"
+#include "vm/Tlb.hpp"
+
+static constexpr uint64_t K4 = AddressSpace::kPageBytes, M2 = AddressSpace::kHugeBytes;
+
+int main() {
+  // --- Tlb: conjuntos, LRU y arreglos separados por tamaño ---
+  {
+    int e = 0, w = 0;
+    assert(parse_tlb_geom("64:4", e, w) && e == 64 && w == 4);
+    assert(parse_tlb_geom("8", e, w) && w == 8);
+    assert(!parse_tlb_geom("6:4", e, w) && !parse_tlb_geom("x", e, w));
+    TlbConfig bad;
+    bad.ways = 3;
+    assert(!Tlb::validate(bad, nullptr));
+
+    TlbConfig c;
+    c.entries = 4; c.ways = 2;                 // 2 sets de 2 vías
+    Tlb t(c);
+    uint64_t pa = 0;
+    bool huge = true;
+    t.insert(0 * K4, 0x10000, false);
+    t.insert(2 * K4, 0x20000, false);          // mismo set (vpn par)
+    assert(t.lookup(0 * K4 + 0x18, pa, &huge) && pa == 0x10018 && !huge);
+    t.insert(4 * K4, 0x30000, false);          // desaloja la LRU: vpn 2
+    assert(t.lookup(0, pa) && !t.lookup(2 * K4, pa) && t.lookup(4 * K4, pa));
+    t.insert(1 * K4, 0x40000, false);          // el otro set no se toca
+    assert(t.lookup(0, pa) && t.lookup(1 * K4, pa));
+
+    t.insert(3 * M2, 0x200000, true);
+    assert(t.lookup(3 * M2 + 0x1234, pa, &huge) && huge && pa == 0x201234);
+    assert(!t.invalidate(3 * M2, false) && t.invalidate(3 * M2, true));
+    assert(!t.lookup(3 * M2, pa));
+    t.invalidate_all();
+    assert(!t.lookup(0, pa) && !t.lookup(1 * K4, pa));
+  }
+
+  // --- AddressSpace: tablas en memoria, traducción del host y tramos ---
+  {
+    SharedMemory shm(AddressSpace::phys_bytes_for(16 * K4, false));
+    AddressSpace as(shm);
+    assert(as.map(0, 16 * K4, false));
+    assert(as.pages() == 16 && as.table_pages() == 4);   // raíz + 3 niveles
+    uint64_t pa0 = 0, pa1 = 0;
+    assert(as.translate(0x10, pa0) && as.translate(K4 + 0x10, pa1));
+    assert(pa0 % K4 == 0x10 && pa1 % K4 == 0x10 && pa1 != pa0);
+    assert(!as.translate(16 * K4, pa0));
+    size_t pieces = 0, total = 0;
+    assert(as.split(K4 - 8, 16, [&](uint64_t, size_t off, size_t len) {
+      assert(off == total);
+      total += len;
+      ++pieces;
+    }));
+    assert(pieces == 2 && total == 16);
+    assert(!as.split(15 * K4, 2 * K4, [](uint64_t, size_t, size_t) {}));
+
+    SharedMemory big(AddressSpace::phys_bytes_for(3 * M2, true));
+    AddressSpace hs(big);
+    assert(hs.map(0, 3 * M2, true) && hs.pages() == 3 && hs.table_pages() == 3);
+    assert(hs.translate(M2 + 0x40, pa0) && pa0 % M2 == 0x40);
+    std::string err;
+    SharedMemory tiny(8 * K4);
+    AddressSpace ts(tiny);
+    assert(!ts.map(0, 16 * K4, false, &err) && !err.empty());
+  }
+
+  // --- Mmu: recorrido por la L1$, hits de TLB, páginas grandes ---
+  {
+    SharedMemory shm(AddressSpace::phys_bytes_for(2 * M2, false));
+    AddressSpace as(shm);
+    assert(as.map(0, 64 * K4, false));
+    MesiInterconnect bus(0);
+    bus.set_shared_memory(&shm);
+    MESICache c0(0, bus), c1(1, bus);
+    bus.connect(&c0);
+    bus.connect(&c1);
+    Mmu m0(0, as, c0, bus), m1(1, as, c1, bus);
+    MesiMemoryPort p0(c0, bus), p1(c1, bus);
+    p0.set_mmu(&m0);
+    p1.set_mmu(&m1);
+
+    const int loads0 = c0.stats().loads;             // MESICache::Counter es int
+    p0.store64(5 * K4 + 8, 77);
+    assert(m0.stats().misses == 1 && m0.stats().walk_loads == 4);
+    assert(c0.stats().loads >= loads0 + 4);          // las PTEs se leen como loads normales
+    assert(m0.stats().walk_cycles >= 4 * timing::kInstrCycles);
+    assert(p0.load64(5 * K4 + 8) == 77);
+    assert(m0.stats().misses == 1 && m0.stats().accesses == 2);   // segundo acceso: hit de TLB
+    assert(p1.load64(5 * K4 + 8) == 77);              // otro PE, misma VA: mismo dato
+
+    // La PA la escribió la L1$: el host la encuentra con su traducción
+    uint64_t pa = 0, v = 0;
+    assert(as.translate(5 * K4 + 8, pa));
+    while (!c1.load(pa, &v)) {}
+    assert(v == 77);
+
+    // Fallo de página: se mapea a demanda (página en cero) y vale para todos
+    const uint64_t far = 1000 * K4;
+    assert(p0.load64(far) == 0);
+    assert(m0.stats().faults == 1);
+    p0.store64(far + 16, 5);
+    assert(p1.load64(far + 16) == 5 && m1.stats().faults == 0);
+
+    // --- Shootdown: remap desde PE0 invalida la traducción en la TLB de PE1 ---
+    uint64_t dst = 0;
+    assert(as.translate(9 * K4, dst));               // marco de la página 9 como destino
+    p0.store64(9 * K4, 123);                          // valor en el marco destino
+    assert(p1.load64(5 * K4 + 8) == 77);              // PE1 tiene la página 5 en su TLB
+    assert(m0.remap(5 * K4, dst));
+    assert(bus.stats().tlb_shootdowns == 1 && m0.stats().shootdowns_sent == 1);
+    assert(m1.stats().shootdowns_recv == 1 && m0.stats().shootdowns_recv == 1);
+    assert(p1.load64(5 * K4) == 123);                 // nueva traducción, por un recorrido nuevo
+    assert(!m0.remap(5 * K4, dst + 8));               // marco desalineado
+    assert(m0.unmap(9 * K4) && !as.translate(9 * K4, pa));
+    assert(!m1.unmap(9 * K4));
+
+    // Concurrente: PE1 lee mientras PE0 cambia el mapeo de otra página una y otra vez
+    std::atomic<bool> done{false};
+    std::thread reader([&] {
+      while (!done.load(std::memory_order_relaxed)) assert(p1.load64(5 * K4) == 123);
+    });
+    uint64_t a = 0, b = 0;
+    assert(as.translate(20 * K4, a) && as.translate(21 * K4, b));
+    for (int i = 0; i < 200; ++i) assert(m0.remap(20 * K4, (i & 1) ? a : b));
+    done = true;
+    reader.join();
+    assert(m1.stats().shootdowns_recv >= 1 && bus.stats().tlb_shootdowns == 202);
+  }
+
+  // --- Páginas grandes: recorridos de 3 niveles y una entrada para 2 MiB ---
+  {
+    SharedMemory shm(AddressSpace::phys_bytes_for(2 * M2, true));
+    AddressSpace as(shm);
+    assert(as.map(0, 2 * M2, true));
+    MesiInterconnect bus(0);
+    bus.set_shared_memory(&shm);
+    MESICache c0(0, bus);
+    bus.connect(&c0);
+    Mmu m(0, as, c0, bus);
+    uint64_t pa = 0;
+    for (uint64_t va = 0; va < 2 * M2; va += 64 * K4) assert(m.translate(va, pa) && pa % M2 == va % M2);
+    assert(m.stats().misses == 2 && m.stats().huge_misses == 2 && m.stats().walk_loads == 6);
+  }
+
+  // --- Fallo de página sin memoria física: translate falla y el PE se detiene ---
+  {
+    SharedMemory shm(5 * K4);                   // raíz + 3 tablas + 1 página
+    AddressSpace as(shm);
+    assert(as.map(0, K4, false));
+    MesiInterconnect bus(0);
+    bus.set_shared_memory(&shm);
+    MESICache c0(0, bus);
+    bus.connect(&c0);
+    Mmu m(0, as, c0, bus);
+    uint64_t pa = 0;
+    std::string err;
+    assert(!m.translate(M2, pa, &err) && !err.empty());
+
+    MesiMemoryPort p(c0, bus);
+    p.set_mmu(&m);
+    PE pe(0, &p);
+    pe.load_program({{Op::LI, 0, 0, 0, int64_t(M2)},
+                     {Op::LOAD, 1, 0, 0, 0},            // falla: sin marco ni tablas libres
+                     {Op::LI, 2, 0, 0, 7},
+                     {Op::HALT, 0, 0, 0, 0}});
+    pe.run(0);
+    assert(pe.halted() && p.fault() && pe.regs()[2] == 0);
+  }
+
+  std::puts("OK vm");
+  return 0;
+}